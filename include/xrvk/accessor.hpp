@@ -0,0 +1,62 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace xrlib
+{
+	// Values match the gltf accessor componentType
+	enum class EAccessorComponent : uint32_t
+	{
+		Byte = 5120,
+		UnsignedByte = 5121,
+		Short = 5122,
+		UnsignedShort = 5123,
+		UnsignedInt = 5125,
+		Float = 5126
+	};
+
+	// Resolved view of a gltf accessor (buffer view offsets and stride applied), independent of the gltf parser
+	struct SAccessorStream
+	{
+		const uint8_t *pData = nullptr; // null if the accessor has no buffer view, elements are then zero unless overridden by sparse values
+		size_t count = 0;
+		size_t stride = 0;
+		EAccessorComponent componentType = EAccessorComponent::Float;
+		uint32_t componentCount = 0;
+		bool normalized = false;
+
+		// Sparse substitution - sparseCount indices (tightly packed, ascending) and matching tightly packed values
+		size_t sparseCount = 0;
+		const uint8_t *pSparseIndices = nullptr;
+		EAccessorComponent sparseIndexType = EAccessorComponent::UnsignedInt;
+		const uint8_t *pSparseValues = nullptr;
+	};
+
+	uint32_t GetAccessorComponentSize( EAccessorComponent componentType );
+
+	// Converts whole streams into strided output (e.g. a field of SMeshVertex), writing min( componentCount, unOutComponents ) components per element.
+	// Normalized integers map to [0, 1] / [-1, 1], other integers convert as is. Streams are decoded with sse2 / neon kernels where available.
+	void DecodeAccessorFloat( const SAccessorStream &stream, float *pOut, uint32_t unOutComponents, size_t unOutStride );
+	void DecodeAccessorUint( const SAccessorStream &stream, uint32_t *pOut, uint32_t unOutComponents, size_t unOutStride );
+
+	// Writes stream.count indices offset by unBaseVertex to pOut, returns false (writing nothing) if the stream isn't an unsigned scalar stream
+	bool DecodeIndices( const SAccessorStream &stream, uint32_t unBaseVertex, uint32_t *pOut );
+
+	// Indices for non indexed geometry: unFirst, unFirst + 1, ...
+	void GenerateSequentialIndices( uint32_t *pOut, size_t unCount, uint32_t unFirst );
+
+} // namespace xrlib
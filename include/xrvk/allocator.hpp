@@ -0,0 +1,204 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <xrlib/session.hpp>
+#include <xrlib/vulkan.hpp>
+
+namespace xrlib
+{
+	static constexpr VkDeviceSize k_unDefaultMemoryBlockSize = 64ull * 1024 * 1024;	// Size of each VkDeviceMemory block owned by the allocator
+	static constexpr VkDeviceSize k_unMinSizeClass = 256;								// Smallest size class (bytes)
+	static constexpr VkDeviceSize k_unMaxSizeClass = 256 * 1024;						// Allocations above this use best-fit ranges instead of size classes
+	static constexpr uint32_t k_unSizeClassCount = 11;									// 256b .. 256kb, power of two
+
+	// Linear resources (buffers, linear images) and optimal tiled images never share a block,
+	// which keeps neighbouring resources within a block compliant with bufferImageGranularity
+	enum class EAllocationKind
+	{
+		Linear = 0,
+		Optimal = 1,
+		EMax
+	};
+
+	struct SMemoryBlock;
+
+	struct SMemoryAllocation
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		VkDeviceSize alignment = 1;
+		uint32_t memoryTypeIndex = 0;
+		EAllocationKind kind = EAllocationKind::Linear;
+
+		// Owner of the allocation (e.g. a CDeviceBuffer), for debugging
+		void *pUserData = nullptr;
+
+		// Internal - allocator bookkeeping
+		SMemoryBlock *pBlock = nullptr;		 // null if this is a dedicated allocation
+		VkDeviceSize reservedSize = 0;		 // range actually reserved in the block (size class rounded)
+		int32_t sizeClass = -1;				 // -1 if not a size class allocation
+		void *pDedicatedMapped = nullptr;
+		uint32_t mapCount = 0;				 // outstanding Map calls
+
+		bool IsDedicated() const { return pBlock == nullptr; }
+	};
+
+	struct SMemoryBlock
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize size = 0;
+		VkDeviceSize usedSize = 0;
+		uint32_t memoryTypeIndex = 0;
+		EAllocationKind kind = EAllocationKind::Linear;
+
+		void *pMapped = nullptr;
+		uint32_t mapCount = 0;
+
+		// Free ranges, by offset (for coalescing) and by size (for best fit)
+		std::map< VkDeviceSize, VkDeviceSize > freeByOffset;
+		std::multimap< VkDeviceSize, VkDeviceSize > freeBySize;
+
+		// Live allocations in this block
+		std::unordered_set< SMemoryAllocation * > allocations;
+	};
+
+	struct SMemoryStats
+	{
+		uint32_t blockCount = 0;
+		uint32_t allocationCount = 0;
+		uint32_t dedicatedAllocationCount = 0;
+		uint32_t cachedSlotCount = 0;
+
+		VkDeviceSize blockBytes = 0;
+		VkDeviceSize usedBytes = 0;
+		VkDeviceSize dedicatedBytes = 0;
+	};
+
+	struct SMemoryHeapBudget
+	{
+		VkDeviceSize size = 0;				// Heap size
+		VkDeviceSize budget = 0;			// Estimated amount this process can use (VK_EXT_memory_budget, else a fraction of the heap size)
+		VkDeviceSize usage = 0;				// Current usage of this process (VK_EXT_memory_budget, else allocator bytes)
+		VkDeviceSize allocatorBytes = 0;	// Device memory owned by this allocator
+		VkMemoryHeapFlags flags = 0;
+	};
+
+	class CDeviceMemoryAllocator
+	{
+	  public:
+		// One allocator per logical device, created on first use
+		static CDeviceMemoryAllocator *Get( VkDevice vkDevice, VkPhysicalDevice vkPhysicalDevice );
+		static CDeviceMemoryAllocator *Get( CSession *pSession );
+
+		// Frees all device memory owned by the allocator of this device - call before the logical device is destroyed
+		static void Destroy( VkDevice vkDevice );
+
+		CDeviceMemoryAllocator( VkDevice vkDevice, VkPhysicalDevice vkPhysicalDevice, VkDeviceSize unBlockSize = k_unDefaultMemoryBlockSize );
+		~CDeviceMemoryAllocator();
+
+		VkResult Allocate(
+			SMemoryAllocation *&outAllocation,
+			const VkMemoryRequirements &memReqs,
+			VkMemoryPropertyFlags memPropFlags,
+			EAllocationKind kind = EAllocationKind::Linear,
+			bool bDedicated = false,
+			const void *pAllocateNext = nullptr );
+
+		VkResult AllocateAndBindBuffer( SMemoryAllocation *&outAllocation, VkBuffer vkBuffer, VkMemoryPropertyFlags memPropFlags, bool bDeviceAddress = false );
+		VkResult AllocateAndBindImage( SMemoryAllocation *&outAllocation, VkImage vkImage, VkMemoryPropertyFlags memPropFlags, VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL );
+
+		void Free( SMemoryAllocation *pAllocation );
+
+		// Blocks are mapped once and shared by all allocations in them
+		VkResult Map( SMemoryAllocation *pAllocation, void **ppOutData );
+		void Unmap( SMemoryAllocation *pAllocation );
+		VkResult Flush( SMemoryAllocation *pAllocation, VkDeviceSize unOffset = 0, VkDeviceSize unSize = VK_WHOLE_SIZE );
+
+		// Returns cached size class slots to their blocks and releases empty blocks
+		void Trim();
+
+		void GetStats( SMemoryStats &outTotal, std::vector< SMemoryStats > *pOutPerMemoryType = nullptr );
+		void LogStats();
+
+		// Per heap usage and budget, from VK_EXT_memory_budget if the device supports it (CVulkan enables it when available)
+		void GetHeapBudgets( std::vector< SMemoryHeapBudget > &outBudgets );
+		void LogHeapBudgets();
+
+		// Highest usage / budget ratio across device local heaps
+		float GetDeviceLocalBudgetUsage();
+		bool IsMemoryBudgetSupported() { return m_bMemoryBudgetSupported; }
+
+		uint32_t FindMemoryType( VkMemoryPropertyFlags memPropFlags, uint32_t unBits );
+		bool IsHostVisible( uint32_t unMemoryTypeIndex ) { return m_vkMemoryProperties.memoryTypes[ unMemoryTypeIndex ].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT; }
+		bool IsHostCoherent( uint32_t unMemoryTypeIndex ) { return m_vkMemoryProperties.memoryTypes[ unMemoryTypeIndex ].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT; }
+
+		VkDevice GetDevice() { return m_vkDevice; }
+		VkDeviceSize GetBlockSize( uint32_t unMemoryTypeIndex );
+		const VkPhysicalDeviceMemoryProperties &GetMemoryProperties() { return m_vkMemoryProperties; }
+
+	  private:
+		struct SMemoryPool
+		{
+			std::vector< SMemoryBlock * > blocks;
+			std::array< std::vector< std::pair< SMemoryBlock *, VkDeviceSize > >, k_unSizeClassCount > sizeClassCache;
+		};
+
+		VkDevice m_vkDevice = VK_NULL_HANDLE;
+		VkPhysicalDevice m_vkPhysicalDevice = VK_NULL_HANDLE;
+		VkPhysicalDeviceMemoryProperties m_vkMemoryProperties {};
+		VkDeviceSize m_unNonCoherentAtomSize = 1;
+		VkDeviceSize m_unBlockSize = k_unDefaultMemoryBlockSize;
+		uint32_t m_unMaxAllocationCount = 4096;
+		bool m_bMemoryBudgetSupported = false;
+		std::vector< VkDeviceSize > m_vecHeapBytes;
+
+		std::vector< SMemoryPool > m_vecPools;
+		uint32_t m_unDeviceAllocationCount = 0;
+		uint32_t m_unDedicatedAllocationCount = 0;
+		VkDeviceSize m_unDedicatedBytes = 0;
+
+		std::recursive_mutex m_mutex;
+
+		static std::mutex s_registryMutex;
+		static std::unordered_map< VkDevice, CDeviceMemoryAllocator * > s_registry;
+
+		SMemoryPool &GetPool( uint32_t unMemoryTypeIndex, EAllocationKind kind ) { return m_vecPools[ unMemoryTypeIndex * (uint32_t) EAllocationKind::EMax + (uint32_t) kind ]; }
+
+		VkResult AllocateDedicated( SMemoryAllocation *pAllocation, VkDeviceSize unSize, const void *pAllocateNext );
+		SMemoryBlock *CreateBlock( uint32_t unMemoryTypeIndex, EAllocationKind kind, VkDeviceSize unSize );
+		void ReleaseBlock( SMemoryPool &pool, SMemoryBlock *pBlock );
+
+		bool AllocateFromBlock( SMemoryBlock *pBlock, VkDeviceSize unSize, VkDeviceSize unAlignment, VkDeviceSize &outOffset );
+		bool AllocateFromPool( SMemoryPool &pool, SMemoryAllocation *pAllocation );
+		void InsertFreeRange( SMemoryBlock *pBlock, VkDeviceSize unOffset, VkDeviceSize unSize );
+		void EraseFreeRange( SMemoryBlock *pBlock, VkDeviceSize unOffset, VkDeviceSize unSize );
+
+		void TrackHeapBytes( uint32_t unMemoryTypeIndex, VkDeviceSize unSize, bool bAdd );
+
+		static int32_t GetSizeClass( VkDeviceSize unSize, VkDeviceSize unAlignment );
+		static VkDeviceSize GetSizeClassBytes( int32_t nSizeClass ) { return k_unMinSizeClass << nSizeClass; }
+		static VkDeviceSize AlignUp( VkDeviceSize unValue, VkDeviceSize unAlignment ) { return ( unValue + unAlignment - 1 ) / unAlignment * unAlignment; }
+	};
+
+} // namespace xrlib
@@ -0,0 +1,177 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <xrlib/common.hpp>
+
+namespace xrlib
+{
+	class CThreadPool;
+	class CRenderModel;
+	class CSceneGraph;
+
+	enum class EAnimationPath : uint8_t
+	{
+		Translation = 0,
+		Rotation = 1,
+		Scale = 2,
+		Weights = 3 // of the morph targets of the node's mesh (see CRenderModel::morphTargets)
+	};
+
+	enum class EAnimationInterpolation : uint8_t
+	{
+		Linear = 0,		// slerp for rotations
+		Step = 1,
+		CubicSpline = 2 // hermite, each key stores in tangent, value, out tangent
+	};
+
+	// Key times, shared by all samplers keyed at the same times (exporters usually key a whole clip at once)
+	struct SAnimationTrack
+	{
+		uint32_t firstKey = 0; // in SAnimationClip::times
+		uint32_t keyCount = 0;
+	};
+
+	struct SAnimationSampler
+	{
+		uint32_t track = 0;
+		uint32_t firstValue = 0; // in SAnimationClip::values, keyCount * components floats (three times that for cubic splines)
+		uint16_t components = 3; // 3 for translation and scale, 4 for rotation, one per morph target for weights
+		EAnimationInterpolation interpolation = EAnimationInterpolation::Linear;
+		EAnimationPath path = EAnimationPath::Translation; // of the channels using the sampler
+	};
+
+	struct SAnimationChannel
+	{
+		uint32_t sampler = 0;
+		uint32_t node = 0; // in the model's scene graph
+		EAnimationPath path = EAnimationPath::Translation;
+	};
+
+	// Keyframes of all samplers in two flat arrays, times in seconds
+	struct SAnimationClip
+	{
+		std::string name;
+		float duration = 0.f;
+
+		std::vector< float > times;
+		std::vector< float > values;
+		std::vector< SAnimationTrack > tracks;
+		std::vector< SAnimationSampler > samplers;
+		std::vector< SAnimationChannel > channels;
+	};
+
+	// Keys of a track around a point in time, next == key outside of the track's keys (the first or last value is held)
+	struct SAnimationKeySpan
+	{
+		uint32_t key = 0;
+		uint32_t next = 0;
+		float t = 0.f;	   // from key to next
+		float delta = 0.f; // seconds from key to next
+	};
+
+	// unCursor is the key found by the previous call - it and the one after are tried before a binary search, so playback is O(1) per frame
+	SAnimationKeySpan FindAnimationKeys( const SAnimationClip &clip, const SAnimationTrack &track, float fTime, uint32_t &unCursor );
+
+	// Value of a sampler between the keys of its track to pOut (sampler.components floats)
+	void SampleAnimation( const SAnimationClip &clip, const SAnimationSampler &sampler, const SAnimationKeySpan &span, float *pOut );
+
+	// Handle of a CAnimator::Play() call - time, speed, weight and loop can be changed at any time (from the thread calling Update())
+	struct SAnimationPlayback
+	{
+		uint32_t clip = 0; // in CRenderModel::animations
+		float time = 0.f;
+		float speed = 1.f;
+		float weight = 1.f; // blended against the model's other playbacks and, below a total of 1, its rest pose
+		bool loop = true;
+		bool finished = false; // non looping playbacks hold their last pose until stopped
+
+		// Internal - key cursors, per track
+		std::vector< uint32_t > cursors;
+	};
+
+	// Plays glTF animations (see CGltf) on render models. Update() evaluates every playing clip, blends the clips of each model by weight
+	// and writes the result to the animated nodes of the model's scene graph and its animated morph weights, then updates the scene graph
+	// and the joint matrices of its skins.
+	// Models are evaluated in batches on a thread pool if one is given.
+	class CAnimator
+	{
+	  public:
+		// Playbacks of a model blend in the order they were started. The model must stay alive until its playbacks are stopped.
+		std::shared_ptr< SAnimationPlayback > Play( CRenderModel *pModel, uint32_t unClip, float fWeight = 1.f, bool bLoop = true, float fSpeed = 1.f );
+		std::shared_ptr< SAnimationPlayback > Play( CRenderModel *pModel, const std::string &sClip, float fWeight = 1.f, bool bLoop = true, float fSpeed = 1.f );
+
+		// Stopping a model's last playback leaves its nodes in the last evaluated pose
+		void Stop( const std::shared_ptr< SAnimationPlayback > &pPlayback );
+		void StopAll( CRenderModel *pModel );
+		void Clear();
+
+		// Call once per frame, before the models are drawn and not while they are being drawn - the render thread reads their scene graphs
+		void Update( float fDeltaSeconds, CThreadPool *pThreadPool = nullptr );
+
+		uint32_t GetModelCount() { return static_cast< uint32_t >( m_vecModels.size() ); }
+
+		// Models per thread pool job
+		uint32_t batchSize = 16;
+
+	  private:
+		// Weighted sums of the values sampled for a node, four floats each so they blend as one SIMD register.
+		// Lane 3 of translation and scale carries their total weight.
+		struct SNodeBlend
+		{
+			float translation[ 4 ] = {};
+			float rotation[ 4 ] = {};
+			float scale[ 4 ] = {};
+			float rotationWeight = 0.f;
+			uint32_t stamp = 0; // update that last wrote the sums
+		};
+
+		struct SAnimatedModel
+		{
+			CRenderModel *pModel = nullptr;
+			std::vector< std::shared_ptr< SAnimationPlayback > > playbacks;
+
+			// Pose the nodes had when the model started playing, blended in where the playbacks' weights add up to less than 1
+			std::vector< XrVector3f > restTranslations;
+			std::vector< XrQuaternionf > restRotations;
+			std::vector< XrVector3f > restScales;
+
+			// Blend accumulators per node and the nodes written this update, sums with an older stamp are stale
+			std::vector< SNodeBlend > blends;
+			std::vector< uint32_t > animatedNodes;
+			uint32_t stamp = 0;
+			std::vector< SAnimationKeySpan > spans; // per track of the playback being evaluated
+			std::vector< float > values;			// sampled values of the channel being evaluated
+
+			// The same for the morph weights, per morph target - and the first morph target of each node, -1 if its mesh has none
+			std::vector< float > restMorphWeights;
+			std::vector< float > morphWeights;
+			std::vector< float > morphBlendWeights; // total weight of the playbacks animating the target
+			std::vector< uint32_t > animatedMorphTargets;
+			std::vector< int32_t > nodeMorphTargets;
+		};
+
+		std::vector< SAnimatedModel > m_vecModels;
+
+		SAnimatedModel *FindModel( CRenderModel *pModel );
+		static void CaptureRestPose( SAnimatedModel &model );
+		static void EvaluateModel( SAnimatedModel &model );
+	};
+
+} // namespace xrlib
@@ -0,0 +1,89 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <xrvk/gltf.hpp>
+#include <xrvk/mesh.hpp>
+#include <xrvk/texture.hpp>
+
+namespace xrlib
+{
+	// Reference counted cache of loaded models, keyed by path and content hash. The first acquire of a file loads
+	// a prototype model (geometry, textures and material descriptor sets), every acquire then shares those with the
+	// caller's model, which only owns its instances and instance buffer.
+	class CAssetCache
+	{
+	  public:
+		// Fills a new prototype - parse, InitBuffers() and LoadMaterial(), the cache never draws it
+		using FnLoadModel = std::function< bool( CRenderModel *pPrototype ) >;
+
+		CAssetCache( CSession *pSession, CRenderInfo *pRenderInfo, CTextureManager *pTextureManager );
+		~CAssetCache();
+
+		// Shares the cached model for sFilename with outRenderModel, loading it with fnLoad on a miss or if the file contents changed.
+		// Shared models aren't evictable (see CResidencyManager), as other models draw from the same resources.
+		bool Acquire( CRenderModel *outRenderModel, const std::string &sFilename, const FnLoadModel &fnLoad );
+
+		// Acquire with the default gltf load - the scale is applied to the instances of outRenderModel. Material sets are freed with the
+		// entry, so the pool needs VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT (the pbr pipeline's material pool has it).
+		bool AcquireGltf(
+			CRenderModel *outRenderModel,
+			CGltf *pGltf,
+			VkCommandPool commandPool,
+			const std::string &sFilename,
+			uint32_t materialLayoutId,
+			uint32_t materialPoolId,
+			XrVector3f scale = { 1.f, 1.f, 1.f } );
+
+		// Call before deleting a model filled by Acquire and once it is no longer referenced by frames in flight.
+		// The cached resources are destroyed with the last reference.
+		void Release( CRenderModel *pRenderModel );
+
+		uint32_t GetEntryCount();
+		uint32_t GetReferenceCount( const std::string &sFilename );
+
+	  private:
+		struct SAssetEntry
+		{
+			std::string path;
+			uint64_t contentHash = 0;
+			uintmax_t fileSize = 0;
+			int64_t writeTime = 0;
+
+			CRenderModel *pPrototype = nullptr;
+			uint32_t refCount = 0;
+		};
+
+		CSession *m_pSession = nullptr;
+		CRenderInfo *m_pRenderInfo = nullptr;
+		CTextureManager *m_pTextureManager = nullptr;
+
+		// Current entry per path - entries of older file contents stay alive through their users
+		std::unordered_map< std::string, SAssetEntry * > m_entries;
+		std::unordered_map< CRenderModel *, SAssetEntry * > m_users;
+
+		std::recursive_mutex m_mutex;
+
+		void DestroyEntry( SAssetEntry *pEntry );
+
+		// False if the file can't be read directly (e.g. android assets), entries are then keyed by path only
+		static bool ReadFileStamp( const std::string &sFilename, uintmax_t &outSize, int64_t &outWriteTime );
+	};
+
+} // namespace xrlib
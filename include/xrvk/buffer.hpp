@@ -15,6 +15,8 @@
 
 #include <xrlib/session.hpp>
 #include <xrlib/vulkan.hpp>
+#include <xrvk/allocator.hpp>
+#include <xrvk/upload.hpp>
 
 namespace xrlib
 {
@@ -31,6 +33,10 @@ namespace xrlib
 		VkResult FlushMemory( VkDeviceSize unSize = VK_WHOLE_SIZE, VkDeviceSize unOffset = 0, uint32_t unRangeCount = 1 );
 		VkResult MapMemory();
 		void UnmapMemory();
+
+		// Copies data into the buffer - directly if it's host visible, otherwise queued on the upload manager (visible to draws after its next Update)
+		VkResult Upload( const void *pData, VkDeviceSize unSize, VkDeviceSize unOffset = 0 );
+		bool IsHostVisible();
 		
 		VkPhysicalDevice GetPhysicalDevice();
 		VkDevice GetLogicalDevice();
@@ -38,14 +44,17 @@ namespace xrlib
 		inline VkBuffer GetVkBuffer() { return m_vkBufferInfo.buffer; }
 		inline VkBuffer *GetVkBufferPtr() { return &m_vkBufferInfo.buffer; };
 		inline VkDescriptorBufferInfo *GetBufferInfo() { return &m_vkBufferInfo; }
-		inline VkDeviceMemory GetDeviceMemory() { return m_vkDeviceMemory; }
+		inline VkDeviceMemory GetDeviceMemory() { return m_pAllocation ? m_pAllocation->memory : VK_NULL_HANDLE; }
+		inline VkDeviceSize GetMemoryOffset() { return m_pAllocation ? m_pAllocation->offset : 0; }
+		inline SMemoryAllocation *GetAllocation() { return m_pAllocation; }
 		inline void *GetMappedData() { return m_pData; }
 
 	  private:
 		CSession *m_pSession = nullptr;
 
 		VkDescriptorBufferInfo m_vkBufferInfo { VK_NULL_HANDLE, 0, 0 };
-		VkDeviceMemory m_vkDeviceMemory = VK_NULL_HANDLE;
+		SMemoryAllocation *m_pAllocation = nullptr;
+		bool m_bHasQueuedUploads = false;
 		VkDeviceSize m_vkMemoryAlignment = 0;
 		VkDeviceSize m_vkMemorySize = VK_WHOLE_SIZE;
 
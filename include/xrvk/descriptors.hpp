@@ -43,7 +43,7 @@ namespace xrlib
 
 		// Creation methods with output IDs
 		VkResult CreateDescriptorSetLayout( uint32_t &outLayoutId, const std::vector< SDescriptorBinding > &bindings, VkAllocationCallbacks *pCallbacks = nullptr );
-		VkResult CreateDescriptorPool( uint32_t &outPoolId, uint32_t layoutId, uint32_t unSetCount = 1, VkAllocationCallbacks *pCallbacks = nullptr );
+		VkResult CreateDescriptorPool( uint32_t &outPoolId, uint32_t layoutId, uint32_t unSetCount = 1, VkDescriptorPoolCreateFlags flags = 0, VkAllocationCallbacks *pCallbacks = nullptr );
 		VkResult CreateDescriptorPool( uint32_t &outPoolId, const VkDescriptorPoolCreateInfo &poolInfo, VkAllocationCallbacks *pCallbacks = nullptr );
 		VkResult CreateDescriptorSets( std::vector< VkDescriptorSet > &outDescriptorSets, uint32_t layoutId, uint32_t poolId, uint32_t unSetCount = 1, VkAllocationCallbacks *pCallbacks = nullptr );
 		VkResult CreateDescriptorSets( uint32_t &outPoolId, uint32_t layoutId, uint32_t unSetCount, VkAllocationCallbacks *pCallbacks = nullptr );
@@ -66,6 +66,10 @@ namespace xrlib
 		void DeletePool( uint32_t poolId );
 		void DeleteDescriptorSet( uint32_t layoutId, const VkDescriptorSet &descriptorSet );
 		void DeleteDescriptorSets( uint32_t layoutId, const std::vector< VkDescriptorSet > &descriptorSets );
+
+		// Returns sets allocated with CreateDescriptorSets( outDescriptorSets, layoutId, poolId ) to their pool and clears descriptorSets.
+		// Only pools created with VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT can take sets back, returns false for others.
+		bool FreeDescriptorSets( uint32_t poolId, std::vector< VkDescriptorSet > &descriptorSets );
 		void DeleteBuffer( uint32_t bufferId );
 		void DeleteAll();
 
@@ -97,6 +101,7 @@ namespace xrlib
 
 		std::unordered_map< uint32_t, VkDescriptorSetLayout > m_descriptorSetLayouts;
 		std::unordered_map< uint32_t, VkDescriptorPool > m_descriptorPools;
+		std::unordered_map< uint32_t, VkDescriptorPoolCreateFlags > m_descriptorPoolFlags;
 		std::unordered_map< uint32_t, std::vector< VkDescriptorSet > > m_descriptorSets;
 		std::unordered_map< uint32_t, std::vector< SDescriptorBinding > > m_layoutBindings;
 		std::unordered_map< uint32_t, std::unique_ptr< CDeviceBuffer > > m_buffers;
@@ -0,0 +1,157 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#pragma once
+
+#include <array>
+#include <deque>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <xrvk/buffer.hpp>
+
+namespace xrlib
+{
+	static constexpr VkDeviceSize k_unDefaultGeometryArenaVertexBytes = 64ull * 1024 * 1024; // Attribute stream bytes per arena (positions get a matching buffer if split)
+	static constexpr VkDeviceSize k_unDefaultGeometryArenaIndexBytes = 16ull * 1024 * 1024;	 // Per index type, created on first use
+	static constexpr uint64_t k_unGeometryFreeDelayFrames = 8;								 // Freed ranges are reused after this many frames (must exceed the frames in flight)
+
+	struct SGeometryAllocation
+	{
+		uint32_t arena = std::numeric_limits< uint32_t >::max();
+		uint32_t firstVertex = 0; // vertexOffset of draws
+		uint32_t vertexCount = 0;
+		uint32_t firstIndex = 0; // added to the firstIndex of draws
+		uint32_t indexCount = 0;
+		VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+
+		bool IsValid() const { return arena != std::numeric_limits< uint32_t >::max(); }
+	};
+
+	struct SGeometryPoolStats
+	{
+		uint32_t arenaCount = 0;
+		uint32_t allocationCount = 0;
+
+		VkDeviceSize vertexBytes = 0;
+		VkDeviceSize usedVertexBytes = 0;
+		VkDeviceSize indexBytes = 0;
+		VkDeviceSize usedIndexBytes = 0;
+	};
+
+	// Large device local vertex and index buffers shared by static models. Arenas are grouped by vertex stride (and split positions),
+	// each model gets a vertex and an index range in one arena, so consecutive models in an arena draw without rebinding buffers.
+	// Arenas never grow, a new one is created once the existing ones are full - recorded binds stay valid.
+	class CGeometryPool
+	{
+	  public:
+		CGeometryPool( CSession *pSession, VkDeviceSize unArenaVertexBytes = k_unDefaultGeometryArenaVertexBytes, VkDeviceSize unArenaIndexBytes = k_unDefaultGeometryArenaIndexBytes );
+		~CGeometryPool();
+
+		// pVertexData is the attribute stream (unStride bytes per vertex), pPositions is required if bSplitPositions.
+		// Index values are relative to the allocation's first vertex. Data is queued on the upload manager before this returns.
+		VkResult Allocate(
+			SGeometryAllocation &outAllocation,
+			uint32_t unStride,
+			bool bSplitPositions,
+			const void *pVertexData,
+			const XrVector3f *pPositions,
+			uint32_t unVertexCount,
+			VkIndexType indexType,
+			const void *pIndexData,
+			uint32_t unIndexCount );
+
+		// The ranges are reused after k_unGeometryFreeDelayFrames calls to Update()
+		void Free( SGeometryAllocation &allocation );
+
+		// Render thread only, once per frame
+		void Update();
+
+		// Binds the allocation's arena (index buffer, positions and attribute stream, or positions only for the depth prepass)
+		// unless it is already bound in this command buffer. Reset before recording and after anything else binds vertex or index buffers.
+		void Bind( VkCommandBuffer commandBuffer, const SGeometryAllocation &allocation, bool bDepthOnly );
+		void ResetBindings( VkCommandBuffer commandBuffer );
+
+		CDeviceBuffer *GetVertexBuffer( const SGeometryAllocation &allocation );
+		CDeviceBuffer *GetPositionBuffer( const SGeometryAllocation &allocation );
+		CDeviceBuffer *GetIndexBuffer( const SGeometryAllocation &allocation );
+		VkDeviceSize GetAllocationBytes( const SGeometryAllocation &allocation );
+
+		void GetStats( SGeometryPoolStats &outStats );
+		void LogStats();
+
+	  private:
+		// First fit over free ranges, in elements (vertices or indices)
+		struct SRangeList
+		{
+			uint32_t capacity = 0;
+			uint32_t used = 0;
+			std::map< uint32_t, uint32_t > freeByOffset;
+
+			void Init( uint32_t unCapacity );
+			bool Allocate( uint32_t unCount, uint32_t &outOffset );
+			void Free( uint32_t unOffset, uint32_t unCount );
+		};
+
+		struct SGeometryArena
+		{
+			uint32_t stride = 0;
+			bool splitPositions = false;
+
+			CDeviceBuffer *pVertexBuffer = nullptr;
+			CDeviceBuffer *pPositionBuffer = nullptr;
+			SRangeList vertexRanges;
+
+			// uint16 and uint32
+			std::array< CDeviceBuffer *, 2 > indexBuffers = { nullptr, nullptr };
+			std::array< SRangeList, 2 > indexRanges;
+		};
+
+		struct SPendingFree
+		{
+			SGeometryAllocation allocation;
+			uint64_t frame = 0;
+		};
+
+		struct SBinding
+		{
+			uint32_t arena = std::numeric_limits< uint32_t >::max();
+			VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+			bool depthOnly = false;
+		};
+
+		CSession *m_pSession = nullptr;
+		VkDeviceSize m_unArenaVertexBytes = k_unDefaultGeometryArenaVertexBytes;
+		VkDeviceSize m_unArenaIndexBytes = k_unDefaultGeometryArenaIndexBytes;
+
+		std::vector< SGeometryArena * > m_vecArenas;
+		std::deque< SPendingFree > m_pendingFrees;
+		uint32_t m_unAllocationCount = 0;
+		uint64_t m_unFrame = 0;
+
+		std::unordered_map< VkCommandBuffer, SBinding > m_bindings;
+
+		std::mutex m_mutex;
+
+		VkResult CreateArena( uint32_t &outArena, uint32_t unStride, bool bSplitPositions, uint32_t unVertexCapacity );
+		VkResult CreateIndexBuffer( SGeometryArena *pArena, uint32_t unTypeIndex, uint32_t unIndexCapacity );
+		void Release( const SGeometryAllocation &allocation );
+
+		static uint32_t GetIndexTypeIndex( VkIndexType indexType ) { return indexType == VK_INDEX_TYPE_UINT16 ? 0 : 1; }
+		static uint32_t GetIndexSize( VkIndexType indexType ) { return indexType == VK_INDEX_TYPE_UINT16 ? sizeof( uint16_t ) : sizeof( uint32_t ); }
+	};
+
+} // namespace xrlib
@@ -16,9 +16,15 @@
 #include <xrlib/session.hpp>
 #include <xrvk/buffer.hpp>
 #include <xrvk/mesh.hpp>
+#include <xrvk/meshopt.hpp>
 
-#include <unordered_map>
+#include <atomic>
+#include <deque>
 #include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 // Forward declare tinygltf classes
 namespace tinygltf
@@ -30,11 +36,50 @@ namespace tinygltf
 	class Texture;
 	class Material;
 	class Skin;
+	class Animation;
 } // namespace tinygltf
 
 using namespace tinygltf;
 namespace xrlib
 {
+	class CThreadPool;
+
+	static constexpr uint64_t k_unReplacedMaterialDelayFrames = 8; // Textures and material sets replaced by async loads are destroyed after this many frames (must exceed the frames in flight)
+
+	enum class EModelLoadState
+	{
+		Queued = 0,		// waiting for a worker
+		Loading = 1,	// parse, image decode and buffer creation on a worker
+		Uploading = 2,	// waiting for the transfer queue
+		Ready = 3,		// swapped into the target model
+		Failed = 4,
+		Cancelled = 5
+	};
+
+	// Handle of a CGltf::LoadAsync() request - fields other than priority and cancelled belong to the loader
+	struct SModelLoadRequest
+	{
+		std::string filename;
+		XrVector3f scale = { 1.f, 1.f, 1.f };
+		bool showWhenReady = true; // sets isVisible on the target once the model is swapped in
+
+		std::atomic< float > priority { 0.f };	 // queued requests with lower values are loaded first (e.g. distance to the viewer)
+		std::atomic< bool > cancelled { false };
+		std::atomic< EModelLoadState > state { EModelLoadState::Queued };
+
+		// Resolves to true once the model is swapped in, false if it failed or was cancelled
+		std::shared_future< bool > future;
+
+		// Internal
+		CRenderModel *pTarget = nullptr;
+		CRenderModel *pStaging = nullptr;
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		std::shared_future< void > uploadFuture;
+		std::promise< bool > promise;
+
+		bool IsDone() const { return state >= EModelLoadState::Ready; }
+	};
+
 	static void inline ExtractEulerAngles( const XrMatrix4x4f &matrix, float &pitch, float &yaw, float &roll )
 	{
 		// Extract pitch (X rotation)
@@ -94,6 +139,7 @@ namespace xrlib
 	class CGltf
 	{
 	  public:
+		// pSession may be null for offline imports (see xrlib_import), textures then only keep their pixels
 		CGltf( CSession *pSession );
 		~CGltf();
 
@@ -101,26 +147,131 @@ namespace xrlib
 		bool LoadFromDisk( CRenderModel *outRenderModel, tinygltf::Model *outModel, const std::string &sFilename, XrVector3f scale = { 1.f, 1.f, 1.f } );
 		void ParseModel( CRenderModel *outRenderModel, tinygltf::Model *pModel, VkCommandPool commandPool );
 
+		// Creates (and hands ownership of) the model for an instanced mesh, e.g. with the main model's pipeline. Returning null bakes the mesh instead.
+		using FnCreateModel = std::function< CRenderModel *( const std::string &sMeshName ) >;
+
+		// As LoadAndParse(), but node transforms are applied and meshes placed at least instancingThreshold times (or by EXT_mesh_gpu_instancing)
+		// are imported once into a model from fnCreateModel, with one instance per placement. The rest is baked into outRenderModel.
+		// Instances are relative to the model's origin (scale applied). Instanced models use outRenderModel's textures (handles only),
+		// so it must not be evicted while they are drawn. Skinned meshes are never instanced, morph targets aren't imported.
+		bool LoadInstanced( 
+			CRenderModel *outRenderModel, 
+			std::vector< CRenderModel * > &outInstancedModels, 
+			const FnCreateModel &fnCreateModel, 
+			VkCommandPool commandPool, 
+			const std::string &sFilename, 
+			XrVector3f scale = { 1.f, 1.f, 1.f } );
+
+		// Loads sCacheFile if it was made from the current contents of sFilename with the current import settings, otherwise
+		// imports sFilename and writes the cache for the next run. Cached textures are uploaded straight from the mapped file.
+		bool LoadCached( CRenderModel *outRenderModel, VkCommandPool commandPool, const std::string &sFilename, const std::string &sCacheFile, XrVector3f scale = { 1.f, 1.f, 1.f } );
+
+		// Contents of sFilename combined with the settings that change the parsed model, 0 if the file can't be read directly.
+		// External buffers and images of a .gltf aren't included - prefer .glb for cached models.
+		uint64_t GetImportHash( const std::string &sFilename );
+
+		// Streaming - parse, image decode and buffer creation run on pThreadPool, textures and geometry go through the upload manager.
+		// The target keeps drawing what it has (a proxy, or nothing if it's invisible) until UpdateAsyncLoads() swaps the new model in.
+		// Geometry settings (vertexFormat, allowIndex16, geometryPool) are taken from the target when the request is made.
+		// The target must outlive the request, or cancel it and call UpdateAsyncLoads() before it's destroyed.
+		std::shared_ptr< SModelLoadRequest > LoadAsync(
+			CRenderModel *outRenderModel,
+			CThreadPool *pThreadPool,
+			VkCommandPool commandPool,
+			const std::string &sFilename,
+			float fPriority = 0.f,
+			XrVector3f scale = { 1.f, 1.f, 1.f } );
+
+		// Called on the thread that owns the target models (usually the render thread) after the model is swapped in and before it's shown,
+		// e.g. to LoadMaterial() - descriptor sets aren't created on workers
+		using FnModelReady = std::function< void( CRenderModel *pModel ) >;
+
+		// Call once per frame - swaps in models whose uploads are done and cleans up cancelled ones. Returns the number of models swapped in.
+		// What the targets had before (e.g. a textured proxy) is destroyed k_unReplacedMaterialDelayFrames calls later, material descriptor
+		// sets through pDescriptors (their pool needs VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT, otherwise they stay allocated).
+		uint32_t UpdateAsyncLoads( const FnModelReady &fnReady = nullptr, CDescriptorManager *pDescriptors = nullptr );
+
+		// Cancelled requests are dropped at the next step that checks for it (before and after parsing, or in UpdateAsyncLoads())
+		void CancelLoad( const std::shared_ptr< SModelLoadRequest > &pRequest );
+		void CancelAllLoads();
+
+		// Sets the priority of every queued request to the distance of its target's first instance from the viewer
+		void UpdateLoadPriorities( const XrVector3f &viewerPosition );
+
+		size_t GetPendingLoadCount();
+
+		// If set, images are decoded on this pool (one job per image, the loading thread takes jobs too) after tinygltf has read the file,
+		// instead of one after the other inside tinygltf's image callback
+		CThreadPool *imageDecodePool = nullptr;
+
+		// Applied to the mesh data of every model parsed by this loader, after all nodes are processed
+		SMeshOptimizeSettings meshOptimization {};
+		SMeshLodSettings lodGeneration {};
+
+		// Sections keep their glTF node and are drawn with its world transform from CRenderModel::sceneGraph, so parts (a door, a lever)
+		// can be moved at runtime. Off flattens the nodes and ignores their transforms. The scene graph is filled either way.
+		bool movableNodes = false;
+
+		// Placements of the same mesh from which LoadInstanced() draws it instanced, 0 only instances EXT_mesh_gpu_instancing nodes
+		uint32_t instancingThreshold = 2;
+
 	  private:
 		CSession *m_pSession = nullptr;
 
-		// Helper functions to process gltf data
+		// Async loads - queued ones are picked by priority when a worker becomes free, the rest wait for their uploads
+		std::vector< std::shared_ptr< SModelLoadRequest > > m_vecQueuedLoads;
+		std::vector< std::shared_ptr< SModelLoadRequest > > m_vecActiveLoads;
+		std::mutex m_loadMutex;
+		std::atomic< uint32_t > m_unLoadTasks { 0 }; // submitted to the thread pool and not finished yet
+
+		// Contents of targets replaced by swapped in models, oldest first
+		std::deque< SReplacedMaterials > m_replacedMaterials;
+		uint64_t m_unFrame = 0;
+
+		void ProcessNextLoad();
+		void FinishLoad( const std::shared_ptr< SModelLoadRequest > &pRequest, EModelLoadState state );
+		void DestroyTextures( std::vector< STexture > &textures );
+		void DestroyReplacedMaterials( SReplacedMaterials &replaced, CDescriptorManager *pDescriptors );
+
+		// Parses a mapped .glb / .gltf (or apk asset), so only the bin chunk is copied (into the model's buffers) rather than the whole file first.
+		// Meshopt fallback buffers without a uri (which tinygltf rejects) get a placeholder, their views are decoded from the compressed data instead.
+		bool LoadMapped( tinygltf::TinyGLTF *pGltfLoader, tinygltf::Model *outModel, std::string &sError, std::string &sWarn, const std::string &sFilename, bool bBinary );
+
+		// Decodes images tinygltf skipped (buffer views, or the encoded copies kept by the deferred image callback, by image index)
+		void DecodeImages( tinygltf::Model &model, std::vector< std::vector< unsigned char > > &encodedImages );
+
+		void OptimizeMeshData( CRenderModel *outRenderModel );
+
+		// Helper functions to process gltf data - ProcessScene() fills the mesh data, scene graph and animations from the first scene (after the skins are parsed)
+		void ProcessScene( CRenderModel *outRenderModel, const tinygltf::Model &model );
+
+		// sceneNodes gets the scene graph node of each glTF node
 		void ProcessNode( 
 			const tinygltf::Model &model, 
 			const tinygltf::Node &node, 
 			std::vector< SMeshVertex > &vertices, 
 			std::vector< uint32_t > &indices, 
-			std::vector< SMeshSection > &materialSections );
-
+			std::vector< SMeshSection > &materialSections,
+			std::vector< SMorphTarget > &morphTargets,
+			std::vector< SMorphDelta > &morphDeltas,
+			CSceneGraph &sceneGraph,
+			int32_t nParent,
+			std::vector< int32_t > &sceneNodes );
+
+		// Morph targets (one per target of the mesh, with its deltas in vertex order) are only imported if pMorphTargets and pMorphDeltas are set
 		void ProcessMesh( 
 			const tinygltf::Model &model, 
 			const tinygltf::Mesh &mesh, 
 			std::vector< SMeshVertex > &vertices, 
 			std::vector< uint32_t > &indices, 
-			std::vector< SMeshSection > &materialSections );
-
-		void ParseTextures( CRenderModel *outRenderModel, VkCommandPool commandPool, const tinygltf::Model &model );
-		void ParseTexture( STexture *outTexture, VkCommandPool commandPool, const tinygltf::Model &model, const tinygltf::Texture &gltfTexture );
+			std::vector< SMeshSection > &materialSections,
+			std::vector< SMorphTarget > *pMorphTargets = nullptr,
+			std::vector< SMorphDelta > *pMorphDeltas = nullptr );
+
+		// Decoded pixels are moved out of the model's images instead of copied if bTakeImageData is set
+		void ParseTextures( CRenderModel *outRenderModel, VkCommandPool commandPool, tinygltf::Model &model, bool bTakeImageData = false );
+		void ParseTexture( STexture *outTexture, VkCommandPool commandPool, tinygltf::Model &model, const tinygltf::Texture &gltfTexture, bool bTakeImageData );
+		void CreateTextureResources( STexture *outTexture, const void *pPixels, VkDeviceSize unSize );
 		void IdentifyTextureTypes( std::vector< STexture > &textures, const tinygltf::Model &model );
 
 		void ParseMaterials( CRenderModel *outRenderModel, const tinygltf::Model &model );
@@ -129,6 +280,10 @@ namespace xrlib
 		void ParseSkins( CRenderModel *outRenderModel, const tinygltf::Model &model );
 		void ParseSkin( SSkin *outSkin, const tinygltf::Model &model, const tinygltf::Skin &gltfSkin );
 
+		// Translation, rotation, scale and morph weight channels of nodes in the scene, in the format CAnimator plays
+		void ParseAnimations( CRenderModel *outRenderModel, const tinygltf::Model &model, const std::vector< int32_t > &sceneNodes );
+		void ParseAnimation( SAnimationClip *outClip, const tinygltf::Model &model, const tinygltf::Animation &gltfAnimation, const std::vector< int32_t > &sceneNodes );
+
 		VkFilter ConvertMagFilter( int gltfFilter );
 		VkFilter ConvertMinFilter( int gltfFilter );
 		VkSamplerAddressMode ConvertWrappingMode( int gltfWrap );
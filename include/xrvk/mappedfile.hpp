@@ -0,0 +1,64 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <xrlib/common.hpp>
+
+namespace xrlib
+{
+	// Read only view of a whole file, mapped instead of read so large assets are never copied into heap memory
+	class CMappedFile
+	{
+	  public:
+		CMappedFile() = default;
+		~CMappedFile();
+
+		CMappedFile( const CMappedFile & ) = delete;
+		CMappedFile &operator=( const CMappedFile & ) = delete;
+
+		// False if the file doesn't exist, is empty or can't be mapped
+		bool Open( const std::string &sFilename );
+
+		#ifdef XR_USE_PLATFORM_ANDROID
+			// Apk assets - uncompressed assets are mapped, compressed ones are inflated into a buffer owned by the asset
+			bool Open( AAssetManager *pAssetManager, const std::string &sFilename );
+		#endif
+
+		void Close();
+
+		bool IsOpen() const { return m_pData != nullptr; }
+		const uint8_t *GetData() const { return m_pData; }
+		size_t GetSize() const { return m_unSize; }
+
+	  private:
+		const uint8_t *m_pData = nullptr;
+		size_t m_unSize = 0;
+
+		#ifdef _WIN32
+			void *m_hFile = nullptr;
+			void *m_hMapping = nullptr;
+		#else
+			int m_nFile = -1;
+		#endif
+
+		#ifdef XR_USE_PLATFORM_ANDROID
+			AAsset *m_pAsset = nullptr;
+		#endif
+	};
+
+} // namespace xrlib
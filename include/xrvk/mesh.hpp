@@ -23,7 +23,10 @@
 #include <cfloat>
 #include <functional>
 
+#include <xrvk/animation.hpp>
+#include <xrvk/geometrypool.hpp>
 #include <xrvk/renderables.hpp>
+#include <xrvk/scenegraph.hpp>
 #include <xrvk/texture.hpp>
 
 namespace xrlib
@@ -51,6 +54,47 @@ namespace xrlib
 		float weights[ JOINT_INFLUENCE_COUNT ] = { 0.0f, 0.0f, 0.0f, 0.0f };
 	};
 
+	// Optional vertex attributes
+	static constexpr uint32_t VERTEX_UV1_BIT = 0x01u;
+	static constexpr uint32_t VERTEX_COLOR0_BIT = 0x02u;
+	static constexpr uint32_t VERTEX_SKIN_BIT = 0x04u; // joints and weights
+	static constexpr uint32_t VERTEX_OPTIONAL_ATTRIBUTES_MASK = VERTEX_UV1_BIT | VERTEX_COLOR0_BIT | VERTEX_SKIN_BIT;
+
+	enum class EVertexLayout : uint8_t
+	{
+		Full,	// SMeshVertex as is (96 bytes), all attributes present
+		Compact // position (float3), normal (octahedral snorm16x2), tangent (octahedral snorm8x2 + handedness), uv0 (half2) - 24 bytes
+				// followed by the selected optional attributes: uv1 (half2), color0 (unorm8x4), joints (uint8x4) + weights (unorm16x4)
+	};
+
+	// Gpu side vertex format of a model, the pipeline it is drawn with must be created with the same format
+	struct SVertexFormat
+	{
+		EVertexLayout layout = EVertexLayout::Full;
+		uint32_t optionalAttributes = 0; // Compact only, e.g. GetUsedVertexAttributes() of the model - the compact pbr shaders read none of them
+
+		// Positions in their own tightly packed stream (binding 0) and the remaining attributes in the next one,
+		// required for models drawn in the depth prepass
+		bool splitPositions = false;
+
+		// Stride of the attribute stream (excludes the position if split)
+		uint32_t GetStride() const;
+		uint32_t GetBindingCount() const { return splitPositions ? 2 : 1; }
+
+		// Locations match the pbr vertex shaders (position = locStart ... weights = locStart + 7), absent attributes are skipped.
+		// If positions are split, attributes other than the position use binding + 1
+		void FillAttributes( std::vector< VkVertexInputAttributeDescription > &outVecAttributes, uint32_t binding, uint32_t locStart = 0 ) const;
+
+		// Converts vertices to the attribute stream of this format, outData is left empty for the interleaved full layout (use SMeshVertex as is)
+		void Pack( std::vector< uint8_t > &outData, const std::vector< SMeshVertex > &vertices ) const;
+		void PackPositions( std::vector< XrVector3f > &outPositions, const std::vector< SMeshVertex > &vertices ) const;
+
+		bool operator==( const SVertexFormat &other ) const 
+		{ 
+			return layout == other.layout && splitPositions == other.splitPositions && ( layout == EVertexLayout::Full || optionalAttributes == other.optionalAttributes ); 
+		}
+	};
+
 	enum class EAlphaMode : uint8_t
 	{
 		Opaque, // Default, fully opaque
@@ -123,143 +167,80 @@ namespace xrlib
 		uint32_t firstIndex;
 		uint32_t indexCount;
 		uint32_t materialIndex;
+		int32_t node = -1; // scene graph node whose world transform applies to the section, -1 if none (see CRenderModel::sceneGraph)
+		int32_t skin = -1; // skin the vertices' joints index when drawn skinned, -1 uses the model's first skin
+	};
+
+	// Simplified level of detail, index ranges into the same index and vertex buffers as lod 0
+	struct SMeshLod
+	{
+		float screenSize = 0.f; // used below this projected size (fraction of the view height) of the model's bounds
+		float error = 0.f;		// simplification error, relative to the mesh extent
+		std::vector< SMeshSection > sections; // one per material section of lod 0, in the same order
+	};
+
+	// Textures, material descriptor sets and material buffer a model let go of (see CRenderModel::TakeFrom), to destroy once frames
+	// in flight are done with them. Textures that other models still use aren't included.
+	struct SReplacedMaterials
+	{
+		std::vector< STexture > textures;
+		std::vector< VkDescriptorSet > descriptorSets;
+		uint32_t descriptorPoolId = std::numeric_limits< uint32_t >::max(); // pool passed to LoadMaterial(), max if none
+		CDeviceBuffer *pMaterialBuffer = nullptr;
+		uint64_t frame = 0; // for the caller's bookkeeping
 	};
 
 	struct SSkin
 	{
 		std::string name;
 		std::vector< uint32_t > joints;
+		std::vector< int32_t > jointNodes; // scene graph node of each joint, -1 if it isn't part of the scene
 		std::vector< XrMatrix4x4f > inverseBindMatrices;
-		std::unordered_map< uint32_t, std::vector< uint32_t > > hierarchy;
+		std::unordered_map< uint32_t, std::vector< uint32_t > > hierarchy; // child joints by parent joint, call BuildHierarchy() after changing it
 		std::vector< XrMatrix4x4f > matrices;
 		int32_t skeleton = -1; // Index of the root node (if defined)
 
-		void UpdateMatrices( const std::vector< XrQuaternionf > &orientation, const std::vector< XrVector3f > &position, XrVector3f scale = { 1.0f, 1.0f, 1.0f } )
-		{
-			matrices.resize( joints.size() );
-
-			std::function< void( uint32_t jointIndex, const XrMatrix4x4f &parentWorldMatrix ) > updateJointHierarchy;
-			updateJointHierarchy = [ & ]( uint32_t jointIndex, const XrMatrix4x4f &parentWorldMatrix )
-			{
-				// Get local transform using the helper function
-				XrMatrix4x4f localMatrix;
-				XrMatrix4x4f_CreateTranslationRotationScale( &localMatrix, &position[ jointIndex ], &orientation[ jointIndex ], &scale );
-
-				// Calculate world matrix
-				XrMatrix4x4f worldMatrix;
-				XrMatrix4x4f_Multiply( &worldMatrix, &parentWorldMatrix, &localMatrix );
-
-				// Multiply with inverse bind matrix if it exists
-				if ( jointIndex < inverseBindMatrices.size() )
-				{
-					XrMatrix4x4f finalMatrix;
-					XrMatrix4x4f_Multiply( &finalMatrix, &worldMatrix, &inverseBindMatrices[ jointIndex ] );
-					matrices[ jointIndex ] = finalMatrix;
-				}
-				else
-				{
-					matrices[ jointIndex ] = worldMatrix;
-				}
-
-				// Store the result
-				matrices[ jointIndex ] = worldMatrix;
-
-				// Process children
-				auto childrenIt = hierarchy.find( jointIndex );
-				if ( childrenIt != hierarchy.end() )
-				{
-					for ( uint32_t childIndex : childrenIt->second )
-					{
-						updateJointHierarchy( childIndex, worldMatrix );
-					}
-				}
-			};
-
-			// Start recursion from root(s)
-			if ( skeleton != -1 )
-			{
-				XrMatrix4x4f identityMatrix;
-				XrMatrix4x4f_CreateIdentity( &identityMatrix );
-				updateJointHierarchy( skeleton, identityMatrix );
-			}
-			else
-			{
-				std::vector< bool > isChild( joints.size(), false );
-				for ( const auto &[ parentIdx, children ] : hierarchy )
-				{
-					for ( uint32_t childIdx : children )
-					{
-						isChild[ childIdx ] = true;
-					}
-				}
-
-				XrMatrix4x4f identityMatrix;
-				XrMatrix4x4f_CreateIdentity( &identityMatrix );
-				for ( size_t i = 0; i < joints.size(); ++i )
-				{
-					if ( !isChild[ i ] )
-					{
-						updateJointHierarchy( i, identityMatrix );
-					}
-				}
-			}
-		}
+		// Flattened hierarchy, built once at load: each joint's parent (-1 for roots) and the joints with parents before their children
+		std::vector< int32_t > parents;
+		std::vector< uint32_t > evaluationOrder;
 
-		void UpdateMatrices( const std::vector< XrPosef > &newJointPoses, XrVector3f scale = { 1.0f, 1.0f, 1.0f } )
-		{
-			std::vector< XrQuaternionf > orientation;
-			std::vector< XrVector3f > position;
+		// World matrices of the joints as of the last update (before the inverse bind matrices)
+		std::vector< XrMatrix4x4f > worldMatrices;
 
-			for ( auto &pose : newJointPoses )
-			{
-				orientation.push_back( pose.orientation );
-				position.push_back( pose.position );
-			}
+		void BuildHierarchy();
 
-			UpdateMatrices( orientation, position, scale );
-		}
+		// From local joint transforms (per joint, in joint order). Each is one forward pass over evaluationOrder, allocating only on the first update.
+		void UpdateMatrices( const XrQuaternionf *pOrientations, const XrVector3f *pPositions, XrVector3f scale = { 1.0f, 1.0f, 1.0f } );
+		void UpdateMatrices( const std::vector< XrQuaternionf > &orientation, const std::vector< XrVector3f > &position, XrVector3f scale = { 1.0f, 1.0f, 1.0f } );
+		void UpdateMatrices( const std::vector< XrPosef > &newJointPoses, XrVector3f scale = { 1.0f, 1.0f, 1.0f } );
+		void UpdateMatrices( const XrMatrix4x4f *localMatrices );
 
-		void UpdateMatrices( XrMatrix4x4f *localMatrices )
-		{
-			matrices.resize( joints.size() );
-
-			// Recursive lambda that uses the existing TRS matrices in localMatrices
-			std::function< void( uint32_t jointIndex, const XrMatrix4x4f &parentWorldMatrix ) > updateJointHierarchy;
-			updateJointHierarchy = [ & ]( uint32_t jointIndex, const XrMatrix4x4f &parentWorldMatrix )
-			{
-				// The local transform is already in localMatrices[jointIndex]
-				const XrMatrix4x4f &localMatrix = localMatrices[ jointIndex ];
-
-				// Calculate world matrix
-				XrMatrix4x4f worldMatrix;
-				XrMatrix4x4f_Multiply( &worldMatrix, &parentWorldMatrix, &localMatrix );
-
-				// Multiply with inverse bind matrix if it exists
-				if ( jointIndex < inverseBindMatrices.size() )
-				{
-					XrMatrix4x4f_Multiply( &matrices[ jointIndex ], &worldMatrix, &inverseBindMatrices[ jointIndex ] );
-				}
-				else
-				{
-					matrices[ jointIndex ] = worldMatrix;
-				}
-
-				// Process children using the calculated world matrix
-				auto childrenIt = hierarchy.find( jointIndex );
-				if ( childrenIt != hierarchy.end() )
-				{
-					for ( uint32_t childIndex : childrenIt->second )
-					{
-						updateJointHierarchy( childIndex, worldMatrix );
-					}
-				}
-			};
-
-			// Start recursion from root with identity matrix
-			XrMatrix4x4f identityMatrix;
-			XrMatrix4x4f_CreateIdentity( &identityMatrix );
-			updateJointHierarchy( 0, identityMatrix );
-		}
+		// From the world matrices of the joints' nodes (as of the scene graph's last Update()), e.g. after CAnimator wrote their poses
+		void UpdateMatrices( const CSceneGraph &sceneGraph );
+
+	  private:
+		template < typename FnLocal >
+		void Evaluate( FnLocal &&fnLocal );
+	};
+
+	// Displacement of one vertex by a morph target at weight 1, uploaded as is (10 words, see skin.comp)
+	struct SMorphDelta
+	{
+		uint32_t vertex = 0; // in the model's vertices
+		XrVector3f position = { 0.f, 0.f, 0.f };
+		XrVector3f normal = { 0.f, 0.f, 0.f };
+		XrVector3f tangent = { 0.f, 0.f, 0.f };
+	};
+
+	// Blend shape (glTF morph target) - only the vertices it moves have a delta, a range of CRenderModel::morphDeltas sorted by vertex
+	struct SMorphTarget
+	{
+		std::string name;	 // from the mesh's extras.targetNames, if the exporter wrote them
+		int32_t node = -1;	 // scene graph node of the mesh, its weights channels drive the target
+		uint32_t index = 0; // in the node's weights (the target's index in its glTF mesh)
+		uint32_t firstDelta = 0;
+		uint32_t deltaCount = 0;
+		float defaultWeight = 0.f; // the glTF mesh's weights
 	};
 
 
@@ -290,12 +271,64 @@ namespace xrlib
 		void Reset() override;
 		VkResult InitBuffers( bool bReset = false ) override;
 		void Draw( const VkCommandBuffer commandBuffer, const CRenderInfo &renderInfo ) override;
+		void DrawDepth( const VkCommandBuffer commandBuffer, const CRenderInfo &renderInfo ) override;
+		void UpdateLods( const CRenderInfo &renderInfo ) override;
+		void UpdateSceneGraph() override;
+		void UpdateSkins( CRenderInfo &renderInfo ) override;
+		bool DispatchSkinning( const VkCommandBuffer commandBuffer, const CRenderInfo &renderInfo ) override;
+		CDeviceBuffer *UpdateInstancesBuffer( VkCommandBuffer transferCmdBuffer ) override;
+		bool UsesGeometryPool() override { return m_geometryAllocation.IsValid(); }
 
 		uint32_t LoadMaterial( CRenderInfo *pRenderInfo, uint32_t layoutId, uint32_t poolId, CTextureManager* pTextureManager );
 		uint32_t LoadMaterial( std::vector< SMaterialUBO* > &outMaterialData, CRenderInfo *pRenderInfo, uint32_t layoutId, uint32_t poolId, CTextureManager *pTextureManager );
 
+		// Returns the material descriptor sets to the pool passed to LoadMaterial(), once no frame in flight uses them. False if the pool
+		// wasn't created with VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT, the sets then stay allocated until the pool is destroyed.
+		bool FreeMaterialDescriptors( CDescriptorManager *pDescriptors );
+
+		// Residency - evicting drops the gpu copies of geometry and textures (cpu data is kept) and the model
+		// is skipped by Draw until a restore has finished uploading. Material textures point to the placeholder while evicted.
+		bool IsEvictable() { return m_bResident && !IsShared() && !HasTextureDependents() && !vertices.empty() && !indices.empty(); }
+		bool IsResident() { return m_bResident; }
+		bool IsRestoring() { return m_restoreFuture.valid(); }
+		VkDeviceSize GetResidentBytes();
+
+		void Evict( CDescriptorManager *pDescriptors, const STexture &placeholder );
+		VkResult Restore( CDescriptorManager *pDescriptors );
+
+		// Returns true once, when the restore uploads are complete and the model is drawable again
+		bool PollRestore();
+
+		// Draws from the source's geometry buffers, textures and material descriptor sets (see CAssetCache), only the instance buffer
+		// stays with this model. The source must outlive this model and must not be evicted while shared.
+		void ShareFrom( const CRenderModel &source );
+
+		// Drops the shared resources, the model draws nothing until it gets geometry of its own
+		void Unshare();
+		bool IsShared() { return m_pSharedSource != nullptr; }
+
+		// Copies source's texture handles without the cpu copies (e.g. meshes split off a glTF model for instancing), so only the source
+		// evicts or restores the images. The source is not evicted while models referencing its textures are alive, and must outlive them.
+		void ShareTexturesFrom( CRenderModel &source );
+		bool HasTextureDependents() { return m_pTextureOwnership.use_count() > 1; }
+
+		// Moves source's geometry (buffers or pool range), cpu mesh data, textures, materials, skins, animations, morph targets, sections and lods to this model,
+		// replacing this model's geometry. Instances stay as they are and source is left empty. Used to swap in streamed models (see CGltf::LoadAsync).
+		// This model's own textures and material descriptors may still be in use by frames in flight, they go to outReplaced instead.
+		void TakeFrom( CRenderModel &source, SReplacedMaterials &outReplaced );
+
+		// Optional attributes that actually carry data (non zero uv1 / weights, non white color) - use to pick a compact format
+		uint32_t GetUsedVertexAttributes();
+
 		// Mesh data
 		const VkDeviceSize vertexOffsets[ 1 ] = { 0 };
+		SVertexFormat vertexFormat; // set before InitBuffers()
+
+		// Use 16 bit indices if they fit, either for the whole model or per material section (relative to the section's lowest vertex) - set before InitBuffers()
+		bool allowIndex16 = true;
+
+		// Vertices and indices go to ranges of this pool instead of buffers of their own - defaults to the render info's pool, set before InitBuffers()
+		CGeometryPool *geometryPool = nullptr;
 
 		std::vector< SMeshVertex > vertices;
 		std::vector< uint32_t > indices;
@@ -305,11 +338,136 @@ namespace xrlib
 		std::vector< SSkin > skins;
 		std::vector< SMeshSection > materialSections;
 
+		// Node hierarchy of the model (e.g. from the glTF file). Sections bound to a node are drawn with its world matrix on top of
+		// each instance's model matrix, so parts can be moved at runtime without touching the geometry. Set node transforms at any time,
+		// changed subtrees are recomputed once per frame. Call InitBuffers() after binding sections to other nodes.
+		CSceneGraph sceneGraph;
+
+		// Clips that animate the scene graph's nodes, see CAnimator. Shared by models sharing this one's geometry.
+		std::vector< std::shared_ptr< const SAnimationClip > > animations;
+
+		// Drawn with the render info's skinned pipeline layout (see CStereoRender::CreateGraphicsPipeline_SkinnedPBR), the skins' matrices
+		// are uploaded each frame and applied on the gpu. Skinned models are not drawn in the depth prepass.
+		bool IsSkinned( const CRenderInfo &renderInfo ) const { return !skins.empty() && renderInfo.IsSkinnedLayout( pipelineLayoutIndex ); }
+
+		// Skinned by the compute prepass instead (see CStereoRender::CreateComputePipeline_Skinning) and drawn from the skinned copies with the
+		// regular pbr pipelines, so skinning is done once however many passes and instances draw the model. Needs the full vertex layout,
+		// and keeps the model out of the geometry pool - set before InitBuffers(). Models sharing this one's geometry inherit it.
+		bool computeSkinning = false;
+		bool IsComputeSkinned( const CRenderInfo &renderInfo ) const;
+
+		// Blend shapes, applied by the compute skinning prepass before the skins (CGltf sets computeSkinning for models that have them) and
+		// ignored otherwise. Only targets with a non zero weight are processed, and a model without skins or such targets is drawn as is.
+		// Models sharing this one's geometry have weights of their own.
+		std::vector< SMorphTarget > morphTargets;
+		std::vector< SMorphDelta > morphDeltas; // cpu copy, cleared by Reset()
+		std::vector< float > morphWeights;		// per target, can be set at any time - CAnimator writes the ones a playing clip animates
+
+		void ResetMorphWeights();
+
+		// Sets every target with this name (e.g. the same expression on several meshes), returns false if there is none
+		bool SetMorphWeight( const std::string &sName, float fWeight );
+
+		// Coarser levels of detail after lod 0 (materialSections), picked per instance from the projected size of the model's bounds in either eye
+		std::vector< SMeshLod > lods;
+		float lodHysteresis = 0.1f; // fraction of a lod's screen size the projected size has to pass it by before switching
+
+		uint32_t GetInstanceLod( uint32_t unInstanceIndex ) { return unInstanceIndex < m_vecInstanceLods.size() ? m_vecInstanceLods[ unInstanceIndex ] : 0; }
+		const std::vector< SMeshSection > &GetLodSections( uint32_t unLod ) { return unLod == 0 || unLod > lods.size() ? materialSections : lods[ unLod - 1 ].sections; }
+
+		CDeviceBuffer *GetPositionBuffer() { return m_pPositionBuffer; }
+		VkIndexType GetIndexType() { return m_vkIndexType; }
+		const SGeometryAllocation &GetGeometryAllocation() { return m_geometryAllocation; }
+
 	  private:
+		CDeviceBuffer *m_pPositionBuffer = nullptr; // only if vertexFormat.splitPositions
+		const CRenderModel *m_pSharedSource = nullptr; // geometry buffers belong to this model if set
+		CGeometryPool *m_pGeometryPool = nullptr;		// pool of m_geometryAllocation, the buffers above are its arena's if the allocation is valid
+		SGeometryAllocation m_geometryAllocation;
+		VkIndexType m_vkIndexType = VK_INDEX_TYPE_UINT32;
+		uint32_t m_unIndexCount = 0; // uploaded indices, cpu copy may be cleared by Reset()
+		uint32_t m_unVertexCount = 0; // uploaded vertices
+		std::vector< int32_t > m_vecSectionBaseVertices; // per material section, only for section relative 16 bit indices
+
+		// Bounding sphere in model space, set by InitBuffers()
+		XrVector3f m_boundsCenter = { 0.f, 0.f, 0.f };
+		float m_fBoundsRadius = 0.f;
+		std::vector< uint8_t > m_vecInstanceLods;
+		bool m_bResident = true;
+
+		// Held by this model and every model sharing its textures (see ShareTexturesFrom), moves with the textures
+		std::shared_ptr< void > m_pTextureOwnership;
+		bool m_bBorrowedTextures = false; // textures are another model's (ShareTexturesFrom)
+
+		// Pool the material descriptor sets were allocated from (see LoadMaterial)
+		uint32_t m_unMaterialPoolId = std::numeric_limits< uint32_t >::max();
+
+		// Instance matrices of the nodes sections are bound to (per node slot, one per instance), uploaded after the model's own
+		CDeviceBuffer *m_pNodeInstanceBuffer = nullptr;
+		std::vector< XrMatrix4x4f > m_vecNodeInstanceMatrices;
+		std::vector< int32_t > m_vecNodeSlots;	 // per scene graph node, -1 if no section is bound to it
+		std::vector< uint32_t > m_vecSlotNodes; // per slot
+
+		// Per skin, joint matrix offsets relative to the frame's region of the joint matrix ring (max if it was full)
+		std::vector< uint32_t > m_vecSkinOffsets;
+
+		// Compute skinning - runs of consecutive vertices skinned by the same skin (one dispatch each), the model's descriptor set
+		// (sources are its own vertex buffers) and its skinned copies relative to the frame's region of the skinned vertex ring (max if it was full)
+		struct SSkinDispatch
+		{
+			uint32_t firstVertex;
+			uint32_t vertexCount;
+			uint32_t skin;
+		};
+
+		std::vector< SSkinDispatch > m_vecSkinDispatches;
+		VkDescriptorSet m_vkSkinningDescriptor = VK_NULL_HANDLE;
+		bool m_bSkinningDescriptorDirty = true;
+		uint32_t m_unSkinnedPositionOffset = std::numeric_limits< uint32_t >::max(); // same as the attribute offset unless positions are split
+		uint32_t m_unSkinnedAttributeOffset = std::numeric_limits< uint32_t >::max();
+
+		// Morph deltas (shared with models sharing the geometry) and this frame's active targets relative to the frame's region of the
+		// joint matrix ring. An unskinned model without active targets is idle - drawn from its own vertices, nothing is dispatched.
+		CDeviceBuffer *m_pMorphDeltaBuffer = nullptr;
+		uint32_t m_unActiveMorphCount = 0;
+		uint32_t m_unActiveMorphOffset = 0;
+		bool m_bMorphsIdle = false;
+		std::shared_future< void > m_restoreFuture;
 
 		// Interfaces
 		void DeleteBuffers() override;
 
+		VkResult InitGeometry();
+		VkResult InitPooledGeometry();
+		VkResult InitVertexBuffer();
+		VkResult InitIndexBuffer();
+		void ReleaseGeometry();
+
+		// Whole model if the indices fit, otherwise per material section relative to outBaseVertices - false if 32 bit indices are needed
+		bool PackIndices16( std::vector< uint16_t > &outIndices16, std::vector< int32_t > &outBaseVertices );
+		int32_t GetSectionBaseVertex( size_t unSection ) const { return m_vecSectionBaseVertices.empty() ? 0 : m_vecSectionBaseVertices[ unSection ]; }
+
+		void UpdateBounds();
+		void UpdateNodeSlots();
+		uint32_t SelectLod( float fScreenSize, uint32_t unCurrentLod );
+
+		// Consecutive instances at the same level of detail share draws
+		void DrawLods( const VkCommandBuffer commandBuffer, const CRenderInfo &renderInfo, bool bDepthOnly );
+		void DrawSections( const VkCommandBuffer commandBuffer, const CRenderInfo &renderInfo, const std::vector< SMeshSection > &sections, uint32_t unFirstInstance, uint32_t unInstanceCount, bool bDepthOnly );
+		void UpdateMaterialTextures( CDescriptorManager *pDescriptors, SMaterial &material, const STexture *pPlaceholder = nullptr );
+
+		// Binds the joint matrices of the section's skin (set 2)
+		void BindSkin( const VkCommandBuffer commandBuffer, const CRenderInfo &renderInfo, int32_t nSkin );
+		bool HasSkinOffsets() const;
+
+		// Compute skinning, dispatches are built from the cpu indices in InitBuffers()
+		void UpdateSkinDispatches();
+		void UpdateActiveMorphs( CRenderInfo &renderInfo );
+		bool UpdateSkinningDescriptor( const CRenderInfo &renderInfo );
+		bool DrawsSkinnedCopies( const CRenderInfo &renderInfo ) const { return IsComputeSkinned( renderInfo ) && !m_bMorphsIdle; }
+		void BindSkinnedVertices( const VkCommandBuffer commandBuffer, const CRenderInfo &renderInfo, bool bPositionsOnly );
+		bool HasSkinnedVertices() const { return m_unSkinnedAttributeOffset != std::numeric_limits< uint32_t >::max() && m_vkSkinningDescriptor != VK_NULL_HANDLE; }
+
 	};
 
 }
@@ -0,0 +1,46 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace xrlib
+{
+	// Decoders for EXT_meshopt_compression buffer views - meshoptimizer's vertex codec (version 0) and index codecs (versions 0 and 1)
+	enum class EMeshoptMode
+	{
+		Attributes, // vertex codec, stride a multiple of 4 up to 256
+		Triangles,	// index codec, triangle lists with 2 or 4 byte indices
+		Indices		// index sequence codec, 2 or 4 byte indices
+	};
+
+	enum class EMeshoptFilter
+	{
+		None,
+		Octahedral,	 // normals / tangents, 4 or 8 byte stride
+		Quaternion,	 // rotations, 8 byte stride
+		Exponential	 // floats with a shared exponent, stride a multiple of 4
+	};
+
+	// Decodes unCount elements of unStride bytes into pDst (unCount * unStride bytes), then applies the filter in place.
+	// Returns false if the data is malformed or the mode / filter doesn't support the stride.
+	bool DecodeMeshoptBuffer( void *pDst, size_t unCount, size_t unStride, const uint8_t *pSrc, size_t unSrcSize, EMeshoptMode mode, EMeshoptFilter filter = EMeshoptFilter::None );
+
+	bool DecodeMeshoptVertexBuffer( void *pDst, size_t unCount, size_t unStride, const uint8_t *pSrc, size_t unSrcSize );
+	bool DecodeMeshoptIndexBuffer( void *pDst, size_t unCount, size_t unIndexSize, const uint8_t *pSrc, size_t unSrcSize );
+	bool DecodeMeshoptIndexSequence( void *pDst, size_t unCount, size_t unIndexSize, const uint8_t *pSrc, size_t unSrcSize );
+	bool DecodeMeshoptFilter( void *pData, size_t unCount, size_t unStride, EMeshoptFilter filter );
+
+} // namespace xrlib
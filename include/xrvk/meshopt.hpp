@@ -0,0 +1,115 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#pragma once
+
+#include <vector>
+
+#include <xrvk/mesh.hpp>
+
+namespace xrlib
+{
+	static constexpr uint32_t k_unDefaultVertexCacheSize = 16; // Post transform cache size used for reordering and acmr reporting
+
+	struct SMeshOptimizeSettings
+	{
+		bool enabled = true;
+		bool deduplicateVertices = true;
+		bool mergeSections = true;			// Merge adjacent sections that share a material (and scene graph node and skin)
+		bool reorderForVertexCache = true;	// Tipsify
+		bool reorderForOverdraw = true;		// Sort tipsify clusters front to back, requires reorderForVertexCache
+		bool reorderForVertexFetch = true;	// Renumber vertices in first use order
+
+		uint32_t vertexCacheSize = k_unDefaultVertexCacheSize;
+		float overdrawThreshold = 1.05f;	// Acmr a cluster may lose (as a ratio) to split it further for overdraw sorting
+	};
+
+	struct SMeshLodSettings
+	{
+		bool enabled = true;
+
+		std::vector< float > ratios = { 0.5f, 0.25f, 0.125f };		 // target triangle counts relative to lod 0
+		std::vector< float > screenSizes = { 0.25f, 0.12f, 0.06f }; // matching lods are used below these projected sizes (fraction of the view height)
+
+		float maxError = 0.02f;		// relative to the mesh extent, lods stop early if they can't get smaller within it
+		float minReduction = 0.05f; // a lod must remove at least this fraction of the previous one's triangles
+	};
+
+	struct SMeshOptimizeStats
+	{
+		uint32_t vertexCountBefore = 0;
+		uint32_t vertexCountAfter = 0;
+		uint32_t sectionCountBefore = 0;
+		uint32_t sectionCountAfter = 0;
+
+		// Average cache miss ratio (transformed vertices per triangle, 0.5 - 3.0, lower is better)
+		float acmrBefore = 0.f;
+		float acmrAfter = 0.f;
+
+		// Average transform to vertex ratio (transformed vertices per unique vertex, 1.0 is optimal)
+		float atvrBefore = 0.f;
+		float atvrAfter = 0.f;
+	};
+
+	// Runs the enabled stages in order: deduplication, section merging, vertex cache and overdraw reordering (per section), vertex fetch remap.
+	// Sections with blended materials keep their authored triangle order. Non triangle list sections (index count not a multiple of 3) are left as is.
+	void OptimizeMesh(
+		std::vector< SMeshVertex > &vertices,
+		std::vector< uint32_t > &indices,
+		std::vector< SMeshSection > &sections,
+		const std::vector< SMaterial > *pMaterials = nullptr,
+		const SMeshOptimizeSettings &settings = {},
+		SMeshOptimizeStats *pOutStats = nullptr );
+
+	// Appends simplified copies of the sections' indices to indices for each ratio that gets small enough within the error bound.
+	// Lod sections are reordered for the vertex cache, except for blended materials.
+	void GenerateMeshLods(
+		std::vector< SMeshLod > &outLods,
+		std::vector< uint32_t > &indices,
+		const std::vector< SMeshSection > &sections,
+		const std::vector< SMeshVertex > &vertices,
+		const std::vector< SMaterial > *pMaterials = nullptr,
+		const SMeshLodSettings &settings = {},
+		uint32_t unCacheSize = k_unDefaultVertexCacheSize );
+
+	// Quadric error edge collapse (Garland and Heckbert 1997) onto existing vertices, so the result indexes the same vertex buffer.
+	// Border and attribute seam vertices stay in place. fTargetError is relative to the mesh extent. Returns the resulting index count.
+	size_t SimplifyMesh(
+		std::vector< uint32_t > &outIndices,
+		const uint32_t *pIndices,
+		size_t unIndexCount,
+		const std::vector< SMeshVertex > &vertices,
+		size_t unTargetIndexCount,
+		float fTargetError,
+		float *pOutError = nullptr );
+
+	// Removes bit identical vertices, returns the number of vertices removed
+	uint32_t DeduplicateVertices( std::vector< SMeshVertex > &vertices, std::vector< uint32_t > &indices );
+
+	// Merges adjacent sections that share a material, node and skin and are contiguous in the index buffer, returns the number of sections removed
+	uint32_t MergeMeshSections( std::vector< SMeshSection > &sections );
+
+	// Tipsify (Sander et al. 2007), indices must be below unVertexCount
+	void ReorderForVertexCache( uint32_t *pIndices, size_t unIndexCount, uint32_t unVertexCount, uint32_t unCacheSize );
+
+	// Run after ReorderForVertexCache - splits the triangles into clusters at cache flushes (and further where acmr allows it),
+	// then orders the clusters so outward facing ones (relative to the mesh center) are drawn first. Indices address positions.
+	void ReorderForOverdraw( uint32_t *pIndices, size_t unIndexCount, const std::vector< XrVector3f > &positions, uint32_t unCacheSize, float fThreshold );
+
+	// Renumbers vertices in the order they are first referenced and drops unreferenced ones
+	void ReorderForVertexFetch( std::vector< SMeshVertex > &vertices, std::vector< uint32_t > &indices );
+
+	// Fifo post transform cache simulation
+	float CalculateACMR( const uint32_t *pIndices, size_t unIndexCount, uint32_t unVertexCount, uint32_t unCacheSize = k_unDefaultVertexCacheSize, float *pOutATVR = nullptr );
+
+} // namespace xrlib
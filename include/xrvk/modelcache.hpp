@@ -0,0 +1,183 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <xrvk/mappedfile.hpp>
+#include <xrvk/mesh.hpp>
+
+namespace xrlib
+{
+	static constexpr uint32_t k_unModelCacheMagic = 0x434d5258;  // "XRMC"
+	static constexpr uint32_t k_unModelCacheVersion = 5;		  // Bump whenever the file layout or any record below changes
+	static constexpr uint64_t k_unModelCacheAlignment = 16;		  // Of every chunk and every texture's pixels in the file
+	static constexpr uint64_t k_unFnvOffsetBasis = 14695981039346656037ull;
+
+	enum class EModelCacheChunk : uint32_t
+	{
+		Vertices = 0,	 // SMeshVertex
+		Indices = 1,	 // uint32_t, lods are appended after lod 0
+		Sections = 2,	 // SMeshSection of lod 0
+		Lods = 3,		 // SModelCacheLod
+		LodSections = 4, // SMeshSection of all lods, in lod order
+		Materials = 5,	 // SModelCacheMaterial
+		Textures = 6,	 // SModelCacheTexture
+		TextureData = 7, // Pixels of all textures as they are uploaded (mip 0)
+		Skins = 8,		 // Serialized SSkin (see CModelCacheFile::Write)
+		Strings = 9,	 // Names and uris, referenced by offset and length
+		Nodes = 10,		 // SModelCacheNode, scene graph in parent order
+		Animations = 11, // Serialized SAnimationClip (see CModelCacheFile::Write)
+		MorphTargets = 12, // SModelCacheMorphTarget
+		MorphDeltas = 13,  // SMorphDelta
+		EMax
+	};
+
+	struct SModelCacheHeader
+	{
+		uint32_t magic = k_unModelCacheMagic;
+		uint32_t version = k_unModelCacheVersion;
+		uint64_t sourceHash = 0;
+		uint32_t chunkCount = 0;
+		uint32_t vertexSize = sizeof( SMeshVertex ); // catches vertex layout changes without a version bump
+	};
+
+	// Chunk table, follows the header
+	struct SModelCacheChunk
+	{
+		EModelCacheChunk type = EModelCacheChunk::EMax;
+		uint32_t count = 0;
+		uint64_t offset = 0; // from the start of the file
+		uint64_t size = 0;
+	};
+
+	struct SModelCacheLod
+	{
+		float screenSize = 0.f;
+		float error = 0.f;
+		uint32_t firstSection = 0; // in the LodSections chunk
+		uint32_t sectionCount = 0;
+	};
+
+	struct SModelCacheMaterial
+	{
+		SMaterialUBO parameters;
+		int32_t baseColorTexture = -1;
+		int32_t metallicRoughnessTexture = -1;
+		int32_t normalTexture = -1;
+		int32_t occlusionTexture = -1;
+		int32_t emissiveTexture = -1;
+		uint32_t doubleSided = 0;
+	};
+
+	struct SModelCacheTexture
+	{
+		uint64_t dataOffset = 0; // in the TextureData chunk
+		uint64_t dataSize = 0;
+		uint32_t nameOffset = 0; // in the Strings chunk
+		uint32_t nameLength = 0;
+		uint32_t uriOffset = 0;
+		uint32_t uriLength = 0;
+
+		ETextureType type = ETextureType::Unknown;
+		int32_t width = 1;
+		int32_t height = 1;
+		int32_t channels = 4;
+		int32_t bitsPerChannel = 8;
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		STextureSamplerConfig samplerConfig;
+	};
+
+	struct SModelCacheNode
+	{
+		int32_t parent = -1;
+		XrVector3f translation = { 0.f, 0.f, 0.f };
+		XrQuaternionf rotation = { 0.f, 0.f, 0.f, 1.f };
+		XrVector3f scale = { 1.f, 1.f, 1.f };
+		uint32_t nameOffset = 0; // in the Strings chunk
+		uint32_t nameLength = 0;
+	};
+
+	struct SModelCacheMorphTarget
+	{
+		uint32_t nameOffset = 0; // in the Strings chunk
+		uint32_t nameLength = 0;
+		int32_t node = -1;
+		uint32_t index = 0;
+		uint32_t firstDelta = 0; // in the MorphDeltas chunk
+		uint32_t deltaCount = 0;
+		float defaultWeight = 0.f;
+	};
+
+	// FNV-1a
+	uint64_t HashBytes( const void *pData, size_t unSize, uint64_t unHash = k_unFnvOffsetBasis );
+	uint64_t HashFile( const std::string &sFilename ); // 0 if the file can't be read
+
+	// Processed model in a single file (header, chunk table, 16 byte aligned chunks) so later runs skip parsing, image decoding,
+	// mesh optimization and lod generation. Written by CGltf::LoadCached() on a miss, or offline by the xrlib_import tool.
+	class CModelCacheFile
+	{
+	  public:
+		CModelCacheFile() = default;
+		~CModelCacheFile();
+
+		CModelCacheFile( const CModelCacheFile & ) = delete;
+		CModelCacheFile &operator=( const CModelCacheFile & ) = delete;
+
+		// Writes the cpu side of a parsed model, i.e. before InitBuffers( true ) clears it. Texture pixels come from STexture::data.
+		static bool Write( const std::string &sCacheFile, const CRenderModel &model, uint64_t unSourceHash );
+
+		// Maps the file - false if it's missing, truncated, of another version or made from a different source
+		bool Open( const std::string &sCacheFile, uint64_t unSourceHash );
+		void Close();
+		bool IsOpen() { return m_pData != nullptr; }
+
+		// Copies mesh data, lods, materials, skins, scene graph, morph targets and animations to the model and fills its textures' properties (no pixels or gpu resources)
+		bool Read( CRenderModel *outRenderModel );
+
+		// Pixels of a texture in the mapped file, valid until Close() - nullptr if the texture has none
+		const uint8_t *GetTextureData( uint32_t unTexture, size_t &outSize );
+
+	  private:
+		CMappedFile m_file;
+		const uint8_t *m_pData = nullptr; // of m_file
+		size_t m_unSize = 0;
+
+		const SModelCacheChunk *m_pChunks = nullptr;
+		uint32_t m_unChunkCount = 0;
+
+		// Chunks whose size doesn't match count * unElementSize are treated as missing, 0 skips the check (variable size records)
+		const SModelCacheChunk *FindChunk( EModelCacheChunk type, size_t unElementSize = 1 );
+		const uint8_t *GetChunkData( const SModelCacheChunk *pChunk ) { return m_pData + pChunk->offset; }
+
+		template < typename T > bool ReadArray( std::vector< T > &outArray, EModelCacheChunk type )
+		{
+			const SModelCacheChunk *pChunk = FindChunk( type, sizeof( T ) );
+			if ( !pChunk )
+				return false;
+
+			outArray.resize( pChunk->count );
+			if ( pChunk->count > 0 )
+				memcpy( outArray.data(), GetChunkData( pChunk ), pChunk->size );
+
+			return true;
+		}
+
+		std::string ReadString( uint32_t unOffset, uint32_t unLength );
+	};
+
+} // namespace xrlib
@@ -20,7 +20,10 @@
 #include <xrvk/renderables.hpp>
 #include <xrvk/primitive.hpp>
 #include <xrvk/mesh.hpp>
+#include <xrvk/geometrypool.hpp>
 #include <xrvk/gltf.hpp>
+#include <xrvk/residency.hpp>
+#include <xrvk/ringbuffer.hpp>
 
 namespace xrlib
 {
@@ -93,11 +96,16 @@ namespace xrlib
 	{
 		uint16_t primitiveLayout = 0;
 		uint16_t pbrLayout = 0;
+		uint16_t skinnedPbrLayout = 0;
+		uint16_t skinningLayout = 0;
 
 		uint32_t primitives = 0;
 		uint32_t pbr = 0;
+		uint32_t skinnedPbr = 0;
 		uint32_t sky = 0;
 		uint32_t floor = 0;
+		uint32_t depthPrepass = 0;
+		uint32_t skinning = 0;
 
 		uint32_t pbrFragmentDescriptorLayout = 0;
 		uint32_t pbrFragmentDescriptorPool = 0;
@@ -221,6 +229,15 @@ namespace xrlib
 			 VkCommandBuffer vkTransferCommandBuffer = VK_NULL_HANDLE;
 			 VkFence vkTransferCommandFence = VK_NULL_HANDLE;
 
+			 // Secondary command buffers for the main subpass - cached draws are only re-recorded when the scene changes
+			 VkCommandBuffer vkCachedDrawCommandBuffer = VK_NULL_HANDLE;
+			 VkCommandBuffer vkDynamicDrawCommandBuffer = VK_NULL_HANDLE;
+
+			 VkRenderPass vkCachedRenderPass = VK_NULL_HANDLE;
+			 uint64_t unCachedSceneVersion = std::numeric_limits< uint64_t >::max();
+			 bool bCachedDepthPrepass = false;
+			 std::vector< std::pair< CRenderable *, uint32_t > > vecCachedDraws;
+
 			 void SetImageViewArray( std::array< VkImageView, 4 > &arrImageViews )
 			 {
 				 arrImageViews[ 0 ] = vkMSAAColorView;					// For msaa rendering (color)
@@ -389,7 +406,8 @@ namespace xrlib
 			VkRenderPass vkRenderPass,
 			std::string sVertexShaderFilename,
 			std::string sFragmentShaderFilename,
-			bool bCreateAsMainPBRPipeline );
+			bool bCreateAsMainPBRPipeline,
+			const SVertexFormat &vertexFormat = {} );
 
 		VkResult CreateGraphicsPipeline_CustomPBR(
 			#ifdef XR_USE_PLATFORM_ANDROID
@@ -403,7 +421,49 @@ namespace xrlib
 			const std::string &sFragmentShaderFilename,
 			SPipelineStateInfo &pipelineState,
 			bool bCreateAsMainPBRPipeline,
-			uint32_t unDescriptorPoolCount);
+			uint32_t unDescriptorPoolCount,
+			const SVertexFormat &vertexFormat = {} );
+
+		// Pbr pipeline that skins vertices with the joint matrices of the model's skins (e.g. mesh_pbr_skinned.vert), models drawn with it
+		// upload their SSkin::matrices each frame. The layout adds the joint matrix set (set 2) to the pbr layout's sets, create the main
+		// pbr pipeline first. The vertex format must use the full layout, which carries joints and weights, skinned models are left out
+		// of the depth prepass.
+		VkResult CreateGraphicsPipeline_SkinnedPBR(
+			#ifdef XR_USE_PLATFORM_ANDROID
+				AAssetManager *assetManager,
+			#endif
+			SPipelines &outPipelines,
+			uint32_t &outPipelineIndex,
+			CRenderInfo *pRenderInfo,
+			VkRenderPass vkRenderPass,
+			const std::string &sVertexShaderFilename,
+			const std::string &sFragmentShaderFilename,
+			const SVertexFormat &vertexFormat = {},
+			uint32_t unMaxFrameJoints = k_unDefaultMaxFrameJoints );
+
+		// Depth only pipeline for models with split position streams, uses the pbr layout (create the main pbr pipeline first)
+		VkResult CreateGraphicsPipeline_DepthPrepass(
+			#ifdef XR_USE_PLATFORM_ANDROID
+				AAssetManager *assetManager,
+			#endif
+			SPipelines &outPipelines,
+			CRenderInfo *pRenderInfo,
+			VkRenderPass vkRenderPass,
+			const std::string &sVertexShaderFilename,
+			const std::string &sFragmentShaderFilename );
+
+		// Compute prepass that applies the morph targets and skins of models with computeSkinning set once per frame (e.g. skin.comp), before the
+		// render pass. They are then drawn from the skinned copies with the regular pbr pipelines and take part in the depth prepass. Full vertex layout only.
+		// unMaxFrameVertices bounds the skinned vertices of all such models per frame, unMaxModels the models that can use it.
+		VkResult CreateComputePipeline_Skinning(
+			#ifdef XR_USE_PLATFORM_ANDROID
+				AAssetManager *assetManager,
+			#endif
+			SPipelines &outPipelines,
+			CRenderInfo *pRenderInfo,
+			const std::string &sShaderFilename,
+			uint32_t unMaxFrameVertices = k_unDefaultMaxFrameSkinnedVertices,
+			uint32_t unMaxModels = k_unDefaultMaxComputeSkinnedModels );
 
 		VkResult CreateGraphicsPipeline( 
 			VkPipelineLayout &outLayout, 
@@ -433,7 +493,7 @@ namespace xrlib
 			uint32_t poolCount );
 
 		void SetupPrimitiveVertexAttributes( SShaderSet &shaderSet );
-		void SetupPBRVertexAttributes( SShaderSet &shaderSet );
+		void SetupPBRVertexAttributes( SShaderSet &shaderSet, const SVertexFormat &vertexFormat = {} );
 
 		VkResult CreateBasePipeline( 
 			VkPipelineLayout &outLayout, 
@@ -461,6 +521,18 @@ namespace xrlib
 			const VkCommandBufferResetFlags transferBufferResetFlags = 0,
 			const VkCommandBufferResetFlags renderBufferResetFlags = 0 );
 
+		bool HasCachedDraws( CRenderInfo *pRenderInfo );
+		bool IsDrawCacheValid( const uint32_t unSwpachainImageIndex, const VkRenderPass renderPass, CRenderInfo *pRenderInfo );
+		void RecordCachedDraws( const uint32_t unSwpachainImageIndex, const VkRenderPass renderPass, CRenderInfo *pRenderInfo );
+		void RecordDynamicDraws( const uint32_t unSwpachainImageIndex, const VkRenderPass renderPass, CRenderInfo *pRenderInfo );
+
+		// Renderables that bind their own vertex and index buffers reset the geometry pool's bindings in the command buffer
+		void DrawRenderable( const VkCommandBuffer commandBuffer, CRenderable *pRenderable, CRenderInfo *pRenderInfo, bool bDepthOnly );
+
+		// Records the compute skinning of visible renderables (outside the render pass) and makes the results visible to vertex input
+		void DispatchSkinning( const VkCommandBuffer commandBuffer, CRenderInfo *pRenderInfo );
+		void InvalidateDrawCache();
+
 		void BeginBufferUpdates( const uint32_t unSwpachainImageIndex );
 		void SubmitBufferUpdates( const uint32_t unSwpachainImageIndex );
 		void CalculateViewMatrices( std::array< XrMatrix4x4f, 2 > &outViewMatrices, const XrVector3f *eyeScale );
@@ -532,6 +604,15 @@ namespace xrlib
 			}
 		}
 
+		void FillVertexAttributes( 
+			std::vector< VkVertexInputAttributeDescription > &outVecAttributes, 
+			uint32_t binding, 
+			uint32_t locStart, 
+			const SVertexFormat &vertexFormat ) 
+		{
+			vertexFormat.FillAttributes( outVecAttributes, binding, locStart );
+		}
+
 #pragma region GETTERS
 
 		const VkPushConstantRange GetEyeMatricesPushConstant() 
@@ -594,6 +675,12 @@ namespace xrlib
 		std::vector< VkRenderPass > vecRenderPasses;
 		VkClearColorValue vkClearColor = { { 0.05f, 0.05f, 0.05f, 1.0f } };
 
+		// Record renderables flagged with cacheDrawCommands into per swapchain image secondary command buffers
+		bool useCachedDrawCommands = true;
+
+		// Draw split position stream models depth only before the main draws, so occluded pbr fragments are rejected early
+		bool useDepthPrepass = false;
+
 		#pragma endregion PUBLIC_VARS
 
 
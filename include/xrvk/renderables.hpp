@@ -30,6 +30,41 @@ namespace xrlib
 {
 	static const uint32_t k_pcrSize = sizeof( XrMatrix4x4f ) * 2;
 
+	static constexpr uint32_t k_unMaxSkinJoints = 256;				// Joint matrices a skinned draw can address (range of the joint matrix descriptor)
+	static constexpr uint32_t k_unDefaultMaxFrameJoints = 16 * 1024;	// Joint matrices of all skinned models per frame
+	static constexpr uint32_t k_unDefaultMaxFrameSkinnedVertices = 64 * 1024; // Vertices of all compute skinned models per frame
+	static constexpr uint32_t k_unDefaultMaxComputeSkinnedModels = 64;		// Models with a compute skinning descriptor set
+	static constexpr uint32_t k_unSkinningGroupSize = 64;					// Local size of the compute skinning shader
+
+	// Per dispatch constants of the compute skinning shader, strides and offsets in 32 bit words of the full vertex layout
+	struct SSkinningPushConstants
+	{
+		uint32_t firstVertex = 0;
+		uint32_t vertexCount = 0;
+		uint32_t positionStride = 0;
+		uint32_t attributeStride = 0;
+		uint32_t attributeShift = 0; // words of the vertex before the attribute stream (the position if split)
+		uint32_t morphTargetCount = 0; // active morph targets, applied before skinning
+	};
+
+	// Morph target with a non zero weight, written to the joint matrix ring each frame for the compute skinning shader
+	struct SActiveMorphTarget
+	{
+		uint32_t firstDelta = 0; // in the model's morph delta buffer
+		uint32_t deltaCount = 0;
+		float weight = 0.f;
+		uint32_t padding = 0;
+	};
+
+	// Active morph targets a compute skinned model can apply per frame (range of the joint matrix descriptor)
+	static constexpr uint32_t k_unMaxActiveMorphTargets = k_unMaxSkinJoints * sizeof( XrMatrix4x4f ) / sizeof( SActiveMorphTarget );
+
+	// Per frame view data, read by the vertex stage (lighting set, binding 1)
+	struct SSceneView
+	{
+		XrMatrix4x4f eyeVPs[ 2 ];
+	};
+
 	struct SInstanceState
 	{
 		XrSpace space = XR_NULL_HANDLE;
@@ -51,10 +86,14 @@ namespace xrlib
 	};
 
 	struct CRenderInfo;
+	class CResidencyManager;
+	class CGeometryPool;
+	class CFrameRingBuffer;
 	class CRenderable
 	{
 	  public:
 		bool isVisible = true;
+		bool cacheDrawCommands = false; // only for pipelines that read eye matrices from the scene view buffer, not push constants
 		uint16_t pipelineLayoutIndex = 0;
 		uint16_t graphicsPipelineIndex = 0;
 		uint32_t descriptorLayoutIndex = 0;
@@ -86,14 +125,33 @@ namespace xrlib
 		virtual VkResult InitBuffers( bool bReset = false ) = 0;
 		virtual void Draw( const VkCommandBuffer commandBuffer, const CRenderInfo &renderInfo  ) = 0;
 
+		// Depth only draw for the optional depth prepass, renderables without a position only stream don't take part
+		virtual void DrawDepth( const VkCommandBuffer commandBuffer, const CRenderInfo &renderInfo ) {}
+
+		// Called each frame after the model matrices are updated, renderables with levels of detail pick one per instance
+		virtual void UpdateLods( const CRenderInfo &renderInfo ) {}
+
+		// Called each frame after the model matrices are updated and before the instance buffer upload, renderables with a node hierarchy update it
+		virtual void UpdateSceneGraph() {}
+
+		// Called each frame after UpdateSceneGraph(), skinned renderables write their joint matrices to the render info's joint matrix ring
+		virtual void UpdateSkins( CRenderInfo &renderInfo ) {}
+
+		// Called each frame before the render pass with the compute skinning pipeline bound, returns true if anything was dispatched
+		virtual bool DispatchSkinning( const VkCommandBuffer commandBuffer, const CRenderInfo &renderInfo ) { return false; }
+
+		// Renderables that bind their own vertex and index buffers invalidate the geometry pool's bindings (see CGeometryPool::Bind)
+		virtual bool UsesGeometryPool() { return false; }
+
 		uint32_t AddInstance( uint32_t unCount, XrVector3f scale = { 1.f, 1.f, 1.f } );
 
+		// Static geometry defaults to device local memory (uploaded via staging), pass host visible flags for dynamic geometry
 		VkResult InitBuffer(
 			CDeviceBuffer *pBuffer,
 			VkBufferUsageFlags usageFlags,
 			VkDeviceSize unSize,
 			void *pData,
-			VkMemoryPropertyFlags memPropFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			VkMemoryPropertyFlags memPropFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			VkAllocationCallbacks *pCallbacks = nullptr );
 
 		VkResult InitInstancesBuffer(
@@ -101,10 +159,11 @@ namespace xrlib
 			VkBufferUsageFlags usageFlags,
 			VkDeviceSize unSize,
 			void *pData,
-			VkMemoryPropertyFlags memPropFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			VkMemoryPropertyFlags memPropFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			VkAllocationCallbacks *pCallbacks = nullptr );
 
-		CDeviceBuffer *UpdateInstancesBuffer( VkCommandBuffer transferCmdBuffer );
+		// Records the copy of the instance matrices, returns the staging buffer (freed by the caller once the copy is done)
+		virtual CDeviceBuffer *UpdateInstancesBuffer( VkCommandBuffer transferCmdBuffer );
 		
 		void ResetScale( float x, float y, float z, uint32_t unInstanceIndex = 0 );
 		void ResetScale( float fScale, uint32_t unInstanceIndex = 0 );
@@ -118,6 +177,7 @@ namespace xrlib
 		XrPosef *GetPose( uint32_t unInstanceindex ) { return &instances[ unInstanceindex ].pose; }
 
 		[[nodiscard]] uint32_t GetInstanceCount() const { return (uint32_t) instances.size(); }
+		[[nodiscard]] uint32_t GetDrawVersion() const { return m_unDrawVersion; }
 		CDeviceBuffer *GetIndexBuffer() { return m_pIndexBuffer; }
 		CDeviceBuffer *GetVertexBuffer() { return m_pVertexBuffer; }
 		CDeviceBuffer *GetInstanceBuffer() { return m_pInstanceBuffer; }
@@ -131,6 +191,9 @@ namespace xrlib
 		CDeviceBuffer *m_pVertexBuffer = nullptr;
 		CDeviceBuffer *m_pInstanceBuffer = nullptr;
 
+		// Bumped whenever gpu buffers are (re)created, invalidates cached draw commands
+		uint32_t m_unDrawVersion = 0;
+
 		// Interfaces
 		virtual void DeleteBuffers() = 0;
 	};
@@ -151,10 +214,19 @@ namespace xrlib
 		uint16_t AddNewPipeline( VkPipeline pipeline = VK_NULL_HANDLE );
 		uint32_t AddNewRenderable( CRenderable *renderable );
 
+		// Scene structure version - bump after changing pipelines, descriptors or materials of existing renderables
+		uint64_t sceneVersion = 0;
+		void BumpSceneVersion() { sceneVersion++; }
+
 		// For stencil ops
 		VkPipelineLayout stencilLayout = VK_NULL_HANDLE;
 		std::vector< VkPipeline > stencilPipelines;
 
+		// For the optional depth prepass (see CStereoRender::CreateGraphicsPipeline_DepthPrepass)
+		uint16_t depthPrepassLayoutIndex = 0;
+		uint32_t depthPrepassPipelineIndex = std::numeric_limits< uint32_t >::max();
+		bool HasDepthPrepass() const { return depthPrepassPipelineIndex != std::numeric_limits< uint32_t >::max(); }
+
 		// For global scene lighting
 		uint32_t lightingPoolId = 0;
 		uint32_t lightingLayoutId = 0;
@@ -162,11 +234,45 @@ namespace xrlib
 		SSceneLighting *pSceneLighting = nullptr;
 		VkDescriptorSet sceneLightingDescriptor = VK_NULL_HANDLE;
 
+		// For per frame eye matrices (shares the scene lighting descriptor set)
+		CDeviceBuffer *pSceneViewBuffer = nullptr;
+		SSceneView *pSceneView = nullptr;
+
 		void SetupSceneLighting();
 
+		// For gpu skinning (see CStereoRender::CreateGraphicsPipeline_SkinnedPBR) - joint matrices are written to a frame ring buffer
+		// each frame, skins are bound to set 2 with their dynamic offset
+		uint32_t skinPoolId = 0;
+		uint32_t skinLayoutId = 0;
+		uint16_t skinnedLayoutIndex = std::numeric_limits< uint16_t >::max();
+		CFrameRingBuffer *pJointMatrices = nullptr;
+		VkDescriptorSet jointMatricesDescriptor = VK_NULL_HANDLE;
+
+		VkResult SetupSkinning( uint32_t unFrameCount, uint32_t unMaxFrameJoints = k_unDefaultMaxFrameJoints );
+		bool HasSkinning() const { return pJointMatrices != nullptr; }
+		bool IsSkinnedLayout( uint16_t layoutIndex ) const { return HasSkinning() && layoutIndex == skinnedLayoutIndex; }
+
+		// For the optional compute skinning prepass (see CStereoRender::CreateComputePipeline_Skinning) - models that ask for it are skinned
+		// once per frame into a device local ring of vertices, then drawn from it like static geometry by every pass (including the depth prepass).
+		// Morph targets are applied by the same pass.
+		uint32_t skinningPoolId = 0;
+		uint32_t skinningLayoutId = 0;
+		uint16_t skinningLayoutIndex = 0;
+		uint32_t skinningPipelineIndex = std::numeric_limits< uint32_t >::max();
+		CFrameRingBuffer *pSkinnedVertices = nullptr;
+
+		VkResult SetupComputeSkinning( uint32_t unFrameCount, VkDeviceSize unFrameBytes, uint32_t unMaxModels = k_unDefaultMaxComputeSkinnedModels );
+		bool HasComputeSkinning() const { return skinningPipelineIndex != std::numeric_limits< uint32_t >::max(); }
+
 		// For descriptor management
 		CDescriptorManager *pDescriptors = nullptr;
 
+		// Optional - evicts least recently drawn models under device memory pressure
+		CResidencyManager *pResidencyManager = nullptr;
+
+		// Optional - shared vertex and index buffers for static models (picked up by models created after it is set)
+		CGeometryPool *pGeometryPool = nullptr;
+
 		struct SFrameState
 		{
 			float nearZ = 0.1f;
@@ -245,6 +351,7 @@ namespace xrlib
 		}state;
 
 	  private:
+		CSession *m_pSession = nullptr;
 		VkDevice m_device = VK_NULL_HANDLE;
 
 	};
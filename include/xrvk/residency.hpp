@@ -0,0 +1,72 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <xrvk/allocator.hpp>
+#include <xrvk/mesh.hpp>
+
+namespace xrlib
+{
+	struct SResidencyConfig
+	{
+		float evictThreshold = 0.9f;	// Start evicting once a device local heap is above this fraction of its budget
+		float evictTarget = 0.8f;		// ...and keep evicting until it is below this
+		uint64_t minIdleFrames = 90;	// Never evict models drawn more recently than this (must exceed the frames in flight)
+		uint32_t maxEvictionsPerFrame = 8;
+	};
+
+	// Tracks when registered models were last drawn and, while device local memory is over budget,
+	// evicts the least recently drawn ones. Evicted models are restored asynchronously once they are drawn again.
+	class CResidencyManager
+	{
+	  public:
+		CResidencyManager( CSession *pSession, CRenderInfo *pRenderInfo, CTextureManager *pTextureManager, SResidencyConfig residencyConfig = {} );
+		~CResidencyManager();
+
+		SResidencyConfig config;
+
+		void Register( CRenderModel *pModel );
+		void Unregister( CRenderModel *pModel );
+
+		// Render thread only. Touch each renderable that is about to be drawn, then Update() once per frame after the upload manager's Update()
+		void Touch( CRenderable *pRenderable );
+		void Update();
+
+		uint64_t GetFrame() { return m_unFrame; }
+		uint32_t GetEvictedCount();
+
+	  private:
+		struct SResidencyEntry
+		{
+			CRenderModel *pModel = nullptr;
+			uint64_t lastDrawnFrame = 0;
+		};
+
+		CSession *m_pSession = nullptr;
+		CRenderInfo *m_pRenderInfo = nullptr;
+		CTextureManager *m_pTextureManager = nullptr;
+		CDeviceMemoryAllocator *m_pAllocator = nullptr;
+
+		STexture m_placeholderTexture;
+		std::unordered_map< CRenderable *, SResidencyEntry > m_models;
+		std::vector< CRenderModel * > m_vecRestoring;
+		uint64_t m_unFrame = 0;
+
+		void EvictLeastRecentlyDrawn();
+	};
+
+} // namespace xrlib
@@ -0,0 +1,68 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#pragma once
+
+#include <xrvk/buffer.hpp>
+
+namespace xrlib
+{
+	// Buffer with one region per frame in flight. Per frame data (e.g. joint matrices) is suballocated linearly from the current frame's
+	// region and read through dynamic offsets, so nothing still in use by an earlier frame is overwritten. Host visible rings are
+	// persistently mapped, device local ones hold data the gpu writes itself (e.g. compute skinned vertices).
+	class CFrameRingBuffer
+	{
+	  public:
+		CFrameRingBuffer( CSession *pSession );
+		~CFrameRingBuffer();
+
+		// unBindRange is the range of the dynamic descriptors bound to the buffer, it is kept addressable past the last region
+		VkResult Init( 
+			VkBufferUsageFlags usageFlags, 
+			VkDeviceSize unFrameSize, 
+			uint32_t unFrameCount, 
+			VkDeviceSize unBindRange, 
+			VkMemoryPropertyFlags memPropFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+
+		// Starts writing to the region of unFrame (e.g. the swapchain image index), the gpu must be done with its previous contents
+		void BeginFrame( uint32_t unFrame );
+
+		// Returns the offset of unSize bytes relative to the current frame's region (aligned for dynamic offsets) and their address in ppOutData,
+		// VK_WHOLE_SIZE if the region is full. Relative offsets repeat from frame to frame as long as the same allocations are made.
+		// ppOutData may be null, and is left untouched for rings that aren't mapped.
+		VkDeviceSize Allocate( VkDeviceSize unSize, void **ppOutData = nullptr );
+
+		// Dynamic offset of the current frame's region, add the relative offsets from Allocate()
+		VkDeviceSize GetFrameOffset() const { return m_unFrameOffset; }
+		VkDeviceSize GetFrameSize() const { return m_unFrameSize; }
+		VkDeviceSize GetBindRange() const { return m_unBindRange; }
+		VkDeviceSize GetUsedBytes() const { return m_unCursor; }
+
+		CDeviceBuffer *GetBuffer() { return m_pBuffer; }
+
+	  private:
+		CSession *m_pSession = nullptr;
+		CDeviceBuffer *m_pBuffer = nullptr;
+		uint8_t *m_pMapped = nullptr;
+
+		VkDeviceSize m_unFrameSize = 0;
+		VkDeviceSize m_unBindRange = 0;
+		VkDeviceSize m_unAlignment = 1;
+		uint32_t m_unFrameCount = 0;
+
+		VkDeviceSize m_unFrameOffset = 0;
+		VkDeviceSize m_unCursor = 0; // relative to m_unFrameOffset
+		bool m_bOverflowLogged = false;
+	};
+
+} // namespace xrlib
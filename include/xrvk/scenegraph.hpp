@@ -0,0 +1,88 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <xrlib/common.hpp>
+
+namespace xrlib
+{
+	// Retained node hierarchy in flat arrays (one per component), in parent order - a node's parent always comes before it,
+	// so world matrices are brought up to date in one linear pass. Only nodes whose local transform changed since the last
+	// Update(), and their descendants, are recomputed.
+	class CSceneGraph
+	{
+	  public:
+		// nParent must be an existing node (or -1 for a root), returns the new node's index
+		uint32_t AddNode( 
+			int32_t nParent, 
+			const XrVector3f &translation = { 0.f, 0.f, 0.f }, 
+			const XrQuaternionf &rotation = { 0.f, 0.f, 0.f, 1.f }, 
+			const XrVector3f &scale = { 1.f, 1.f, 1.f }, 
+			const std::string &sName = "" );
+
+		void Clear();
+		void Reserve( size_t unNodeCount );
+
+		// Local transform, relative to the parent. Setting any part marks the node (and so its subtree) for the next Update().
+		void SetTranslation( uint32_t unNode, const XrVector3f &translation );
+		void SetRotation( uint32_t unNode, const XrQuaternionf &rotation );
+		void SetScale( uint32_t unNode, const XrVector3f &scale );
+		void SetLocalTransform( uint32_t unNode, const XrVector3f &translation, const XrQuaternionf &rotation, const XrVector3f &scale );
+
+		const XrVector3f &GetTranslation( uint32_t unNode ) const { return m_vecTranslations[ unNode ]; }
+		const XrQuaternionf &GetRotation( uint32_t unNode ) const { return m_vecRotations[ unNode ]; }
+		const XrVector3f &GetScale( uint32_t unNode ) const { return m_vecScales[ unNode ]; }
+
+		// Recomputes the world matrices of dirty nodes and their descendants, returns the number of nodes recomputed
+		uint32_t Update();
+
+		// Relative to the model (the root's parent space), as of the last Update()
+		const XrMatrix4x4f &GetWorldMatrix( uint32_t unNode ) const { return m_vecWorldMatrices[ unNode ]; }
+		const std::vector< XrMatrix4x4f > &GetWorldMatrices() const { return m_vecWorldMatrices; }
+
+		// True if the node's world matrix was recomputed by the last Update()
+		bool IsChanged( uint32_t unNode ) const { return m_vecFlags[ unNode ] & k_unChanged; }
+		bool IsDirty() const { return m_unDirtyCount > 0; }
+
+		// First node with this name, -1 if there is none
+		int32_t FindNode( const std::string &sName ) const;
+
+		int32_t GetParent( uint32_t unNode ) const { return m_vecParents[ unNode ]; }
+		const std::string &GetName( uint32_t unNode ) const { return m_vecNames[ unNode ]; }
+		uint32_t GetNodeCount() const { return static_cast< uint32_t >( m_vecParents.size() ); }
+		bool IsEmpty() const { return m_vecParents.empty(); }
+
+	  private:
+		static constexpr uint8_t k_unDirty = 1;	  // local transform set since the last update
+		static constexpr uint8_t k_unChanged = 2; // world matrix recomputed by the last update
+
+		std::vector< int32_t > m_vecParents;
+		std::vector< XrVector3f > m_vecTranslations;
+		std::vector< XrQuaternionf > m_vecRotations;
+		std::vector< XrVector3f > m_vecScales;
+		std::vector< XrMatrix4x4f > m_vecWorldMatrices;
+		std::vector< uint8_t > m_vecFlags;
+		std::vector< std::string > m_vecNames;
+
+		uint32_t m_unDirtyCount = 0;
+		bool m_bChangedFlags = false; // flags of the last update still need clearing
+
+		void MarkDirty( uint32_t unNode );
+	};
+
+} // namespace xrlib
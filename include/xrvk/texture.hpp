@@ -65,7 +65,7 @@ namespace xrlib
 
 		// Vulkan resources
 		VkImage image = VK_NULL_HANDLE;
-		VkDeviceMemory memory = VK_NULL_HANDLE;
+		SMemoryAllocation *allocation = nullptr;
 		VkImageView view = VK_NULL_HANDLE;
 		VkSampler sampler = VK_NULL_HANDLE;
 	};
@@ -0,0 +1,144 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <xrlib/session.hpp>
+#include <xrlib/vulkan.hpp>
+#include <xrvk/allocator.hpp>
+
+namespace xrlib
+{
+	static constexpr VkDeviceSize k_unMaxUploadBatchSize = 32ull * 1024 * 1024;	// Staging bytes after which a batch is closed and a new one started
+
+	// Stages of the graphics submit that wait on a batch's semaphore, and that the queue family acquires are ordered after
+	static constexpr VkPipelineStageFlags k_vkUploadWaitStages = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+	struct SUpload
+	{
+		// Staging copy of the source data
+		VkBuffer stagingBuffer = VK_NULL_HANDLE;
+		SMemoryAllocation *pStagingAllocation = nullptr;
+		VkDeviceSize size = 0;
+
+		// Destination - either a buffer range or a whole (single mip, color) image
+		VkBuffer dstBuffer = VK_NULL_HANDLE;
+		VkDeviceSize dstOffset = 0;
+
+		VkImage dstImage = VK_NULL_HANDLE;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	};
+
+	struct SUploadBatch
+	{
+		std::vector< SUpload > uploads;
+		VkDeviceSize stagingBytes = 0;
+
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		VkFence fence = VK_NULL_HANDLE;
+		VkSemaphore semaphore = VK_NULL_HANDLE;		// waited on by the graphics submit of the frame that submitted the batch
+
+		std::promise< void > promise;
+		std::shared_future< void > future = promise.get_future().share();
+	};
+
+	// Batches buffer and image uploads into a few command buffers on the transfer queue.
+	// Callers on any thread enqueue uploads and get a future back. The render thread calls Update()
+	// once per frame before recording draws, which submits closed batches, records their queue family
+	// ownership acquires (if the transfer queue is in a different family than graphics) into the same
+	// frame and retires finished ones. The frame's graphics submit waits on the batch semaphores from
+	// GetWaitSemaphores(), so anything enqueued before Update() can be drawn in that frame.
+	class CUploadManager
+	{
+	  public:
+		// One upload manager per logical device, created on first use
+		static CUploadManager *Get( CSession *pSession );
+
+		// Waits for in flight uploads and frees all resources - call before the logical device is destroyed
+		static void Destroy( VkDevice vkDevice );
+
+		explicit CUploadManager( CSession *pSession );
+		~CUploadManager();
+
+		// Source data is copied to staging memory before these return. The returned future is ready
+		// once the copy has finished and its staging memory is released
+		std::shared_future< void > UploadBuffer( VkBuffer vkDstBuffer, const void *pData, VkDeviceSize unSize, VkDeviceSize unDstOffset = 0 );
+		std::shared_future< void > UploadImage(
+			VkImage vkDstImage,
+			const void *pData,
+			VkDeviceSize unSize,
+			uint32_t unWidth,
+			uint32_t unHeight,
+			VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL );
+
+		// Closes the current batch so it goes out on the next Update()
+		std::shared_future< void > Submit();
+
+		// Render thread only (owns the queues) - call while graphicsCommandBuffer is recording, outside a render pass
+		void Update( VkCommandBuffer graphicsCommandBuffer );
+
+		// Render thread only - semaphores (and wait stages) the graphics submit of graphicsCommandBuffer must wait on, cleared by this call
+		void GetWaitSemaphores( std::vector< VkSemaphore > &outSemaphores, std::vector< VkPipelineStageFlags > &outWaitStages );
+
+		// Call before destroying a destination resource - drops pending uploads and waits for in flight ones that target it
+		void ReleaseBuffer( VkBuffer vkBuffer );
+		void ReleaseImage( VkImage vkImage );
+
+		// Blocks until everything submitted so far has finished on the gpu
+		void WaitIdle();
+
+		bool IsOwnershipTransferRequired() { return m_unTransferFamily != m_unGraphicsFamily; }
+		size_t GetPendingBatchCount();
+
+	  private:
+		VkDevice m_vkDevice = VK_NULL_HANDLE;
+		CDeviceMemoryAllocator *m_pAllocator = nullptr;
+
+		VkQueue m_vkTransferQueue = VK_NULL_HANDLE;
+		uint32_t m_unTransferFamily = 0;
+		uint32_t m_unGraphicsFamily = 0;
+		VkCommandPool m_vkCommandPool = VK_NULL_HANDLE;
+
+		SUploadBatch *m_pOpenBatch = nullptr;
+		std::deque< SUploadBatch * > m_closedBatches;
+		std::deque< SUploadBatch * > m_inFlightBatches;
+		std::vector< VkSemaphore > m_vecWaitSemaphores;
+
+		std::recursive_mutex m_mutex;
+
+		static std::mutex s_registryMutex;
+		static std::unordered_map< VkDevice, CUploadManager * > s_registry;
+
+		SUploadBatch *GetOpenBatch();
+		void CloseOpenBatch();
+		VkResult CreateStaging( SUpload &upload, const void *pData, VkDeviceSize unSize );
+		void FreeStaging( SUpload &upload );
+
+		VkResult SubmitBatch( SUploadBatch *pBatch );
+		void RecordBatch( SUploadBatch *pBatch );
+		void RecordAcquires( SUploadBatch *pBatch, VkCommandBuffer graphicsCommandBuffer );
+		void RetireBatch( SUploadBatch *pBatch );
+		std::shared_future< void > AddUpload( SUpload &upload );
+	};
+
+} // namespace xrlib
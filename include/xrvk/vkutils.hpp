@@ -14,6 +14,7 @@
 #pragma once
 
 #include <xrlib/vulkan.hpp>
+#include <xrvk/allocator.hpp>
 
 namespace vkutils
 {
@@ -27,7 +28,7 @@ namespace vkutils
 
 	VkResult CreateImage( 
 		VkImage &outImage, 
-		VkDeviceMemory &outImageMemory,
+		xrlib::SMemoryAllocation *&outImageAllocation,
 		VkDevice device, 
 		VkPhysicalDevice physicalDevice, 
 		uint32_t width, 
@@ -0,0 +1,9 @@
+// Copyright 2024-25 Rune Berg (http://runeberg.io | https://github.com/1runeberg)
+// Licensed under Apache 2.0 (https://www.apache.org/licenses/LICENSE-2.0)
+// SPDX-License-Identifier: Apache-2.0
+
+#version 450
+
+// Depth only - color writes are masked off in the depth prepass pipeline
+void main() {
+}
@@ -0,0 +1,35 @@
+// Copyright 2024-25 Rune Berg (http://runeberg.io | https://github.com/1runeberg)
+// Licensed under Apache 2.0 (https://www.apache.org/licenses/LICENSE-2.0)
+// SPDX-License-Identifier: Apache-2.0
+
+#version 450
+#extension GL_EXT_multiview : require
+
+// Scene view - view/projection matrices for both eyes (written each frame, see xrlib::SSceneView)
+layout(set = 1, binding = 1) uniform SceneView {
+    mat4 eyeVPs[2];
+} sceneView;
+
+// Position only stream (binding 0)
+layout(location = 0) in vec3 inPosition;
+
+// Instance data (model matrix columns, binding 1)
+layout(location = 8) in vec4 inModelMatrix_col0;
+layout(location = 9) in vec4 inModelMatrix_col1;
+layout(location = 10) in vec4 inModelMatrix_col2;
+layout(location = 11) in vec4 inModelMatrix_col3;
+
+// Must match the pbr vertex shaders exactly so the main pass passes the depth test with LESS_OR_EQUAL
+invariant gl_Position;
+
+void main() {
+    mat4 modelMatrix = mat4(
+        inModelMatrix_col0,
+        inModelMatrix_col1,
+        inModelMatrix_col2,
+        inModelMatrix_col3
+    );
+
+    vec4 worldPos = modelMatrix * vec4(inPosition, 1.0);
+    gl_Position = sceneView.eyeVPs[gl_ViewIndex] * worldPos;
+}
@@ -5,10 +5,10 @@
 #version 450
 #extension GL_EXT_multiview : require
 
-// Push constants - view/projection matrices for both eyes
-layout(push_constant) uniform PushConsts {
+// Scene view - view/projection matrices for both eyes (written each frame, see xrlib::SSceneView)
+layout(set = 1, binding = 1) uniform SceneView {
     mat4 eyeVPs[2];
-} pushConsts;
+} sceneView;
 
 // Vertex attributes
 layout(location = 0) in vec3 inPosition;
@@ -33,6 +33,9 @@ layout(location = 2) out vec3 outNormal;
 layout(location = 3) out vec3 outTangent;
 layout(location = 4) out vec3 outBitangent;
 
+// Depth must match the depth prepass (mesh_depth.vert) exactly
+invariant gl_Position;
+
 void main() {
     // Reconstruct model matrix from columns
     mat4 modelMatrix = mat4(
@@ -62,6 +65,6 @@ void main() {
     // Pass through texture coordinates
     outUV = inTexCoord0;
 
-    // Final position in clip space (using eye VPs from push constants)
-    gl_Position = pushConsts.eyeVPs[gl_ViewIndex] * worldPos;
+    // Final position in clip space (using eye VPs from the scene view buffer)
+    gl_Position = sceneView.eyeVPs[gl_ViewIndex] * worldPos;
 }
\ No newline at end of file
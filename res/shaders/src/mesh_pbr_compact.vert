@@ -0,0 +1,74 @@
+// Copyright 2024-25 Rune Berg (http://runeberg.io | https://github.com/1runeberg)
+// Licensed under Apache 2.0 (https://www.apache.org/licenses/LICENSE-2.0)
+// SPDX-License-Identifier: Apache-2.0
+
+#version 450
+#extension GL_EXT_multiview : require
+
+// Scene view - view/projection matrices for both eyes (written each frame, see xrlib::SSceneView)
+layout(set = 1, binding = 1) uniform SceneView {
+    mat4 eyeVPs[2];
+} sceneView;
+
+// Vertex attributes - compact layout (see xrlib::SVertexFormat), unused optional attributes are not declared
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec2 inNormalOct;       // snorm16x2, octahedral
+layout(location = 2) in vec4 inTangentOct;      // snorm8x4, octahedral xy + handedness in z
+layout(location = 3) in vec2 inTexCoord0;       // half2
+
+// Instance data (model matrix columns)
+layout(location = 8) in vec4 inModelMatrix_col0;
+layout(location = 9) in vec4 inModelMatrix_col1;
+layout(location = 10) in vec4 inModelMatrix_col2;
+layout(location = 11) in vec4 inModelMatrix_col3;
+
+// Output to fragment shader
+layout(location = 0) out vec3 outWorldPos;
+layout(location = 1) out vec2 outUV;
+layout(location = 2) out vec3 outNormal;
+layout(location = 3) out vec3 outTangent;
+layout(location = 4) out vec3 outBitangent;
+
+// Depth must match the depth prepass (mesh_depth.vert) exactly
+invariant gl_Position;
+
+vec3 DecodeOctahedral(vec2 e) {
+    vec3 v = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0.0) {
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(v);
+}
+
+void main() {
+    // Reconstruct model matrix from columns
+    mat4 modelMatrix = mat4(
+        inModelMatrix_col0,
+        inModelMatrix_col1,
+        inModelMatrix_col2,
+        inModelMatrix_col3
+    );
+
+    // Calculate normal matrix (transpose of inverse of upper 3x3 model matrix)
+    mat3 normalMatrix = transpose(inverse(mat3(modelMatrix)));
+
+    // Transform vertex position to world space
+    vec4 worldPos = modelMatrix * vec4(inPosition, 1.0);
+    outWorldPos = worldPos.xyz;
+
+    // Transform normal to world space
+    outNormal = normalize(normalMatrix * DecodeOctahedral(inNormalOct));
+
+    // Transform tangent and calculate bitangent
+    vec3 tangent = normalize(normalMatrix * DecodeOctahedral(inTangentOct.xy));
+    outTangent = tangent;
+
+    // Calculate bitangent (handedness is stored as +/-1 in z)
+    outBitangent = cross(outNormal, tangent) * (inTangentOct.z < 0.0 ? -1.0 : 1.0);
+
+    // Pass through texture coordinates
+    outUV = inTexCoord0;
+
+    // Final position in clip space (using eye VPs from the scene view buffer)
+    gl_Position = sceneView.eyeVPs[gl_ViewIndex] * worldPos;
+}
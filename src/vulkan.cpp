@@ -17,6 +17,11 @@
 #include <bluevk/BlueVK.h>
 using namespace bluevk;
 
+#ifdef XRVK_ENABLED
+	#include <xrvk/allocator.hpp>
+	#include <xrvk/upload.hpp>
+#endif
+
 namespace xrlib
 {
 	CVulkan::CVulkan( CSession *pSession ) : 
@@ -29,7 +34,15 @@ namespace xrlib
 	{
 		// Destroy logical device
 		if ( m_vkDevice )
+		{
+			#ifdef XRVK_ENABLED
+				// Finish pending uploads, then release any device memory still held by the xrvk allocator
+				CUploadManager::Destroy( m_vkDevice );
+				CDeviceMemoryAllocator::Destroy( m_vkDevice );
+			#endif
+
 			vkDestroyDevice( m_vkDevice, nullptr );
+		}
 	}
 
 	XrResult CVulkan::Init( 
@@ -242,6 +255,26 @@ namespace xrlib
 			vecLogicalDeviceExtensions.push_back( VK_KHR_SWAPCHAIN_EXTENSION_NAME );
 		#endif
 
+		// Enable per heap budget queries if available (used by xrvk's memory accounting and residency)
+		uint32_t unDeviceExtensionCount = 0;
+		vkEnumerateDeviceExtensionProperties( m_vkPhysicalDevice, nullptr, &unDeviceExtensionCount, nullptr );
+		std::vector< VkExtensionProperties > vecDeviceExtensionProps( unDeviceExtensionCount );
+		vkEnumerateDeviceExtensionProperties( m_vkPhysicalDevice, nullptr, &unDeviceExtensionCount, vecDeviceExtensionProps.data() );
+
+		for ( auto &extensionProps : vecDeviceExtensionProps )
+		{
+			if ( strcmp( extensionProps.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME ) != 0 )
+				continue;
+
+			bool bAlreadyRequested = std::find_if( vecLogicalDeviceExtensions.begin(), vecLogicalDeviceExtensions.end(),
+				[]( const char *pName ) { return strcmp( pName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME ) == 0; } ) != vecLogicalDeviceExtensions.end();
+
+			if ( !bAlreadyRequested )
+				vecLogicalDeviceExtensions.push_back( VK_EXT_MEMORY_BUDGET_EXTENSION_NAME );
+
+			break;
+		}
+
 		// Setup logical device
 		vkPhysicalDeviceFeatures.samplerAnisotropy = VK_TRUE;
 		// VkPhysicalDeviceFeatures2 physical_features2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
@@ -0,0 +1,539 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#include <xrvk/accessor.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+	#define XRVK_ACCESSOR_SSE2
+	#include <emmintrin.h>
+#elif defined( __ARM_NEON )
+	#define XRVK_ACCESSOR_NEON
+	#include <arm_neon.h>
+#endif
+
+namespace xrlib
+{
+	namespace
+	{
+		// Accessor data is only guaranteed to be aligned to its component size
+		template < typename T >
+		inline T Load( const uint8_t *pSrc )
+		{
+			T value;
+			memcpy( &value, pSrc, sizeof( T ) );
+			return value;
+		}
+
+		inline uint8_t *Advance( void *pOut, size_t unBytes ) { return reinterpret_cast< uint8_t * >( pOut ) + unBytes; }
+
+		// Gltf normalization - unsigned: c / max, signed: max( c / max, -1 )
+		template < typename T, bool bNormalized >
+		inline float ToFloat( T value )
+		{
+			if constexpr ( !bNormalized || std::is_floating_point_v< T > )
+				return static_cast< float >( value );
+			else if constexpr ( std::is_signed_v< T > )
+				return std::max( static_cast< float >( value ) / static_cast< float >( std::numeric_limits< T >::max() ), -1.f );
+			else
+				return static_cast< float >( value ) / static_cast< float >( std::numeric_limits< T >::max() );
+		}
+
+		uint32_t ReadIndex( const uint8_t *pSrc, EAccessorComponent componentType )
+		{
+			switch ( componentType )
+			{
+				case EAccessorComponent::UnsignedByte:
+					return *pSrc;
+				case EAccessorComponent::UnsignedShort:
+					return Load< uint16_t >( pSrc );
+				case EAccessorComponent::UnsignedInt:
+					return Load< uint32_t >( pSrc );
+				default:
+					return std::numeric_limits< uint32_t >::max();
+			}
+		}
+
+		// Calls fnDecode( valueStream, unElement ) for each sparse substitution, with valueStream being a single element stream
+		template < typename Fn >
+		void ForEachSparseValue( const SAccessorStream &stream, Fn &&fnDecode )
+		{
+			if ( stream.sparseCount == 0 || !stream.pSparseIndices || !stream.pSparseValues )
+				return;
+
+			const size_t unIndexSize = GetAccessorComponentSize( stream.sparseIndexType );
+			const size_t unElementSize = GetAccessorComponentSize( stream.componentType ) * stream.componentCount;
+
+			SAccessorStream value = stream;
+			value.count = 1;
+			value.stride = unElementSize;
+			value.sparseCount = 0;
+
+			for ( size_t i = 0; i < stream.sparseCount; i++ )
+			{
+				const uint32_t unElement = ReadIndex( stream.pSparseIndices + i * unIndexSize, stream.sparseIndexType );
+				if ( unElement >= stream.count )
+					continue;
+
+				value.pData = stream.pSparseValues + i * unElementSize;
+				fnDecode( value, unElement );
+			}
+		}
+
+		// Float streams - fixed size copies per element, or one copy if both sides are tightly packed
+		template < uint32_t unComponents >
+		void CopyFloats( const uint8_t *pSrc, size_t unCount, size_t unStride, float *pOut, size_t unOutStride )
+		{
+			constexpr size_t unElementSize = unComponents * sizeof( float );
+			if ( unStride == unElementSize && unOutStride == unElementSize )
+			{
+				memcpy( pOut, pSrc, unCount * unElementSize );
+				return;
+			}
+
+			uint8_t *pDst = reinterpret_cast< uint8_t * >( pOut );
+			for ( size_t i = 0; i < unCount; i++, pSrc += unStride, pDst += unOutStride )
+				memcpy( pDst, pSrc, unElementSize );
+		}
+
+		template < typename T, bool bNormalized >
+		void ConvertFloatsScalar( const uint8_t *pSrc, size_t unCount, size_t unStride, uint32_t unComponents, float *pOut, size_t unOutStride )
+		{
+			uint8_t *pDst = reinterpret_cast< uint8_t * >( pOut );
+			for ( size_t i = 0; i < unCount; i++, pSrc += unStride, pDst += unOutStride )
+			{
+				float *pElement = reinterpret_cast< float * >( pDst );
+				for ( uint32_t c = 0; c < unComponents; c++ )
+					pElement[ c ] = ToFloat< T, bNormalized >( Load< T >( pSrc + c * sizeof( T ) ) );
+			}
+		}
+
+		// Four 8 / 16 bit components (tangents, colors, weights) convert in one register per element
+		#if defined( XRVK_ACCESSOR_SSE2 )
+			template < typename T >
+			inline __m128i Widen4( const uint8_t *pSrc )
+			{
+				if constexpr ( std::is_same_v< T, uint8_t > )
+				{
+					const __m128i vZero = _mm_setzero_si128();
+					__m128i v = _mm_cvtsi32_si128( Load< int32_t >( pSrc ) );
+					v = _mm_unpacklo_epi8( v, vZero );
+					return _mm_unpacklo_epi16( v, vZero );
+				}
+				else if constexpr ( std::is_same_v< T, int8_t > )
+				{
+					// Interleave with itself and shift back down to sign extend
+					__m128i v = _mm_cvtsi32_si128( Load< int32_t >( pSrc ) );
+					v = _mm_unpacklo_epi8( v, v );
+					v = _mm_unpacklo_epi16( v, v );
+					return _mm_srai_epi32( v, 24 );
+				}
+				else if constexpr ( std::is_same_v< T, uint16_t > )
+				{
+					__m128i v = _mm_loadl_epi64( reinterpret_cast< const __m128i * >( pSrc ) );
+					return _mm_unpacklo_epi16( v, _mm_setzero_si128() );
+				}
+				else
+				{
+					__m128i v = _mm_loadl_epi64( reinterpret_cast< const __m128i * >( pSrc ) );
+					v = _mm_unpacklo_epi16( v, v );
+					return _mm_srai_epi32( v, 16 );
+				}
+			}
+
+			template < typename T, bool bNormalized >
+			void ConvertFloats4( const uint8_t *pSrc, size_t unCount, size_t unStride, float *pOut, size_t unOutStride )
+			{
+				const __m128 vScale = _mm_set1_ps( bNormalized ? 1.f / static_cast< float >( std::numeric_limits< T >::max() ) : 1.f );
+				const __m128 vMin = _mm_set1_ps( -1.f );
+
+				uint8_t *pDst = reinterpret_cast< uint8_t * >( pOut );
+				for ( size_t i = 0; i < unCount; i++, pSrc += unStride, pDst += unOutStride )
+				{
+					__m128 v = _mm_mul_ps( _mm_cvtepi32_ps( Widen4< T >( pSrc ) ), vScale );
+					if constexpr ( bNormalized && std::is_signed_v< T > )
+						v = _mm_max_ps( v, vMin );
+
+					_mm_storeu_ps( reinterpret_cast< float * >( pDst ), v );
+				}
+			}
+
+			template < typename T >
+			void ConvertUints4( const uint8_t *pSrc, size_t unCount, size_t unStride, uint32_t *pOut, size_t unOutStride )
+			{
+				uint8_t *pDst = reinterpret_cast< uint8_t * >( pOut );
+				for ( size_t i = 0; i < unCount; i++, pSrc += unStride, pDst += unOutStride )
+					_mm_storeu_si128( reinterpret_cast< __m128i * >( pDst ), Widen4< T >( pSrc ) );
+			}
+
+		#elif defined( XRVK_ACCESSOR_NEON )
+			template < typename T >
+			inline int32x4_t Widen4( const uint8_t *pSrc )
+			{
+				if constexpr ( std::is_same_v< T, uint8_t > )
+					return vreinterpretq_s32_u32( vmovl_u16( vget_low_u16( vmovl_u8( vcreate_u8( Load< uint32_t >( pSrc ) ) ) ) ) );
+				else if constexpr ( std::is_same_v< T, int8_t > )
+					return vmovl_s16( vget_low_s16( vmovl_s8( vcreate_s8( Load< uint32_t >( pSrc ) ) ) ) );
+				else if constexpr ( std::is_same_v< T, uint16_t > )
+					return vreinterpretq_s32_u32( vmovl_u16( vcreate_u16( Load< uint64_t >( pSrc ) ) ) );
+				else
+					return vmovl_s16( vcreate_s16( Load< uint64_t >( pSrc ) ) );
+			}
+
+			template < typename T, bool bNormalized >
+			void ConvertFloats4( const uint8_t *pSrc, size_t unCount, size_t unStride, float *pOut, size_t unOutStride )
+			{
+				const float fScale = bNormalized ? 1.f / static_cast< float >( std::numeric_limits< T >::max() ) : 1.f;
+				const float32x4_t vMin = vdupq_n_f32( -1.f );
+
+				uint8_t *pDst = reinterpret_cast< uint8_t * >( pOut );
+				for ( size_t i = 0; i < unCount; i++, pSrc += unStride, pDst += unOutStride )
+				{
+					float32x4_t v = vmulq_n_f32( vcvtq_f32_s32( Widen4< T >( pSrc ) ), fScale );
+					if constexpr ( bNormalized && std::is_signed_v< T > )
+						v = vmaxq_f32( v, vMin );
+
+					vst1q_f32( reinterpret_cast< float * >( pDst ), v );
+				}
+			}
+
+			template < typename T >
+			void ConvertUints4( const uint8_t *pSrc, size_t unCount, size_t unStride, uint32_t *pOut, size_t unOutStride )
+			{
+				uint8_t *pDst = reinterpret_cast< uint8_t * >( pOut );
+				for ( size_t i = 0; i < unCount; i++, pSrc += unStride, pDst += unOutStride )
+					vst1q_u32( reinterpret_cast< uint32_t * >( pDst ), vreinterpretq_u32_s32( Widen4< T >( pSrc ) ) );
+			}
+		#endif
+
+		template < typename T, bool bNormalized >
+		void ConvertFloats( const uint8_t *pSrc, size_t unCount, size_t unStride, uint32_t unComponents, float *pOut, size_t unOutStride )
+		{
+			#if defined( XRVK_ACCESSOR_SSE2 ) || defined( XRVK_ACCESSOR_NEON )
+				if constexpr ( sizeof( T ) <= 2 )
+				{
+					if ( unComponents == 4 )
+					{
+						ConvertFloats4< T, bNormalized >( pSrc, unCount, unStride, pOut, unOutStride );
+						return;
+					}
+				}
+			#endif
+
+			ConvertFloatsScalar< T, bNormalized >( pSrc, unCount, unStride, unComponents, pOut, unOutStride );
+		}
+
+		template < typename T >
+		void ConvertUints( const uint8_t *pSrc, size_t unCount, size_t unStride, uint32_t unComponents, uint32_t *pOut, size_t unOutStride )
+		{
+			#if defined( XRVK_ACCESSOR_SSE2 ) || defined( XRVK_ACCESSOR_NEON )
+				if constexpr ( sizeof( T ) <= 2 && std::is_unsigned_v< T > )
+				{
+					if ( unComponents == 4 )
+					{
+						ConvertUints4< T >( pSrc, unCount, unStride, pOut, unOutStride );
+						return;
+					}
+				}
+			#endif
+
+			uint8_t *pDst = reinterpret_cast< uint8_t * >( pOut );
+			for ( size_t i = 0; i < unCount; i++, pSrc += unStride, pDst += unOutStride )
+			{
+				uint32_t *pElement = reinterpret_cast< uint32_t * >( pDst );
+				for ( uint32_t c = 0; c < unComponents; c++ )
+				{
+					if constexpr ( std::is_floating_point_v< T > )
+						pElement[ c ] = static_cast< uint32_t >( std::max( Load< T >( pSrc + c * sizeof( T ) ), T( 0 ) ) );
+					else
+						pElement[ c ] = static_cast< uint32_t >( Load< T >( pSrc + c * sizeof( T ) ) );
+				}
+			}
+		}
+
+		void DecodeFloatsDense( const SAccessorStream &stream, uint32_t unComponents, float *pOut, size_t unOutStride )
+		{
+			const bool bNormalized = stream.normalized;
+
+			switch ( stream.componentType )
+			{
+				case EAccessorComponent::Float:
+					switch ( unComponents )
+					{
+						case 1:
+							CopyFloats< 1 >( stream.pData, stream.count, stream.stride, pOut, unOutStride );
+							break;
+						case 2:
+							CopyFloats< 2 >( stream.pData, stream.count, stream.stride, pOut, unOutStride );
+							break;
+						case 3:
+							CopyFloats< 3 >( stream.pData, stream.count, stream.stride, pOut, unOutStride );
+							break;
+						case 4:
+							CopyFloats< 4 >( stream.pData, stream.count, stream.stride, pOut, unOutStride );
+							break;
+						default:
+							ConvertFloatsScalar< float, false >( stream.pData, stream.count, stream.stride, unComponents, pOut, unOutStride );
+							break;
+					}
+					break;
+				case EAccessorComponent::Byte:
+					bNormalized ? ConvertFloats< int8_t, true >( stream.pData, stream.count, stream.stride, unComponents, pOut, unOutStride )
+								: ConvertFloats< int8_t, false >( stream.pData, stream.count, stream.stride, unComponents, pOut, unOutStride );
+					break;
+				case EAccessorComponent::UnsignedByte:
+					bNormalized ? ConvertFloats< uint8_t, true >( stream.pData, stream.count, stream.stride, unComponents, pOut, unOutStride )
+								: ConvertFloats< uint8_t, false >( stream.pData, stream.count, stream.stride, unComponents, pOut, unOutStride );
+					break;
+				case EAccessorComponent::Short:
+					bNormalized ? ConvertFloats< int16_t, true >( stream.pData, stream.count, stream.stride, unComponents, pOut, unOutStride )
+								: ConvertFloats< int16_t, false >( stream.pData, stream.count, stream.stride, unComponents, pOut, unOutStride );
+					break;
+				case EAccessorComponent::UnsignedShort:
+					bNormalized ? ConvertFloats< uint16_t, true >( stream.pData, stream.count, stream.stride, unComponents, pOut, unOutStride )
+								: ConvertFloats< uint16_t, false >( stream.pData, stream.count, stream.stride, unComponents, pOut, unOutStride );
+					break;
+				case EAccessorComponent::UnsignedInt:
+					ConvertFloats< uint32_t, false >( stream.pData, stream.count, stream.stride, unComponents, pOut, unOutStride );
+					break;
+			}
+		}
+
+		void DecodeUintsDense( const SAccessorStream &stream, uint32_t unComponents, uint32_t *pOut, size_t unOutStride )
+		{
+			switch ( stream.componentType )
+			{
+				case EAccessorComponent::Byte:
+					ConvertUints< int8_t >( stream.pData, stream.count, stream.stride, unComponents, pOut, unOutStride );
+					break;
+				case EAccessorComponent::UnsignedByte:
+					ConvertUints< uint8_t >( stream.pData, stream.count, stream.stride, unComponents, pOut, unOutStride );
+					break;
+				case EAccessorComponent::Short:
+					ConvertUints< int16_t >( stream.pData, stream.count, stream.stride, unComponents, pOut, unOutStride );
+					break;
+				case EAccessorComponent::UnsignedShort:
+					ConvertUints< uint16_t >( stream.pData, stream.count, stream.stride, unComponents, pOut, unOutStride );
+					break;
+				case EAccessorComponent::UnsignedInt:
+					ConvertUints< uint32_t >( stream.pData, stream.count, stream.stride, unComponents, pOut, unOutStride );
+					break;
+				case EAccessorComponent::Float:
+					ConvertUints< float >( stream.pData, stream.count, stream.stride, unComponents, pOut, unOutStride );
+					break;
+			}
+		}
+
+		template < typename T >
+		void ZeroFill( T *pOut, size_t unCount, uint32_t unComponents, size_t unOutStride )
+		{
+			uint8_t *pDst = reinterpret_cast< uint8_t * >( pOut );
+			for ( size_t i = 0; i < unCount; i++, pDst += unOutStride )
+				memset( pDst, 0, unComponents * sizeof( T ) );
+		}
+
+		// Indices - tightly packed streams are widened and offset 8 / 16 at a time
+		template < typename T >
+		void WidenIndicesScalar( const uint8_t *pSrc, size_t unCount, size_t unStride, uint32_t unBaseVertex, uint32_t *pOut )
+		{
+			for ( size_t i = 0; i < unCount; i++, pSrc += unStride )
+				pOut[ i ] = static_cast< uint32_t >( Load< T >( pSrc ) ) + unBaseVertex;
+		}
+
+		template < typename T >
+		void WidenIndices( const uint8_t *pSrc, size_t unCount, uint32_t unBaseVertex, uint32_t *pOut )
+		{
+			size_t i = 0;
+
+			#if defined( XRVK_ACCESSOR_SSE2 )
+				const __m128i vBase = _mm_set1_epi32( static_cast< int >( unBaseVertex ) );
+				const __m128i vZero = _mm_setzero_si128();
+				__m128i *pDst = reinterpret_cast< __m128i * >( pOut );
+
+				if constexpr ( sizeof( T ) == 1 )
+				{
+					for ( ; i + 16 <= unCount; i += 16, pDst += 4 )
+					{
+						const __m128i v = _mm_loadu_si128( reinterpret_cast< const __m128i * >( pSrc + i ) );
+						const __m128i vLo = _mm_unpacklo_epi8( v, vZero );
+						const __m128i vHi = _mm_unpackhi_epi8( v, vZero );
+						_mm_storeu_si128( pDst, _mm_add_epi32( _mm_unpacklo_epi16( vLo, vZero ), vBase ) );
+						_mm_storeu_si128( pDst + 1, _mm_add_epi32( _mm_unpackhi_epi16( vLo, vZero ), vBase ) );
+						_mm_storeu_si128( pDst + 2, _mm_add_epi32( _mm_unpacklo_epi16( vHi, vZero ), vBase ) );
+						_mm_storeu_si128( pDst + 3, _mm_add_epi32( _mm_unpackhi_epi16( vHi, vZero ), vBase ) );
+					}
+				}
+				else if constexpr ( sizeof( T ) == 2 )
+				{
+					for ( ; i + 8 <= unCount; i += 8, pDst += 2 )
+					{
+						const __m128i v = _mm_loadu_si128( reinterpret_cast< const __m128i * >( pSrc + i * 2 ) );
+						_mm_storeu_si128( pDst, _mm_add_epi32( _mm_unpacklo_epi16( v, vZero ), vBase ) );
+						_mm_storeu_si128( pDst + 1, _mm_add_epi32( _mm_unpackhi_epi16( v, vZero ), vBase ) );
+					}
+				}
+				else
+				{
+					for ( ; i + 4 <= unCount; i += 4, pDst++ )
+						_mm_storeu_si128( pDst, _mm_add_epi32( _mm_loadu_si128( reinterpret_cast< const __m128i * >( pSrc + i * 4 ) ), vBase ) );
+				}
+
+			#elif defined( XRVK_ACCESSOR_NEON )
+				const uint32x4_t vBase = vdupq_n_u32( unBaseVertex );
+
+				if constexpr ( sizeof( T ) == 1 )
+				{
+					for ( ; i + 16 <= unCount; i += 16 )
+					{
+						const uint8x16_t v = vld1q_u8( pSrc + i );
+						const uint16x8_t vLo = vmovl_u8( vget_low_u8( v ) );
+						const uint16x8_t vHi = vmovl_u8( vget_high_u8( v ) );
+						vst1q_u32( pOut + i, vaddq_u32( vmovl_u16( vget_low_u16( vLo ) ), vBase ) );
+						vst1q_u32( pOut + i + 4, vaddq_u32( vmovl_u16( vget_high_u16( vLo ) ), vBase ) );
+						vst1q_u32( pOut + i + 8, vaddq_u32( vmovl_u16( vget_low_u16( vHi ) ), vBase ) );
+						vst1q_u32( pOut + i + 12, vaddq_u32( vmovl_u16( vget_high_u16( vHi ) ), vBase ) );
+					}
+				}
+				else if constexpr ( sizeof( T ) == 2 )
+				{
+					for ( ; i + 8 <= unCount; i += 8 )
+					{
+						const uint16x8_t v = vreinterpretq_u16_u8( vld1q_u8( pSrc + i * 2 ) );
+						vst1q_u32( pOut + i, vaddq_u32( vmovl_u16( vget_low_u16( v ) ), vBase ) );
+						vst1q_u32( pOut + i + 4, vaddq_u32( vmovl_u16( vget_high_u16( v ) ), vBase ) );
+					}
+				}
+				else
+				{
+					for ( ; i + 4 <= unCount; i += 4 )
+						vst1q_u32( pOut + i, vaddq_u32( vreinterpretq_u32_u8( vld1q_u8( pSrc + i * 4 ) ), vBase ) );
+				}
+			#endif
+
+			WidenIndicesScalar< T >( pSrc + i * sizeof( T ), unCount - i, sizeof( T ), unBaseVertex, pOut + i );
+		}
+
+		template < typename T >
+		void DecodeIndicesDense( const SAccessorStream &stream, uint32_t unBaseVertex, uint32_t *pOut )
+		{
+			if ( stream.stride == sizeof( T ) )
+				WidenIndices< T >( stream.pData, stream.count, unBaseVertex, pOut );
+			else
+				WidenIndicesScalar< T >( stream.pData, stream.count, stream.stride, unBaseVertex, pOut );
+		}
+	} // namespace
+
+	uint32_t GetAccessorComponentSize( EAccessorComponent componentType )
+	{
+		switch ( componentType )
+		{
+			case EAccessorComponent::Byte:
+			case EAccessorComponent::UnsignedByte:
+				return 1;
+			case EAccessorComponent::Short:
+			case EAccessorComponent::UnsignedShort:
+				return 2;
+			case EAccessorComponent::UnsignedInt:
+			case EAccessorComponent::Float:
+				return 4;
+		}
+
+		return 0;
+	}
+
+	void DecodeAccessorFloat( const SAccessorStream &stream, float *pOut, uint32_t unOutComponents, size_t unOutStride )
+	{
+		const uint32_t unComponents = std::min( stream.componentCount, unOutComponents );
+		if ( stream.count == 0 || unComponents == 0 )
+			return;
+
+		if ( stream.pData )
+			DecodeFloatsDense( stream, unComponents, pOut, unOutStride );
+		else
+			ZeroFill( pOut, stream.count, unComponents, unOutStride );
+
+		ForEachSparseValue( stream, [ & ]( const SAccessorStream &value, uint32_t unElement ) 
+			{ DecodeFloatsDense( value, unComponents, reinterpret_cast< float * >( Advance( pOut, unElement * unOutStride ) ), unOutStride ); } );
+	}
+
+	void DecodeAccessorUint( const SAccessorStream &stream, uint32_t *pOut, uint32_t unOutComponents, size_t unOutStride )
+	{
+		const uint32_t unComponents = std::min( stream.componentCount, unOutComponents );
+		if ( stream.count == 0 || unComponents == 0 )
+			return;
+
+		if ( stream.pData )
+			DecodeUintsDense( stream, unComponents, pOut, unOutStride );
+		else
+			ZeroFill( pOut, stream.count, unComponents, unOutStride );
+
+		ForEachSparseValue( stream, [ & ]( const SAccessorStream &value, uint32_t unElement ) 
+			{ DecodeUintsDense( value, unComponents, reinterpret_cast< uint32_t * >( Advance( pOut, unElement * unOutStride ) ), unOutStride ); } );
+	}
+
+	bool DecodeIndices( const SAccessorStream &stream, uint32_t unBaseVertex, uint32_t *pOut )
+	{
+		if ( stream.componentCount != 1 )
+			return false;
+
+		void ( *fnDecode )( const SAccessorStream &, uint32_t, uint32_t * ) = nullptr;
+		switch ( stream.componentType )
+		{
+			case EAccessorComponent::UnsignedByte:
+				fnDecode = &DecodeIndicesDense< uint8_t >;
+				break;
+			case EAccessorComponent::UnsignedShort:
+				fnDecode = &DecodeIndicesDense< uint16_t >;
+				break;
+			case EAccessorComponent::UnsignedInt:
+				fnDecode = &DecodeIndicesDense< uint32_t >;
+				break;
+			default:
+				return false;
+		}
+
+		if ( stream.pData )
+			fnDecode( stream, unBaseVertex, pOut );
+		else
+			std::fill( pOut, pOut + stream.count, unBaseVertex );
+
+		ForEachSparseValue( stream, [ & ]( const SAccessorStream &value, uint32_t unElement ) { fnDecode( value, unBaseVertex, pOut + unElement ); } );
+		return true;
+	}
+
+	void GenerateSequentialIndices( uint32_t *pOut, size_t unCount, uint32_t unFirst )
+	{
+		size_t i = 0;
+
+		#if defined( XRVK_ACCESSOR_SSE2 )
+			const __m128i vStep = _mm_set1_epi32( 4 );
+			__m128i v = _mm_setr_epi32( static_cast< int >( unFirst ), static_cast< int >( unFirst + 1 ), static_cast< int >( unFirst + 2 ), static_cast< int >( unFirst + 3 ) );
+			for ( ; i + 4 <= unCount; i += 4, v = _mm_add_epi32( v, vStep ) )
+				_mm_storeu_si128( reinterpret_cast< __m128i * >( pOut + i ), v );
+		#elif defined( XRVK_ACCESSOR_NEON )
+			const uint32_t unFirstFour[ 4 ] = { unFirst, unFirst + 1, unFirst + 2, unFirst + 3 };
+			const uint32x4_t vStep = vdupq_n_u32( 4 );
+			uint32x4_t v = vld1q_u32( unFirstFour );
+			for ( ; i + 4 <= unCount; i += 4, v = vaddq_u32( v, vStep ) )
+				vst1q_u32( pOut + i, v );
+		#endif
+
+		for ( ; i < unCount; i++ )
+			pOut[ i ] = unFirst + static_cast< uint32_t >( i );
+	}
+
+} // namespace xrlib
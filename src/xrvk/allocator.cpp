@@ -0,0 +1,747 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#include <cstring>
+
+#include <xrvk/allocator.hpp>
+
+namespace xrlib
+{
+	std::mutex CDeviceMemoryAllocator::s_registryMutex;
+	std::unordered_map< VkDevice, CDeviceMemoryAllocator * > CDeviceMemoryAllocator::s_registry;
+
+	CDeviceMemoryAllocator *CDeviceMemoryAllocator::Get( VkDevice vkDevice, VkPhysicalDevice vkPhysicalDevice )
+	{
+		assert( vkDevice != VK_NULL_HANDLE && vkPhysicalDevice != VK_NULL_HANDLE );
+
+		std::scoped_lock lock( s_registryMutex );
+
+		auto it = s_registry.find( vkDevice );
+		if ( it != s_registry.end() )
+			return it->second;
+
+		CDeviceMemoryAllocator *pAllocator = new CDeviceMemoryAllocator( vkDevice, vkPhysicalDevice );
+		s_registry[ vkDevice ] = pAllocator;
+		return pAllocator;
+	}
+
+	CDeviceMemoryAllocator *CDeviceMemoryAllocator::Get( CSession *pSession )
+	{
+		assert( pSession );
+		return Get( pSession->GetVulkan()->GetVkLogicalDevice(), pSession->GetVulkan()->GetVkPhysicalDevice() );
+	}
+
+	void CDeviceMemoryAllocator::Destroy( VkDevice vkDevice )
+	{
+		std::scoped_lock lock( s_registryMutex );
+
+		auto it = s_registry.find( vkDevice );
+		if ( it == s_registry.end() )
+			return;
+
+		delete it->second;
+		s_registry.erase( it );
+	}
+
+	CDeviceMemoryAllocator::CDeviceMemoryAllocator( VkDevice vkDevice, VkPhysicalDevice vkPhysicalDevice, VkDeviceSize unBlockSize )
+		: m_vkDevice( vkDevice )
+		, m_vkPhysicalDevice( vkPhysicalDevice )
+		, m_unBlockSize( unBlockSize )
+	{
+		vkGetPhysicalDeviceMemoryProperties( m_vkPhysicalDevice, &m_vkMemoryProperties );
+
+		VkPhysicalDeviceProperties deviceProps;
+		vkGetPhysicalDeviceProperties( m_vkPhysicalDevice, &deviceProps );
+		m_unNonCoherentAtomSize = std::max< VkDeviceSize >( deviceProps.limits.nonCoherentAtomSize, 1 );
+		m_unMaxAllocationCount = deviceProps.limits.maxMemoryAllocationCount;
+
+		m_vecPools.resize( m_vkMemoryProperties.memoryTypeCount * (uint32_t) EAllocationKind::EMax );
+		m_vecHeapBytes.resize( m_vkMemoryProperties.memoryHeapCount, 0 );
+
+		// CVulkan enables VK_EXT_memory_budget whenever the physical device supports it
+		uint32_t unExtensionCount = 0;
+		vkEnumerateDeviceExtensionProperties( m_vkPhysicalDevice, nullptr, &unExtensionCount, nullptr );
+		std::vector< VkExtensionProperties > vecExtensions( unExtensionCount );
+		vkEnumerateDeviceExtensionProperties( m_vkPhysicalDevice, nullptr, &unExtensionCount, vecExtensions.data() );
+
+		for ( auto &extension : vecExtensions )
+		{
+			if ( strcmp( extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME ) == 0 )
+			{
+				m_bMemoryBudgetSupported = true;
+				break;
+			}
+		}
+	}
+
+	CDeviceMemoryAllocator::~CDeviceMemoryAllocator()
+	{
+		uint32_t unLeakedAllocations = 0;
+
+		for ( auto &pool : m_vecPools )
+		{
+			for ( SMemoryBlock *pBlock : pool.blocks )
+			{
+				unLeakedAllocations += (uint32_t) pBlock->allocations.size();
+
+				if ( pBlock->pMapped )
+					vkUnmapMemory( m_vkDevice, pBlock->memory );
+
+				vkFreeMemory( m_vkDevice, pBlock->memory, nullptr );
+				delete pBlock;
+			}
+
+			pool.blocks.clear();
+		}
+
+		if ( unLeakedAllocations > 0 || m_unDedicatedAllocationCount > 0 )
+			LogWarning( "", "Device memory allocator destroyed with %i live sub-allocations and %i live dedicated allocations", unLeakedAllocations, m_unDedicatedAllocationCount );
+	}
+
+	VkResult CDeviceMemoryAllocator::Allocate(
+		SMemoryAllocation *&outAllocation,
+		const VkMemoryRequirements &memReqs,
+		VkMemoryPropertyFlags memPropFlags,
+		EAllocationKind kind,
+		bool bDedicated,
+		const void *pAllocateNext )
+	{
+		std::scoped_lock lock( m_mutex );
+
+		// Resolve the memory type before allocating bookkeeping, this throws if there is no match
+		const uint32_t unMemoryTypeIndex = FindMemoryType( memPropFlags, memReqs.memoryTypeBits );
+
+		SMemoryAllocation *pAllocation = new SMemoryAllocation();
+		pAllocation->memoryTypeIndex = unMemoryTypeIndex;
+		pAllocation->kind = kind;
+		pAllocation->size = memReqs.size;
+		pAllocation->alignment = std::max< VkDeviceSize >( memReqs.alignment, 1 );
+
+		// Non-coherent memory needs allocations aligned to the atom size so flushes don't touch neighbours
+		if ( IsHostVisible( pAllocation->memoryTypeIndex ) && !IsHostCoherent( pAllocation->memoryTypeIndex ) )
+		{
+			pAllocation->alignment = std::max( pAllocation->alignment, m_unNonCoherentAtomSize );
+			pAllocation->size = AlignUp( pAllocation->size, m_unNonCoherentAtomSize );
+		}
+
+		// Large or special allocations get their own device memory
+		if ( bDedicated || pAllocateNext || pAllocation->size > GetBlockSize( pAllocation->memoryTypeIndex ) / 2 )
+		{
+			VkResult result = AllocateDedicated( pAllocation, pAllocation->size, pAllocateNext );
+			if ( result != VK_SUCCESS )
+			{
+				delete pAllocation;
+				return result;
+			}
+
+			outAllocation = pAllocation;
+			return VK_SUCCESS;
+		}
+
+		SMemoryPool &pool = GetPool( pAllocation->memoryTypeIndex, kind );
+
+		// Small allocations are rounded up to a size class, freed slots of the same class are reused as-is
+		pAllocation->sizeClass = GetSizeClass( pAllocation->size, pAllocation->alignment );
+		pAllocation->reservedSize = pAllocation->sizeClass < 0 ? pAllocation->size : GetSizeClassBytes( pAllocation->sizeClass );
+
+		if ( pAllocation->sizeClass >= 0 )
+		{
+			auto &cache = pool.sizeClassCache[ pAllocation->sizeClass ];
+			for ( size_t i = cache.size(); i-- > 0; )
+			{
+				if ( cache[ i ].second % pAllocation->alignment != 0 )
+					continue;
+
+				pAllocation->pBlock = cache[ i ].first;
+				pAllocation->offset = cache[ i ].second;
+				pAllocation->memory = pAllocation->pBlock->memory;
+
+				pAllocation->pBlock->usedSize += pAllocation->reservedSize;
+				pAllocation->pBlock->allocations.insert( pAllocation );
+
+				cache[ i ] = cache.back();
+				cache.pop_back();
+
+				outAllocation = pAllocation;
+				return VK_SUCCESS;
+			}
+		}
+
+		// Best fit from existing blocks, then a new block
+		if ( !AllocateFromPool( pool, pAllocation ) )
+		{
+			SMemoryBlock *pBlock = CreateBlock( pAllocation->memoryTypeIndex, kind, GetBlockSize( pAllocation->memoryTypeIndex ) );
+			if ( !pBlock )
+			{
+				// Out of blocks (memory or allocation count) - try returning cached slots first
+				Trim();
+				if ( !AllocateFromPool( pool, pAllocation ) )
+				{
+					LogError( "", "Unable to allocate %llu bytes from memory type %i", (unsigned long long) pAllocation->size, pAllocation->memoryTypeIndex );
+					LogHeapBudgets();
+
+					delete pAllocation;
+					return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+				}
+			}
+			else
+			{
+				pool.blocks.push_back( pBlock );
+				bool bAllocated = AllocateFromPool( pool, pAllocation );
+				assert( bAllocated );
+				( void ) bAllocated;
+			}
+		}
+
+		outAllocation = pAllocation;
+		return VK_SUCCESS;
+	}
+
+	VkResult CDeviceMemoryAllocator::AllocateAndBindBuffer( SMemoryAllocation *&outAllocation, VkBuffer vkBuffer, VkMemoryPropertyFlags memPropFlags, bool bDeviceAddress )
+	{
+		VkMemoryRequirements memReqs;
+		vkGetBufferMemoryRequirements( m_vkDevice, vkBuffer, &memReqs );
+
+		// Device address buffers need the allocate flag on their memory, keep these dedicated
+		VkMemoryAllocateFlagsInfoKHR memAllocFlags { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO_KHR };
+		memAllocFlags.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR;
+
+		VK_CHECK_RETURN( Allocate( outAllocation, memReqs, memPropFlags, EAllocationKind::Linear, bDeviceAddress, bDeviceAddress ? &memAllocFlags : nullptr ) );
+		return vkBindBufferMemory( m_vkDevice, vkBuffer, outAllocation->memory, outAllocation->offset );
+	}
+
+	VkResult CDeviceMemoryAllocator::AllocateAndBindImage( SMemoryAllocation *&outAllocation, VkImage vkImage, VkMemoryPropertyFlags memPropFlags, VkImageTiling tiling )
+	{
+		VkMemoryRequirements memReqs;
+		vkGetImageMemoryRequirements( m_vkDevice, vkImage, &memReqs );
+
+		EAllocationKind kind = tiling == VK_IMAGE_TILING_OPTIMAL ? EAllocationKind::Optimal : EAllocationKind::Linear;
+		VK_CHECK_RETURN( Allocate( outAllocation, memReqs, memPropFlags, kind ) );
+		return vkBindImageMemory( m_vkDevice, vkImage, outAllocation->memory, outAllocation->offset );
+	}
+
+	void CDeviceMemoryAllocator::Free( SMemoryAllocation *pAllocation )
+	{
+		if ( !pAllocation )
+			return;
+
+		std::scoped_lock lock( m_mutex );
+
+		// Dedicated allocations own their memory
+		if ( pAllocation->IsDedicated() )
+		{
+			if ( pAllocation->pDedicatedMapped )
+				vkUnmapMemory( m_vkDevice, pAllocation->memory );
+
+			vkFreeMemory( m_vkDevice, pAllocation->memory, nullptr );
+			TrackHeapBytes( pAllocation->memoryTypeIndex, pAllocation->size, false );
+
+			m_unDeviceAllocationCount--;
+			m_unDedicatedAllocationCount--;
+			m_unDedicatedBytes -= pAllocation->size;
+
+			delete pAllocation;
+			return;
+		}
+
+		SMemoryBlock *pBlock = pAllocation->pBlock;
+		SMemoryPool &pool = GetPool( pBlock->memoryTypeIndex, pBlock->kind );
+
+		pBlock->allocations.erase( pAllocation );
+		pBlock->usedSize -= pAllocation->reservedSize;
+
+		// Drop any maps the owner didn't release
+		if ( pAllocation->mapCount > 0 )
+		{
+			pBlock->mapCount -= std::min( pBlock->mapCount, pAllocation->mapCount );
+			if ( pBlock->mapCount == 0 && pBlock->pMapped )
+			{
+				vkUnmapMemory( m_vkDevice, pBlock->memory );
+				pBlock->pMapped = nullptr;
+			}
+		}
+
+		if ( pAllocation->sizeClass >= 0 )
+			pool.sizeClassCache[ pAllocation->sizeClass ].push_back( { pBlock, pAllocation->offset } );
+		else
+			InsertFreeRange( pBlock, pAllocation->offset, pAllocation->reservedSize );
+
+		delete pAllocation;
+
+		// Empty block - return its cached slots, and release it unless it's the last block of the pool
+		if ( pBlock->allocations.empty() )
+		{
+			for ( auto &cache : pool.sizeClassCache )
+			{
+				for ( size_t i = cache.size(); i-- > 0; )
+				{
+					if ( cache[ i ].first != pBlock )
+						continue;
+
+					cache[ i ] = cache.back();
+					cache.pop_back();
+				}
+			}
+
+			pBlock->freeByOffset.clear();
+			pBlock->freeBySize.clear();
+			InsertFreeRange( pBlock, 0, pBlock->size );
+
+			if ( pool.blocks.size() > 1 )
+				ReleaseBlock( pool, pBlock );
+		}
+	}
+
+	VkResult CDeviceMemoryAllocator::Map( SMemoryAllocation *pAllocation, void **ppOutData )
+	{
+		assert( pAllocation && ppOutData );
+		std::scoped_lock lock( m_mutex );
+
+		if ( pAllocation->IsDedicated() )
+		{
+			if ( pAllocation->mapCount == 0 )
+				VK_CHECK_RETURN( vkMapMemory( m_vkDevice, pAllocation->memory, 0, VK_WHOLE_SIZE, 0, &pAllocation->pDedicatedMapped ) );
+
+			pAllocation->mapCount++;
+			*ppOutData = pAllocation->pDedicatedMapped;
+			return VK_SUCCESS;
+		}
+
+		SMemoryBlock *pBlock = pAllocation->pBlock;
+		if ( pBlock->mapCount == 0 )
+			VK_CHECK_RETURN( vkMapMemory( m_vkDevice, pBlock->memory, 0, VK_WHOLE_SIZE, 0, &pBlock->pMapped ) );
+
+		pBlock->mapCount++;
+		pAllocation->mapCount++;
+		*ppOutData = static_cast< uint8_t * >( pBlock->pMapped ) + pAllocation->offset;
+		return VK_SUCCESS;
+	}
+
+	void CDeviceMemoryAllocator::Unmap( SMemoryAllocation *pAllocation )
+	{
+		assert( pAllocation );
+		std::scoped_lock lock( m_mutex );
+
+		if ( pAllocation->IsDedicated() )
+		{
+			if ( pAllocation->mapCount > 0 && --pAllocation->mapCount == 0 )
+			{
+				vkUnmapMemory( m_vkDevice, pAllocation->memory );
+				pAllocation->pDedicatedMapped = nullptr;
+			}
+
+			return;
+		}
+
+		if ( pAllocation->mapCount == 0 )
+			return;
+
+		pAllocation->mapCount--;
+
+		SMemoryBlock *pBlock = pAllocation->pBlock;
+		if ( pBlock->mapCount > 0 && --pBlock->mapCount == 0 )
+		{
+			vkUnmapMemory( m_vkDevice, pBlock->memory );
+			pBlock->pMapped = nullptr;
+		}
+	}
+
+	VkResult CDeviceMemoryAllocator::Flush( SMemoryAllocation *pAllocation, VkDeviceSize unOffset, VkDeviceSize unSize )
+	{
+		assert( pAllocation );
+
+		if ( IsHostCoherent( pAllocation->memoryTypeIndex ) )
+			return VK_SUCCESS;
+
+		if ( unSize == VK_WHOLE_SIZE )
+			unSize = pAllocation->size - unOffset;
+
+		// Flush ranges must be aligned to the non coherent atom size
+		VkDeviceSize unStart = ( pAllocation->offset + unOffset ) / m_unNonCoherentAtomSize * m_unNonCoherentAtomSize;
+		VkDeviceSize unEnd = AlignUp( pAllocation->offset + unOffset + unSize, m_unNonCoherentAtomSize );
+
+		VkMappedMemoryRange mappedRange { VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE };
+		mappedRange.memory = pAllocation->memory;
+		mappedRange.offset = unStart;
+		mappedRange.size = unEnd - unStart;
+
+		VkDeviceSize unMemorySize = pAllocation->IsDedicated() ? pAllocation->size : pAllocation->pBlock->size;
+		if ( unEnd >= unMemorySize )
+			mappedRange.size = VK_WHOLE_SIZE;
+
+		return vkFlushMappedMemoryRanges( m_vkDevice, 1, &mappedRange );
+	}
+
+	void CDeviceMemoryAllocator::Trim()
+	{
+		std::scoped_lock lock( m_mutex );
+
+		for ( auto &pool : m_vecPools )
+		{
+			for ( int32_t nSizeClass = 0; nSizeClass < (int32_t) k_unSizeClassCount; nSizeClass++ )
+			{
+				for ( auto &slot : pool.sizeClassCache[ nSizeClass ] )
+					InsertFreeRange( slot.first, slot.second, GetSizeClassBytes( nSizeClass ) );
+
+				pool.sizeClassCache[ nSizeClass ].clear();
+			}
+
+			for ( size_t i = pool.blocks.size(); i-- > 0; )
+			{
+				if ( pool.blocks[ i ]->allocations.empty() )
+					ReleaseBlock( pool, pool.blocks[ i ] );
+			}
+		}
+	}
+
+	void CDeviceMemoryAllocator::GetStats( SMemoryStats &outTotal, std::vector< SMemoryStats > *pOutPerMemoryType )
+	{
+		std::scoped_lock lock( m_mutex );
+
+		outTotal = {};
+		if ( pOutPerMemoryType )
+			pOutPerMemoryType->assign( m_vkMemoryProperties.memoryTypeCount, {} );
+
+		for ( uint32_t i = 0; i < m_vecPools.size(); i++ )
+		{
+			SMemoryStats poolStats;
+			for ( SMemoryBlock *pBlock : m_vecPools[ i ].blocks )
+			{
+				poolStats.blockCount++;
+				poolStats.allocationCount += (uint32_t) pBlock->allocations.size();
+				poolStats.blockBytes += pBlock->size;
+				poolStats.usedBytes += pBlock->usedSize;
+			}
+
+			for ( auto &cache : m_vecPools[ i ].sizeClassCache )
+				poolStats.cachedSlotCount += (uint32_t) cache.size();
+
+			outTotal.blockCount += poolStats.blockCount;
+			outTotal.allocationCount += poolStats.allocationCount;
+			outTotal.blockBytes += poolStats.blockBytes;
+			outTotal.usedBytes += poolStats.usedBytes;
+			outTotal.cachedSlotCount += poolStats.cachedSlotCount;
+
+			if ( pOutPerMemoryType )
+			{
+				SMemoryStats &typeStats = ( *pOutPerMemoryType )[ i / (uint32_t) EAllocationKind::EMax ];
+				typeStats.blockCount += poolStats.blockCount;
+				typeStats.allocationCount += poolStats.allocationCount;
+				typeStats.blockBytes += poolStats.blockBytes;
+				typeStats.usedBytes += poolStats.usedBytes;
+				typeStats.cachedSlotCount += poolStats.cachedSlotCount;
+			}
+		}
+
+		outTotal.dedicatedAllocationCount = m_unDedicatedAllocationCount;
+		outTotal.dedicatedBytes = m_unDedicatedBytes;
+	}
+
+	void CDeviceMemoryAllocator::LogStats()
+	{
+		SMemoryStats total;
+		std::vector< SMemoryStats > vecPerType;
+		GetStats( total, &vecPerType );
+
+		LogInfo( "", "Device memory: %i blocks (%.2f MB, %.2f MB used), %i sub-allocations, %i dedicated (%.2f MB), %i vkAllocateMemory calls live",
+			total.blockCount, total.blockBytes / 1048576.0, total.usedBytes / 1048576.0, total.allocationCount, total.dedicatedAllocationCount, total.dedicatedBytes / 1048576.0, m_unDeviceAllocationCount );
+
+		for ( uint32_t i = 0; i < vecPerType.size(); i++ )
+		{
+			if ( vecPerType[ i ].blockCount == 0 )
+				continue;
+
+			LogInfo( "", "\tMemory type %i (heap %i): %i blocks, %.2f MB used of %.2f MB, %i sub-allocations, %i cached slots",
+				i, m_vkMemoryProperties.memoryTypes[ i ].heapIndex, vecPerType[ i ].blockCount, vecPerType[ i ].usedBytes / 1048576.0, vecPerType[ i ].blockBytes / 1048576.0, vecPerType[ i ].allocationCount, vecPerType[ i ].cachedSlotCount );
+		}
+
+		LogHeapBudgets();
+	}
+
+	void CDeviceMemoryAllocator::GetHeapBudgets( std::vector< SMemoryHeapBudget > &outBudgets )
+	{
+		outBudgets.assign( m_vkMemoryProperties.memoryHeapCount, {} );
+
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProps { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT };
+		if ( m_bMemoryBudgetSupported )
+		{
+			VkPhysicalDeviceMemoryProperties2 memProps2 { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2 };
+			memProps2.pNext = &budgetProps;
+			vkGetPhysicalDeviceMemoryProperties2( m_vkPhysicalDevice, &memProps2 );
+		}
+
+		std::scoped_lock lock( m_mutex );
+		for ( uint32_t i = 0; i < m_vkMemoryProperties.memoryHeapCount; i++ )
+		{
+			SMemoryHeapBudget &heapBudget = outBudgets[ i ];
+			heapBudget.size = m_vkMemoryProperties.memoryHeaps[ i ].size;
+			heapBudget.flags = m_vkMemoryProperties.memoryHeaps[ i ].flags;
+			heapBudget.allocatorBytes = m_vecHeapBytes[ i ];
+
+			if ( m_bMemoryBudgetSupported )
+			{
+				heapBudget.budget = budgetProps.heapBudget[ i ];
+				heapBudget.usage = budgetProps.heapUsage[ i ];
+			}
+			else
+			{
+				// Other processes (incl. the openxr runtime compositor) share the heap, assume 80% is ours to use
+				heapBudget.budget = heapBudget.size * 8 / 10;
+				heapBudget.usage = heapBudget.allocatorBytes;
+			}
+		}
+	}
+
+	void CDeviceMemoryAllocator::LogHeapBudgets()
+	{
+		std::vector< SMemoryHeapBudget > vecBudgets;
+		GetHeapBudgets( vecBudgets );
+
+		for ( uint32_t i = 0; i < vecBudgets.size(); i++ )
+		{
+			LogInfo( "", "\tMemory heap %i%s: %.2f MB used of %.2f MB budget (%.2f MB heap, %.2f MB by this allocator)%s",
+				i,
+				( vecBudgets[ i ].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT ) ? " (device local)" : "",
+				vecBudgets[ i ].usage / 1048576.0,
+				vecBudgets[ i ].budget / 1048576.0,
+				vecBudgets[ i ].size / 1048576.0,
+				vecBudgets[ i ].allocatorBytes / 1048576.0,
+				m_bMemoryBudgetSupported ? "" : " - estimated, VK_EXT_memory_budget unavailable" );
+		}
+	}
+
+	float CDeviceMemoryAllocator::GetDeviceLocalBudgetUsage()
+	{
+		std::vector< SMemoryHeapBudget > vecBudgets;
+		GetHeapBudgets( vecBudgets );
+
+		float fUsage = 0.f;
+		for ( auto &heapBudget : vecBudgets )
+		{
+			if ( ( heapBudget.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT ) == 0 || heapBudget.budget == 0 )
+				continue;
+
+			fUsage = std::max( fUsage, (float) ( (double) heapBudget.usage / (double) heapBudget.budget ) );
+		}
+
+		return fUsage;
+	}
+
+	uint32_t CDeviceMemoryAllocator::FindMemoryType( VkMemoryPropertyFlags memPropFlags, uint32_t unBits )
+	{
+		for ( uint32_t i = 0; i < m_vkMemoryProperties.memoryTypeCount; i++ )
+			if ( ( unBits & ( 1 << i ) ) && ( m_vkMemoryProperties.memoryTypes[ i ].propertyFlags & memPropFlags ) == memPropFlags )
+				return i;
+
+		throw std::runtime_error( "FATAL: Unable to find requested memory type for device's physical device." );
+	}
+
+	VkDeviceSize CDeviceMemoryAllocator::GetBlockSize( uint32_t unMemoryTypeIndex )
+	{
+		// Use smaller blocks on small heaps
+		VkDeviceSize unHeapSize = m_vkMemoryProperties.memoryHeaps[ m_vkMemoryProperties.memoryTypes[ unMemoryTypeIndex ].heapIndex ].size;
+		if ( unHeapSize <= 1024ull * 1024 * 1024 )
+			return std::min( m_unBlockSize, AlignUp( unHeapSize / 8, 1024 * 1024 ) );
+
+		return m_unBlockSize;
+	}
+
+	VkResult CDeviceMemoryAllocator::AllocateDedicated( SMemoryAllocation *pAllocation, VkDeviceSize unSize, const void *pAllocateNext )
+	{
+		if ( m_unDeviceAllocationCount >= m_unMaxAllocationCount )
+			return VK_ERROR_TOO_MANY_OBJECTS;
+
+		VkMemoryAllocateInfo memAllocInfo { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+		memAllocInfo.pNext = pAllocateNext;
+		memAllocInfo.allocationSize = unSize;
+		memAllocInfo.memoryTypeIndex = pAllocation->memoryTypeIndex;
+
+		VkResult result = vkAllocateMemory( m_vkDevice, &memAllocInfo, nullptr, &pAllocation->memory );
+		if ( result != VK_SUCCESS )
+		{
+			LogError( "", "Unable to allocate %llu bytes of dedicated memory from memory type %i", (unsigned long long) unSize, pAllocation->memoryTypeIndex );
+			LogHeapBudgets();
+			return result;
+		}
+
+		TrackHeapBytes( pAllocation->memoryTypeIndex, unSize, true );
+		pAllocation->offset = 0;
+		pAllocation->reservedSize = unSize;
+		pAllocation->pBlock = nullptr;
+
+		m_unDeviceAllocationCount++;
+		m_unDedicatedAllocationCount++;
+		m_unDedicatedBytes += unSize;
+
+		return VK_SUCCESS;
+	}
+
+	SMemoryBlock *CDeviceMemoryAllocator::CreateBlock( uint32_t unMemoryTypeIndex, EAllocationKind kind, VkDeviceSize unSize )
+	{
+		if ( m_unDeviceAllocationCount >= m_unMaxAllocationCount )
+			return nullptr;
+
+		VkMemoryAllocateInfo memAllocInfo { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+		memAllocInfo.allocationSize = unSize;
+		memAllocInfo.memoryTypeIndex = unMemoryTypeIndex;
+
+		VkDeviceMemory vkMemory = VK_NULL_HANDLE;
+		if ( vkAllocateMemory( m_vkDevice, &memAllocInfo, nullptr, &vkMemory ) != VK_SUCCESS )
+			return nullptr;
+
+		SMemoryBlock *pBlock = new SMemoryBlock();
+		pBlock->memory = vkMemory;
+		pBlock->size = unSize;
+		pBlock->memoryTypeIndex = unMemoryTypeIndex;
+		pBlock->kind = kind;
+		InsertFreeRange( pBlock, 0, unSize );
+
+		TrackHeapBytes( unMemoryTypeIndex, unSize, true );
+		m_unDeviceAllocationCount++;
+		return pBlock;
+	}
+
+	void CDeviceMemoryAllocator::ReleaseBlock( SMemoryPool &pool, SMemoryBlock *pBlock )
+	{
+		assert( pBlock->allocations.empty() );
+
+		// Drop any cached slots still pointing to this block
+		for ( auto &cache : pool.sizeClassCache )
+			cache.erase( std::remove_if( cache.begin(), cache.end(), [ pBlock ]( const auto &slot ) { return slot.first == pBlock; } ), cache.end() );
+
+		if ( pBlock->pMapped )
+			vkUnmapMemory( m_vkDevice, pBlock->memory );
+
+		vkFreeMemory( m_vkDevice, pBlock->memory, nullptr );
+		TrackHeapBytes( pBlock->memoryTypeIndex, pBlock->size, false );
+		m_unDeviceAllocationCount--;
+
+		pool.blocks.erase( std::remove( pool.blocks.begin(), pool.blocks.end(), pBlock ), pool.blocks.end() );
+		delete pBlock;
+	}
+
+	bool CDeviceMemoryAllocator::AllocateFromBlock( SMemoryBlock *pBlock, VkDeviceSize unSize, VkDeviceSize unAlignment, VkDeviceSize &outOffset )
+	{
+		// Best fit - smallest free range that fits the aligned request
+		for ( auto it = pBlock->freeBySize.lower_bound( unSize ); it != pBlock->freeBySize.end(); ++it )
+		{
+			VkDeviceSize unRangeOffset = it->second;
+			VkDeviceSize unRangeSize = it->first;
+			VkDeviceSize unAlignedOffset = AlignUp( unRangeOffset, unAlignment );
+			VkDeviceSize unPadding = unAlignedOffset - unRangeOffset;
+
+			if ( unPadding + unSize > unRangeSize )
+				continue;
+
+			EraseFreeRange( pBlock, unRangeOffset, unRangeSize );
+
+			if ( unPadding > 0 )
+				InsertFreeRange( pBlock, unRangeOffset, unPadding );
+
+			if ( unRangeSize > unPadding + unSize )
+				InsertFreeRange( pBlock, unAlignedOffset + unSize, unRangeSize - unPadding - unSize );
+
+			outOffset = unAlignedOffset;
+			return true;
+		}
+
+		return false;
+	}
+
+	bool CDeviceMemoryAllocator::AllocateFromPool( SMemoryPool &pool, SMemoryAllocation *pAllocation )
+	{
+		for ( SMemoryBlock *pBlock : pool.blocks )
+		{
+			if ( pBlock->size - pBlock->usedSize < pAllocation->reservedSize )
+				continue;
+
+			VkDeviceSize unOffset = 0;
+			if ( !AllocateFromBlock( pBlock, pAllocation->reservedSize, pAllocation->alignment, unOffset ) )
+				continue;
+
+			pAllocation->pBlock = pBlock;
+			pAllocation->memory = pBlock->memory;
+			pAllocation->offset = unOffset;
+
+			pBlock->usedSize += pAllocation->reservedSize;
+			pBlock->allocations.insert( pAllocation );
+			return true;
+		}
+
+		return false;
+	}
+
+	void CDeviceMemoryAllocator::InsertFreeRange( SMemoryBlock *pBlock, VkDeviceSize unOffset, VkDeviceSize unSize )
+	{
+		// Coalesce with next range
+		auto itNext = pBlock->freeByOffset.lower_bound( unOffset );
+		if ( itNext != pBlock->freeByOffset.end() && unOffset + unSize == itNext->first )
+		{
+			VkDeviceSize unNextSize = itNext->second;
+			EraseFreeRange( pBlock, itNext->first, unNextSize );
+			unSize += unNextSize;
+		}
+
+		// Coalesce with previous range
+		auto itPrev = pBlock->freeByOffset.lower_bound( unOffset );
+		if ( itPrev != pBlock->freeByOffset.begin() )
+		{
+			--itPrev;
+			if ( itPrev->first + itPrev->second == unOffset )
+			{
+				VkDeviceSize unPrevOffset = itPrev->first;
+				VkDeviceSize unPrevSize = itPrev->second;
+				EraseFreeRange( pBlock, unPrevOffset, unPrevSize );
+				unOffset = unPrevOffset;
+				unSize += unPrevSize;
+			}
+		}
+
+		pBlock->freeByOffset[ unOffset ] = unSize;
+		pBlock->freeBySize.insert( { unSize, unOffset } );
+	}
+
+	void CDeviceMemoryAllocator::EraseFreeRange( SMemoryBlock *pBlock, VkDeviceSize unOffset, VkDeviceSize unSize )
+	{
+		pBlock->freeByOffset.erase( unOffset );
+
+		auto range = pBlock->freeBySize.equal_range( unSize );
+		for ( auto it = range.first; it != range.second; ++it )
+		{
+			if ( it->second == unOffset )
+			{
+				pBlock->freeBySize.erase( it );
+				break;
+			}
+		}
+	}
+
+	void CDeviceMemoryAllocator::TrackHeapBytes( uint32_t unMemoryTypeIndex, VkDeviceSize unSize, bool bAdd )
+	{
+		VkDeviceSize &unHeapBytes = m_vecHeapBytes[ m_vkMemoryProperties.memoryTypes[ unMemoryTypeIndex ].heapIndex ];
+		unHeapBytes = bAdd ? unHeapBytes + unSize : unHeapBytes - std::min( unHeapBytes, unSize );
+	}
+
+	int32_t CDeviceMemoryAllocator::GetSizeClass( VkDeviceSize unSize, VkDeviceSize unAlignment )
+	{
+		if ( unSize > k_unMaxSizeClass || unAlignment > k_unMaxSizeClass )
+			return -1;
+
+		int32_t nSizeClass = 0;
+		while ( GetSizeClassBytes( nSizeClass ) < unSize )
+			nSizeClass++;
+
+		return nSizeClass;
+	}
+
+} // namespace xrlib
@@ -0,0 +1,672 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#include <xrvk/animation.hpp>
+#include <xrvk/mesh.hpp>
+#include <xrlib/thread_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+	#define XRVK_ANIMATION_SSE
+	#include <xmmintrin.h>
+#elif defined( __ARM_NEON ) && ( defined( __aarch64__ ) || defined( _M_ARM64 ) )
+	#define XRVK_ANIMATION_NEON
+	#include <arm_neon.h>
+#endif
+
+namespace xrlib
+{
+	namespace
+	{
+		// Translation, rotation and scale values are sampled and blended four lanes at a time (lane 3 is zero for vectors)
+	#if defined( XRVK_ANIMATION_SSE )
+		using Float4 = __m128;
+
+		inline Float4 Load4( const float *p ) { return _mm_loadu_ps( p ); }
+		inline Float4 Load3( const float *p ) { return _mm_movelh_ps( _mm_loadl_pi( _mm_setzero_ps(), reinterpret_cast< const __m64 * >( p ) ), _mm_load_ss( p + 2 ) ); }
+		inline void Store4( float *p, Float4 v ) { _mm_storeu_ps( p, v ); }
+		inline void Store3( float *p, Float4 v )
+		{
+			_mm_storel_pi( reinterpret_cast< __m64 * >( p ), v );
+			_mm_store_ss( p + 2, _mm_movehl_ps( v, v ) );
+		}
+
+		inline Float4 Splat( float f ) { return _mm_set1_ps( f ); }
+		inline Float4 Set( float x, float y, float z, float w ) { return _mm_setr_ps( x, y, z, w ); }
+		inline Float4 Add( Float4 a, Float4 b ) { return _mm_add_ps( a, b ); }
+		inline Float4 Sub( Float4 a, Float4 b ) { return _mm_sub_ps( a, b ); }
+		inline Float4 Mul( Float4 a, Float4 b ) { return _mm_mul_ps( a, b ); }
+		inline Float4 MulAdd( Float4 a, Float4 b, Float4 c ) { return _mm_add_ps( _mm_mul_ps( a, b ), c ); }
+
+		inline float Dot4( Float4 a, Float4 b )
+		{
+			__m128 m = _mm_mul_ps( a, b );
+			m = _mm_add_ps( m, _mm_movehl_ps( m, m ) );
+			m = _mm_add_ss( m, _mm_shuffle_ps( m, m, _MM_SHUFFLE( 1, 1, 1, 1 ) ) );
+			return _mm_cvtss_f32( m );
+		}
+	#elif defined( XRVK_ANIMATION_NEON )
+		using Float4 = float32x4_t;
+
+		inline Float4 Load4( const float *p ) { return vld1q_f32( p ); }
+		inline Float4 Load3( const float *p ) { return vcombine_f32( vld1_f32( p ), vset_lane_f32( p[ 2 ], vdup_n_f32( 0.f ), 0 ) ); }
+		inline void Store4( float *p, Float4 v ) { vst1q_f32( p, v ); }
+		inline void Store3( float *p, Float4 v )
+		{
+			vst1_f32( p, vget_low_f32( v ) );
+			p[ 2 ] = vgetq_lane_f32( v, 2 );
+		}
+
+		inline Float4 Splat( float f ) { return vdupq_n_f32( f ); }
+		inline Float4 Set( float x, float y, float z, float w ) { return { x, y, z, w }; }
+		inline Float4 Add( Float4 a, Float4 b ) { return vaddq_f32( a, b ); }
+		inline Float4 Sub( Float4 a, Float4 b ) { return vsubq_f32( a, b ); }
+		inline Float4 Mul( Float4 a, Float4 b ) { return vmulq_f32( a, b ); }
+		inline Float4 MulAdd( Float4 a, Float4 b, Float4 c ) { return vfmaq_f32( c, a, b ); }
+		inline float Dot4( Float4 a, Float4 b ) { return vaddvq_f32( vmulq_f32( a, b ) ); }
+	#else
+		struct Float4
+		{
+			float v[ 4 ];
+		};
+
+		inline Float4 Load4( const float *p ) { return { p[ 0 ], p[ 1 ], p[ 2 ], p[ 3 ] }; }
+		inline Float4 Load3( const float *p ) { return { p[ 0 ], p[ 1 ], p[ 2 ], 0.f }; }
+		inline void Store4( float *p, Float4 v ) { memcpy( p, v.v, sizeof( float ) * 4 ); }
+		inline void Store3( float *p, Float4 v ) { memcpy( p, v.v, sizeof( float ) * 3 ); }
+
+		inline Float4 Splat( float f ) { return { f, f, f, f }; }
+		inline Float4 Set( float x, float y, float z, float w ) { return { x, y, z, w }; }
+		inline Float4 Add( Float4 a, Float4 b ) { return { a.v[ 0 ] + b.v[ 0 ], a.v[ 1 ] + b.v[ 1 ], a.v[ 2 ] + b.v[ 2 ], a.v[ 3 ] + b.v[ 3 ] }; }
+		inline Float4 Sub( Float4 a, Float4 b ) { return { a.v[ 0 ] - b.v[ 0 ], a.v[ 1 ] - b.v[ 1 ], a.v[ 2 ] - b.v[ 2 ], a.v[ 3 ] - b.v[ 3 ] }; }
+		inline Float4 Mul( Float4 a, Float4 b ) { return { a.v[ 0 ] * b.v[ 0 ], a.v[ 1 ] * b.v[ 1 ], a.v[ 2 ] * b.v[ 2 ], a.v[ 3 ] * b.v[ 3 ] }; }
+		inline Float4 MulAdd( Float4 a, Float4 b, Float4 c ) { return { a.v[ 0 ] * b.v[ 0 ] + c.v[ 0 ], a.v[ 1 ] * b.v[ 1 ] + c.v[ 1 ], a.v[ 2 ] * b.v[ 2 ] + c.v[ 2 ], a.v[ 3 ] * b.v[ 3 ] + c.v[ 3 ] }; }
+		inline float Dot4( Float4 a, Float4 b ) { return a.v[ 0 ] * b.v[ 0 ] + a.v[ 1 ] * b.v[ 1 ] + a.v[ 2 ] * b.v[ 2 ] + a.v[ 3 ] * b.v[ 3 ]; }
+	#endif
+
+		inline Float4 Load3( const XrVector3f &v ) { return Load3( &v.x ); }
+		inline Float4 Load4( const XrQuaternionf &q ) { return Load4( &q.x ); }
+
+		inline Float4 Normalize4( Float4 v )
+		{
+			const float fLengthSq = Dot4( v, v );
+			return fLengthSq > 0.f ? Mul( v, Splat( 1.f / std::sqrt( fLengthSq ) ) ) : v;
+		}
+
+		// Shortest path slerp weights of the keys, nlerp where they are close enough for it to be indistinguishable
+		inline void SlerpWeights( float fDot, float t, float &outWeightA, float &outWeightB )
+		{
+			const float fSign = fDot < 0.f ? -1.f : 1.f;
+			fDot *= fSign;
+
+			outWeightA = 1.f - t;
+			outWeightB = t;
+			if ( fDot < 0.99f )
+			{
+				const float fTheta = std::acos( fDot );
+				const float fSinTheta = std::sin( fTheta );
+				outWeightA = std::sin( outWeightA * fTheta ) / fSinTheta;
+				outWeightB = std::sin( outWeightB * fTheta ) / fSinTheta;
+			}
+
+			outWeightB *= fSign;
+		}
+
+		// SampleAnimation for translation, rotation and scale samplers, straight into a register
+		inline Float4 SampleTransform( const SAnimationClip &clip, const SAnimationSampler &sampler, const SAnimationKeySpan &span )
+		{
+			const bool bRotation = sampler.path == EAnimationPath::Rotation;
+			const bool bCubic = sampler.interpolation == EAnimationInterpolation::CubicSpline;
+			const uint32_t unComponents = bRotation ? 4 : 3;
+			const uint32_t unStride = bCubic ? unComponents * 3 : unComponents;
+			const uint32_t unValue = bCubic ? unComponents : 0;
+
+			const float *pKey0 = clip.values.data() + sampler.firstValue + span.key * unStride;
+			const float *pKey1 = clip.values.data() + sampler.firstValue + span.next * unStride;
+
+			if ( sampler.interpolation == EAnimationInterpolation::Step || span.key == span.next )
+				return bRotation ? Load4( pKey0 + unValue ) : Load3( pKey0 + unValue );
+
+			const float t = span.t;
+			if ( !bCubic )
+			{
+				if ( !bRotation )
+				{
+					const Float4 a = Load3( pKey0 );
+					return MulAdd( Sub( Load3( pKey1 ), a ), Splat( t ), a );
+				}
+
+				const Float4 a = Load4( pKey0 );
+				const Float4 b = Load4( pKey1 );
+
+				float fWeightA, fWeightB;
+				SlerpWeights( Dot4( a, b ), t, fWeightA, fWeightB );
+				return Normalize4( MulAdd( b, Splat( fWeightB ), Mul( a, Splat( fWeightA ) ) ) );
+			}
+
+			const float t2 = t * t;
+			const float t3 = t2 * t;
+			const Float4 value0 = Splat( 2.f * t3 - 3.f * t2 + 1.f );
+			const Float4 tangent0 = Splat( ( t3 - 2.f * t2 + t ) * span.delta );
+			const Float4 value1 = Splat( -2.f * t3 + 3.f * t2 );
+			const Float4 tangent1 = Splat( ( t3 - t2 ) * span.delta );
+
+			if ( bRotation )
+			{
+				Float4 v = Mul( Load4( pKey0 + unValue ), value0 );
+				v = MulAdd( Load4( pKey0 + unValue + 4 ), tangent0, v );
+				v = MulAdd( Load4( pKey1 + unValue ), value1, v );
+				v = MulAdd( Load4( pKey1 ), tangent1, v );
+				return Normalize4( v );
+			}
+
+			Float4 v = Mul( Load3( pKey0 + unValue ), value0 );
+			v = MulAdd( Load3( pKey0 + unValue + 3 ), tangent0, v );
+			v = MulAdd( Load3( pKey1 + unValue ), value1, v );
+			return MulAdd( Load3( pKey1 ), tangent1, v );
+		}
+	} // namespace
+
+	static void SlerpQuaternion( const float *pA, const float *pB, float t, float *pOut )
+	{
+		float fWeightA, fWeightB;
+		SlerpWeights( pA[ 0 ] * pB[ 0 ] + pA[ 1 ] * pB[ 1 ] + pA[ 2 ] * pB[ 2 ] + pA[ 3 ] * pB[ 3 ], t, fWeightA, fWeightB );
+
+		float fLengthSq = 0.f;
+		for ( uint32_t i = 0; i < 4; i++ )
+		{
+			pOut[ i ] = pA[ i ] * fWeightA + pB[ i ] * fWeightB;
+			fLengthSq += pOut[ i ] * pOut[ i ];
+		}
+
+		const float fInvLength = fLengthSq > 0.f ? 1.f / std::sqrt( fLengthSq ) : 0.f;
+		for ( uint32_t i = 0; i < 4; i++ )
+			pOut[ i ] *= fInvLength;
+	}
+
+	SAnimationKeySpan FindAnimationKeys( const SAnimationClip &clip, const SAnimationTrack &track, float fTime, uint32_t &unCursor )
+	{
+		SAnimationKeySpan span;
+		const uint32_t unKeyCount = track.keyCount;
+		const float *pTimes = clip.times.data() + track.firstKey;
+
+		// Held before the first and after the last key
+		if ( unKeyCount < 2 || fTime <= pTimes[ 0 ] )
+		{
+			unCursor = 0;
+			return span;
+		}
+
+		if ( fTime >= pTimes[ unKeyCount - 1 ] )
+		{
+			unCursor = unKeyCount - 1;
+			span.key = span.next = unKeyCount - 1;
+			return span;
+		}
+
+		// Key at the start of the segment that holds fTime - usually the last one or its successor
+		uint32_t k = unCursor;
+		if ( k + 1 < unKeyCount && pTimes[ k ] <= fTime && fTime < pTimes[ k + 1 ] )
+		{
+		}
+		else if ( k + 2 < unKeyCount && pTimes[ k + 1 ] <= fTime && fTime < pTimes[ k + 2 ] )
+		{
+			k++;
+		}
+		else
+		{
+			k = static_cast< uint32_t >( std::upper_bound( pTimes, pTimes + unKeyCount, fTime ) - pTimes ) - 1;
+		}
+
+		unCursor = k;
+		span.key = k;
+		span.next = k + 1;
+		span.delta = pTimes[ k + 1 ] - pTimes[ k ];
+		span.t = ( fTime - pTimes[ k ] ) / span.delta;
+		return span;
+	}
+
+	void SampleAnimation( const SAnimationClip &clip, const SAnimationSampler &sampler, const SAnimationKeySpan &span, float *pOut )
+	{
+		const uint32_t unComponents = sampler.components;
+		const bool bCubic = sampler.interpolation == EAnimationInterpolation::CubicSpline;
+		const uint32_t unStride = bCubic ? unComponents * 3 : unComponents;
+		const uint32_t unValue = bCubic ? unComponents : 0; // of a key, past the in tangent
+
+		const float *pKey0 = clip.values.data() + sampler.firstValue + span.key * unStride;
+		const float *pKey1 = clip.values.data() + sampler.firstValue + span.next * unStride;
+
+		if ( sampler.interpolation == EAnimationInterpolation::Step || span.key == span.next )
+		{
+			for ( uint32_t i = 0; i < unComponents; i++ )
+				pOut[ i ] = pKey0[ unValue + i ];
+
+			return;
+		}
+
+		const float t = span.t;
+		if ( !bCubic )
+		{
+			if ( sampler.path == EAnimationPath::Rotation )
+			{
+				SlerpQuaternion( pKey0, pKey1, t, pOut );
+				return;
+			}
+
+			for ( uint32_t i = 0; i < unComponents; i++ )
+				pOut[ i ] = pKey0[ i ] + ( pKey1[ i ] - pKey0[ i ] ) * t;
+
+			return;
+		}
+
+		// Hermite spline between the values, with the out tangent of key 0 and the in tangent of key 1 (scaled by the segment's duration)
+		const float t2 = t * t;
+		const float t3 = t2 * t;
+		const float fValue0 = 2.f * t3 - 3.f * t2 + 1.f;
+		const float fTangent0 = ( t3 - 2.f * t2 + t ) * span.delta;
+		const float fValue1 = -2.f * t3 + 3.f * t2;
+		const float fTangent1 = ( t3 - t2 ) * span.delta;
+
+		float fLengthSq = 0.f;
+		for ( uint32_t i = 0; i < unComponents; i++ )
+		{
+			pOut[ i ] = fValue0 * pKey0[ unValue + i ] + fTangent0 * pKey0[ unValue + unComponents + i ] + fValue1 * pKey1[ unValue + i ] + fTangent1 * pKey1[ i ];
+			fLengthSq += pOut[ i ] * pOut[ i ];
+		}
+
+		if ( sampler.path == EAnimationPath::Rotation && fLengthSq > 0.f )
+		{
+			const float fInvLength = 1.f / std::sqrt( fLengthSq );
+			for ( uint32_t i = 0; i < 4; i++ )
+				pOut[ i ] *= fInvLength;
+		}
+	}
+
+	std::shared_ptr< SAnimationPlayback > CAnimator::Play( CRenderModel *pModel, uint32_t unClip, float fWeight, bool bLoop, float fSpeed )
+	{
+		if ( !pModel || unClip >= pModel->animations.size() || !pModel->animations[ unClip ] )
+		{
+			LogWarning( XRLIB_NAME, "Unable to play animation %u, the model has %u", unClip, pModel ? static_cast< uint32_t >( pModel->animations.size() ) : 0 );
+			return nullptr;
+		}
+
+		SAnimatedModel *pAnimated = FindModel( pModel );
+		if ( !pAnimated )
+		{
+			pAnimated = &m_vecModels.emplace_back();
+			pAnimated->pModel = pModel;
+			CaptureRestPose( *pAnimated );
+		}
+
+		std::shared_ptr< SAnimationPlayback > pPlayback = std::make_shared< SAnimationPlayback >();
+		pPlayback->clip = unClip;
+		pPlayback->weight = fWeight;
+		pPlayback->loop = bLoop;
+		pPlayback->speed = fSpeed;
+		pPlayback->time = fSpeed < 0.f ? pModel->animations[ unClip ]->duration : 0.f;
+		pPlayback->cursors.assign( pModel->animations[ unClip ]->tracks.size(), 0 );
+
+		pAnimated->playbacks.push_back( pPlayback );
+		return pPlayback;
+	}
+
+	std::shared_ptr< SAnimationPlayback > CAnimator::Play( CRenderModel *pModel, const std::string &sClip, float fWeight, bool bLoop, float fSpeed )
+	{
+		if ( pModel )
+		{
+			for ( uint32_t i = 0; i < pModel->animations.size(); i++ )
+			{
+				if ( pModel->animations[ i ] && pModel->animations[ i ]->name == sClip )
+					return Play( pModel, i, fWeight, bLoop, fSpeed );
+			}
+		}
+
+		LogWarning( XRLIB_NAME, "Animation %s not found", sClip.c_str() );
+		return nullptr;
+	}
+
+	void CAnimator::Stop( const std::shared_ptr< SAnimationPlayback > &pPlayback )
+	{
+		for ( auto itModel = m_vecModels.begin(); itModel != m_vecModels.end(); ++itModel )
+		{
+			auto it = std::find( itModel->playbacks.begin(), itModel->playbacks.end(), pPlayback );
+			if ( it == itModel->playbacks.end() )
+				continue;
+
+			itModel->playbacks.erase( it );
+			if ( itModel->playbacks.empty() )
+				m_vecModels.erase( itModel );
+
+			return;
+		}
+	}
+
+	void CAnimator::StopAll( CRenderModel *pModel )
+	{
+		m_vecModels.erase( std::remove_if( m_vecModels.begin(), m_vecModels.end(), [ pModel ]( const SAnimatedModel &model ) { return model.pModel == pModel; } ), m_vecModels.end() );
+	}
+
+	void CAnimator::Clear() 
+	{ 
+		m_vecModels.clear(); 
+	}
+
+	void CAnimator::Update( float fDeltaSeconds, CThreadPool *pThreadPool )
+	{
+		// Advance the playbacks
+		for ( SAnimatedModel &model : m_vecModels )
+		{
+			for ( const std::shared_ptr< SAnimationPlayback > &pPlayback : model.playbacks )
+			{
+				if ( pPlayback->finished || pPlayback->clip >= model.pModel->animations.size() || !model.pModel->animations[ pPlayback->clip ] )
+					continue;
+
+				const float fDuration = model.pModel->animations[ pPlayback->clip ]->duration;
+				pPlayback->time += fDeltaSeconds * pPlayback->speed;
+
+				if ( pPlayback->loop && fDuration > 0.f )
+				{
+					pPlayback->time = std::fmod( pPlayback->time, fDuration );
+					if ( pPlayback->time < 0.f )
+						pPlayback->time += fDuration;
+				}
+				else if ( pPlayback->time >= fDuration || pPlayback->time <= 0.f )
+				{
+					pPlayback->time = std::clamp( pPlayback->time, 0.f, fDuration );
+					pPlayback->finished = true;
+				}
+			}
+		}
+
+		const uint32_t unBatchSize = std::max( batchSize, 1u );
+		const uint32_t unBatchCount = static_cast< uint32_t >( ( m_vecModels.size() + unBatchSize - 1 ) / unBatchSize );
+		if ( !pThreadPool || unBatchCount < 2 )
+		{
+			for ( SAnimatedModel &model : m_vecModels )
+				EvaluateModel( model );
+
+			return;
+		}
+
+		// Shared with the pool's tasks, which may only get to run after the calling thread has evaluated everything itself
+		struct SEvaluateJobs
+		{
+			SAnimatedModel *pModels = nullptr;
+			uint32_t modelCount = 0;
+			uint32_t batchSize = 0;
+			uint32_t batchCount = 0;
+			std::atomic< uint32_t > next { 0 };
+			std::atomic< uint32_t > done { 0 };
+			std::mutex mutex;
+			std::condition_variable condition;
+		};
+
+		std::shared_ptr< SEvaluateJobs > pJobs = std::make_shared< SEvaluateJobs >();
+		pJobs->pModels = m_vecModels.data();
+		pJobs->modelCount = static_cast< uint32_t >( m_vecModels.size() );
+		pJobs->batchSize = unBatchSize;
+		pJobs->batchCount = unBatchCount;
+
+		auto fnWork = []( SEvaluateJobs *pJobs )
+		{
+			uint32_t unBatch;
+			while ( ( unBatch = pJobs->next++ ) < pJobs->batchCount )
+			{
+				const uint32_t unEnd = std::min( ( unBatch + 1 ) * pJobs->batchSize, pJobs->modelCount );
+				for ( uint32_t i = unBatch * pJobs->batchSize; i < unEnd; i++ )
+					EvaluateModel( pJobs->pModels[ i ] );
+
+				if ( ++pJobs->done == pJobs->batchCount )
+				{
+					std::scoped_lock lock( pJobs->mutex );
+					pJobs->condition.notify_all();
+				}
+			}
+		};
+
+		// One job per batch past the first, which the calling thread starts on right away
+		for ( uint32_t i = 1; i < unBatchCount; i++ )
+			pThreadPool->SubmitTask( [ pJobs, fnWork ]() { fnWork( pJobs.get() ); } );
+
+		fnWork( pJobs.get() );
+
+		std::unique_lock lock( pJobs->mutex );
+		pJobs->condition.wait( lock, [ &pJobs ]() { return pJobs->done == pJobs->batchCount; } );
+	}
+
+	CAnimator::SAnimatedModel *CAnimator::FindModel( CRenderModel *pModel )
+	{
+		for ( SAnimatedModel &model : m_vecModels )
+		{
+			if ( model.pModel == pModel )
+				return &model;
+		}
+
+		return nullptr;
+	}
+
+	void CAnimator::CaptureRestPose( SAnimatedModel &model )
+	{
+		const CSceneGraph &sceneGraph = model.pModel->sceneGraph;
+		const uint32_t unNodeCount = sceneGraph.GetNodeCount();
+
+		model.restTranslations.resize( unNodeCount );
+		model.restRotations.resize( unNodeCount );
+		model.restScales.resize( unNodeCount );
+		for ( uint32_t i = 0; i < unNodeCount; i++ )
+		{
+			model.restTranslations[ i ] = sceneGraph.GetTranslation( i );
+			model.restRotations[ i ] = sceneGraph.GetRotation( i );
+			model.restScales[ i ] = sceneGraph.GetScale( i );
+		}
+
+		model.blends.assign( unNodeCount, {} );
+		model.animatedNodes.clear();
+		model.stamp = 0;
+
+		// Targets of a mesh are consecutive, in the order of the node's weights
+		CRenderModel *pRenderModel = model.pModel;
+		if ( pRenderModel->morphWeights.size() != pRenderModel->morphTargets.size() )
+			pRenderModel->ResetMorphWeights();
+
+		const size_t unTargetCount = pRenderModel->morphTargets.size();
+		model.restMorphWeights = pRenderModel->morphWeights;
+		model.morphWeights.assign( unTargetCount, 0.f );
+		model.morphBlendWeights.assign( unTargetCount, 0.f );
+		model.animatedMorphTargets.clear();
+
+		model.nodeMorphTargets.assign( unNodeCount, -1 );
+		for ( size_t i = unTargetCount; i-- > 0; )
+		{
+			const int32_t nNode = pRenderModel->morphTargets[ i ].node;
+			if ( nNode >= 0 && static_cast< uint32_t >( nNode ) < unNodeCount )
+				model.nodeMorphTargets[ nNode ] = static_cast< int32_t >( i );
+		}
+	}
+
+	void CAnimator::EvaluateModel( SAnimatedModel &model )
+	{
+		CRenderModel *pRenderModel = model.pModel;
+		CSceneGraph &sceneGraph = pRenderModel->sceneGraph;
+		const uint32_t unNodeCount = sceneGraph.GetNodeCount();
+
+		// The model got a different scene graph or morph targets (e.g. a streamed model was swapped in)
+		if ( model.restTranslations.size() != unNodeCount || model.restMorphWeights.size() != pRenderModel->morphTargets.size() )
+			CaptureRestPose( model );
+
+		// Sums are cleared when a node is first written in this update
+		model.animatedNodes.clear();
+		model.stamp++;
+
+		// Targets that stop being animated return to their rest weights
+		for ( uint32_t unTarget : model.animatedMorphTargets )
+		{
+			model.morphWeights[ unTarget ] = 0.f;
+			model.morphBlendWeights[ unTarget ] = 0.f;
+			pRenderModel->morphWeights[ unTarget ] = model.restMorphWeights[ unTarget ];
+		}
+
+		model.animatedMorphTargets.clear();
+
+		// Weighted sums of every playback's samples
+		const uint32_t unTargetCount = static_cast< uint32_t >( pRenderModel->morphTargets.size() );
+		for ( const std::shared_ptr< SAnimationPlayback > &pPlayback : model.playbacks )
+		{
+			const float fWeight = pPlayback->weight;
+			if ( fWeight <= 0.f || pPlayback->clip >= pRenderModel->animations.size() || !pRenderModel->animations[ pPlayback->clip ] )
+				continue;
+
+			const SAnimationClip &clip = *pRenderModel->animations[ pPlayback->clip ];
+			if ( pPlayback->cursors.size() != clip.tracks.size() )
+				pPlayback->cursors.assign( clip.tracks.size(), 0 );
+
+			// Keys are looked up once per track, the channels only interpolate
+			model.spans.resize( clip.tracks.size() );
+			for ( size_t i = 0; i < clip.tracks.size(); i++ )
+				model.spans[ i ] = FindAnimationKeys( clip, clip.tracks[ i ], pPlayback->time, pPlayback->cursors[ i ] );
+
+			// One pass over the channels, sampled and accumulated four lanes at a time. Vectors get a 1 in lane 3, which sums their weight.
+			const Float4 weight = Splat( fWeight );
+			const Float4 laneW = Set( 0.f, 0.f, 0.f, 1.f );
+			for ( const SAnimationChannel &channel : clip.channels )
+			{
+				if ( channel.node >= unNodeCount )
+					continue;
+
+				const SAnimationSampler &sampler = clip.samplers[ channel.sampler ];
+				if ( channel.path == EAnimationPath::Weights )
+				{
+					if ( model.values.size() < sampler.components )
+						model.values.resize( sampler.components );
+
+					float *value = model.values.data();
+					SampleAnimation( clip, sampler, model.spans[ sampler.track ], value );
+
+					const int32_t nFirstTarget = model.nodeMorphTargets[ channel.node ];
+					if ( nFirstTarget < 0 )
+						continue;
+
+					// Values past the node's targets are ignored
+					for ( uint32_t i = 0; i < sampler.components; i++ )
+					{
+						const uint32_t unTarget = static_cast< uint32_t >( nFirstTarget ) + i;
+						if ( unTarget >= unTargetCount || pRenderModel->morphTargets[ unTarget ].node != static_cast< int32_t >( channel.node ) )
+							break;
+
+						if ( model.morphBlendWeights[ unTarget ] == 0.f )
+							model.animatedMorphTargets.push_back( unTarget );
+
+						model.morphWeights[ unTarget ] += value[ i ] * fWeight;
+						model.morphBlendWeights[ unTarget ] += fWeight;
+					}
+
+					continue;
+				}
+
+				SNodeBlend &blend = model.blends[ channel.node ];
+				if ( blend.stamp != model.stamp )
+				{
+					blend = {};
+					blend.stamp = model.stamp;
+					model.animatedNodes.push_back( channel.node );
+				}
+
+				const Float4 value = SampleTransform( clip, sampler, model.spans[ sampler.track ] );
+				switch ( channel.path )
+				{
+					case EAnimationPath::Translation:
+						Store4( blend.translation, MulAdd( Add( value, laneW ), weight, Load4( blend.translation ) ) );
+						break;
+					case EAnimationPath::Rotation:
+					{
+						// Into the hemisphere of the sum so far, or opposite rotations cancel out
+						const Float4 sum = Load4( blend.rotation );
+						Store4( blend.rotation, MulAdd( value, Splat( Dot4( sum, value ) < 0.f ? -fWeight : fWeight ), sum ) );
+						blend.rotationWeight += fWeight;
+						break;
+					}
+					case EAnimationPath::Scale:
+						Store4( blend.scale, MulAdd( Add( value, laneW ), weight, Load4( blend.scale ) ) );
+						break;
+					default:
+						break;
+				}
+			}
+		}
+
+		// Morph weights blend like translations, the render thread reads them in UpdateSkins()
+		for ( uint32_t unTarget : model.animatedMorphTargets )
+		{
+			const float fTotal = model.morphBlendWeights[ unTarget ];
+			const float fScale = fTotal > 1.f ? 1.f / fTotal : 1.f;
+			const float fRest = fTotal > 1.f ? 0.f : 1.f - fTotal;
+			pRenderModel->morphWeights[ unTarget ] = model.morphWeights[ unTarget ] * fScale + model.restMorphWeights[ unTarget ] * fRest;
+		}
+
+		if ( model.animatedNodes.empty() )
+			return;
+
+		// Normalized where the weights add up to more than 1, topped up with the rest pose where they add up to less.
+		// Paths no playback animates keep whatever the node has.
+		for ( uint32_t unNode : model.animatedNodes )
+		{
+			const SNodeBlend &blend = model.blends[ unNode ];
+
+			XrVector3f translation = sceneGraph.GetTranslation( unNode );
+			const float fTranslationWeight = blend.translation[ 3 ];
+			if ( fTranslationWeight > 0.f )
+			{
+				const float fScale = fTranslationWeight > 1.f ? 1.f / fTranslationWeight : 1.f;
+				const float fRest = fTranslationWeight > 1.f ? 0.f : 1.f - fTranslationWeight;
+				Store3( &translation.x, MulAdd( Load4( blend.translation ), Splat( fScale ), Mul( Load3( model.restTranslations[ unNode ] ), Splat( fRest ) ) ) );
+			}
+
+			XrQuaternionf rotation = sceneGraph.GetRotation( unNode );
+			if ( blend.rotationWeight > 0.f )
+			{
+				Float4 sum = Load4( blend.rotation );
+				if ( blend.rotationWeight < 1.f )
+				{
+					const Float4 rest = Load4( model.restRotations[ unNode ] );
+					sum = MulAdd( rest, Splat( ( Dot4( sum, rest ) < 0.f ? -1.f : 1.f ) * ( 1.f - blend.rotationWeight ) ), sum );
+				}
+
+				if ( Dot4( sum, sum ) > 0.f )
+					Store4( &rotation.x, Normalize4( sum ) );
+			}
+
+			XrVector3f scale = sceneGraph.GetScale( unNode );
+			const float fScaleWeight = blend.scale[ 3 ];
+			if ( fScaleWeight > 0.f )
+			{
+				const float fScale = fScaleWeight > 1.f ? 1.f / fScaleWeight : 1.f;
+				const float fRest = fScaleWeight > 1.f ? 0.f : 1.f - fScaleWeight;
+				Store3( &scale.x, MulAdd( Load4( blend.scale ), Splat( fScale ), Mul( Load3( model.restScales[ unNode ] ), Splat( fRest ) ) ) );
+			}
+
+			sceneGraph.SetLocalTransform( unNode, translation, rotation, scale );
+		}
+
+		// World matrices now rather than on the render thread, the skins need them
+		sceneGraph.Update();
+		for ( SSkin &skin : pRenderModel->skins )
+			skin.UpdateMatrices( sceneGraph );
+	}
+
+} // namespace xrlib
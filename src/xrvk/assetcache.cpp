@@ -0,0 +1,228 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#include <xrvk/assetcache.hpp>
+#include <xrvk/modelcache.hpp>
+
+#include <filesystem>
+#include <unordered_set>
+
+namespace xrlib
+{
+	namespace fs = std::filesystem;
+
+	CAssetCache::CAssetCache( CSession *pSession, CRenderInfo *pRenderInfo, CTextureManager *pTextureManager )
+		: m_pSession( pSession )
+		, m_pRenderInfo( pRenderInfo )
+		, m_pTextureManager( pTextureManager )
+	{
+		assert( pSession && pRenderInfo && pTextureManager );
+	}
+
+	CAssetCache::~CAssetCache()
+	{
+		std::scoped_lock lock( m_mutex );
+
+		// Models that weren't released stop drawing
+		if ( !m_users.empty() )
+			LogWarning( XRLIB_NAME, "Asset cache destroyed with %i models still sharing its resources", (int) m_users.size() );
+
+		std::unordered_set< SAssetEntry * > entries;
+		for ( auto &[ sPath, pEntry ] : m_entries )
+			entries.insert( pEntry );
+
+		for ( auto &[ pModel, pEntry ] : m_users )
+		{
+			pModel->Unshare();
+			entries.insert( pEntry );
+		}
+
+		for ( SAssetEntry *pEntry : entries )
+			DestroyEntry( pEntry );
+
+		m_entries.clear();
+		m_users.clear();
+	}
+
+	bool CAssetCache::Acquire( CRenderModel *outRenderModel, const std::string &sFilename, const FnLoadModel &fnLoad )
+	{
+		assert( outRenderModel && fnLoad );
+		std::scoped_lock lock( m_mutex );
+
+		const std::string sKey = fs::path( sFilename ).lexically_normal().string();
+
+		uintmax_t unFileSize = 0;
+		int64_t nWriteTime = 0;
+		const bool bHasStamp = ReadFileStamp( sFilename, unFileSize, nWriteTime );
+
+		SAssetEntry *pEntry = nullptr;
+		auto it = m_entries.find( sKey );
+		if ( it != m_entries.end() )
+		{
+			pEntry = it->second;
+
+			// Touched on disk - still the same asset if the contents match, otherwise current users keep the old one
+			if ( bHasStamp && ( pEntry->fileSize != unFileSize || pEntry->writeTime != nWriteTime ) )
+			{
+				uint64_t unHash = HashFile( sFilename );
+				if ( unHash == pEntry->contentHash )
+				{
+					pEntry->fileSize = unFileSize;
+					pEntry->writeTime = nWriteTime;
+				}
+				else
+				{
+					m_entries.erase( it );
+					pEntry = nullptr;
+				}
+			}
+		}
+
+		if ( !pEntry )
+		{
+			pEntry = new SAssetEntry;
+			pEntry->path = sKey;
+			pEntry->fileSize = unFileSize;
+			pEntry->writeTime = nWriteTime;
+			pEntry->contentHash = bHasStamp ? HashFile( sFilename ) : 0;
+			pEntry->pPrototype = new CRenderModel( m_pSession, m_pRenderInfo, false );
+
+			if ( !fnLoad( pEntry->pPrototype ) )
+			{
+				LogError( XRLIB_NAME, "Asset cache failed to load %s", sFilename.c_str() );
+				DestroyEntry( pEntry );
+				return false;
+			}
+
+			m_entries[ sKey ] = pEntry;
+			LogInfo( XRLIB_NAME, "Asset cache loaded %s (content hash %016llx)", sKey.c_str(), (unsigned long long) pEntry->contentHash );
+		}
+
+		// Re-acquiring drops whatever the model shared before (referenced first, in case that's this entry)
+		pEntry->refCount++;
+		if ( m_users.find( outRenderModel ) != m_users.end() )
+			Release( outRenderModel );
+
+		outRenderModel->ShareFrom( *pEntry->pPrototype );
+		m_users[ outRenderModel ] = pEntry;
+
+		return true;
+	}
+
+	bool CAssetCache::AcquireGltf(
+		CRenderModel *outRenderModel,
+		CGltf *pGltf,
+		VkCommandPool commandPool,
+		const std::string &sFilename,
+		uint32_t materialLayoutId,
+		uint32_t materialPoolId,
+		XrVector3f scale )
+	{
+		assert( pGltf );
+
+		auto fnLoad = [ & ]( CRenderModel *pPrototype )
+		{
+			// The prototype is created with the vertex format of its first user
+			pPrototype->vertexFormat = outRenderModel->vertexFormat;
+			pPrototype->allowIndex16 = outRenderModel->allowIndex16;
+
+			if ( !pGltf->LoadAndParse( pPrototype, commandPool, sFilename ) )
+				return false;
+
+			// Cpu copies aren't needed, shared models are never evicted
+			if ( pPrototype->InitBuffers( true ) != VK_SUCCESS )
+				return false;
+
+			pPrototype->LoadMaterial( m_pRenderInfo, materialLayoutId, materialPoolId, m_pTextureManager );
+			return true;
+		};
+
+		if ( !Acquire( outRenderModel, sFilename, fnLoad ) )
+			return false;
+
+		for ( auto &instance : outRenderModel->instances )
+			instance.scale = scale;
+
+		return true;
+	}
+
+	void CAssetCache::Release( CRenderModel *pRenderModel )
+	{
+		std::scoped_lock lock( m_mutex );
+
+		auto it = m_users.find( pRenderModel );
+		if ( it == m_users.end() )
+			return;
+
+		SAssetEntry *pEntry = it->second;
+		m_users.erase( it );
+
+		// The model keeps its instances and instance buffer
+		pRenderModel->Unshare();
+
+		assert( pEntry->refCount > 0 );
+		if ( --pEntry->refCount > 0 )
+			return;
+
+		auto entryIt = m_entries.find( pEntry->path );
+		if ( entryIt != m_entries.end() && entryIt->second == pEntry )
+			m_entries.erase( entryIt );
+
+		DestroyEntry( pEntry );
+	}
+
+	uint32_t CAssetCache::GetEntryCount()
+	{
+		std::scoped_lock lock( m_mutex );
+		return (uint32_t) m_entries.size();
+	}
+
+	uint32_t CAssetCache::GetReferenceCount( const std::string &sFilename )
+	{
+		std::scoped_lock lock( m_mutex );
+		auto it = m_entries.find( fs::path( sFilename ).lexically_normal().string() );
+		return it == m_entries.end() ? 0 : it->second->refCount;
+	}
+
+	void CAssetCache::DestroyEntry( SAssetEntry *pEntry )
+	{
+		if ( pEntry->pPrototype )
+		{
+			if ( !pEntry->pPrototype->FreeMaterialDescriptors( m_pRenderInfo->pDescriptors ) )
+				LogWarning( XRLIB_NAME, "Material descriptor sets of %s stay allocated, their pool can't free sets", pEntry->path.c_str() );
+
+			for ( auto &texture : pEntry->pPrototype->textures )
+				m_pTextureManager->DestroyTexture( texture );
+
+			delete pEntry->pPrototype;
+		}
+
+		delete pEntry;
+	}
+
+	bool CAssetCache::ReadFileStamp( const std::string &sFilename, uintmax_t &outSize, int64_t &outWriteTime )
+	{
+		std::error_code error;
+		outSize = fs::file_size( sFilename, error );
+		if ( error )
+			return false;
+
+		auto writeTime = fs::last_write_time( sFilename, error );
+		if ( error )
+			return false;
+
+		outWriteTime = (int64_t) writeTime.time_since_epoch().count();
+		return true;
+	}
+
+} // namespace xrlib
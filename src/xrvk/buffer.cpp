@@ -27,10 +27,16 @@ namespace xrlib
 		UnmapMemory();
 
 		if ( m_vkBufferInfo.buffer != VK_NULL_HANDLE )
+		{
+			// Make sure no queued copy still targets this buffer
+			if ( m_bHasQueuedUploads )
+				CUploadManager::Get( m_pSession )->ReleaseBuffer( m_vkBufferInfo.buffer );
+
 			vkDestroyBuffer( GetLogicalDevice(), m_vkBufferInfo.buffer, nullptr );
+		}
 
-		if ( m_vkDeviceMemory != VK_NULL_HANDLE )
-			vkFreeMemory( GetLogicalDevice(), m_vkDeviceMemory, nullptr );
+		if ( m_pAllocation )
+			CDeviceMemoryAllocator::Get( m_pSession )->Free( m_pAllocation );
 	}
 
 	VkResult CDeviceBuffer::Init( 
@@ -44,6 +50,10 @@ namespace xrlib
 		assert( usageFlags != 0 );
 		assert( memPropFlags != 0 );
 
+		// Buffers outside host visible memory can only be filled via transfers
+		if ( ( memPropFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT ) == 0 )
+			usageFlags |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
 		// Create vulkan buffer
 		VkBufferCreateInfo bufferCI { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
 		bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -54,40 +64,27 @@ namespace xrlib
 		if ( result != VK_SUCCESS )
 			return result;
 
-		// Get buffer memory requirements
-		VkMemoryRequirements memReqs;
-		VkMemoryAllocateInfo memAllocInfo { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-		vkGetBufferMemoryRequirements( GetLogicalDevice(), m_vkBufferInfo.buffer, &memReqs );
-
-		// Find memory type matching memory requirement for the buffer and provided memory property(ies)
-		memAllocInfo.allocationSize = memReqs.size;
-		memAllocInfo.memoryTypeIndex = FindMemoryType( memPropFlags, memReqs.memoryTypeBits );
-
-		// If buffer is for shader use, allocate required flag
-		VkMemoryAllocateFlagsInfoKHR memAllocFlags {};
-		if ( usageFlags & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT )
-		{
-			memAllocFlags.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO_KHR;
-			memAllocFlags.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR;
-			memAllocInfo.pNext = &memAllocFlags;
-		}
-
-		result = vkAllocateMemory( GetLogicalDevice(), &memAllocInfo, pCallbacks, &m_vkDeviceMemory );
+		// Sub-allocate memory from the device allocator and bind buffer to it
+		result = CDeviceMemoryAllocator::Get( m_pSession )->AllocateAndBindBuffer( m_pAllocation, m_vkBufferInfo.buffer, memPropFlags, usageFlags & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT );
 		if ( result != VK_SUCCESS )
 			return result;
 
-		m_vkMemoryAlignment = memReqs.alignment;
-		m_vkMemorySize = memReqs.size;
+		m_pAllocation->pUserData = this;
+		m_vkMemoryAlignment = m_pAllocation->alignment;
+		m_vkMemorySize = m_pAllocation->size;
+
+		// If buffer data's provided but memory isn't host visible (e.g. device local), stage the upload
+		if ( pData && !IsHostVisible() )
+			return Upload( pData, unSize );
 
 		// If buffer data's provided, copy to internal cache
 		if ( pData )
 		{
-			result = vkMapMemory( GetLogicalDevice(), m_vkDeviceMemory, 0, m_vkMemorySize, 0, &m_pData ); 
+			result = MapMemory();
 			if ( result != VK_SUCCESS )
 				return result;
 
-
-			memcpy( m_pData, pData, m_vkMemorySize );
+			memcpy( m_pData, pData, unSize );
 			if ( ( memPropFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT ) == 0 )
 			{
 				result = FlushMemory();
@@ -99,34 +96,25 @@ namespace xrlib
 				UnmapMemory();
 		}
 
-		// Bind buffer to device memory
-		return vkBindBufferMemory( GetLogicalDevice(), m_vkBufferInfo.buffer, m_vkDeviceMemory, 0 );
+		return VK_SUCCESS;
 	}
 
 	uint32_t CDeviceBuffer::FindMemoryType( VkMemoryPropertyFlags memPropFlags, uint32_t unBits ) 
 	{ 
-		VkPhysicalDeviceMemoryProperties memProps;
-		vkGetPhysicalDeviceMemoryProperties( GetPhysicalDevice(), &memProps );
-
-		for ( uint32_t i = 0; i < memProps.memoryTypeCount; i++ )
-			if ( ( unBits & ( 1 << i ) ) && ( memProps.memoryTypes[ i ].propertyFlags & memPropFlags ) == memPropFlags )
-				return i;
-
-		throw std::runtime_error( "FATAL: Unable to find requested memory type for device's physical device." );
+		return CDeviceMemoryAllocator::Get( m_pSession )->FindMemoryType( memPropFlags, unBits );
 	}
 
 	VkResult CDeviceBuffer::FlushMemory( VkDeviceSize unSize, VkDeviceSize unOffset, uint32_t unRangeCount ) 
 	{ 
-		VkMappedMemoryRange mappedRange { VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE };
-		mappedRange.memory = m_vkDeviceMemory;
-		mappedRange.offset = unOffset;
-		mappedRange.size = unSize;
-		return vkFlushMappedMemoryRanges( GetLogicalDevice(), unRangeCount, &mappedRange );
+		return CDeviceMemoryAllocator::Get( m_pSession )->Flush( m_pAllocation, unOffset, unSize );
 	}
 
 	VkResult CDeviceBuffer::MapMemory() 
 	{ 
-		return vkMapMemory( GetLogicalDevice(), m_vkDeviceMemory, 0, m_vkMemorySize, 0, &m_pData ); 
+		if ( m_pData )
+			return VK_SUCCESS;
+
+		return CDeviceMemoryAllocator::Get( m_pSession )->Map( m_pAllocation, &m_pData ); 
 	}
 
 	void CDeviceBuffer::UnmapMemory() 
@@ -134,10 +122,46 @@ namespace xrlib
 		if ( !m_pData )
 			return;
 
-		vkUnmapMemory( GetLogicalDevice(), m_vkDeviceMemory );
+		CDeviceMemoryAllocator::Get( m_pSession )->Unmap( m_pAllocation );
 		m_pData = nullptr;
 	}
 
+	VkResult CDeviceBuffer::Upload( const void *pData, VkDeviceSize unSize, VkDeviceSize unOffset ) 
+	{
+		assert( pData );
+		assert( m_pAllocation );
+		assert( unOffset + unSize <= m_vkMemorySize );
+
+		// Host visible, copy directly
+		if ( IsHostVisible() )
+		{
+			bool bWasMapped = m_pData != nullptr;
+			VkResult result = MapMemory();
+			if ( result != VK_SUCCESS )
+				return result;
+
+			memcpy( static_cast< uint8_t * >( m_pData ) + unOffset, pData, unSize );
+			result = FlushMemory( unSize, unOffset );
+
+			if ( !bWasMapped )
+				UnmapMemory();
+
+			return result;
+		}
+
+		// Device local, batch the copy on the transfer queue
+		CUploadManager::Get( m_pSession )->UploadBuffer( m_vkBufferInfo.buffer, pData, unSize, unOffset );
+		m_bHasQueuedUploads = true;
+
+		return VK_SUCCESS;
+	}
+
+	bool CDeviceBuffer::IsHostVisible() 
+	{ 
+		assert( m_pAllocation );
+		return CDeviceMemoryAllocator::Get( m_pSession )->IsHostVisible( m_pAllocation->memoryTypeIndex );
+	}
+
 	VkPhysicalDevice CDeviceBuffer::GetPhysicalDevice() 
 	{ 
 		return m_pSession->GetVulkan()->GetVkPhysicalDevice(); 
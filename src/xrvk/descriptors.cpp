@@ -72,7 +72,7 @@ namespace xrlib
 		return result;
 	}
 
-	VkResult CDescriptorManager::CreateDescriptorPool( uint32_t &outPoolId, uint32_t layoutId, uint32_t unSetCount, VkAllocationCallbacks *pCallbacks ) 
+	VkResult CDescriptorManager::CreateDescriptorPool( uint32_t &outPoolId, uint32_t layoutId, uint32_t unSetCount, VkDescriptorPoolCreateFlags flags, VkAllocationCallbacks *pCallbacks ) 
 	{ 
 		auto layoutIt = m_descriptorSetLayouts.find( layoutId );
 		if ( layoutIt == m_descriptorSetLayouts.end() )
@@ -100,6 +100,7 @@ namespace xrlib
 		poolInfo.poolSizeCount = static_cast< uint32_t >( poolSizes.size() );
 		poolInfo.pPoolSizes = poolSizes.data();
 		poolInfo.maxSets = unSetCount;
+		poolInfo.flags = flags;
 
 		VkDescriptorPool descriptorPool;
 		VkResult result = vkCreateDescriptorPool( m_pSession->GetVulkan()->GetVkLogicalDevice(), &poolInfo, pCallbacks, &descriptorPool );
@@ -108,6 +109,7 @@ namespace xrlib
 
 		outPoolId = m_nextPoolId++;
 		m_descriptorPools[ outPoolId ] = descriptorPool;
+		m_descriptorPoolFlags[ outPoolId ] = flags;
 
 		return VK_SUCCESS;
 	}
@@ -121,6 +123,7 @@ namespace xrlib
 
 		outPoolId = m_nextPoolId++;
 		m_descriptorPools[ outPoolId ] = descriptorPool;
+		m_descriptorPoolFlags[ outPoolId ] = poolInfo.flags;
 
 		return VK_SUCCESS; 
 	}
@@ -378,6 +381,7 @@ namespace xrlib
 		{
 			vkDestroyDescriptorPool( m_pSession->GetVulkan()->GetVkLogicalDevice(), poolIt->second, nullptr );
 			m_descriptorPools.erase( poolIt );
+			m_descriptorPoolFlags.erase( poolId );
 			m_descriptorSets.clear();
 		}
 	}
@@ -405,6 +409,19 @@ namespace xrlib
 		}
 	}
 
+	bool CDescriptorManager::FreeDescriptorSets( uint32_t poolId, std::vector< VkDescriptorSet > &descriptorSets )
+	{
+		auto poolIt = m_descriptorPools.find( poolId );
+		if ( poolIt == m_descriptorPools.end() || !( m_descriptorPoolFlags[ poolId ] & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT ) )
+			return false;
+
+		if ( !descriptorSets.empty() )
+			vkFreeDescriptorSets( m_pSession->GetVulkan()->GetVkLogicalDevice(), poolIt->second, static_cast< uint32_t >( descriptorSets.size() ), descriptorSets.data() );
+
+		descriptorSets.clear();
+		return true;
+	}
+
 	void CDescriptorManager::DeleteBuffer( uint32_t bufferId ) { m_buffers.erase( bufferId ); }
 
 	void CDescriptorManager::DeleteAll()
@@ -420,6 +437,7 @@ namespace xrlib
 		}
 
 		m_descriptorPools.clear();
+		m_descriptorPoolFlags.clear();
 		m_descriptorSetLayouts.clear();
 		m_descriptorSets.clear();
 		m_layoutBindings.clear();
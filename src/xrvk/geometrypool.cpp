@@ -0,0 +1,369 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#include <xrvk/geometrypool.hpp>
+
+#include <algorithm>
+
+namespace xrlib
+{
+	void CGeometryPool::SRangeList::Init( uint32_t unCapacity )
+	{
+		capacity = unCapacity;
+		used = 0;
+		freeByOffset.clear();
+
+		if ( unCapacity > 0 )
+			freeByOffset[ 0 ] = unCapacity;
+	}
+
+	bool CGeometryPool::SRangeList::Allocate( uint32_t unCount, uint32_t &outOffset )
+	{
+		for ( auto it = freeByOffset.begin(); it != freeByOffset.end(); ++it )
+		{
+			if ( it->second < unCount )
+				continue;
+
+			outOffset = it->first;
+			const uint32_t unRemaining = it->second - unCount;
+			freeByOffset.erase( it );
+
+			if ( unRemaining > 0 )
+				freeByOffset[ outOffset + unCount ] = unRemaining;
+
+			used += unCount;
+			return true;
+		}
+
+		return false;
+	}
+
+	void CGeometryPool::SRangeList::Free( uint32_t unOffset, uint32_t unCount )
+	{
+		if ( unCount == 0 )
+			return;
+
+		assert( used >= unCount );
+		used -= unCount;
+
+		// Coalesce with the neighbouring free ranges
+		auto itNext = freeByOffset.lower_bound( unOffset );
+		if ( itNext != freeByOffset.end() && unOffset + unCount == itNext->first )
+		{
+			unCount += itNext->second;
+			itNext = freeByOffset.erase( itNext );
+		}
+
+		if ( itNext != freeByOffset.begin() )
+		{
+			auto itPrev = std::prev( itNext );
+			if ( itPrev->first + itPrev->second == unOffset )
+			{
+				itPrev->second += unCount;
+				return;
+			}
+		}
+
+		freeByOffset[ unOffset ] = unCount;
+	}
+
+	CGeometryPool::CGeometryPool( CSession *pSession, VkDeviceSize unArenaVertexBytes, VkDeviceSize unArenaIndexBytes )
+		: m_pSession( pSession )
+		, m_unArenaVertexBytes( unArenaVertexBytes )
+		, m_unArenaIndexBytes( unArenaIndexBytes )
+	{
+		assert( pSession );
+		assert( unArenaVertexBytes > 0 && unArenaIndexBytes > 0 );
+	}
+
+	CGeometryPool::~CGeometryPool()
+	{
+		std::scoped_lock lock( m_mutex );
+
+		if ( m_unAllocationCount > m_pendingFrees.size() )
+			LogWarning( "", "Geometry pool destroyed with %i live allocations", (int) ( m_unAllocationCount - m_pendingFrees.size() ) );
+
+		for ( SGeometryArena *pArena : m_vecArenas )
+		{
+			delete pArena->pVertexBuffer;
+			delete pArena->pPositionBuffer;
+
+			for ( CDeviceBuffer *pIndexBuffer : pArena->indexBuffers )
+				delete pIndexBuffer;
+
+			delete pArena;
+		}
+
+		m_vecArenas.clear();
+		m_pendingFrees.clear();
+		m_bindings.clear();
+	}
+
+	VkResult CGeometryPool::Allocate(
+		SGeometryAllocation &outAllocation,
+		uint32_t unStride,
+		bool bSplitPositions,
+		const void *pVertexData,
+		const XrVector3f *pPositions,
+		uint32_t unVertexCount,
+		VkIndexType indexType,
+		const void *pIndexData,
+		uint32_t unIndexCount )
+	{
+		assert( unStride > 0 && pVertexData && pIndexData );
+		assert( !bSplitPositions || pPositions );
+
+		if ( unVertexCount == 0 || unIndexCount == 0 )
+			return VK_ERROR_INITIALIZATION_FAILED;
+
+		std::scoped_lock lock( m_mutex );
+
+		const uint32_t unTypeIndex = GetIndexTypeIndex( indexType );
+
+		SGeometryAllocation allocation;
+		allocation.vertexCount = unVertexCount;
+		allocation.indexCount = unIndexCount;
+		allocation.indexType = indexType;
+
+		// First arena of this layout with room for both ranges
+		for ( uint32_t i = 0; i < m_vecArenas.size() && !allocation.IsValid(); i++ )
+		{
+			SGeometryArena *pArena = m_vecArenas[ i ];
+			if ( pArena->stride != unStride || pArena->splitPositions != bSplitPositions )
+				continue;
+
+			if ( !pArena->vertexRanges.Allocate( unVertexCount, allocation.firstVertex ) )
+				continue;
+
+			const bool bHasIndexBuffer = pArena->indexBuffers[ unTypeIndex ] || CreateIndexBuffer( pArena, unTypeIndex, unIndexCount ) == VK_SUCCESS;
+			if ( !bHasIndexBuffer || !pArena->indexRanges[ unTypeIndex ].Allocate( unIndexCount, allocation.firstIndex ) )
+			{
+				pArena->vertexRanges.Free( allocation.firstVertex, unVertexCount );
+				continue;
+			}
+
+			allocation.arena = i;
+		}
+
+		if ( !allocation.IsValid() )
+		{
+			uint32_t unArena = 0;
+			VK_CHECK_RETURN( CreateArena( unArena, unStride, bSplitPositions, unVertexCount ) );
+			VK_CHECK_RETURN( CreateIndexBuffer( m_vecArenas[ unArena ], unTypeIndex, unIndexCount ) );
+
+			SGeometryArena *pArena = m_vecArenas[ unArena ];
+			bool bAllocated = pArena->vertexRanges.Allocate( unVertexCount, allocation.firstVertex ) && pArena->indexRanges[ unTypeIndex ].Allocate( unIndexCount, allocation.firstIndex );
+			assert( bAllocated );
+
+			allocation.arena = unArena;
+		}
+
+		// Ranges in use by the gpu are never written, so the copies need no synchronization with draws
+		SGeometryArena *pArena = m_vecArenas[ allocation.arena ];
+		VK_CHECK_RETURN( pArena->pVertexBuffer->Upload( pVertexData, (VkDeviceSize) unVertexCount * unStride, (VkDeviceSize) allocation.firstVertex * unStride ) );
+
+		if ( bSplitPositions )
+			VK_CHECK_RETURN( pArena->pPositionBuffer->Upload( pPositions, (VkDeviceSize) unVertexCount * sizeof( XrVector3f ), (VkDeviceSize) allocation.firstVertex * sizeof( XrVector3f ) ) );
+
+		const uint32_t unIndexSize = GetIndexSize( indexType );
+		VK_CHECK_RETURN( pArena->indexBuffers[ unTypeIndex ]->Upload( pIndexData, (VkDeviceSize) unIndexCount * unIndexSize, (VkDeviceSize) allocation.firstIndex * unIndexSize ) );
+
+		m_unAllocationCount++;
+		outAllocation = allocation;
+		return VK_SUCCESS;
+	}
+
+	void CGeometryPool::Free( SGeometryAllocation &allocation )
+	{
+		if ( !allocation.IsValid() )
+			return;
+
+		std::scoped_lock lock( m_mutex );
+		m_pendingFrees.push_back( { allocation, m_unFrame } );
+		allocation = {};
+	}
+
+	void CGeometryPool::Update()
+	{
+		std::scoped_lock lock( m_mutex );
+		m_unFrame++;
+
+		while ( !m_pendingFrees.empty() && m_unFrame - m_pendingFrees.front().frame >= k_unGeometryFreeDelayFrames )
+		{
+			Release( m_pendingFrees.front().allocation );
+			m_pendingFrees.pop_front();
+		}
+	}
+
+	void CGeometryPool::Bind( VkCommandBuffer commandBuffer, const SGeometryAllocation &allocation, bool bDepthOnly )
+	{
+		assert( allocation.IsValid() );
+
+		SBinding &binding = m_bindings[ commandBuffer ];
+		if ( binding.arena == allocation.arena && binding.indexType == allocation.indexType && binding.depthOnly == bDepthOnly )
+			return;
+
+		SGeometryArena *pArena = nullptr;
+		{
+			std::scoped_lock lock( m_mutex );
+			pArena = m_vecArenas[ allocation.arena ];
+		}
+
+		const VkDeviceSize offsets[ 1 ] = { 0 };
+		vkCmdBindIndexBuffer( commandBuffer, pArena->indexBuffers[ GetIndexTypeIndex( allocation.indexType ) ]->GetVkBuffer(), 0, allocation.indexType );
+
+		// Positions at binding 0 if split, then the attribute stream - the depth prepass only reads positions
+		if ( pArena->splitPositions )
+			vkCmdBindVertexBuffers( commandBuffer, 0, 1, pArena->pPositionBuffer->GetVkBufferPtr(), offsets );
+
+		if ( !bDepthOnly )
+			vkCmdBindVertexBuffers( commandBuffer, pArena->splitPositions ? 1 : 0, 1, pArena->pVertexBuffer->GetVkBufferPtr(), offsets );
+
+		binding = { allocation.arena, allocation.indexType, bDepthOnly };
+	}
+
+	void CGeometryPool::ResetBindings( VkCommandBuffer commandBuffer ) 
+	{ 
+		m_bindings.erase( commandBuffer ); 
+	}
+
+	CDeviceBuffer *CGeometryPool::GetVertexBuffer( const SGeometryAllocation &allocation )
+	{
+		std::scoped_lock lock( m_mutex );
+		return allocation.IsValid() ? m_vecArenas[ allocation.arena ]->pVertexBuffer : nullptr;
+	}
+
+	CDeviceBuffer *CGeometryPool::GetPositionBuffer( const SGeometryAllocation &allocation )
+	{
+		std::scoped_lock lock( m_mutex );
+		return allocation.IsValid() ? m_vecArenas[ allocation.arena ]->pPositionBuffer : nullptr;
+	}
+
+	CDeviceBuffer *CGeometryPool::GetIndexBuffer( const SGeometryAllocation &allocation )
+	{
+		std::scoped_lock lock( m_mutex );
+		return allocation.IsValid() ? m_vecArenas[ allocation.arena ]->indexBuffers[ GetIndexTypeIndex( allocation.indexType ) ] : nullptr;
+	}
+
+	VkDeviceSize CGeometryPool::GetAllocationBytes( const SGeometryAllocation &allocation )
+	{
+		if ( !allocation.IsValid() )
+			return 0;
+
+		std::scoped_lock lock( m_mutex );
+		const SGeometryArena *pArena = m_vecArenas[ allocation.arena ];
+		const VkDeviceSize unVertexSize = pArena->stride + ( pArena->splitPositions ? sizeof( XrVector3f ) : 0 );
+
+		return (VkDeviceSize) allocation.vertexCount * unVertexSize + (VkDeviceSize) allocation.indexCount * GetIndexSize( allocation.indexType );
+	}
+
+	void CGeometryPool::GetStats( SGeometryPoolStats &outStats )
+	{
+		std::scoped_lock lock( m_mutex );
+
+		outStats = {};
+		outStats.arenaCount = (uint32_t) m_vecArenas.size();
+		outStats.allocationCount = m_unAllocationCount;
+
+		for ( SGeometryArena *pArena : m_vecArenas )
+		{
+			const VkDeviceSize unVertexSize = pArena->stride + ( pArena->splitPositions ? sizeof( XrVector3f ) : 0 );
+			outStats.vertexBytes += (VkDeviceSize) pArena->vertexRanges.capacity * unVertexSize;
+			outStats.usedVertexBytes += (VkDeviceSize) pArena->vertexRanges.used * unVertexSize;
+
+			for ( uint32_t i = 0; i < 2; i++ )
+			{
+				const uint32_t unIndexSize = i == 0 ? sizeof( uint16_t ) : sizeof( uint32_t );
+				outStats.indexBytes += (VkDeviceSize) pArena->indexRanges[ i ].capacity * unIndexSize;
+				outStats.usedIndexBytes += (VkDeviceSize) pArena->indexRanges[ i ].used * unIndexSize;
+			}
+		}
+	}
+
+	void CGeometryPool::LogStats()
+	{
+		SGeometryPoolStats stats;
+		GetStats( stats );
+
+		LogInfo( "", "Geometry pool: %i arenas, %i allocations, vertices %.2f MB used of %.2f MB, indices %.2f MB used of %.2f MB",
+			stats.arenaCount,
+			stats.allocationCount,
+			stats.usedVertexBytes / ( 1024.f * 1024.f ),
+			stats.vertexBytes / ( 1024.f * 1024.f ),
+			stats.usedIndexBytes / ( 1024.f * 1024.f ),
+			stats.indexBytes / ( 1024.f * 1024.f ) );
+	}
+
+	VkResult CGeometryPool::CreateArena( uint32_t &outArena, uint32_t unStride, bool bSplitPositions, uint32_t unVertexCapacity )
+	{
+		// Models larger than an arena get one of their own
+		unVertexCapacity = std::max( unVertexCapacity, (uint32_t) ( m_unArenaVertexBytes / unStride ) );
+
+		SGeometryArena *pArena = new SGeometryArena;
+		pArena->stride = unStride;
+		pArena->splitPositions = bSplitPositions;
+		pArena->vertexRanges.Init( unVertexCapacity );
+
+		pArena->pVertexBuffer = new CDeviceBuffer( m_pSession );
+		VkResult result = pArena->pVertexBuffer->Init( VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, (VkDeviceSize) unVertexCapacity * unStride );
+
+		if ( result == VK_SUCCESS && bSplitPositions )
+		{
+			pArena->pPositionBuffer = new CDeviceBuffer( m_pSession );
+			result = pArena->pPositionBuffer->Init( VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, (VkDeviceSize) unVertexCapacity * sizeof( XrVector3f ) );
+		}
+
+		if ( result != VK_SUCCESS )
+		{
+			delete pArena->pVertexBuffer;
+			delete pArena->pPositionBuffer;
+			delete pArena;
+			return result;
+		}
+
+		outArena = (uint32_t) m_vecArenas.size();
+		m_vecArenas.push_back( pArena );
+
+		LogInfo( "", "Geometry pool arena %i created: %i vertices of %i bytes%s", outArena, unVertexCapacity, unStride, bSplitPositions ? " (split positions)" : "" );
+		return VK_SUCCESS;
+	}
+
+	VkResult CGeometryPool::CreateIndexBuffer( SGeometryArena *pArena, uint32_t unTypeIndex, uint32_t unIndexCapacity )
+	{
+		const uint32_t unIndexSize = unTypeIndex == 0 ? sizeof( uint16_t ) : sizeof( uint32_t );
+		unIndexCapacity = std::max( unIndexCapacity, (uint32_t) ( m_unArenaIndexBytes / unIndexSize ) );
+
+		CDeviceBuffer *pIndexBuffer = new CDeviceBuffer( m_pSession );
+		VkResult result = pIndexBuffer->Init( VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, (VkDeviceSize) unIndexCapacity * unIndexSize );
+		if ( result != VK_SUCCESS )
+		{
+			delete pIndexBuffer;
+			return result;
+		}
+
+		pArena->indexBuffers[ unTypeIndex ] = pIndexBuffer;
+		pArena->indexRanges[ unTypeIndex ].Init( unIndexCapacity );
+		return VK_SUCCESS;
+	}
+
+	void CGeometryPool::Release( const SGeometryAllocation &allocation )
+	{
+		SGeometryArena *pArena = m_vecArenas[ allocation.arena ];
+		pArena->vertexRanges.Free( allocation.firstVertex, allocation.vertexCount );
+		pArena->indexRanges[ GetIndexTypeIndex( allocation.indexType ) ].Free( allocation.firstIndex, allocation.indexCount );
+
+		assert( m_unAllocationCount > 0 );
+		m_unAllocationCount--;
+	}
+
+} // namespace xrlib
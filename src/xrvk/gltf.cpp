@@ -16,22 +16,685 @@
 #endif
 
 #include <tinygltf/tiny_gltf.h>
+#include <tinygltf/json.hpp>
+#include <xrlib/thread_pool.hpp>
+#include <xrvk/accessor.hpp>
 #include <xrvk/gltf.hpp>
+#include <xrvk/mappedfile.hpp>
+#include <xrvk/meshcodec.hpp>
+#include <xrvk/modelcache.hpp>
 #include <xrvk/texture.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
 #include <filesystem>
+#include <limits>
+#include <string_view>
+#include <thread>
 
 namespace fs = std::filesystem;
 namespace xrlib
 {
+	// Image callback for tinygltf when decoding is left to CGltf::DecodeImages - buffer view images are decoded straight from the
+	// model's buffers later, any other image (uri, data uri) only has its encoded bytes in a temporary so those get copied
+	static bool DeferImageDecode( 
+		tinygltf::Image *pImage, 
+		const int nImageIndex, 
+		std::string *pError, 
+		std::string *pWarning, 
+		int nRequiredWidth, 
+		int nRequiredHeight, 
+		const unsigned char *pBytes, 
+		int nSize, 
+		void *pUserData )
+	{
+		auto *pEncodedImages = static_cast< std::vector< std::vector< unsigned char > > * >( pUserData );
+		if ( nImageIndex < 0 )
+			return false;
+
+		if ( static_cast< size_t >( nImageIndex ) >= pEncodedImages->size() )
+			pEncodedImages->resize( nImageIndex + 1 );
+
+		if ( pImage->bufferView < 0 )
+			( *pEncodedImages )[ nImageIndex ].assign( pBytes, pBytes + nSize );
+
+		return true;
+	}
+
+	// Resolves an accessor's buffer view, stride and sparse data - false if any of it lies outside its buffer
+	static bool GetAccessorStream( SAccessorStream &outStream, const tinygltf::Model &model, int nAccessor )
+	{
+		auto GetBufferView = [ &model ]( int nView, const uint8_t *&outData, size_t &outSize ) -> bool
+		{
+			if ( nView < 0 || nView >= static_cast< int >( model.bufferViews.size() ) )
+				return false;
+
+			const tinygltf::BufferView &view = model.bufferViews[ nView ];
+			if ( view.buffer < 0 || view.buffer >= static_cast< int >( model.buffers.size() ) )
+				return false;
+
+			const std::vector< unsigned char > &data = model.buffers[ view.buffer ].data;
+			if ( view.byteOffset + view.byteLength > data.size() )
+				return false;
+
+			outData = data.data() + view.byteOffset;
+			outSize = view.byteLength;
+			return true;
+		};
+
+		if ( nAccessor < 0 || nAccessor >= static_cast< int >( model.accessors.size() ) )
+			return false;
+
+		const tinygltf::Accessor &accessor = model.accessors[ nAccessor ];
+		const int nComponents = tinygltf::GetNumComponentsInType( accessor.type );
+
+		outStream = {};
+		outStream.count = accessor.count;
+		outStream.componentType = static_cast< EAccessorComponent >( accessor.componentType );
+		outStream.normalized = accessor.normalized;
+
+		const size_t unComponentSize = GetAccessorComponentSize( outStream.componentType );
+		if ( unComponentSize == 0 || nComponents <= 0 )
+			return false;
+
+		outStream.componentCount = static_cast< uint32_t >( nComponents );
+		const size_t unElementSize = unComponentSize * outStream.componentCount;
+		outStream.stride = unElementSize;
+
+		// No buffer view - all zeros, unless replaced by sparse values
+		if ( accessor.bufferView >= 0 )
+		{
+			const uint8_t *pView = nullptr;
+			size_t unViewSize = 0;
+			if ( !GetBufferView( accessor.bufferView, pView, unViewSize ) )
+				return false;
+
+			if ( model.bufferViews[ accessor.bufferView ].byteStride > 0 )
+				outStream.stride = model.bufferViews[ accessor.bufferView ].byteStride;
+
+			if ( accessor.count > 0 && accessor.byteOffset + outStream.stride * ( accessor.count - 1 ) + unElementSize > unViewSize )
+				return false;
+
+			outStream.pData = pView + accessor.byteOffset;
+		}
+
+		if ( accessor.sparse.isSparse && accessor.sparse.count > 0 )
+		{
+			const uint8_t *pIndices = nullptr;
+			const uint8_t *pValues = nullptr;
+			size_t unIndicesSize = 0;
+			size_t unValuesSize = 0;
+			if ( !GetBufferView( accessor.sparse.indices.bufferView, pIndices, unIndicesSize ) || !GetBufferView( accessor.sparse.values.bufferView, pValues, unValuesSize ) )
+				return false;
+
+			outStream.sparseCount = static_cast< size_t >( accessor.sparse.count );
+			outStream.sparseIndexType = static_cast< EAccessorComponent >( accessor.sparse.indices.componentType );
+
+			const size_t unIndexSize = GetAccessorComponentSize( outStream.sparseIndexType );
+			const size_t unIndicesOffset = static_cast< size_t >( accessor.sparse.indices.byteOffset );
+			const size_t unValuesOffset = static_cast< size_t >( accessor.sparse.values.byteOffset );
+			if ( unIndexSize == 0 || 
+				 unIndicesOffset + outStream.sparseCount * unIndexSize > unIndicesSize || 
+				 unValuesOffset + outStream.sparseCount * unElementSize > unValuesSize )
+				return false;
+
+			outStream.pSparseIndices = pIndices + unIndicesOffset;
+			outStream.pSparseValues = pValues + unValuesOffset;
+		}
+
+		return true;
+	}
+
+	// EXT_meshopt_compression fallback buffers may have no uri (the data only exists compressed), which tinygltf refuses to load.
+	// Gives them a placeholder data uri instead - returns false if there was nothing to patch.
+	static bool PatchMeshoptFallbackBuffers( std::string &sJson )
+	{
+		nlohmann::json json = nlohmann::json::parse( sJson, nullptr, false );
+		if ( json.is_discarded() || !json.is_object() )
+			return false;
+
+		auto itBuffers = json.find( "buffers" );
+		if ( itBuffers == json.end() || !itBuffers->is_array() )
+			return false;
+
+		bool bPatched = false;
+		for ( auto &buffer : *itBuffers )
+		{
+			if ( !buffer.is_object() || buffer.contains( "uri" ) )
+				continue;
+
+			auto itExtensions = buffer.find( "extensions" );
+			if ( itExtensions == buffer.end() || !itExtensions->is_object() )
+				continue;
+
+			auto itMeshopt = itExtensions->find( "EXT_meshopt_compression" );
+			if ( itMeshopt == itExtensions->end() || !itMeshopt->is_object() )
+				continue;
+
+			auto itFallback = itMeshopt->find( "fallback" );
+			if ( itFallback != itMeshopt->end() && itFallback->is_boolean() && itFallback->get< bool >() )
+			{
+				buffer[ "uri" ] = "data:application/octet-stream;base64,AAAA";
+				buffer[ "byteLength" ] = 3;
+				bPatched = true;
+			}
+		}
+
+		if ( bPatched )
+			sJson = json.dump();
+
+		return bPatched;
+	}
+
+	// Required extensions that change how geometry is stored can't be ignored
+	static bool CheckRequiredExtensions( const tinygltf::Model &model, const std::string &sFilename )
+	{
+		for ( const std::string &sExtension : model.extensionsRequired )
+		{
+			#ifndef TINYGLTF_ENABLE_DRACO
+				if ( sExtension == "KHR_draco_mesh_compression" )
+				{
+					LogError( XRLIB_NAME, "%s requires KHR_draco_mesh_compression, xrlib was built without draco (ENABLE_DRACO)", sFilename.c_str() );
+					return false;
+				}
+			#endif
+
+			if ( sExtension == "EXT_meshopt_compression" || sExtension == "KHR_mesh_quantization" || sExtension == "KHR_draco_mesh_compression" )
+				continue;
+
+			LogWarning( XRLIB_NAME, "%s requires unsupported extension %s, it may not display correctly", sFilename.c_str(), sExtension.c_str() );
+		}
+
+		return true;
+	}
+
+	// Decodes EXT_meshopt_compression buffer views into one new buffer and points the views at it, accessors then read them as usual
+	static bool DecodeMeshoptBufferViews( tinygltf::Model &model )
+	{
+		struct SCompressedView
+		{
+			tinygltf::BufferView *pView = nullptr;
+			const uint8_t *pSource = nullptr;
+			size_t unSourceSize = 0;
+			size_t unCount = 0;
+			size_t unStride = 0;
+			size_t unOffset = 0;
+			EMeshoptMode mode = EMeshoptMode::Attributes;
+			EMeshoptFilter filter = EMeshoptFilter::None;
+		};
+
+		std::vector< SCompressedView > vecViews;
+		size_t unDecodedSize = 0;
+
+		for ( auto &view : model.bufferViews )
+		{
+			auto itExtension = view.extensions.find( "EXT_meshopt_compression" );
+			if ( itExtension == view.extensions.end() )
+				continue;
+
+			const tinygltf::Value &extension = itExtension->second;
+			auto GetNumber = [ &extension ]( const char *pKey ) -> size_t 
+			{ 
+				return extension.Has( pKey ) && extension.Get( pKey ).IsNumber() ? static_cast< size_t >( extension.Get( pKey ).GetNumberAsDouble() ) : 0; 
+			};
+			auto GetString = [ &extension ]( const char *pKey ) -> std::string 
+			{ 
+				return extension.Has( pKey ) && extension.Get( pKey ).IsString() ? extension.Get( pKey ).Get< std::string >() : std::string(); 
+			};
+
+			SCompressedView compressed;
+			compressed.pView = &view;
+			compressed.unSourceSize = GetNumber( "byteLength" );
+			compressed.unCount = GetNumber( "count" );
+			compressed.unStride = GetNumber( "byteStride" );
+
+			const size_t unBuffer = extension.Has( "buffer" ) ? GetNumber( "buffer" ) : model.buffers.size();
+			const size_t unSourceOffset = GetNumber( "byteOffset" );
+			if ( unBuffer >= model.buffers.size() || unSourceOffset + compressed.unSourceSize > model.buffers[ unBuffer ].data.size() )
+			{
+				LogError( XRLIB_NAME, "Meshopt compressed buffer view %s references data outside of its buffer", view.name.c_str() );
+				return false;
+			}
+
+			compressed.pSource = model.buffers[ unBuffer ].data.data() + unSourceOffset;
+
+			const std::string sMode = GetString( "mode" );
+			if ( sMode == "ATTRIBUTES" )
+				compressed.mode = EMeshoptMode::Attributes;
+			else if ( sMode == "TRIANGLES" )
+				compressed.mode = EMeshoptMode::Triangles;
+			else if ( sMode == "INDICES" )
+				compressed.mode = EMeshoptMode::Indices;
+			else
+			{
+				LogError( XRLIB_NAME, "Unknown meshopt compression mode %s", sMode.c_str() );
+				return false;
+			}
+
+			const std::string sFilter = GetString( "filter" );
+			if ( sFilter.empty() || sFilter == "NONE" )
+				compressed.filter = EMeshoptFilter::None;
+			else if ( sFilter == "OCTAHEDRAL" )
+				compressed.filter = EMeshoptFilter::Octahedral;
+			else if ( sFilter == "QUATERNION" )
+				compressed.filter = EMeshoptFilter::Quaternion;
+			else if ( sFilter == "EXPONENTIAL" )
+				compressed.filter = EMeshoptFilter::Exponential;
+			else
+			{
+				LogError( XRLIB_NAME, "Unknown meshopt compression filter %s", sFilter.c_str() );
+				return false;
+			}
+
+			compressed.unOffset = unDecodedSize;
+			unDecodedSize += ( compressed.unCount * compressed.unStride + 3 ) & ~size_t( 3 );
+			vecViews.push_back( compressed );
+		}
+
+		if ( vecViews.empty() )
+			return true;
+
+		// Decode before adding the buffer, the source pointers point into model.buffers
+		std::vector< unsigned char > vecDecoded( unDecodedSize );
+		for ( const SCompressedView &compressed : vecViews )
+		{
+			if ( !DecodeMeshoptBuffer( vecDecoded.data() + compressed.unOffset, compressed.unCount, compressed.unStride, compressed.pSource, compressed.unSourceSize, compressed.mode, compressed.filter ) )
+			{
+				LogError( XRLIB_NAME, "Failed to decode meshopt compressed buffer view %s", compressed.pView->name.c_str() );
+				return false;
+			}
+		}
+
+		const int nDecodedBuffer = static_cast< int >( model.buffers.size() );
+
+		tinygltf::Buffer decodedBuffer;
+		decodedBuffer.name = "EXT_meshopt_compression";
+		decodedBuffer.data = std::move( vecDecoded );
+		model.buffers.push_back( std::move( decodedBuffer ) );
+
+		for ( const SCompressedView &compressed : vecViews )
+		{
+			compressed.pView->buffer = nDecodedBuffer;
+			compressed.pView->byteOffset = compressed.unOffset;
+			compressed.pView->byteLength = compressed.unCount * compressed.unStride;
+			compressed.pView->extensions.erase( "EXT_meshopt_compression" );
+		}
+
+		// Fallback buffers (placeholders, or uncompressed copies loaded from a uri) aren't referenced by anything anymore
+		for ( auto &buffer : model.buffers )
+		{
+			auto itExtension = buffer.extensions.find( "EXT_meshopt_compression" );
+			if ( itExtension != buffer.extensions.end() && itExtension->second.Has( "fallback" ) && itExtension->second.Get( "fallback" ).IsBool() && itExtension->second.Get( "fallback" ).Get< bool >() )
+				std::vector< unsigned char >().swap( buffer.data );
+		}
+
+		return true;
+	}
+
+	// Quantized texture coordinates (KHR_mesh_quantization) are dequantized through KHR_texture_transform. Materials have no uv transform,
+	// so the base color texture's transform (exporters use the same one for all of a material's textures) is baked into uv0 instead.
+	static bool GetUv0Transform( const tinygltf::Model &model, int nMaterial, float outTransform[ 6 ] )
+	{
+		if ( nMaterial < 0 || nMaterial >= static_cast< int >( model.materials.size() ) )
+			return false;
+
+		const tinygltf::TextureInfo &textureInfo = model.materials[ nMaterial ].pbrMetallicRoughness.baseColorTexture;
+		auto itExtension = textureInfo.extensions.find( "KHR_texture_transform" );
+		if ( textureInfo.index < 0 || itExtension == textureInfo.extensions.end() )
+			return false;
+
+		const tinygltf::Value &transform = itExtension->second;
+		auto GetNumber = [ &transform ]( const char *pKey, int nIndex, float fDefault ) -> float
+		{
+			if ( !transform.Has( pKey ) )
+				return fDefault;
+
+			const tinygltf::Value &value = nIndex < 0 ? transform.Get( pKey ) : transform.Get( pKey ).Get( nIndex );
+			return value.IsNumber() ? static_cast< float >( value.GetNumberAsDouble() ) : fDefault;
+		};
+
+		const int nTexCoord = static_cast< int >( GetNumber( "texCoord", -1, static_cast< float >( textureInfo.texCoord ) ) );
+		if ( nTexCoord != 0 )
+			return false;
+
+		// offset * rotation * scale, as a 2x3 matrix
+		const float fRotation = GetNumber( "rotation", -1, 0.f );
+		const float fCos = std::cos( fRotation );
+		const float fSin = std::sin( fRotation );
+		const float fScaleU = GetNumber( "scale", 0, 1.f );
+		const float fScaleV = GetNumber( "scale", 1, 1.f );
+
+		outTransform[ 0 ] = fCos * fScaleU;
+		outTransform[ 1 ] = fSin * fScaleV;
+		outTransform[ 2 ] = GetNumber( "offset", 0, 0.f );
+		outTransform[ 3 ] = -fSin * fScaleU;
+		outTransform[ 4 ] = fCos * fScaleV;
+		outTransform[ 5 ] = GetNumber( "offset", 1, 0.f );
+		return true;
+	}
+
+	// Rough capacity for all mesh data (meshes used by several nodes are processed again), saves regrowing the vectors per primitive
+	static void ReserveMeshData( const tinygltf::Model &model, CRenderModel *outRenderModel )
+	{
+		size_t unVertexCount = 0;
+		size_t unIndexCount = 0;
+		for ( const auto &mesh : model.meshes )
+		{
+			for ( const auto &primitive : mesh.primitives )
+			{
+				auto itPosition = primitive.attributes.find( "POSITION" );
+				if ( itPosition == primitive.attributes.end() || itPosition->second < 0 || itPosition->second >= static_cast< int >( model.accessors.size() ) )
+					continue;
+
+				const size_t unPrimitiveVertices = model.accessors[ itPosition->second ].count;
+				unVertexCount += unPrimitiveVertices;
+
+				if ( primitive.indices >= 0 && primitive.indices < static_cast< int >( model.accessors.size() ) )
+					unIndexCount += model.accessors[ primitive.indices ].count;
+				else
+					unIndexCount += unPrimitiveVertices;
+			}
+		}
+
+		outRenderModel->vertices.reserve( outRenderModel->vertices.size() + unVertexCount );
+		outRenderModel->indices.reserve( outRenderModel->indices.size() + unIndexCount );
+	}
+
+	// Appends the deltas of one primitive's morph target that move its vertex, in vertex order (unFirstVertex is the primitive's first vertex)
+	static void AppendMorphDeltas( std::vector< SMorphDelta > &outDeltas, const tinygltf::Model &model, const std::map< std::string, int > &target, uint32_t unFirstVertex, size_t unVertexCount )
+	{
+		if ( unVertexCount == 0 )
+			return;
+
+		std::vector< SMorphDelta > vecDeltas( unVertexCount );
+		auto DecodeStream = [ & ]( const char *pName, XrVector3f SMorphDelta::*pMember )
+		{
+			SAccessorStream stream;
+			auto it = target.find( pName );
+			if ( it == target.end() || !GetAccessorStream( stream, model, it->second ) )
+				return;
+
+			stream.count = std::min( stream.count, unVertexCount );
+			DecodeAccessorFloat( stream, &( vecDeltas[ 0 ].*pMember ).x, 3, sizeof( SMorphDelta ) );
+		};
+
+		DecodeStream( "POSITION", &SMorphDelta::position );
+		DecodeStream( "NORMAL", &SMorphDelta::normal );
+		DecodeStream( "TANGENT", &SMorphDelta::tangent );
+
+		// Dense targets of a face mostly hold zeros
+		auto IsZero = []( const XrVector3f &v ) { return v.x == 0.f && v.y == 0.f && v.z == 0.f; };
+		for ( size_t i = 0; i < unVertexCount; i++ )
+		{
+			SMorphDelta &delta = vecDeltas[ i ];
+			if ( IsZero( delta.position ) && IsZero( delta.normal ) && IsZero( delta.tangent ) )
+				continue;
+
+			delta.vertex = unFirstVertex + static_cast< uint32_t >( i );
+			outDeltas.push_back( delta );
+		}
+	}
+
+	// Where each mesh is placed in the default scene, in model space
+	struct SGltfMeshPlacements
+	{
+		std::vector< XrMatrix4x4f > matrices;
+		uint32_t gpuInstancedCount = 0;	// placements from EXT_mesh_gpu_instancing
+		bool skinned = false;			// skinned meshes ignore their node transforms and are never instanced
+	};
+
+	// Translation, rotation and scale properties of a node (defaults for the ones it doesn't have), ignores the matrix property
+	static void GetNodeTRS( const tinygltf::Node &node, XrVector3f &outTranslation, XrQuaternionf &outRotation, XrVector3f &outScale )
+	{
+		outTranslation = { 0.f, 0.f, 0.f };
+		outRotation = { 0.f, 0.f, 0.f, 1.f };
+		outScale = { 1.f, 1.f, 1.f };
+
+		if ( node.translation.size() == 3 )
+			outTranslation = { static_cast< float >( node.translation[ 0 ] ), static_cast< float >( node.translation[ 1 ] ), static_cast< float >( node.translation[ 2 ] ) };
+
+		if ( node.rotation.size() == 4 )
+			outRotation = { static_cast< float >( node.rotation[ 0 ] ), static_cast< float >( node.rotation[ 1 ] ), static_cast< float >( node.rotation[ 2 ] ), static_cast< float >( node.rotation[ 3 ] ) };
+
+		if ( node.scale.size() == 3 )
+			outScale = { static_cast< float >( node.scale[ 0 ] ), static_cast< float >( node.scale[ 1 ] ), static_cast< float >( node.scale[ 2 ] ) };
+	}
+
+	static XrMatrix4x4f GetNodeMatrix( const tinygltf::Node &node )
+	{
+		XrMatrix4x4f matrix;
+
+		// Both glTF and XrMatrix4x4f are column major
+		if ( node.matrix.size() == 16 )
+		{
+			for ( size_t i = 0; i < 16; i++ )
+				matrix.m[ i ] = static_cast< float >( node.matrix[ i ] );
+
+			return matrix;
+		}
+
+		XrVector3f translation, scale;
+		XrQuaternionf rotation;
+		GetNodeTRS( node, translation, rotation, scale );
+
+		XrMatrix4x4f_CreateTranslationRotationScale( &matrix, &translation, &rotation, &scale );
+		return matrix;
+	}
+
+	// Appends the EXT_mesh_gpu_instancing transforms of a node (relative to the node), returns false if the node doesn't use the extension
+	static bool GetGpuInstanceMatrices( std::vector< XrMatrix4x4f > &outMatrices, const tinygltf::Model &model, const tinygltf::Node &node )
+	{
+		auto itExtension = node.extensions.find( "EXT_mesh_gpu_instancing" );
+		if ( itExtension == node.extensions.end() || !itExtension->second.Has( "attributes" ) )
+			return false;
+
+		const tinygltf::Value &attributes = itExtension->second.Get( "attributes" );
+
+		// Missing attributes keep their defaults, all present ones must have the same count
+		size_t unCount = std::numeric_limits< size_t >::max();
+		auto FindStream = [ & ]( const char *pName, SAccessorStream &outStream ) -> bool
+		{
+			if ( !attributes.Has( pName ) || !GetAccessorStream( outStream, model, attributes.Get( pName ).GetNumberAsInt() ) )
+				return false;
+
+			unCount = std::min( unCount, outStream.count );
+			return true;
+		};
+
+		SAccessorStream translation, rotation, scale;
+		const bool bTranslation = FindStream( "TRANSLATION", translation );
+		const bool bRotation = FindStream( "ROTATION", rotation );
+		const bool bScale = FindStream( "SCALE", scale );
+
+		if ( !bTranslation && !bRotation && !bScale )
+			return false;
+
+		std::vector< XrVector3f > vecTranslations( unCount, XrVector3f { 0.f, 0.f, 0.f } );
+		std::vector< XrQuaternionf > vecRotations( unCount, XrQuaternionf { 0.f, 0.f, 0.f, 1.f } );
+		std::vector< XrVector3f > vecScales( unCount, XrVector3f { 1.f, 1.f, 1.f } );
+
+		if ( bTranslation )
+		{
+			translation.count = unCount;
+			DecodeAccessorFloat( translation, &vecTranslations.data()->x, 3, sizeof( XrVector3f ) );
+		}
+
+		if ( bRotation )
+		{
+			rotation.count = unCount;
+			DecodeAccessorFloat( rotation, &vecRotations.data()->x, 4, sizeof( XrQuaternionf ) );
+		}
+
+		if ( bScale )
+		{
+			scale.count = unCount;
+			DecodeAccessorFloat( scale, &vecScales.data()->x, 3, sizeof( XrVector3f ) );
+		}
+
+		outMatrices.resize( outMatrices.size() + unCount );
+		XrMatrix4x4f *pMatrices = outMatrices.data() + outMatrices.size() - unCount;
+		for ( size_t i = 0; i < unCount; i++ )
+			XrMatrix4x4f_CreateTranslationRotationScale( &pMatrices[ i ], &vecTranslations[ i ], &vecRotations[ i ], &vecScales[ i ] );
+
+		return true;
+	}
+
+	static void CollectMeshPlacements( std::vector< SGltfMeshPlacements > &placements, const tinygltf::Model &model, int nNode, const XrMatrix4x4f &parentMatrix, uint32_t unDepth )
+	{
+		// Node graphs are trees, but don't trust the file with the recursion depth
+		if ( nNode < 0 || nNode >= static_cast< int >( model.nodes.size() ) || unDepth > model.nodes.size() )
+			return;
+
+		const tinygltf::Node &node = model.nodes[ nNode ];
+
+		XrMatrix4x4f localMatrix = GetNodeMatrix( node );
+		XrMatrix4x4f worldMatrix;
+		XrMatrix4x4f_Multiply( &worldMatrix, &parentMatrix, &localMatrix );
+
+		if ( node.mesh >= 0 && node.mesh < static_cast< int >( placements.size() ) )
+		{
+			SGltfMeshPlacements &meshPlacements = placements[ node.mesh ];
+
+			std::vector< XrMatrix4x4f > vecInstanceMatrices;
+			if ( node.skin >= 0 )
+			{
+				meshPlacements.skinned = true;
+				meshPlacements.matrices.push_back( worldMatrix );
+			}
+			else if ( GetGpuInstanceMatrices( vecInstanceMatrices, model, node ) )
+			{
+				meshPlacements.gpuInstancedCount += static_cast< uint32_t >( vecInstanceMatrices.size() );
+				for ( const XrMatrix4x4f &instanceMatrix : vecInstanceMatrices )
+				{
+					meshPlacements.matrices.emplace_back();
+					XrMatrix4x4f_Multiply( &meshPlacements.matrices.back(), &worldMatrix, &instanceMatrix );
+				}
+			}
+			else
+			{
+				meshPlacements.matrices.push_back( worldMatrix );
+			}
+		}
+
+		for ( int nChild : node.children )
+			CollectMeshPlacements( placements, model, nChild, worldMatrix, unDepth + 1 );
+	}
+
+	// Negative for transforms that mirror (and so flip the triangle winding)
+	static float GetDeterminant3x3( const XrMatrix4x4f &matrix )
+	{
+		const float *m = matrix.m;
+		return m[ 0 ] * ( m[ 5 ] * m[ 10 ] - m[ 9 ] * m[ 6 ] ) - m[ 4 ] * ( m[ 1 ] * m[ 10 ] - m[ 9 ] * m[ 2 ] ) + m[ 8 ] * ( m[ 1 ] * m[ 6 ] - m[ 5 ] * m[ 2 ] );
+	}
+
+	// Transforms vertices [unFirstVertex, end) and flips the winding of indices [unFirstIndex, end) if the transform mirrors
+	static void BakeMeshTransform( std::vector< SMeshVertex > &vertices, std::vector< uint32_t > &indices, size_t unFirstVertex, size_t unFirstIndex, const XrMatrix4x4f &matrix )
+	{
+		// Normals use the inverse transpose, tangents the upper 3x3
+		XrMatrix4x4f inverse;
+		XrMatrix4x4f_Invert( &inverse, &matrix );
+
+		const float *m = matrix.m;
+		const float *inv = inverse.m;
+
+		auto Normalized = []( XrVector3f v ) -> XrVector3f
+		{
+			const float fLength = sqrtf( v.x * v.x + v.y * v.y + v.z * v.z );
+			return fLength > 0.f ? XrVector3f { v.x / fLength, v.y / fLength, v.z / fLength } : v;
+		};
+
+		for ( size_t i = unFirstVertex; i < vertices.size(); i++ )
+		{
+			SMeshVertex &vertex = vertices[ i ];
+
+			const XrVector3f p = vertex.position;
+			vertex.position = { m[ 0 ] * p.x + m[ 4 ] * p.y + m[ 8 ] * p.z + m[ 12 ], m[ 1 ] * p.x + m[ 5 ] * p.y + m[ 9 ] * p.z + m[ 13 ], m[ 2 ] * p.x + m[ 6 ] * p.y + m[ 10 ] * p.z + m[ 14 ] };
+
+			const XrVector3f n = vertex.normal;
+			vertex.normal = Normalized( { inv[ 0 ] * n.x + inv[ 1 ] * n.y + inv[ 2 ] * n.z, inv[ 4 ] * n.x + inv[ 5 ] * n.y + inv[ 6 ] * n.z, inv[ 8 ] * n.x + inv[ 9 ] * n.y + inv[ 10 ] * n.z } );
+
+			const XrVector3f t = { vertex.tangent.x, vertex.tangent.y, vertex.tangent.z };
+			const XrVector3f tangent = Normalized( { m[ 0 ] * t.x + m[ 4 ] * t.y + m[ 8 ] * t.z, m[ 1 ] * t.x + m[ 5 ] * t.y + m[ 9 ] * t.z, m[ 2 ] * t.x + m[ 6 ] * t.y + m[ 10 ] * t.z } );
+			vertex.tangent = { tangent.x, tangent.y, tangent.z, vertex.tangent.w };
+		}
+
+		if ( GetDeterminant3x3( matrix ) < 0.f )
+		{
+			for ( size_t i = unFirstIndex; i + 2 < indices.size(); i += 3 )
+				std::swap( indices[ i + 1 ], indices[ i + 2 ] );
+		}
+	}
+
+	// Shear (non uniform scale under a rotated parent) is lost
+	static void DecomposeMatrix( const XrMatrix4x4f &matrix, XrVector3f &outTranslation, XrQuaternionf &outRotation, XrVector3f &outScale )
+	{
+		XrMatrix4x4f_GetTranslation( &outTranslation, &matrix );
+		XrMatrix4x4f_GetScale( &outScale, &matrix );
+
+		// Mirrored placements keep the mirror in the x scale, the rotation is taken from the unmirrored axes
+		XrMatrix4x4f rotationMatrix = matrix;
+		if ( GetDeterminant3x3( matrix ) < 0.f )
+		{
+			outScale.x = -outScale.x;
+			rotationMatrix.m[ 0 ] = -rotationMatrix.m[ 0 ];
+			rotationMatrix.m[ 1 ] = -rotationMatrix.m[ 1 ];
+			rotationMatrix.m[ 2 ] = -rotationMatrix.m[ 2 ];
+		}
+
+		XrMatrix4x4f_GetRotation( &outRotation, &rotationMatrix );
+	}
+
+	// Matrix nodes are decomposed, so they can be animated and moved like the others
+	static uint32_t AddSceneGraphNode( CSceneGraph &sceneGraph, const tinygltf::Node &node, int32_t nParent )
+	{
+		XrVector3f translation, scale;
+		XrQuaternionf rotation;
+
+		if ( node.matrix.size() == 16 )
+			DecomposeMatrix( GetNodeMatrix( node ), translation, rotation, scale );
+		else
+			GetNodeTRS( node, translation, rotation, scale );
+
+		return sceneGraph.AddNode( nParent, translation, rotation, scale, node.name );
+	}
+
+	// Instance pose and scale of a placement, scaled by the model's import scale
+	static SInstanceState GetInstanceState( const XrMatrix4x4f &matrix, const XrVector3f &modelScale )
+	{
+		XrVector3f translation, scale;
+		XrQuaternionf rotation;
+		DecomposeMatrix( matrix, translation, rotation, scale );
+
+		SInstanceState state( XrVector3f { scale.x * modelScale.x, scale.y * modelScale.y, scale.z * modelScale.z } );
+		state.pose.orientation = rotation;
+		state.pose.position = { translation.x * modelScale.x, translation.y * modelScale.y, translation.z * modelScale.z };
+		return state;
+	}
+
 	CGltf::CGltf( CSession *pSession )
 		: m_pSession( pSession )
 	{
-		assert( pSession );
 	}
 
 	CGltf::~CGltf()
 	{
+		// Workers may still be parsing a cancelled request - the thread pool has to outlive the loader
+		CancelAllLoads();
+		while ( m_unLoadTasks > 0 )
+			std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+
+		// Again for requests that were loading and reached their upload step in the meantime
+		CancelAllLoads();
+		UpdateAsyncLoads();
+
+		// Frames are done by now, descriptor sets go with their pool
+		for ( SReplacedMaterials &replaced : m_replacedMaterials )
+			DestroyReplacedMaterials( replaced, nullptr );
+
+		m_replacedMaterials.clear();
 	}
 
 	bool CGltf::LoadAndParse( CRenderModel *outRenderModel, VkCommandPool commandPool, const std::string &sFilename, XrVector3f scale )
@@ -39,6 +702,10 @@ namespace xrlib
 		std::unique_ptr< TinyGLTF > pGltfLoader = std::make_unique< TinyGLTF >();
 		std::unique_ptr< Model > pModel = std::make_unique< Model >();
 
+		std::vector< std::vector< unsigned char > > vecEncodedImages;
+		if ( imageDecodePool )
+			pGltfLoader->SetImageLoader( DeferImageDecode, &vecEncodedImages );
+
 		// Check file validity
 		bool bResult = false;
 		std::string sError, sWarn;
@@ -62,61 +729,576 @@ namespace xrlib
 		// Load gltf file based on extension
 		if ( file.extension() == ".glb" )
 		{
-			bResult = pGltfLoader->LoadBinaryFromFile( pModel.get(), &sError, &sWarn, sFilename );
+			bResult = LoadMapped( pGltfLoader.get(), pModel.get(), sError, sWarn, sFilename, true );
+		}
+		else if ( file.extension() == ".gltf" )
+		{
+			bResult = LoadMapped( pGltfLoader.get(), pModel.get(), sError, sWarn, sFilename, false );
+		}
+		else
+		{
+			LogError( XRLIB_NAME, "Error: Invalid file format: %s", sFilename.c_str() );
+			return false;
+		}
+
+		// Show warnings and errors
+		if ( !sWarn.empty() )
+			LogWarning( XRLIB_NAME, "Warning loading %s: %s", sFilename.c_str(), sWarn.c_str() );
+
+		if ( !sError.empty() )
+			LogError( XRLIB_NAME, "Error loading %s: %s", sFilename.c_str(), sError.c_str() );
+        
+
+		if ( !bResult )
+		{
+			LogError( XRLIB_NAME, "Failed to parse gltf file: %s", sFilename.c_str() );
+			return false;
+		}
+
+		// Compressed geometry is decoded into plain buffer views before anything reads it
+		if ( !CheckRequiredExtensions( *pModel, sFilename ) || !DecodeMeshoptBufferViews( *pModel ) )
+			return false;
+
+		if ( imageDecodePool )
+			DecodeImages( *pModel, vecEncodedImages );
+
+		// Parse Textures (the gltf model is discarded, so its pixels are moved rather than copied)
+		ParseTextures( outRenderModel, commandPool, *pModel, true );
+
+		// Parse Materials
+		ParseMaterials( outRenderModel, *pModel );
+
+		// Parse Skins
+		ParseSkins( outRenderModel, *pModel );
+
+		// Process all nodes in the scene, the hierarchy is kept in the model's scene graph
+		ProcessScene( outRenderModel, *pModel );
+
+		// Everything needed is in the render model now - release the gltf buffers before optimization allocates more
+		pModel.reset();
+
+		OptimizeMeshData( outRenderModel );
+
+		// Set scale
+		for ( size_t i = 0; i < outRenderModel->GetInstanceCount(); i++ )
+		{
+			outRenderModel->instances[ i ].scale = scale;
+		}
+		
+		return true;
+	}
+
+	bool CGltf::LoadCached( CRenderModel *outRenderModel, VkCommandPool commandPool, const std::string &sFilename, const std::string &sCacheFile, XrVector3f scale )
+	{
+		const uint64_t unImportHash = GetImportHash( sFilename );
+
+		CModelCacheFile cache;
+		if ( unImportHash != 0 && cache.Open( sCacheFile, unImportHash ) )
+		{
+			if ( cache.Read( outRenderModel ) )
+			{
+				for ( uint32_t i = 0; i < outRenderModel->textures.size(); i++ )
+				{
+					size_t unSize = 0;
+					const uint8_t *pPixels = cache.GetTextureData( i, unSize );
+					if ( !pPixels )
+						continue;
+
+					// The upload reads the mapping, the copy is kept for residency (evicted textures are restored from it)
+					STexture &texture = outRenderModel->textures[ i ];
+					texture.data.assign( pPixels, pPixels + unSize );
+
+					if ( m_pSession )
+						CreateTextureResources( &texture, pPixels, unSize );
+				}
+
+				for ( size_t i = 0; i < outRenderModel->GetInstanceCount(); i++ )
+				{
+					outRenderModel->instances[ i ].scale = scale;
+				}
+
+				LogInfo( XRLIB_NAME, "Loaded %s from model cache %s", sFilename.c_str(), sCacheFile.c_str() );
+				return true;
+			}
+
+			LogWarning( XRLIB_NAME, "Model cache %s is corrupt, importing %s", sCacheFile.c_str(), sFilename.c_str() );
+
+			// Drop whatever was read before the failure
+			outRenderModel->vertices.clear();
+			outRenderModel->indices.clear();
+			outRenderModel->materialSections.clear();
+			outRenderModel->lods.clear();
+			outRenderModel->materials.clear();
+			outRenderModel->textures.clear();
+			outRenderModel->skins.clear();
+			outRenderModel->morphTargets.clear();
+			outRenderModel->morphDeltas.clear();
+		}
+
+		cache.Close();
+		if ( !LoadAndParse( outRenderModel, commandPool, sFilename, scale ) )
+			return false;
+
+		if ( unImportHash != 0 )
+			CModelCacheFile::Write( sCacheFile, *outRenderModel, unImportHash );
+
+		return true;
+	}
+
+	uint64_t CGltf::GetImportHash( const std::string &sFilename )
+	{
+		uint64_t unHash = HashFile( sFilename );
+		if ( unHash == 0 )
+			return 0;
+
+		auto hashValue = [ &unHash ]( const auto &value ) { unHash = HashBytes( &value, sizeof( value ), unHash ); };
+
+		hashValue( meshOptimization.enabled );
+		hashValue( meshOptimization.deduplicateVertices );
+		hashValue( meshOptimization.mergeSections );
+		hashValue( meshOptimization.reorderForVertexCache );
+		hashValue( meshOptimization.reorderForOverdraw );
+		hashValue( meshOptimization.reorderForVertexFetch );
+		hashValue( meshOptimization.vertexCacheSize );
+		hashValue( meshOptimization.overdrawThreshold );
+
+		hashValue( movableNodes );
+
+		hashValue( lodGeneration.enabled );
+		hashValue( lodGeneration.maxError );
+		hashValue( lodGeneration.minReduction );
+		unHash = HashBytes( lodGeneration.ratios.data(), sizeof( float ) * lodGeneration.ratios.size(), unHash );
+		unHash = HashBytes( lodGeneration.screenSizes.data(), sizeof( float ) * lodGeneration.screenSizes.size(), unHash );
+
+		return unHash;
+	}
+
+	std::shared_ptr< SModelLoadRequest > CGltf::LoadAsync( 
+		CRenderModel *outRenderModel, 
+		CThreadPool *pThreadPool, 
+		VkCommandPool commandPool, 
+		const std::string &sFilename, 
+		float fPriority, 
+		XrVector3f scale )
+	{
+		assert( m_pSession );
+		assert( outRenderModel );
+		assert( pThreadPool );
+
+		std::shared_ptr< SModelLoadRequest > pRequest = std::make_shared< SModelLoadRequest >();
+		pRequest->filename = sFilename;
+		pRequest->scale = scale;
+		pRequest->priority = fPriority;
+		pRequest->pTarget = outRenderModel;
+		pRequest->commandPool = commandPool;
+		pRequest->future = pRequest->promise.get_future().share();
+
+		// Parsed into a model of its own so the target can keep drawing while the load runs, instances stay with the target
+		CRenderModel *pStaging = new CRenderModel( m_pSession, nullptr, false );
+		pStaging->vertexFormat = outRenderModel->vertexFormat;
+		pStaging->allowIndex16 = outRenderModel->allowIndex16;
+		pStaging->geometryPool = outRenderModel->geometryPool;
+		pStaging->instances.clear();
+		pStaging->instanceMatrices.clear();
+		pRequest->pStaging = pStaging;
+
+		{
+			std::scoped_lock lock( m_loadMutex );
+			m_vecQueuedLoads.push_back( pRequest );
+		}
+
+		// The pool runs tasks in submission order, each task takes whichever queued request has the highest priority when it starts
+		m_unLoadTasks++;
+		pThreadPool->SubmitTask( [ this ]() { ProcessNextLoad(); } );
+
+		return pRequest;
+	}
+
+	void CGltf::ProcessNextLoad()
+	{
+		std::shared_ptr< SModelLoadRequest > pRequest;
+		{
+			std::scoped_lock lock( m_loadMutex );
+			auto it = std::min_element( m_vecQueuedLoads.begin(), m_vecQueuedLoads.end(), 
+				[]( const std::shared_ptr< SModelLoadRequest > &a, const std::shared_ptr< SModelLoadRequest > &b ) { return a->priority < b->priority; } );
+
+			if ( it != m_vecQueuedLoads.end() )
+			{
+				pRequest = *it;
+				m_vecQueuedLoads.erase( it );
+			}
+		}
+
+		// Cancelled requests leave the queue without taking their task with them
+		if ( !pRequest )
+		{
+			m_unLoadTasks--;
+			return;
+		}
+
+		pRequest->state = EModelLoadState::Loading;
+		CRenderModel *pStaging = pRequest->pStaging;
+
+		if ( pRequest->cancelled )
+		{
+			FinishLoad( pRequest, EModelLoadState::Cancelled );
+		}
+		else if ( !LoadAndParse( pStaging, pRequest->commandPool, pRequest->filename ) )
+		{
+			FinishLoad( pRequest, EModelLoadState::Failed );
+		}
+		else if ( pRequest->cancelled )
+		{
+			FinishLoad( pRequest, EModelLoadState::Cancelled );
+		}
+		else
+		{
+			VkResult result = pStaging->InitBuffers( false );
+			if ( result != VK_SUCCESS )
+			{
+				LogError( XRLIB_NAME, "Unable to create buffers for %s (%i)", pRequest->filename.c_str(), (int) result );
+				FinishLoad( pRequest, EModelLoadState::Failed );
+			}
+			else
+			{
+				// Textures and geometry are queued on the upload manager by now
+				pRequest->uploadFuture = CUploadManager::Get( m_pSession )->Submit();
+				pRequest->state = EModelLoadState::Uploading;
+
+				std::scoped_lock lock( m_loadMutex );
+				m_vecActiveLoads.push_back( pRequest );
+			}
+		}
+
+		m_unLoadTasks--;
+	}
+
+	void CGltf::FinishLoad( const std::shared_ptr< SModelLoadRequest > &pRequest, EModelLoadState state )
+	{
+		// Whatever the target didn't take over
+		if ( pRequest->pStaging )
+		{
+			DestroyTextures( pRequest->pStaging->textures );
+			delete pRequest->pStaging;
+			pRequest->pStaging = nullptr;
+		}
+
+		pRequest->state = state;
+		pRequest->promise.set_value( state == EModelLoadState::Ready );
+	}
+
+	uint32_t CGltf::UpdateAsyncLoads( const FnModelReady &fnReady, CDescriptorManager *pDescriptors )
+	{
+		// Replaced contents no frame in flight can reference anymore
+		m_unFrame++;
+		while ( !m_replacedMaterials.empty() && m_unFrame - m_replacedMaterials.front().frame >= k_unReplacedMaterialDelayFrames )
+		{
+			DestroyReplacedMaterials( m_replacedMaterials.front(), pDescriptors );
+			m_replacedMaterials.pop_front();
+		}
+
+		std::vector< std::shared_ptr< SModelLoadRequest > > vecFinished;
+		{
+			std::scoped_lock lock( m_loadMutex );
+			for ( auto it = m_vecActiveLoads.begin(); it != m_vecActiveLoads.end(); )
+			{
+				if ( ( *it )->cancelled || ( *it )->uploadFuture.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready )
+				{
+					vecFinished.push_back( *it );
+					it = m_vecActiveLoads.erase( it );
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+
+		uint32_t unReady = 0;
+		for ( std::shared_ptr< SModelLoadRequest > &pRequest : vecFinished )
+		{
+			if ( pRequest->cancelled )
+			{
+				FinishLoad( pRequest, EModelLoadState::Cancelled );
+				continue;
+			}
+
+			CRenderModel *pTarget = pRequest->pTarget;
+			SReplacedMaterials replaced;
+			pTarget->TakeFrom( *pRequest->pStaging, replaced );
+
+			replaced.frame = m_unFrame;
+			m_replacedMaterials.push_back( std::move( replaced ) );
+
+			for ( size_t i = 0; i < pTarget->GetInstanceCount(); i++ )
+			{
+				pTarget->instances[ i ].scale = pRequest->scale;
+			}
+
+			if ( fnReady )
+				fnReady( pTarget );
+
+			if ( pRequest->showWhenReady )
+				pTarget->isVisible = true;
+
+			FinishLoad( pRequest, EModelLoadState::Ready );
+			unReady++;
+		}
+
+		return unReady;
+	}
+
+	void CGltf::CancelLoad( const std::shared_ptr< SModelLoadRequest > &pRequest )
+	{
+		if ( !pRequest || pRequest->IsDone() )
+			return;
+
+		pRequest->cancelled = true;
+
+		// Queued requests are dropped right away, loading and uploading ones when they reach their next check
+		bool bWasQueued = false;
+		{
+			std::scoped_lock lock( m_loadMutex );
+			auto it = std::find( m_vecQueuedLoads.begin(), m_vecQueuedLoads.end(), pRequest );
+			if ( it != m_vecQueuedLoads.end() )
+			{
+				m_vecQueuedLoads.erase( it );
+				bWasQueued = true;
+			}
+		}
+
+		if ( bWasQueued )
+			FinishLoad( pRequest, EModelLoadState::Cancelled );
+	}
+
+	void CGltf::CancelAllLoads()
+	{
+		std::vector< std::shared_ptr< SModelLoadRequest > > vecQueued;
+		{
+			std::scoped_lock lock( m_loadMutex );
+			vecQueued.swap( m_vecQueuedLoads );
+
+			for ( std::shared_ptr< SModelLoadRequest > &pRequest : m_vecActiveLoads )
+				pRequest->cancelled = true;
+		}
+
+		for ( std::shared_ptr< SModelLoadRequest > &pRequest : vecQueued )
+		{
+			pRequest->cancelled = true;
+			FinishLoad( pRequest, EModelLoadState::Cancelled );
+		}
+	}
+
+	void CGltf::UpdateLoadPriorities( const XrVector3f &viewerPosition )
+	{
+		std::scoped_lock lock( m_loadMutex );
+		for ( std::shared_ptr< SModelLoadRequest > &pRequest : m_vecQueuedLoads )
+		{
+			if ( pRequest->pTarget->GetInstanceCount() == 0 )
+				continue;
+
+			XrVector3f *pPosition = pRequest->pTarget->GetPosition( 0 );
+			float fX = pPosition->x - viewerPosition.x;
+			float fY = pPosition->y - viewerPosition.y;
+			float fZ = pPosition->z - viewerPosition.z;
+			pRequest->priority = sqrtf( fX * fX + fY * fY + fZ * fZ );
+		}
+	}
+
+	size_t CGltf::GetPendingLoadCount()
+	{
+		std::scoped_lock lock( m_loadMutex );
+		return m_vecQueuedLoads.size() + m_vecActiveLoads.size();
+	}
+
+	void CGltf::DecodeImages( tinygltf::Model &model, std::vector< std::vector< unsigned char > > &encodedImages )
+	{
+		encodedImages.resize( model.images.size() );
+
+		// Shared with the pool's tasks, which may only get to run after the loading thread has decoded everything itself
+		struct SDecodeJobs
+		{
+			std::vector< uint32_t > images;
+			std::function< void( uint32_t ) > fnDecode;
+			std::atomic< uint32_t > next { 0 };
+			std::atomic< uint32_t > done { 0 };
+			std::mutex mutex;
+			std::condition_variable condition;
+		};
+
+		std::shared_ptr< SDecodeJobs > pJobs = std::make_shared< SDecodeJobs >();
+		for ( uint32_t i = 0; i < model.images.size(); i++ )
+		{
+			const tinygltf::Image &image = model.images[ i ];
+			if ( image.image.empty() && ( image.bufferView >= 0 || !encodedImages[ i ].empty() ) )
+				pJobs->images.push_back( i );
+		}
+
+		if ( pJobs->images.empty() )
+			return;
+
+		pJobs->fnDecode = [ &model, &encodedImages ]( uint32_t unImage )
+		{
+			tinygltf::Image &image = model.images[ unImage ];
+			const unsigned char *pBytes = encodedImages[ unImage ].data();
+			size_t unSize = encodedImages[ unImage ].size();
+
+			if ( image.bufferView >= 0 )
+			{
+				const tinygltf::BufferView &bufferView = model.bufferViews[ image.bufferView ];
+				pBytes = model.buffers[ bufferView.buffer ].data.data() + bufferView.byteOffset;
+				unSize = bufferView.byteLength;
+			}
+
+			std::string sError, sWarn;
+			if ( !tinygltf::LoadImageData( &image, static_cast< int >( unImage ), &sError, &sWarn, 0, 0, pBytes, static_cast< int >( unSize ), nullptr ) )
+				LogError( XRLIB_NAME, "Unable to decode image %i (%s): %s", unImage, image.name.c_str(), sError.c_str() );
+			else if ( !sWarn.empty() )
+				LogWarning( XRLIB_NAME, "Warning decoding image %i (%s): %s", unImage, image.name.c_str(), sWarn.c_str() );
+
+			// Encoded copy isn't needed past this point
+			std::vector< unsigned char >().swap( encodedImages[ unImage ] );
+		};
+
+		auto fnWork = []( SDecodeJobs *pJobs )
+		{
+			uint32_t unJob;
+			while ( ( unJob = pJobs->next++ ) < pJobs->images.size() )
+			{
+				pJobs->fnDecode( pJobs->images[ unJob ] );
+				if ( ++pJobs->done == pJobs->images.size() )
+				{
+					std::scoped_lock lock( pJobs->mutex );
+					pJobs->condition.notify_all();
+				}
+			}
+		};
+
+		// One job per image past the first, which the loading thread starts on right away. Jobs take whichever image is next,
+		// so the loading thread never waits on a task that hasn't started (e.g. when it is a worker of the same pool itself).
+		for ( size_t i = 1; i < pJobs->images.size(); i++ )
+			imageDecodePool->SubmitTask( [ pJobs, fnWork ]() { fnWork( pJobs.get() ); } );
+
+		fnWork( pJobs.get() );
+
+		std::unique_lock lock( pJobs->mutex );
+		pJobs->condition.wait( lock, [ &pJobs ]() { return pJobs->done == pJobs->images.size(); } );
+	}
+
+	bool CGltf::LoadMapped( tinygltf::TinyGLTF *pGltfLoader, tinygltf::Model *outModel, std::string &sError, std::string &sWarn, const std::string &sFilename, bool bBinary )
+	{
+		CMappedFile file;
+		bool bMapped = file.Open( sFilename );
+
+		#ifdef XR_USE_PLATFORM_ANDROID
+			if ( !bMapped )
+				bMapped = file.Open( tinygltf::asset_manager, sFilename );
+		#endif
+
+		// tinygltf takes the size as 32 bit
+		if ( !bMapped || file.GetSize() > std::numeric_limits< unsigned int >::max() )
+		{
+			return bBinary ? pGltfLoader->LoadBinaryFromFile( outModel, &sError, &sWarn, sFilename ) 
+						   : pGltfLoader->LoadASCIIFromFile( outModel, &sError, &sWarn, sFilename );
 		}
-		else if ( file.extension() == ".gltf" )
+
+		const std::string sBaseDir = fs::path( sFilename ).parent_path().string();
+		const char *pJson = reinterpret_cast< const char * >( file.GetData() );
+		size_t unJsonSize = file.GetSize();
+
+		if ( !bBinary )
 		{
-			bResult = pGltfLoader->LoadASCIIFromFile( pModel.get(), &sError, &sWarn, sFilename );
+			std::string sJson;
+			if ( std::string_view( pJson, unJsonSize ).find( "EXT_meshopt_compression" ) != std::string_view::npos )
+			{
+				sJson.assign( pJson, unJsonSize );
+				if ( PatchMeshoptFallbackBuffers( sJson ) )
+				{
+					pJson = sJson.data();
+					unJsonSize = sJson.size();
+				}
+			}
+
+			return pGltfLoader->LoadASCIIFromString( outModel, &sError, &sWarn, pJson, static_cast< unsigned int >( unJsonSize ), sBaseDir );
 		}
-		else
+
+		// Glb: 12 byte header, then the json chunk (length, type, data) and the bin chunk
+		const uint8_t *pData = file.GetData();
+		const size_t unSize = file.GetSize();
+
+		if ( unSize >= 20 )
 		{
-			LogError( XRLIB_NAME, "Error: Invalid file format: %s", sFilename.c_str() );
-			return false;
-		}
+			uint32_t unChunkLength = 0;
+			memcpy( &unChunkLength, pData + 12, sizeof( uint32_t ) );
 
-		// Show warnings and errors
-		if ( !sWarn.empty() )
-			LogWarning( XRLIB_NAME, "Warning loading %s: %s", sFilename.c_str(), sWarn.c_str() );
+			const size_t unBinOffset = 20 + static_cast< size_t >( unChunkLength );
+			if ( unBinOffset <= unSize && std::string_view( pJson + 20, unChunkLength ).find( "EXT_meshopt_compression" ) != std::string_view::npos )
+			{
+				std::string sJson( pJson + 20, unChunkLength );
+				if ( PatchMeshoptFallbackBuffers( sJson ) )
+				{
+					// Repack with the patched json, chunks stay 4 byte aligned
+					sJson.resize( ( sJson.size() + 3 ) & ~size_t( 3 ), ' ' );
 
-		if ( !sError.empty() )
-			LogError( XRLIB_NAME, "Error loading %s: %s", sFilename.c_str(), sError.c_str() );
-        
+					std::vector< uint8_t > vecGlb( 20 + sJson.size() + ( unSize - unBinOffset ) );
+					const uint32_t unTotalLength = static_cast< uint32_t >( vecGlb.size() );
+					const uint32_t unJsonLength = static_cast< uint32_t >( sJson.size() );
 
-		if ( !bResult )
-		{
-			LogError( XRLIB_NAME, "Failed to parse gltf file: %s", sFilename.c_str() );
-			return false;
+					memcpy( vecGlb.data(), pData, 8 );
+					memcpy( vecGlb.data() + 8, &unTotalLength, sizeof( uint32_t ) );
+					memcpy( vecGlb.data() + 12, &unJsonLength, sizeof( uint32_t ) );
+					memcpy( vecGlb.data() + 16, pData + 16, 4 );
+					memcpy( vecGlb.data() + 20, sJson.data(), sJson.size() );
+					memcpy( vecGlb.data() + 20 + sJson.size(), pData + unBinOffset, unSize - unBinOffset );
+
+					return pGltfLoader->LoadBinaryFromMemory( outModel, &sError, &sWarn, vecGlb.data(), unTotalLength, sBaseDir );
+				}
+			}
 		}
 
-		// Parse Textures
-		ParseTextures( outRenderModel, commandPool, *pModel );
+		return pGltfLoader->LoadBinaryFromMemory( outModel, &sError, &sWarn, pData, static_cast< unsigned int >( unSize ), sBaseDir );
+	}
 
-		// Parse Materials
-		ParseMaterials( outRenderModel, *pModel );
+	void CGltf::DestroyReplacedMaterials( SReplacedMaterials &replaced, CDescriptorManager *pDescriptors )
+	{
+		DestroyTextures( replaced.textures );
 
-		// Parse Skins
-		ParseSkins( outRenderModel, *pModel );
+		if ( pDescriptors && !replaced.descriptorSets.empty() && !pDescriptors->FreeDescriptorSets( replaced.descriptorPoolId, replaced.descriptorSets ) )
+			LogWarning( XRLIB_NAME, "Material descriptor sets of a replaced model stay allocated, their pool can't free sets" );
 
-		// Process all nodes in the scene
-		for ( size_t i = 0; i < pModel->scenes[ 0 ].nodes.size(); i++ )
-		{
-			const tinygltf::Node &node = pModel->nodes[ pModel->scenes[ 0 ].nodes[ i ] ];
-			ProcessNode( *pModel, node, outRenderModel->vertices, outRenderModel->indices, outRenderModel->materialSections );
-		}
+		delete replaced.pMaterialBuffer;
+		replaced.pMaterialBuffer = nullptr;
+	}
 
-		// Set scale
-		for ( size_t i = 0; i < outRenderModel->GetInstanceCount(); i++ )
+	void CGltf::DestroyTextures( std::vector< STexture > &textures )
+	{
+		VkDevice vkDevice = m_pSession->GetVulkan()->GetVkLogicalDevice();
+		for ( STexture &texture : textures )
 		{
-			outRenderModel->instances[ i ].scale = scale;
+			if ( texture.view != VK_NULL_HANDLE )
+				vkDestroyImageView( vkDevice, texture.view, nullptr );
+			if ( texture.image != VK_NULL_HANDLE )
+			{
+				CUploadManager::Get( m_pSession )->ReleaseImage( texture.image );
+				vkDestroyImage( vkDevice, texture.image, nullptr );
+			}
+			if ( texture.allocation )
+				CDeviceMemoryAllocator::Get( m_pSession )->Free( texture.allocation );
+			if ( texture.sampler != VK_NULL_HANDLE )
+				vkDestroySampler( vkDevice, texture.sampler, nullptr );
 		}
-		
-		return true;
+
+		textures.clear();
 	}
 
 	bool CGltf::LoadFromDisk( CRenderModel *outRenderModel, tinygltf::Model *outModel, const std::string &sFilename, XrVector3f scale ) 
 	{ 
 		std::unique_ptr< TinyGLTF > pGltfLoader = std::make_unique< TinyGLTF >();
 
+		std::vector< std::vector< unsigned char > > vecEncodedImages;
+		if ( imageDecodePool )
+			pGltfLoader->SetImageLoader( DeferImageDecode, &vecEncodedImages );
+
 		// Check file validity
 		bool bResult = false;
 		std::string sError, sWarn;
@@ -140,11 +1322,11 @@ namespace xrlib
 		// Load gltf file based on extension
 		if ( file.extension() == ".glb" )
 		{
-			bResult = pGltfLoader->LoadBinaryFromFile( outModel, &sError, &sWarn, sFilename );
+			bResult = LoadMapped( pGltfLoader.get(), outModel, sError, sWarn, sFilename, true );
 		}
 		else if ( file.extension() == ".gltf" )
 		{
-			bResult = pGltfLoader->LoadASCIIFromFile( outModel, &sError, &sWarn, sFilename );
+			bResult = LoadMapped( pGltfLoader.get(), outModel, sError, sWarn, sFilename, false );
 		}
 		else
 		{
@@ -165,6 +1347,12 @@ namespace xrlib
 			return false;
 		}
 
+		if ( !CheckRequiredExtensions( *outModel, sFilename ) || !DecodeMeshoptBufferViews( *outModel ) )
+			return false;
+
+		if ( imageDecodePool )
+			DecodeImages( *outModel, vecEncodedImages );
+
 		// Set scale
 		for ( size_t i = 0; i < outRenderModel->GetInstanceCount(); i++ )
 		{
@@ -185,12 +1373,152 @@ namespace xrlib
 		// Parse Skins
 		ParseSkins( outRenderModel, *pModel );
 
-		// Process all nodes in the scene
-		for ( size_t i = 0; i < pModel->scenes[ 0 ].nodes.size(); i++ )
+		// Process all nodes in the scene, the hierarchy is kept in the model's scene graph
+		ProcessScene( outRenderModel, *pModel );
+
+		OptimizeMeshData( outRenderModel );
+	}
+
+	bool CGltf::LoadInstanced( 
+		CRenderModel *outRenderModel, 
+		std::vector< CRenderModel * > &outInstancedModels, 
+		const FnCreateModel &fnCreateModel, 
+		VkCommandPool commandPool, 
+		const std::string &sFilename, 
+		XrVector3f scale )
+	{
+		std::unique_ptr< Model > pModel = std::make_unique< Model >();
+		if ( !LoadFromDisk( outRenderModel, pModel.get(), sFilename, scale ) )
+			return false;
+
+		if ( pModel->scenes.empty() )
+		{
+			LogError( XRLIB_NAME, "No scene in gltf file: %s", sFilename.c_str() );
+			return false;
+		}
+
+		// Textures are parsed once into the main model, instanced models only get their handles
+		ParseTextures( outRenderModel, commandPool, *pModel, true );
+		ParseMaterials( outRenderModel, *pModel );
+		ParseSkins( outRenderModel, *pModel );
+
+		// Where each mesh ends up in model space
+		std::vector< SGltfMeshPlacements > vecPlacements( pModel->meshes.size() );
+		XrMatrix4x4f identity;
+		XrMatrix4x4f_CreateIdentity( &identity );
+
+		for ( int nNode : pModel->scenes[ 0 ].nodes )
+			CollectMeshPlacements( vecPlacements, *pModel, nNode, identity, 0 );
+
+		ReserveMeshData( *pModel, outRenderModel );
+		for ( size_t i = 0; i < pModel->meshes.size(); i++ )
+		{
+			const SGltfMeshPlacements &placements = vecPlacements[ i ];
+			const tinygltf::Mesh &mesh = pModel->meshes[ i ];
+
+			const bool bInstance = fnCreateModel && !placements.skinned && 
+				( placements.gpuInstancedCount > 0 || ( instancingThreshold > 0 && placements.matrices.size() >= instancingThreshold ) );
+
+			CRenderModel *pInstanced = bInstance ? fnCreateModel( mesh.name ) : nullptr;
+			if ( !pInstanced )
+			{
+				// Placed few times (or skinned) - a copy per placement in the main model
+				for ( const XrMatrix4x4f &matrix : placements.matrices )
+				{
+					const size_t unFirstVertex = outRenderModel->vertices.size();
+					const size_t unFirstIndex = outRenderModel->indices.size();
+					ProcessMesh( *pModel, mesh, outRenderModel->vertices, outRenderModel->indices, outRenderModel->materialSections );
+
+					if ( !placements.skinned )
+						BakeMeshTransform( outRenderModel->vertices, outRenderModel->indices, unFirstVertex, unFirstIndex, matrix );
+				}
+
+				continue;
+			}
+
+			// Texture handles without the cpu copies, the main model stays resident while this one is alive
+			pInstanced->ShareTexturesFrom( *outRenderModel );
+
+			// The mesh is stored once, in its own space
+			ProcessMesh( *pModel, mesh, pInstanced->vertices, pInstanced->indices, pInstanced->materialSections );
+
+			// Only the materials this mesh uses (each one gets its own descriptor sets)
+			std::vector< int32_t > vecMaterialRemap( outRenderModel->materials.size(), -1 );
+			for ( SMeshSection &section : pInstanced->materialSections )
+			{
+				if ( section.materialIndex >= vecMaterialRemap.size() )
+					continue;
+
+				int32_t &nRemapped = vecMaterialRemap[ section.materialIndex ];
+				if ( nRemapped < 0 )
+				{
+					nRemapped = static_cast< int32_t >( pInstanced->materials.size() );
+					pInstanced->materials.push_back( outRenderModel->materials[ section.materialIndex ] );
+				}
+
+				section.materialIndex = static_cast< uint32_t >( nRemapped );
+			}
+
+			OptimizeMeshData( pInstanced );
+
+			// One instance per placement
+			pInstanced->instances.clear();
+			pInstanced->instanceMatrices.clear();
+			pInstanced->instances.reserve( placements.matrices.size() );
+			pInstanced->instanceMatrices.reserve( placements.matrices.size() );
+
+			for ( const XrMatrix4x4f &matrix : placements.matrices )
+			{
+				const SInstanceState &state = pInstanced->instances.emplace_back( GetInstanceState( matrix, scale ) );
+				XrMatrix4x4f_CreateTranslationRotationScale( &pInstanced->instanceMatrices.emplace_back(), &state.pose.position, &state.pose.orientation, &state.scale );
+			}
+
+			LogInfo( XRLIB_NAME, "Mesh %s instanced: %u placements (%u from EXT_mesh_gpu_instancing), %u vertices", 
+				mesh.name.c_str(), 
+				pInstanced->GetInstanceCount(), 
+				placements.gpuInstancedCount, 
+				static_cast< uint32_t >( pInstanced->vertices.size() ) );
+
+			outInstancedModels.push_back( pInstanced );
+		}
+
+		// Everything needed is in the render models now
+		pModel.reset();
+
+		OptimizeMeshData( outRenderModel );
+		return true;
+	}
+
+	void CGltf::ProcessScene( CRenderModel *outRenderModel, const tinygltf::Model &model )
+	{
+		ReserveMeshData( model, outRenderModel );
+		outRenderModel->sceneGraph.Clear();
+		outRenderModel->sceneGraph.Reserve( model.nodes.size() );
+
+		std::vector< int32_t > vecSceneNodes( model.nodes.size(), -1 );
+		for ( size_t i = 0; i < model.scenes[ 0 ].nodes.size(); i++ )
+		{
+			const tinygltf::Node &node = model.nodes[ model.scenes[ 0 ].nodes[ i ] ];
+			ProcessNode( model, node, outRenderModel->vertices, outRenderModel->indices, outRenderModel->materialSections, outRenderModel->morphTargets, outRenderModel->morphDeltas, outRenderModel->sceneGraph, -1, vecSceneNodes );
+		}
+
+		// Only the compute skinning prepass applies morph targets
+		outRenderModel->ResetMorphWeights();
+		if ( !outRenderModel->morphTargets.empty() )
+		{
+			outRenderModel->computeSkinning = true;
+			LogInfo( XRLIB_NAME, "Morph targets: %u, %u vertex deltas", static_cast< uint32_t >( outRenderModel->morphTargets.size() ), static_cast< uint32_t >( outRenderModel->morphDeltas.size() ) );
+		}
+
+		// Joints and animation channels refer to glTF nodes, at runtime they drive scene graph nodes
+		for ( SSkin &skin : outRenderModel->skins )
 		{
-			const tinygltf::Node &node = pModel->nodes[ pModel->scenes[ 0 ].nodes[ i ] ];
-			ProcessNode( *pModel, node, outRenderModel->vertices, outRenderModel->indices, outRenderModel->materialSections );
+			skin.jointNodes.resize( skin.joints.size() );
+			for ( size_t i = 0; i < skin.joints.size(); i++ )
+				skin.jointNodes[ i ] = vecSceneNodes[ skin.joints[ i ] ];
 		}
+
+		ParseAnimations( outRenderModel, model, vecSceneNodes );
 	}
 
 	void CGltf::ProcessNode( 
@@ -198,18 +1526,41 @@ namespace xrlib
 		const tinygltf::Node &node, 
 		std::vector< SMeshVertex > &vertices, 
 		std::vector< uint32_t > &indices, 
-		std::vector< SMeshSection > &materialSections )
+		std::vector< SMeshSection > &materialSections,
+		std::vector< SMorphTarget > &morphTargets,
+		std::vector< SMorphDelta > &morphDeltas,
+		CSceneGraph &sceneGraph,
+		int32_t nParent,
+		std::vector< int32_t > &sceneNodes )
 	{
+		const uint32_t unSceneNode = AddSceneGraphNode( sceneGraph, node, nParent );
+		sceneNodes[ &node - model.nodes.data() ] = static_cast< int32_t >( unSceneNode );
+
 		// Process mesh if present
 		if ( node.mesh >= 0 )
 		{
-			ProcessMesh( model, model.meshes[ node.mesh ], vertices, indices, materialSections );
+			const size_t unFirstSection = materialSections.size();
+			const size_t unFirstTarget = morphTargets.size();
+			ProcessMesh( model, model.meshes[ node.mesh ], vertices, indices, materialSections, &morphTargets, &morphDeltas );
+
+			// The node's weights drive the targets of its copy of the mesh
+			for ( size_t i = unFirstTarget; i < morphTargets.size(); i++ )
+				morphTargets[ i ].node = static_cast< int32_t >( unSceneNode );
+
+			// Skinned meshes don't follow their node's transform, their joints index the node's skin
+			for ( size_t i = unFirstSection; i < materialSections.size(); i++ )
+			{
+				if ( node.skin >= 0 )
+					materialSections[ i ].skin = node.skin;
+				else if ( movableNodes )
+					materialSections[ i ].node = static_cast< int32_t >( unSceneNode );
+			}
 		}
 
 		// Process child nodes
 		for ( size_t i = 0; i < node.children.size(); i++ )
 		{
-			ProcessNode( model, model.nodes[ node.children[ i ] ], vertices, indices, materialSections );
+			ProcessNode( model, model.nodes[ node.children[ i ] ], vertices, indices, materialSections, morphTargets, morphDeltas, sceneGraph, static_cast< int32_t >( unSceneNode ), sceneNodes );
 		}
 	}
 
@@ -218,310 +1569,259 @@ namespace xrlib
 		const tinygltf::Mesh &mesh, 
 		std::vector< SMeshVertex > &vertices, 
 		std::vector< uint32_t > &indices, 
-		std::vector< SMeshSection > &materialSections )
+		std::vector< SMeshSection > &materialSections,
+		std::vector< SMorphTarget > *pMorphTargets,
+		std::vector< SMorphDelta > *pMorphDeltas )
 	{
-		// Set material mesh section tracking
-		uint32_t currentFirstIndex = indices.empty() ? 0 : indices.size() - 1;
-		uint32_t currentIndexCount = 0;
-		uint32_t currentMaterialIndex = 0;
+		constexpr size_t unVertexStride = sizeof( SMeshVertex );
+
+		// Deltas per morph target of the mesh, which spans all of its primitives
+		std::vector< std::vector< SMorphDelta > > vecTargetDeltas;
 
-		// Process each primitive in the mesh
 		for ( const auto &primitive : mesh.primitives )
 		{
-			uint32_t vertexBase = vertices.size();
-
-			// Get accessor for vertex positions (required)
-			const tinygltf::Accessor &posAccessor = model.accessors[ primitive.attributes.at( "POSITION" ) ];
-			const tinygltf::BufferView &posView = model.bufferViews[ posAccessor.bufferView ];
-			const float *positions = reinterpret_cast< const float * >( &( model.buffers[ posView.buffer ].data[ posView.byteOffset + posAccessor.byteOffset ] ) );
+			const uint32_t vertexBase = static_cast< uint32_t >( vertices.size() );
+			const uint32_t firstIndex = static_cast< uint32_t >( indices.size() );
 
-			// Process each vertex
-			for ( size_t i = 0; i < posAccessor.count; i++ )
+			// Positions (required) determine the vertex count
+			SAccessorStream position;
+			auto itPosition = primitive.attributes.find( "POSITION" );
+			if ( itPosition == primitive.attributes.end() || !GetAccessorStream( position, model, itPosition->second ) )
 			{
-				SMeshVertex vertex {};
+				LogError( XRLIB_NAME, "Skipping primitive without valid positions in mesh %s", mesh.name.c_str() );
+				continue;
+			}
 
-				// Position (required)
-				vertex.position = { positions[ i * 3 ], positions[ i * 3 + 1 ], positions[ i * 3 + 2 ] };
+			// Resolve the optional attributes once, they are then decoded as whole streams into the new vertices
+			auto FindStream = [ & ]( const char *pName, SAccessorStream &outStream ) -> bool
+			{
+				auto it = primitive.attributes.find( pName );
+				if ( it == primitive.attributes.end() )
+					return false;
 
-				// Normal (optional)
-				if ( primitive.attributes.find( "NORMAL" ) != primitive.attributes.end() )
+				if ( !GetAccessorStream( outStream, model, it->second ) )
 				{
-					const tinygltf::Accessor &normalAccessor = model.accessors[ primitive.attributes.at( "NORMAL" ) ];
-					const tinygltf::BufferView &normalView = model.bufferViews[ normalAccessor.bufferView ];
-					const float *normals = reinterpret_cast< const float * >( &( model.buffers[ normalView.buffer ].data[ normalView.byteOffset + normalAccessor.byteOffset ] ) );
-
-					vertex.normal = { normals[ i * 3 ], normals[ i * 3 + 1 ], normals[ i * 3 + 2 ] };
+					LogWarning( XRLIB_NAME, "Ignoring invalid %s accessor in mesh %s", pName, mesh.name.c_str() );
+					return false;
 				}
 
-				// Texture coordinates (optional)
-				if ( primitive.attributes.find( "TEXCOORD_0" ) != primitive.attributes.end() )
-				{
-					const tinygltf::Accessor &uvAccessor = model.accessors[ primitive.attributes.at( "TEXCOORD_0" ) ];
-					const tinygltf::BufferView &uvView = model.bufferViews[ uvAccessor.bufferView ];
-					const float *uvs = reinterpret_cast< const float * >( &( model.buffers[ uvView.buffer ].data[ uvView.byteOffset + uvAccessor.byteOffset ] ) );
+				outStream.count = std::min( outStream.count, position.count );
+				return true;
+			};
 
-					vertex.uv0 = { uvs[ i * 2 ], uvs[ i * 2 + 1 ] };
-				}
+			SAccessorStream normal, tangent, uv0, uv1, color0, joints, weights;
+			const bool bNormal = FindStream( "NORMAL", normal );
+			const bool bTangent = FindStream( "TANGENT", tangent );
+			const bool bUv0 = FindStream( "TEXCOORD_0", uv0 );
+			const bool bUv1 = FindStream( "TEXCOORD_1", uv1 );
+			const bool bColor0 = FindStream( "COLOR_0", color0 );
+			const bool bJoints = FindStream( "JOINTS_0", joints );
+			const bool bWeights = FindStream( "WEIGHTS_0", weights );
 
-				// Second set of texture coordinates (optional)
-				if ( primitive.attributes.find( "TEXCOORD_1" ) != primitive.attributes.end() )
-				{
-					const tinygltf::Accessor &uvAccessor = model.accessors[ primitive.attributes.at( "TEXCOORD_1" ) ];
-					const tinygltf::BufferView &uvView = model.bufferViews[ uvAccessor.bufferView ];
-					const float *uvs = reinterpret_cast< const float * >( &( model.buffers[ uvView.buffer ].data[ uvView.byteOffset + uvAccessor.byteOffset ] ) );
+			// Values for missing attributes
+			SMeshVertex defaultVertex {};
+			defaultVertex.color0 = { 1.0f, 1.0f, 1.0f };
 
-					vertex.uv1 = { uvs[ i * 2 ], uvs[ i * 2 + 1 ] };
-				}
+			if ( bNormal && !bTangent )
+				defaultVertex.tangent = { 1.0f, 0.0f, 0.0f, 1.0f };
 
-				// Tangents (optional but important for normal mapping)
-				if ( primitive.attributes.find( "TANGENT" ) != primitive.attributes.end() )
-				{
-					const tinygltf::Accessor &tangentAccessor = model.accessors[ primitive.attributes.at( "TANGENT" ) ];
-					const tinygltf::BufferView &tangentView = model.bufferViews[ tangentAccessor.bufferView ];
-					const float *tangents = reinterpret_cast< const float * >( &( model.buffers[ tangentView.buffer ].data[ tangentView.byteOffset + tangentAccessor.byteOffset ] ) );
+			// If we have joints but no weights, assign full weight to the first joint
+			if ( bJoints && !bWeights )
+				defaultVertex.weights[ 0 ] = 1.0f;
 
-					vertex.tangent = { tangents[ i * 4 ], tangents[ i * 4 + 1 ], tangents[ i * 4 + 2 ], tangents[ i * 4 + 3 ] };
-				}
-				else if ( primitive.attributes.find( "NORMAL" ) != primitive.attributes.end() )
-				{
-					vertex.tangent = { 1.0f, 0.0f, 0.0f, 1.0f };
-				}
+			vertices.resize( vertexBase + position.count, defaultVertex );
+			SMeshVertex *pVertices = vertices.data() + vertexBase;
 
-				// Color (optional)
-				if ( primitive.attributes.find( "COLOR_0" ) != primitive.attributes.end() )
-				{
-					const tinygltf::Accessor &colorAccessor = model.accessors[ primitive.attributes.at( "COLOR_0" ) ];
-					const tinygltf::BufferView &colorView = model.bufferViews[ colorAccessor.bufferView ];
-					const float *colors = reinterpret_cast< const float * >( &( model.buffers[ colorView.buffer ].data[ colorView.byteOffset + colorAccessor.byteOffset ] ) );
+			DecodeAccessorFloat( position, &pVertices->position.x, 3, unVertexStride );
 
-					vertex.color0 = { colors[ i * 3 ], colors[ i * 3 + 1 ], colors[ i * 3 + 2 ] };
-				}
-				else
-				{
-					vertex.color0 = { 1.0f, 1.0f, 1.0f };
-				}
+			if ( bNormal )
+				DecodeAccessorFloat( normal, &pVertices->normal.x, 3, unVertexStride );
 
-				// Joint indices (optional)
-				if ( primitive.attributes.find( "JOINTS_0" ) != primitive.attributes.end() )
-				{
-					const tinygltf::Accessor &jointAccessor = model.accessors[ primitive.attributes.at( "JOINTS_0" ) ];
-					const tinygltf::BufferView &jointView = model.bufferViews[ jointAccessor.bufferView ];
+			if ( bTangent )
+				DecodeAccessorFloat( tangent, &pVertices->tangent.x, 4, unVertexStride );
 
-					// Handle different component types for joints
-					if ( jointAccessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE )
-					{
-						const uint8_t *joints = reinterpret_cast< const uint8_t * >( &( model.buffers[ jointView.buffer ].data[ jointView.byteOffset + jointAccessor.byteOffset ] ) );
-						for ( int j = 0; j < JOINT_INFLUENCE_COUNT; j++ )
-						{
-							vertex.joints[ j ] = static_cast< uint32_t >( joints[ i * 4 + j ] );
-						}
-					}
-					else if ( jointAccessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT )
+			if ( bUv0 )
+			{
+				DecodeAccessorFloat( uv0, &pVertices->uv0.x, 2, unVertexStride );
+
+				float uvTransform[ 6 ];
+				if ( GetUv0Transform( model, primitive.material, uvTransform ) )
+				{
+					for ( size_t i = 0; i < uv0.count; i++ )
 					{
-						const uint16_t *joints = reinterpret_cast< const uint16_t * >( &( model.buffers[ jointView.buffer ].data[ jointView.byteOffset + jointAccessor.byteOffset ] ) );
-						for ( int j = 0; j < JOINT_INFLUENCE_COUNT; j++ )
-						{
-							vertex.joints[ j ] = static_cast< uint32_t >( joints[ i * 4 + j ] );
-						}
+						const XrVector2f uv = pVertices[ i ].uv0;
+						pVertices[ i ].uv0 = { uvTransform[ 0 ] * uv.x + uvTransform[ 1 ] * uv.y + uvTransform[ 2 ], uvTransform[ 3 ] * uv.x + uvTransform[ 4 ] * uv.y + uvTransform[ 5 ] };
 					}
 				}
+			}
 
-				// Joint weights (optional)
-				if ( primitive.attributes.find( "WEIGHTS_0" ) != primitive.attributes.end() )
-				{
-					const tinygltf::Accessor &weightAccessor = model.accessors[ primitive.attributes.at( "WEIGHTS_0" ) ];
-					const tinygltf::BufferView &weightView = model.bufferViews[ weightAccessor.bufferView ];
-					const float *weights = reinterpret_cast< const float * >( &( model.buffers[ weightView.buffer ].data[ weightView.byteOffset + weightAccessor.byteOffset ] ) );
+			if ( bUv1 )
+				DecodeAccessorFloat( uv1, &pVertices->uv1.x, 2, unVertexStride );
 
-					for ( int j = 0; j < JOINT_INFLUENCE_COUNT; j++ )
-					{
-						vertex.weights[ j ] = weights[ i * 4 + j ];
-					}
+			// Vec4 colors lose their alpha
+			if ( bColor0 )
+				DecodeAccessorFloat( color0, &pVertices->color0.x, 3, unVertexStride );
+
+			if ( bJoints )
+				DecodeAccessorUint( joints, pVertices->joints, JOINT_INFLUENCE_COUNT, unVertexStride );
+
+			if ( bWeights )
+			{
+				DecodeAccessorFloat( weights, pVertices->weights, JOINT_INFLUENCE_COUNT, unVertexStride );
+
+				// Normalize weights (in case file isn't up to spec)
+				for ( size_t i = 0; i < weights.count; i++ )
+				{
+					float *pWeights = pVertices[ i ].weights;
 
-					// Normalize weights (in case file isn't up to spec)
 					float weightSum = 0.0f;
 					for ( int j = 0; j < JOINT_INFLUENCE_COUNT; ++j )
-					{
-						weightSum += vertex.weights[ j ];
-					}
+						weightSum += pWeights[ j ];
 
 					if ( weightSum > 1.0f )
 					{
 						for ( int j = 0; j < JOINT_INFLUENCE_COUNT; ++j )
-						{
-							vertex.weights[ j ] /= weightSum;
-						}
-					}
-				}
-				else if ( primitive.attributes.find( "JOINTS_0" ) != primitive.attributes.end() )
-				{
-					// If we have joints but no weights, rest weights to 0
-					for ( int j = 1; j < JOINT_INFLUENCE_COUNT; ++j )
-					{
-						vertex.weights[ j ] = 0.0f;
+							pWeights[ j ] /= weightSum;
 					}
-
-					// Then assign full weight to the first joint
-					vertex.weights[ 0 ] = 1.0f;
 				}
+			}
 
-				vertices.push_back( vertex );
+			if ( pMorphTargets && pMorphDeltas )
+			{
+				vecTargetDeltas.resize( std::max( vecTargetDeltas.size(), primitive.targets.size() ) );
+				for ( size_t i = 0; i < primitive.targets.size(); i++ )
+					AppendMorphDeltas( vecTargetDeltas[ i ], model, primitive.targets[ i ], vertexBase, position.count );
 			}
 
-			// Process indices
+			// Process indices, offset by the primitive's first vertex
 			if ( primitive.indices >= 0 )
 			{
-				const tinygltf::Accessor &accessor = model.accessors[ primitive.indices ];
-				const uint32_t numIndices = accessor.count;
-				const tinygltf::BufferView &indexView = model.bufferViews[ accessor.bufferView ];
-
-				// Check component type to determine index size
-				switch ( accessor.componentType )
+				SAccessorStream indexStream;
+				bool bIndicesValid = GetAccessorStream( indexStream, model, primitive.indices );
+				if ( bIndicesValid )
 				{
-					case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-					{
-						// 16-bit indices
-						const uint16_t *indicesArray = reinterpret_cast< const uint16_t * >( &( model.buffers[ indexView.buffer ].data[ indexView.byteOffset + accessor.byteOffset ] ) );
-						for ( size_t i = 0; i < numIndices; i++ )
-						{
-							indices.push_back( static_cast< uint32_t >( indicesArray[ i ] ) + vertexBase );
-						}
-						break;
-					}
-					case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
-					{
-						// 32-bit indices
-						const uint32_t *indicesArray = reinterpret_cast< const uint32_t * >( &( model.buffers[ indexView.buffer ].data[ indexView.byteOffset + accessor.byteOffset ] ) );
-						for ( size_t i = 0; i < numIndices; i++ )
-						{
-							indices.push_back( indicesArray[ i ] + vertexBase );
-						}
-						break;
-					}
-					case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-					{
-						// 8-bit indices
-						const uint8_t *indicesArray = reinterpret_cast< const uint8_t * >( &( model.buffers[ indexView.buffer ].data[ indexView.byteOffset + accessor.byteOffset ] ) );
-						for ( size_t i = 0; i < numIndices; i++ )
-						{
-							indices.push_back( static_cast< uint32_t >( indicesArray[ i ] ) + vertexBase );
-						}
-						break;
-					}
-					default:
-						throw std::runtime_error( "Unsupported index component type" );
+					indices.resize( firstIndex + indexStream.count );
+					bIndicesValid = DecodeIndices( indexStream, vertexBase, indices.data() + firstIndex );
 				}
 
-				// Material section
-				uint32_t materialIndex = primitive.material >= 0 ? primitive.material : 0;
-				if ( primitive.material >= 0 )
-				{
-					// If material changes, add the last section and create a new one
-					if ( materialIndex != currentMaterialIndex )
-					{
-						// Add new mesh section
-						SMeshSection newSection { .firstIndex = currentFirstIndex, .indexCount = currentIndexCount, .materialIndex = materialIndex };
-						materialSections.push_back( newSection );
-
-						// Set for new section
-						currentFirstIndex = currentFirstIndex + currentIndexCount;
-						currentIndexCount = 0;
-						currentMaterialIndex = materialIndex;
-					}
-
-					currentIndexCount += numIndices;
-				}
-				else
+				if ( !bIndicesValid )
 				{
-					// No material - add last mesh section
-					if ( currentIndexCount > 0 )
-					{
-						// Add new mesh section
-						SMeshSection newSection { .firstIndex = currentFirstIndex, .indexCount = currentIndexCount, .materialIndex = materialIndex };
-						materialSections.push_back( newSection );
-
-						// Set for new section
-						currentFirstIndex = currentFirstIndex + currentIndexCount;
-						currentIndexCount = 0;
-					}
+					LogError( XRLIB_NAME, "Unsupported or invalid index accessor %i in mesh %s", primitive.indices, mesh.name.c_str() );
+					indices.resize( firstIndex );
 				}
 			}
 			else
 			{
 				// Handle non-indexed geometry
 				// When no indices are specified, vertices are used in order as triangles
-				const size_t numVertices = posAccessor.count;
-				for ( size_t i = 0; i < numVertices; i++ )
-				{
-					indices.push_back( static_cast< uint32_t >( vertices.size() - numVertices + i ) );
-				}
-
-				// Update material section tracking
-				uint32_t materialIndex = primitive.material >= 0 ? primitive.material : 0;
-				if ( primitive.material >= 0 )
-				{
-					if ( materialIndex != currentMaterialIndex )
-					{
-						// Add new mesh section
-						SMeshSection newSection { .firstIndex = currentFirstIndex, .indexCount = currentIndexCount, .materialIndex = materialIndex };
-						materialSections.push_back( newSection );
-
-						// Set for new section
-						currentFirstIndex = currentFirstIndex + currentIndexCount;
-						currentIndexCount = 0;
-						currentMaterialIndex = materialIndex;
-					}
-
-					currentIndexCount += numVertices;
-				}
-				else if ( currentIndexCount > 0 )
-				{
-					// No material - add last mesh section
-					SMeshSection newSection { .firstIndex = currentFirstIndex, .indexCount = currentIndexCount, .materialIndex = materialIndex };
-					materialSections.push_back( newSection );
-
-					// Set for new section
-					currentFirstIndex = currentFirstIndex + currentIndexCount;
-					currentIndexCount = 0;
-				}
+				indices.resize( firstIndex + position.count );
+				GenerateSequentialIndices( indices.data() + firstIndex, position.count, vertexBase );
 			}
-		
 
-			// Check for single material
-			if ( materialSections.empty() && currentIndexCount > 0 )
+			// One section per primitive, adjacent sections that share a material are merged by the mesh optimizer
+			if ( indices.size() > firstIndex )
 			{
-				// Add new mesh section
-				SMeshSection newSection { .firstIndex = 0, .indexCount = static_cast< uint32_t >( indices.size() ), .materialIndex = 0 };
+				SMeshSection newSection { .firstIndex = firstIndex, .indexCount = static_cast< uint32_t >( indices.size() - firstIndex ), .materialIndex = primitive.material >= 0 ? static_cast< uint32_t >( primitive.material ) : 0 };
 				materialSections.push_back( newSection );
 			}
-			// Check for last material section
-			else if ( !materialSections.empty() && currentIndexCount > 0 )
-			{
+		}
 
-				// Add new mesh section
-				SMeshSection newSection { .firstIndex = currentFirstIndex, .indexCount = currentIndexCount, .materialIndex = currentMaterialIndex };
-				materialSections.push_back( newSection );
+		if ( vecTargetDeltas.empty() )
+			return;
+
+		// Target names aren't part of the spec, most exporters write them to the mesh's extras
+		const tinygltf::Value *pNames = mesh.extras.Has( "targetNames" ) && mesh.extras.Get( "targetNames" ).IsArray() ? &mesh.extras.Get( "targetNames" ) : nullptr;
+		for ( size_t i = 0; i < vecTargetDeltas.size(); i++ )
+		{
+			SMorphTarget &target = pMorphTargets->emplace_back();
+			target.index = static_cast< uint32_t >( i );
+			target.firstDelta = static_cast< uint32_t >( pMorphDeltas->size() );
+			target.deltaCount = static_cast< uint32_t >( vecTargetDeltas[ i ].size() );
+			target.defaultWeight = i < mesh.weights.size() ? static_cast< float >( mesh.weights[ i ] ) : 0.f;
+
+			if ( pNames && i < pNames->ArrayLen() && pNames->Get( static_cast< int >( i ) ).IsString() )
+				target.name = pNames->Get( static_cast< int >( i ) ).Get< std::string >();
+
+			pMorphDeltas->insert( pMorphDeltas->end(), vecTargetDeltas[ i ].begin(), vecTargetDeltas[ i ].end() );
+		}
+	}
+
+	void CGltf::OptimizeMeshData( CRenderModel *outRenderModel ) 
+	{
+		if ( outRenderModel->indices.empty() )
+			return;
+
+		if ( meshOptimization.enabled )
+		{
+			// Morph deltas address vertices by index, so their order and count have to stay as they are
+			SMeshOptimizeSettings settings = meshOptimization;
+			if ( !outRenderModel->morphTargets.empty() )
+			{
+				settings.deduplicateVertices = false;
+				settings.reorderForVertexFetch = false;
 			}
 
+			SMeshOptimizeStats stats;
+			OptimizeMesh( outRenderModel->vertices, outRenderModel->indices, outRenderModel->materialSections, &outRenderModel->materials, settings, &stats );
+
+			LogInfo( XRLIB_NAME, "Mesh optimized: vertices %u -> %u, sections %u -> %u, acmr %.3f -> %.3f, atvr %.3f -> %.3f (cache size %u)", 
+				stats.vertexCountBefore, stats.vertexCountAfter, 
+				stats.sectionCountBefore, stats.sectionCountAfter, 
+				stats.acmrBefore, stats.acmrAfter, 
+				stats.atvrBefore, stats.atvrAfter,
+				meshOptimization.vertexCacheSize );
 		}
 
+		// Levels of detail are appended to the (optimized) index buffer
+		if ( lodGeneration.enabled )
+		{
+			GenerateMeshLods( outRenderModel->lods, outRenderModel->indices, outRenderModel->materialSections, outRenderModel->vertices, &outRenderModel->materials, lodGeneration, meshOptimization.vertexCacheSize );
+
+			uint32_t unBaseIndexCount = 0;
+			for ( auto &section : outRenderModel->materialSections )
+				unBaseIndexCount += section.indexCount;
+
+			for ( size_t i = 0; i < outRenderModel->lods.size(); i++ )
+			{
+				uint32_t unIndexCount = 0;
+				for ( auto &section : outRenderModel->lods[ i ].sections )
+					unIndexCount += section.indexCount;
+
+				LogInfo( XRLIB_NAME, "Mesh lod %i: %u triangles (%.1f%% of lod 0), error %.4f, below screen size %.3f", 
+					(int) i + 1, 
+					unIndexCount / 3, 
+					unBaseIndexCount > 0 ? 100.f * unIndexCount / unBaseIndexCount : 0.f, 
+					outRenderModel->lods[ i ].error, 
+					outRenderModel->lods[ i ].screenSize );
+			}
+		}
 	}
 
-	void CGltf::ParseTextures( CRenderModel *outRenderModel, VkCommandPool commandPool, const tinygltf::Model &model ) 
+	void CGltf::ParseTextures( CRenderModel *outRenderModel, VkCommandPool commandPool, tinygltf::Model &model, bool bTakeImageData ) 
 	{
 		if ( model.textures.size() < 1 )
 			return;
 
+		// Images can be shared by textures, only the last one using an image may take its pixels
+		std::vector< uint32_t > vecImageUses( model.images.size(), 0 );
+		for ( const auto &gltfTexture : model.textures )
+		{
+			if ( gltfTexture.source >= 0 && gltfTexture.source < static_cast< int >( model.images.size() ) )
+				vecImageUses[ gltfTexture.source ]++;
+		}
+
 		outRenderModel->textures.reserve( model.textures.size() );
 		for ( const auto &gltfTexture : model.textures )
 		{
+			bool bLastUse = gltfTexture.source >= 0 && gltfTexture.source < static_cast< int >( model.images.size() ) && --vecImageUses[ gltfTexture.source ] == 0;
+
 			STexture texture;
-			ParseTexture( &texture, commandPool, model, gltfTexture );
-			outRenderModel->textures.push_back( texture );
+			ParseTexture( &texture, commandPool, model, gltfTexture, bTakeImageData && bLastUse );
+			outRenderModel->textures.push_back( std::move( texture ) );
 		}
 	}
 
-	void CGltf::ParseTexture( STexture *outTexture, VkCommandPool commandPool, const tinygltf::Model &model, const tinygltf::Texture &gltfTexture ) 
+	void CGltf::ParseTexture( STexture *outTexture, VkCommandPool commandPool, tinygltf::Model &model, const tinygltf::Texture &gltfTexture, bool bTakeImageData ) 
 	{
 		// Get the image data
 		if ( gltfTexture.source < 0 || gltfTexture.source >= static_cast< int >( model.images.size() ) )
@@ -530,7 +1830,12 @@ namespace xrlib
 			return;
 		}
 
-		const tinygltf::Image &image = model.images[ gltfTexture.source ];
+		tinygltf::Image &image = model.images[ gltfTexture.source ];
+		if ( image.image.empty() )
+		{
+			LogError( "CGltf::ParseTexture", "Texture source %d has no decoded image data", gltfTexture.source );
+			return;
+		}
 
 		// Basic texture properties
 		outTexture->name = gltfTexture.name.empty() ? image.name : gltfTexture.name;
@@ -633,66 +1938,67 @@ namespace xrlib
 		// Copy image data
 		if ( !image.image.empty() )
 		{
-			outTexture->data = image.image;
-
-			// Create image
-			vkutils::CreateImage(
-				outTexture->image,
-				outTexture->memory,
-				m_pSession->GetVulkan()->GetVkLogicalDevice(),
-				m_pSession->GetVulkan()->GetVkPhysicalDevice(),
-				outTexture->width,
-				outTexture->height,
-				outTexture->format,
-				VK_IMAGE_TILING_OPTIMAL,
-				VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
-
-			// Create image view
-			vkutils::CreateImageView( outTexture->view, m_pSession->GetVulkan()->GetVkLogicalDevice(), outTexture->image, outTexture->format, VK_IMAGE_ASPECT_COLOR_BIT );
-
-			// Upload image to gpu buffer and transition image for shader reads
-			vkutils::UploadTextureDataToImage(
-				m_pSession->GetVulkan()->GetVkLogicalDevice(),
-				m_pSession->GetVulkan()->GetVkPhysicalDevice(),
-				commandPool,
-				m_pSession->GetVulkan()->GetVkQueue_Graphics(),
-				outTexture->image,
-				outTexture->data,
-				outTexture->width,
-				outTexture->height,
-				outTexture->format );
-
-			// Create texture sampler
-			VkSamplerCreateInfo samplerInfo {};
-			samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-			samplerInfo.magFilter = outTexture->samplerConfig.magFilter;
-			samplerInfo.minFilter = outTexture->samplerConfig.minFilter;
-
-			if ( outTexture->samplerConfig.minFilter == VK_FILTER_LINEAR )
-				samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-			else if ( outTexture->samplerConfig.minFilter == VK_FILTER_NEAREST )
-				samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+			if ( bTakeImageData )
+				outTexture->data = std::move( image.image );
 			else
-				samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
-
-			samplerInfo.addressModeU = outTexture->samplerConfig.addressModeU;
-			samplerInfo.addressModeV = outTexture->samplerConfig.addressModeV;
-			samplerInfo.addressModeW = outTexture->samplerConfig.addressModeW;
-			samplerInfo.anisotropyEnable = outTexture->samplerConfig.anisotropyEnable ? VK_TRUE : VK_FALSE;
-			samplerInfo.maxAnisotropy = outTexture->samplerConfig.maxAnisotropy;
-			samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-			samplerInfo.unnormalizedCoordinates = VK_FALSE;
-			samplerInfo.compareEnable = VK_FALSE;
-			samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-			samplerInfo.mipLodBias = 0.0f;
-			samplerInfo.minLod = outTexture->samplerConfig.minLod;
-			samplerInfo.maxLod = outTexture->samplerConfig.maxLod;
-
-			vkCreateSampler( m_pSession->GetVulkan()->GetVkLogicalDevice(), &samplerInfo, nullptr, &outTexture->sampler );
+				outTexture->data = image.image;
+
+			// Offline imports (no session) only keep the pixels
+			if ( m_pSession )
+				CreateTextureResources( outTexture, outTexture->data.data(), outTexture->data.size() );
 		}
 	}
 
+	void CGltf::CreateTextureResources( STexture *outTexture, const void *pPixels, VkDeviceSize unSize )
+	{
+		// Create image
+		vkutils::CreateImage(
+			outTexture->image,
+			outTexture->allocation,
+			m_pSession->GetVulkan()->GetVkLogicalDevice(),
+			m_pSession->GetVulkan()->GetVkPhysicalDevice(),
+			outTexture->width,
+			outTexture->height,
+			outTexture->format,
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+		// Create image view
+		vkutils::CreateImageView( outTexture->view, m_pSession->GetVulkan()->GetVkLogicalDevice(), outTexture->image, outTexture->format, VK_IMAGE_ASPECT_COLOR_BIT );
+
+		// Queue image upload on the transfer queue, the upload manager transitions it for shader reads
+		CUploadManager::Get( m_pSession )->UploadImage( outTexture->image, pPixels, unSize, outTexture->width, outTexture->height );
+
+		// Create texture sampler
+		VkSamplerCreateInfo samplerInfo {};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = outTexture->samplerConfig.magFilter;
+		samplerInfo.minFilter = outTexture->samplerConfig.minFilter;
+
+		if ( outTexture->samplerConfig.minFilter == VK_FILTER_LINEAR )
+			samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		else if ( outTexture->samplerConfig.minFilter == VK_FILTER_NEAREST )
+			samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		else
+			samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+
+		samplerInfo.addressModeU = outTexture->samplerConfig.addressModeU;
+		samplerInfo.addressModeV = outTexture->samplerConfig.addressModeV;
+		samplerInfo.addressModeW = outTexture->samplerConfig.addressModeW;
+		samplerInfo.anisotropyEnable = outTexture->samplerConfig.anisotropyEnable ? VK_TRUE : VK_FALSE;
+		samplerInfo.maxAnisotropy = outTexture->samplerConfig.maxAnisotropy;
+		samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+		samplerInfo.unnormalizedCoordinates = VK_FALSE;
+		samplerInfo.compareEnable = VK_FALSE;
+		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+		samplerInfo.mipLodBias = 0.0f;
+		samplerInfo.minLod = outTexture->samplerConfig.minLod;
+		samplerInfo.maxLod = outTexture->samplerConfig.maxLod;
+
+		vkCreateSampler( m_pSession->GetVulkan()->GetVkLogicalDevice(), &samplerInfo, nullptr, &outTexture->sampler );
+	}
+
 	void CGltf::IdentifyTextureTypes( std::vector< STexture > &textures, const tinygltf::Model &model )
 	{
 		// Go through each material to identify texture types
@@ -835,6 +2141,129 @@ namespace xrlib
 			
 	}
 
+	void CGltf::ParseAnimations( CRenderModel *outRenderModel, const tinygltf::Model &model, const std::vector< int32_t > &sceneNodes )
+	{
+		outRenderModel->animations.clear();
+		outRenderModel->animations.reserve( model.animations.size() );
+
+		for ( const tinygltf::Animation &gltfAnimation : model.animations )
+		{
+			std::shared_ptr< SAnimationClip > pClip = std::make_shared< SAnimationClip >();
+			ParseAnimation( pClip.get(), model, gltfAnimation, sceneNodes );
+			outRenderModel->animations.push_back( std::move( pClip ) );
+		}
+	}
+
+	void CGltf::ParseAnimation( SAnimationClip *outClip, const tinygltf::Model &model, const tinygltf::Animation &gltfAnimation, const std::vector< int32_t > &sceneNodes )
+	{
+		outClip->name = gltfAnimation.name;
+
+		// Samplers are only decoded once a channel uses them, samplers with the same input accessor share its track
+		std::vector< int32_t > vecSamplers( gltfAnimation.samplers.size(), -1 );
+		std::unordered_map< int, uint32_t > mapTracks;
+
+		for ( const tinygltf::AnimationChannel &gltfChannel : gltfAnimation.channels )
+		{
+			SAnimationChannel channel;
+			if ( gltfChannel.target_path == "translation" )
+				channel.path = EAnimationPath::Translation;
+			else if ( gltfChannel.target_path == "rotation" )
+				channel.path = EAnimationPath::Rotation;
+			else if ( gltfChannel.target_path == "scale" )
+				channel.path = EAnimationPath::Scale;
+			else if ( gltfChannel.target_path == "weights" )
+				channel.path = EAnimationPath::Weights;
+			else
+				continue;
+
+			// Channels of nodes outside of the scene have nothing to animate
+			if ( gltfChannel.target_node < 0 || gltfChannel.target_node >= static_cast< int >( sceneNodes.size() ) || sceneNodes[ gltfChannel.target_node ] < 0 || 
+				 gltfChannel.sampler < 0 || gltfChannel.sampler >= static_cast< int >( vecSamplers.size() ) )
+				continue;
+
+			channel.node = static_cast< uint32_t >( sceneNodes[ gltfChannel.target_node ] );
+
+			// Weights keys hold one value per morph target of the node's mesh
+			size_t unComponents = channel.path == EAnimationPath::Rotation ? 4 : 3;
+			if ( channel.path == EAnimationPath::Weights )
+			{
+				const int nMesh = model.nodes[ gltfChannel.target_node ].mesh;
+				unComponents = 0;
+				if ( nMesh >= 0 && nMesh < static_cast< int >( model.meshes.size() ) && !model.meshes[ nMesh ].primitives.empty() )
+					unComponents = model.meshes[ nMesh ].primitives[ 0 ].targets.size();
+
+				if ( unComponents == 0 || unComponents > std::numeric_limits< uint16_t >::max() )
+					continue;
+			}
+
+			int32_t &nSampler = vecSamplers[ gltfChannel.sampler ];
+			if ( nSampler < 0 )
+			{
+				const tinygltf::AnimationSampler &gltfSampler = gltfAnimation.samplers[ gltfChannel.sampler ];
+
+				SAnimationSampler sampler;
+				sampler.components = static_cast< uint16_t >( unComponents );
+				sampler.path = channel.path;
+				if ( gltfSampler.interpolation == "STEP" )
+					sampler.interpolation = EAnimationInterpolation::Step;
+				else if ( gltfSampler.interpolation == "CUBICSPLINE" )
+					sampler.interpolation = EAnimationInterpolation::CubicSpline;
+
+				// Weights outputs are scalars, one element per target and key
+				const size_t unValuesPerKey = sampler.interpolation == EAnimationInterpolation::CubicSpline ? 3 : 1;
+				const size_t unElementsPerValue = sampler.path == EAnimationPath::Weights ? sampler.components : 1;
+				const size_t unElementComponents = sampler.path == EAnimationPath::Weights ? 1 : sampler.components;
+
+				SAccessorStream input, output;
+				if ( !GetAccessorStream( input, model, gltfSampler.input ) || !GetAccessorStream( output, model, gltfSampler.output ) || 
+					 input.count == 0 || input.componentCount != 1 || output.componentCount != unElementComponents || output.count < input.count * unValuesPerKey * unElementsPerValue )
+				{
+					LogWarning( XRLIB_NAME, "Skipping invalid sampler %i of animation %s", gltfChannel.sampler, gltfAnimation.name.c_str() );
+					continue;
+				}
+
+				auto itTrack = mapTracks.find( gltfSampler.input );
+				if ( itTrack == mapTracks.end() )
+				{
+					SAnimationTrack track;
+					track.firstKey = static_cast< uint32_t >( outClip->times.size() );
+					track.keyCount = static_cast< uint32_t >( input.count );
+
+					outClip->times.resize( outClip->times.size() + input.count );
+					DecodeAccessorFloat( input, outClip->times.data() + track.firstKey, 1, sizeof( float ) );
+					outClip->duration = std::max( outClip->duration, outClip->times.back() );
+
+					itTrack = mapTracks.emplace( gltfSampler.input, static_cast< uint32_t >( outClip->tracks.size() ) ).first;
+					outClip->tracks.push_back( track );
+				}
+
+				sampler.track = itTrack->second;
+				sampler.firstValue = static_cast< uint32_t >( outClip->values.size() );
+
+				output.count = input.count * unValuesPerKey * unElementsPerValue;
+				outClip->values.resize( outClip->values.size() + output.count * unElementComponents );
+				DecodeAccessorFloat( output, outClip->values.data() + sampler.firstValue, static_cast< uint32_t >( unElementComponents ), sizeof( float ) * unElementComponents );
+
+				nSampler = static_cast< int32_t >( outClip->samplers.size() );
+				outClip->samplers.push_back( sampler );
+			}
+
+			// A sampler is meant for one path (and one mesh for weights)
+			if ( outClip->samplers[ nSampler ].path != channel.path || outClip->samplers[ nSampler ].components != unComponents )
+				continue;
+
+			channel.sampler = static_cast< uint32_t >( nSampler );
+			outClip->channels.push_back( channel );
+		}
+
+		LogInfo( XRLIB_NAME, "Animation %s: %u channels, %u tracks, %u keys, %.2f seconds", 
+			outClip->name.c_str(), 
+			static_cast< uint32_t >( outClip->channels.size() ), 
+			static_cast< uint32_t >( outClip->tracks.size() ), 
+			static_cast< uint32_t >( outClip->times.size() ), 
+			outClip->duration );
+	}
+
 	void CGltf::ParseSkin( SSkin *outSkin, const tinygltf::Model &model, const tinygltf::Skin &gltfSkin ) 
 	{
 		outSkin->name = gltfSkin.name;
@@ -972,6 +2401,8 @@ namespace xrlib
 			}
 		}
 
+		// Parent array and evaluation order for the per frame updates
+		outSkin->BuildHierarchy();
 	}
 
 	VkFilter CGltf::ConvertMagFilter( int gltfFilter )
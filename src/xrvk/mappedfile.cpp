@@ -0,0 +1,156 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#include <xrvk/mappedfile.hpp>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace xrlib
+{
+	CMappedFile::~CMappedFile() 
+	{ 
+		Close(); 
+	}
+
+	bool CMappedFile::Open( const std::string &sFilename )
+	{
+		Close();
+
+		#ifdef _WIN32
+			HANDLE hFile = CreateFileA( sFilename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+			if ( hFile == INVALID_HANDLE_VALUE )
+				return false;
+
+			m_hFile = hFile;
+
+			LARGE_INTEGER size {};
+			if ( !GetFileSizeEx( hFile, &size ) || size.QuadPart == 0 )
+			{
+				Close();
+				return false;
+			}
+
+			m_hMapping = CreateFileMappingA( hFile, nullptr, PAGE_READONLY, 0, 0, nullptr );
+			if ( !m_hMapping )
+			{
+				Close();
+				return false;
+			}
+
+			m_pData = static_cast< const uint8_t * >( MapViewOfFile( m_hMapping, FILE_MAP_READ, 0, 0, 0 ) );
+			m_unSize = static_cast< size_t >( size.QuadPart );
+		#else
+			m_nFile = open( sFilename.c_str(), O_RDONLY );
+			if ( m_nFile < 0 )
+				return false;
+
+			struct stat fileStat {};
+			if ( fstat( m_nFile, &fileStat ) != 0 || fileStat.st_size == 0 )
+			{
+				Close();
+				return false;
+			}
+
+			void *pMapped = mmap( nullptr, static_cast< size_t >( fileStat.st_size ), PROT_READ, MAP_PRIVATE, m_nFile, 0 );
+			if ( pMapped == MAP_FAILED )
+			{
+				Close();
+				return false;
+			}
+
+			// Read front to back by the loaders
+			madvise( pMapped, static_cast< size_t >( fileStat.st_size ), MADV_SEQUENTIAL );
+
+			m_pData = static_cast< const uint8_t * >( pMapped );
+			m_unSize = static_cast< size_t >( fileStat.st_size );
+		#endif
+
+		if ( !m_pData )
+		{
+			Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	#ifdef XR_USE_PLATFORM_ANDROID
+		bool CMappedFile::Open( AAssetManager *pAssetManager, const std::string &sFilename )
+		{
+			Close();
+
+			if ( !pAssetManager )
+				return false;
+
+			m_pAsset = AAssetManager_open( pAssetManager, sFilename.c_str(), AASSET_MODE_BUFFER );
+			if ( !m_pAsset )
+				return false;
+
+			m_pData = static_cast< const uint8_t * >( AAsset_getBuffer( m_pAsset ) );
+			m_unSize = static_cast< size_t >( AAsset_getLength64( m_pAsset ) );
+
+			if ( !m_pData || m_unSize == 0 )
+			{
+				Close();
+				return false;
+			}
+
+			return true;
+		}
+	#endif
+
+	void CMappedFile::Close()
+	{
+		#ifdef XR_USE_PLATFORM_ANDROID
+			if ( m_pAsset )
+			{
+				// The asset owns its buffer
+				AAsset_close( m_pAsset );
+				m_pAsset = nullptr;
+				m_pData = nullptr;
+			}
+		#endif
+
+		#ifdef _WIN32
+			if ( m_pData )
+				UnmapViewOfFile( m_pData );
+			if ( m_hMapping )
+				CloseHandle( m_hMapping );
+			if ( m_hFile )
+				CloseHandle( m_hFile );
+
+			m_hMapping = nullptr;
+			m_hFile = nullptr;
+		#else
+			if ( m_pData )
+				munmap( const_cast< uint8_t * >( m_pData ), m_unSize );
+			if ( m_nFile >= 0 )
+				close( m_nFile );
+
+			m_nFile = -1;
+		#endif
+
+		m_pData = nullptr;
+		m_unSize = 0;
+	}
+
+} // namespace xrlib
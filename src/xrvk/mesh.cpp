@@ -12,9 +12,415 @@
 
 
 #include <xrvk/mesh.hpp>
+#include <xrvk/ringbuffer.hpp>
+
+#include <algorithm>
+
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+	#define XRVK_MESH_SSE
+	#include <xmmintrin.h>
+#elif defined( __ARM_NEON ) && ( defined( __aarch64__ ) || defined( _M_ARM64 ) )
+	#define XRVK_MESH_NEON
+	#include <arm_neon.h>
+#endif
 
 namespace xrlib
 {
+	namespace
+	{
+		// Column major, same result as XrMatrix4x4f_Multiply. pOut may alias either input.
+		inline void MultiplyMatrix( XrMatrix4x4f *pOut, const XrMatrix4x4f *pA, const XrMatrix4x4f *pB )
+		{
+		#if defined( XRVK_MESH_SSE )
+			const __m128 a0 = _mm_loadu_ps( &pA->m[ 0 ] );
+			const __m128 a1 = _mm_loadu_ps( &pA->m[ 4 ] );
+			const __m128 a2 = _mm_loadu_ps( &pA->m[ 8 ] );
+			const __m128 a3 = _mm_loadu_ps( &pA->m[ 12 ] );
+
+			for ( int i = 0; i < 4; i++ )
+			{
+				const float *pColumn = &pB->m[ i * 4 ];
+				__m128 c = _mm_mul_ps( a0, _mm_set1_ps( pColumn[ 0 ] ) );
+				c = _mm_add_ps( c, _mm_mul_ps( a1, _mm_set1_ps( pColumn[ 1 ] ) ) );
+				c = _mm_add_ps( c, _mm_mul_ps( a2, _mm_set1_ps( pColumn[ 2 ] ) ) );
+				c = _mm_add_ps( c, _mm_mul_ps( a3, _mm_set1_ps( pColumn[ 3 ] ) ) );
+				_mm_storeu_ps( &pOut->m[ i * 4 ], c );
+			}
+		#elif defined( XRVK_MESH_NEON )
+			const float32x4_t a0 = vld1q_f32( &pA->m[ 0 ] );
+			const float32x4_t a1 = vld1q_f32( &pA->m[ 4 ] );
+			const float32x4_t a2 = vld1q_f32( &pA->m[ 8 ] );
+			const float32x4_t a3 = vld1q_f32( &pA->m[ 12 ] );
+
+			for ( int i = 0; i < 4; i++ )
+			{
+				const float32x4_t b = vld1q_f32( &pB->m[ i * 4 ] );
+				float32x4_t c = vmulq_laneq_f32( a0, b, 0 );
+				c = vfmaq_laneq_f32( c, a1, b, 1 );
+				c = vfmaq_laneq_f32( c, a2, b, 2 );
+				c = vfmaq_laneq_f32( c, a3, b, 3 );
+				vst1q_f32( &pOut->m[ i * 4 ], c );
+			}
+		#else
+			XrMatrix4x4f result;
+			XrMatrix4x4f_Multiply( &result, pA, pB );
+			*pOut = result;
+		#endif
+		}
+
+		// Compact attribute sizes
+		constexpr uint32_t k_unPositionSize = sizeof( XrVector3f );
+		constexpr uint32_t k_unCompactBaseSize = 24; // position 12, normal 4, tangent 4, uv0 4
+		constexpr uint32_t k_unCompactUV1Size = 4;
+		constexpr uint32_t k_unCompactColorSize = 4;
+		constexpr uint32_t k_unCompactSkinSize = 12; // joints 4, weights 8
+
+		uint16_t FloatToHalf( float fValue )
+		{
+			uint32_t unBits;
+			memcpy( &unBits, &fValue, sizeof( float ) );
+
+			uint32_t unSign = ( unBits >> 16 ) & 0x8000u;
+			int32_t nExponent = (int32_t) ( ( unBits >> 23 ) & 0xFFu ) - 127 + 15;
+			uint32_t unMantissa = unBits & 0x7FFFFFu;
+
+			// NaN / infinity
+			if ( ( ( unBits >> 23 ) & 0xFFu ) == 0xFFu )
+				return (uint16_t) ( unSign | 0x7C00u | ( unMantissa ? 0x200u : 0u ) );
+
+			// Overflow - clamp to infinity
+			if ( nExponent >= 31 )
+				return (uint16_t) ( unSign | 0x7C00u );
+
+			// Denormal or zero
+			if ( nExponent <= 0 )
+			{
+				if ( nExponent < -10 )
+					return (uint16_t) unSign;
+
+				unMantissa |= 0x800000u;
+				uint32_t unShift = (uint32_t) ( 14 - nExponent );
+				uint32_t unHalfMantissa = unMantissa >> unShift;
+
+				// Round to nearest even
+				uint32_t unRemainder = unMantissa & ( ( 1u << unShift ) - 1 );
+				uint32_t unHalfway = 1u << ( unShift - 1 );
+				if ( unRemainder > unHalfway || ( unRemainder == unHalfway && ( unHalfMantissa & 1u ) ) )
+					unHalfMantissa++;
+
+				return (uint16_t) ( unSign | unHalfMantissa );
+			}
+
+			uint32_t unHalf = unSign | ( (uint32_t) nExponent << 10 ) | ( unMantissa >> 13 );
+
+			// Round to nearest even (carry into the exponent is intended)
+			uint32_t unRemainder = unMantissa & 0x1FFFu;
+			if ( unRemainder > 0x1000u || ( unRemainder == 0x1000u && ( unHalf & 1u ) ) )
+				unHalf++;
+
+			return (uint16_t) unHalf;
+		}
+
+		template < typename T > 
+		T FloatToSnorm( float fValue )
+		{
+			return (T) std::round( std::clamp( fValue, -1.f, 1.f ) * (float) std::numeric_limits< T >::max() );
+		}
+
+		template < typename T > 
+		T FloatToUnorm( float fValue )
+		{
+			return (T) std::round( std::clamp( fValue, 0.f, 1.f ) * (float) std::numeric_limits< T >::max() );
+		}
+
+		// Octahedral mapping of a unit vector to [-1, 1]^2
+		XrVector2f OctahedralEncode( const XrVector3f &v )
+		{
+			float fL1 = std::abs( v.x ) + std::abs( v.y ) + std::abs( v.z );
+			if ( fL1 <= FLT_EPSILON )
+				return { 0.f, 0.f };
+
+			XrVector2f e { v.x / fL1, v.y / fL1 };
+			if ( v.z < 0.f )
+			{
+				XrVector2f folded { ( 1.f - std::abs( e.y ) ) * ( e.x >= 0.f ? 1.f : -1.f ), ( 1.f - std::abs( e.x ) ) * ( e.y >= 0.f ? 1.f : -1.f ) };
+				e = folded;
+			}
+
+			return e;
+		}
+	}
+
+	void SSkin::BuildHierarchy()
+	{
+		const uint32_t unJointCount = static_cast< uint32_t >( joints.size() );
+
+		parents.assign( unJointCount, -1 );
+		for ( const auto &[ unParent, children ] : hierarchy )
+		{
+			for ( uint32_t unChild : children )
+			{
+				if ( unParent < unJointCount && unChild < unJointCount && unChild != unParent )
+					parents[ unChild ] = static_cast< int32_t >( unParent );
+			}
+		}
+
+		// Depth of each joint, joints in a cycle (malformed files) become roots
+		std::vector< uint32_t > vecDepths( unJointCount, 0 );
+		for ( uint32_t i = 0; i < unJointCount; i++ )
+		{
+			uint32_t unDepth = 0;
+			for ( int32_t nParent = parents[ i ]; nParent >= 0 && unDepth <= unJointCount; nParent = parents[ nParent ] )
+				unDepth++;
+
+			if ( unDepth > unJointCount )
+			{
+				parents[ i ] = -1;
+				unDepth = 0;
+			}
+
+			vecDepths[ i ] = unDepth;
+		}
+
+		// Shallower joints first, so every parent's world matrix is ready before its children's
+		evaluationOrder.resize( unJointCount );
+		for ( uint32_t i = 0; i < unJointCount; i++ )
+			evaluationOrder[ i ] = i;
+
+		std::stable_sort( evaluationOrder.begin(), evaluationOrder.end(), [ & ]( uint32_t a, uint32_t b ) { return vecDepths[ a ] < vecDepths[ b ]; } );
+
+		matrices.resize( unJointCount );
+		worldMatrices.resize( unJointCount );
+	}
+
+	template < typename FnLocal >
+	void SSkin::Evaluate( FnLocal &&fnLocal )
+	{
+		// Skins assembled at runtime are flattened on their first update
+		if ( parents.size() != joints.size() || evaluationOrder.size() != joints.size() )
+			BuildHierarchy();
+
+		matrices.resize( joints.size() );
+		worldMatrices.resize( joints.size() );
+
+		const size_t unInverseBindCount = inverseBindMatrices.size();
+		XrMatrix4x4f localMatrix;
+
+		for ( uint32_t unJoint : evaluationOrder )
+		{
+			const XrMatrix4x4f &local = fnLocal( unJoint, localMatrix );
+			const int32_t nParent = parents[ unJoint ];
+
+			XrMatrix4x4f &world = worldMatrices[ unJoint ];
+			if ( nParent < 0 )
+				world = local;
+			else
+				MultiplyMatrix( &world, &worldMatrices[ nParent ], &local );
+
+			if ( unJoint < unInverseBindCount )
+				MultiplyMatrix( &matrices[ unJoint ], &world, &inverseBindMatrices[ unJoint ] );
+			else
+				matrices[ unJoint ] = world;
+		}
+	}
+
+	void SSkin::UpdateMatrices( const XrQuaternionf *pOrientations, const XrVector3f *pPositions, XrVector3f scale )
+	{
+		Evaluate( [ & ]( uint32_t unJoint, XrMatrix4x4f &outLocal ) -> const XrMatrix4x4f & 
+		{
+			XrMatrix4x4f_CreateTranslationRotationScale( &outLocal, &pPositions[ unJoint ], &pOrientations[ unJoint ], &scale );
+			return outLocal;
+		} );
+	}
+
+	void SSkin::UpdateMatrices( const std::vector< XrQuaternionf > &orientation, const std::vector< XrVector3f > &position, XrVector3f scale )
+	{
+		assert( orientation.size() >= joints.size() && position.size() >= joints.size() );
+		UpdateMatrices( orientation.data(), position.data(), scale );
+	}
+
+	void SSkin::UpdateMatrices( const std::vector< XrPosef > &newJointPoses, XrVector3f scale )
+	{
+		assert( newJointPoses.size() >= joints.size() );
+
+		Evaluate( [ & ]( uint32_t unJoint, XrMatrix4x4f &outLocal ) -> const XrMatrix4x4f & 
+		{
+			XrMatrix4x4f_CreateTranslationRotationScale( &outLocal, &newJointPoses[ unJoint ].position, &newJointPoses[ unJoint ].orientation, &scale );
+			return outLocal;
+		} );
+	}
+
+	void SSkin::UpdateMatrices( const XrMatrix4x4f *localMatrices )
+	{
+		Evaluate( [ & ]( uint32_t unJoint, XrMatrix4x4f & ) -> const XrMatrix4x4f & { return localMatrices[ unJoint ]; } );
+	}
+
+	void SSkin::UpdateMatrices( const CSceneGraph &sceneGraph )
+	{
+		matrices.resize( joints.size() );
+		for ( size_t i = 0; i < joints.size(); i++ )
+		{
+			const int32_t nNode = i < jointNodes.size() ? jointNodes[ i ] : -1;
+			if ( nNode < 0 || static_cast< uint32_t >( nNode ) >= sceneGraph.GetNodeCount() )
+			{
+				XrMatrix4x4f_CreateIdentity( &matrices[ i ] );
+				continue;
+			}
+
+			if ( i < inverseBindMatrices.size() )
+				MultiplyMatrix( &matrices[ i ], &sceneGraph.GetWorldMatrix( nNode ), &inverseBindMatrices[ i ] );
+			else
+				matrices[ i ] = sceneGraph.GetWorldMatrix( nNode );
+		}
+	}
+
+	uint32_t SVertexFormat::GetStride() const
+	{
+		uint32_t unStride = k_unCompactBaseSize;
+
+		if ( layout == EVertexLayout::Full )
+		{
+			unStride = sizeof( SMeshVertex );
+		}
+		else
+		{
+			if ( optionalAttributes & VERTEX_UV1_BIT )
+				unStride += k_unCompactUV1Size;
+			if ( optionalAttributes & VERTEX_COLOR0_BIT )
+				unStride += k_unCompactColorSize;
+			if ( optionalAttributes & VERTEX_SKIN_BIT )
+				unStride += k_unCompactSkinSize;
+		}
+
+		// Position is the first member of both layouts
+		return splitPositions ? unStride - k_unPositionSize : unStride;
+	}
+
+	void SVertexFormat::FillAttributes( std::vector< VkVertexInputAttributeDescription > &outVecAttributes, uint32_t binding, uint32_t locStart ) const
+	{
+		// Split formats read positions from their own stream, everything else moves to the next binding and one position earlier
+		const uint32_t unAttributeBinding = splitPositions ? binding + 1 : binding;
+		const uint32_t unShift = splitPositions ? k_unPositionSize : 0;
+
+		outVecAttributes.push_back( { locStart + 0, binding, VK_FORMAT_R32G32B32_SFLOAT, 0 } );
+
+		if ( layout == EVertexLayout::Full )
+		{
+			outVecAttributes.push_back( { locStart + 1, unAttributeBinding, VK_FORMAT_R32G32B32_SFLOAT, (uint32_t) offsetof( SMeshVertex, normal ) - unShift } );
+			outVecAttributes.push_back( { locStart + 2, unAttributeBinding, VK_FORMAT_R32G32B32A32_SFLOAT, (uint32_t) offsetof( SMeshVertex, tangent ) - unShift } );
+			outVecAttributes.push_back( { locStart + 3, unAttributeBinding, VK_FORMAT_R32G32_SFLOAT, (uint32_t) offsetof( SMeshVertex, uv0 ) - unShift } );
+			outVecAttributes.push_back( { locStart + 4, unAttributeBinding, VK_FORMAT_R32G32_SFLOAT, (uint32_t) offsetof( SMeshVertex, uv1 ) - unShift } );
+			outVecAttributes.push_back( { locStart + 5, unAttributeBinding, VK_FORMAT_R32G32B32_SFLOAT, (uint32_t) offsetof( SMeshVertex, color0 ) - unShift } );
+			outVecAttributes.push_back( { locStart + 6, unAttributeBinding, VK_FORMAT_R32G32B32A32_SINT, (uint32_t) offsetof( SMeshVertex, joints ) - unShift } );
+			outVecAttributes.push_back( { locStart + 7, unAttributeBinding, VK_FORMAT_R32G32B32A32_SFLOAT, (uint32_t) offsetof( SMeshVertex, weights ) - unShift } );
+			return;
+		}
+
+		outVecAttributes.push_back( { locStart + 1, unAttributeBinding, VK_FORMAT_R16G16_SNORM, 12 - unShift } );
+		outVecAttributes.push_back( { locStart + 2, unAttributeBinding, VK_FORMAT_R8G8B8A8_SNORM, 16 - unShift } );
+		outVecAttributes.push_back( { locStart + 3, unAttributeBinding, VK_FORMAT_R16G16_SFLOAT, 20 - unShift } );
+
+		uint32_t unOffset = k_unCompactBaseSize - unShift;
+		if ( optionalAttributes & VERTEX_UV1_BIT )
+		{
+			outVecAttributes.push_back( { locStart + 4, unAttributeBinding, VK_FORMAT_R16G16_SFLOAT, unOffset } );
+			unOffset += k_unCompactUV1Size;
+		}
+
+		if ( optionalAttributes & VERTEX_COLOR0_BIT )
+		{
+			outVecAttributes.push_back( { locStart + 5, unAttributeBinding, VK_FORMAT_R8G8B8A8_UNORM, unOffset } );
+			unOffset += k_unCompactColorSize;
+		}
+
+		if ( optionalAttributes & VERTEX_SKIN_BIT )
+		{
+			outVecAttributes.push_back( { locStart + 6, unAttributeBinding, VK_FORMAT_R8G8B8A8_UINT, unOffset } );
+			outVecAttributes.push_back( { locStart + 7, unAttributeBinding, VK_FORMAT_R16G16B16A16_UNORM, unOffset + 4 } );
+		}
+	}
+
+	void SVertexFormat::Pack( std::vector< uint8_t > &outData, const std::vector< SMeshVertex > &vertices ) const
+	{
+		outData.clear();
+		if ( layout == EVertexLayout::Full && !splitPositions )
+			return;
+
+		// Offsets below are in the interleaved layout, the destination starts at the normal if positions are split
+		const uint32_t unStride = GetStride();
+		const uint32_t unShift = splitPositions ? k_unPositionSize : 0;
+		outData.resize( (size_t) unStride * vertices.size() );
+
+		uint8_t *pDst = outData.data();
+		for ( auto &vertex : vertices )
+		{
+			if ( layout == EVertexLayout::Full )
+			{
+				// Everything after the position
+				memcpy( pDst, reinterpret_cast< const uint8_t * >( &vertex ) + k_unPositionSize, unStride );
+				pDst += unStride;
+				continue;
+			}
+
+			if ( !splitPositions )
+				memcpy( pDst, &vertex.position, sizeof( XrVector3f ) );
+
+			XrVector2f normal = OctahedralEncode( vertex.normal );
+			int16_t *pNormal = reinterpret_cast< int16_t * >( pDst + 12 - unShift );
+			pNormal[ 0 ] = FloatToSnorm< int16_t >( normal.x );
+			pNormal[ 1 ] = FloatToSnorm< int16_t >( normal.y );
+
+			XrVector2f tangent = OctahedralEncode( { vertex.tangent.x, vertex.tangent.y, vertex.tangent.z } );
+			int8_t *pTangent = reinterpret_cast< int8_t * >( pDst + 16 - unShift );
+			pTangent[ 0 ] = FloatToSnorm< int8_t >( tangent.x );
+			pTangent[ 1 ] = FloatToSnorm< int8_t >( tangent.y );
+			pTangent[ 2 ] = vertex.tangent.w < 0.f ? -127 : 127;
+			pTangent[ 3 ] = 0;
+
+			uint16_t *pUV0 = reinterpret_cast< uint16_t * >( pDst + 20 - unShift );
+			pUV0[ 0 ] = FloatToHalf( vertex.uv0.x );
+			pUV0[ 1 ] = FloatToHalf( vertex.uv0.y );
+
+			uint8_t *pOptional = pDst + k_unCompactBaseSize - unShift;
+			if ( optionalAttributes & VERTEX_UV1_BIT )
+			{
+				uint16_t *pUV1 = reinterpret_cast< uint16_t * >( pOptional );
+				pUV1[ 0 ] = FloatToHalf( vertex.uv1.x );
+				pUV1[ 1 ] = FloatToHalf( vertex.uv1.y );
+				pOptional += k_unCompactUV1Size;
+			}
+
+			if ( optionalAttributes & VERTEX_COLOR0_BIT )
+			{
+				pOptional[ 0 ] = FloatToUnorm< uint8_t >( vertex.color0.x );
+				pOptional[ 1 ] = FloatToUnorm< uint8_t >( vertex.color0.y );
+				pOptional[ 2 ] = FloatToUnorm< uint8_t >( vertex.color0.z );
+				pOptional[ 3 ] = 255;
+				pOptional += k_unCompactColorSize;
+			}
+
+			if ( optionalAttributes & VERTEX_SKIN_BIT )
+			{
+				uint16_t *pWeights = reinterpret_cast< uint16_t * >( pOptional + 4 );
+				for ( uint32_t i = 0; i < JOINT_INFLUENCE_COUNT; i++ )
+				{
+					assert( vertex.joints[ i ] <= std::numeric_limits< uint8_t >::max() );
+					pOptional[ i ] = (uint8_t) vertex.joints[ i ];
+					pWeights[ i ] = FloatToUnorm< uint16_t >( vertex.weights[ i ] );
+				}
+			}
+
+			pDst += unStride;
+		}
+	}
+
+	void SVertexFormat::PackPositions( std::vector< XrVector3f > &outPositions, const std::vector< SMeshVertex > &vertices ) const
+	{
+		outPositions.resize( vertices.size() );
+		for ( size_t i = 0; i < vertices.size(); i++ )
+			outPositions[ i ] = vertices[ i ].position;
+	}
+
 	CRenderModel::CRenderModel( 
 		CSession *pSession,
 		CRenderInfo *pRenderInfo,
@@ -25,11 +431,13 @@ namespace xrlib
 		XrVector3f xrScale,
 		XrSpace xrSpace )
 		: CRenderable( pSession, pRenderInfo, pipelineLayoutIdx, graphicsPipelineIdx, descriptorLayoutIdx, bIsVisible, xrScale, xrSpace )
+		, geometryPool( pRenderInfo ? pRenderInfo->pGeometryPool : nullptr )
 	{
 	}
 
 	CRenderModel::CRenderModel( CSession *pSession, CRenderInfo *pRenderInfo, bool bIsVisible, XrVector3f xrScale, XrSpace xrSpace ) : 
-		CRenderable( pSession, pRenderInfo, 0, 0, std::numeric_limits< uint32_t >::max(), bIsVisible, xrScale, xrSpace )
+		CRenderable( pSession, pRenderInfo, 0, 0, std::numeric_limits< uint32_t >::max(), bIsVisible, xrScale, xrSpace ),
+		geometryPool( pRenderInfo ? pRenderInfo->pGeometryPool : nullptr )
 	{
 	}
 
@@ -41,27 +449,13 @@ namespace xrlib
 
 	VkResult CRenderModel::InitBuffers( bool bReset )
 	{
-
-		// Initialize vertex buffer
+		// Initialize vertex and index buffers (or pool ranges)
 		if ( vertices.size() > 0 )
-		{
-			if ( m_pVertexBuffer )
-				delete m_pVertexBuffer;
-
-			m_pVertexBuffer = new CDeviceBuffer( m_pSession );
-			VkResult result = InitBuffer( m_pVertexBuffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof( SMeshVertex ) * vertices.size(), vertices.data() );
-			if ( result != VK_SUCCESS )
-				return result;
-		}
+			UpdateBounds();
 
-		// Initialize index buffer
-		if ( indices.size() > 0 )
+		if ( vertices.size() > 0 || indices.size() > 0 )
 		{
-			if ( m_pIndexBuffer )
-				delete m_pIndexBuffer;
-
-			m_pIndexBuffer = new CDeviceBuffer( m_pSession );
-			VkResult result = InitBuffer( m_pIndexBuffer, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, sizeof( uint32_t ) * indices.size(), indices.data() );
+			VkResult result = InitGeometry();
 			if ( result != VK_SUCCESS )
 				return result;
 		}
@@ -78,6 +472,12 @@ namespace xrlib
 				return result;
 		}
 
+		// Nodes the sections are bound to, their instance matrices are filled by UpdateSceneGraph()
+		UpdateNodeSlots();
+
+		// Needs the cpu indices, which a reset drops
+		UpdateSkinDispatches();
+
 		// Reset if requested
 		if ( bReset )
 			Reset();
@@ -87,14 +487,18 @@ namespace xrlib
 
 	void CRenderModel::Draw( const VkCommandBuffer commandBuffer, const CRenderInfo &renderInfo ) 
 	{
-		// Set push constants
-		vkCmdPushConstants( 
-			commandBuffer, 
-			renderInfo.vecPipelineLayouts[ pipelineLayoutIndex ], 
-			VK_SHADER_STAGE_VERTEX_BIT, 
-			0, 
-			k_pcrSize, 
-			renderInfo.state.eyeVPs.data() );
+		// Evicted, still restoring or without geometry
+		if ( !m_bResident || !m_pVertexBuffer || !m_pIndexBuffer )
+			return;
+
+		// Joint matrices (or skinned vertices) didn't fit in this frame's region of their ring
+		const bool bSkinned = IsSkinned( renderInfo );
+		const bool bComputeSkinned = DrawsSkinnedCopies( renderInfo );
+		if ( ( bSkinned || bComputeSkinned ) && !HasSkinOffsets() )
+			return;
+
+		if ( bComputeSkinned && !HasSkinnedVertices() )
+			return;
 
 		// Set stencil reference
 		vkCmdSetStencilReference( commandBuffer, VK_STENCIL_FACE_FRONT_AND_BACK, 1 );
@@ -102,10 +506,28 @@ namespace xrlib
 		// Bind the graphics pipeline for this shape
 		vkCmdBindPipeline( commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderInfo.vecGraphicsPipelines[ graphicsPipelineIndex ] );
 
-		// Bind shape's index and vertex buffers
-		vkCmdBindIndexBuffer( commandBuffer, GetIndexBuffer()->GetVkBuffer(), 0, VK_INDEX_TYPE_UINT32 );
-		vkCmdBindVertexBuffers( commandBuffer, 0, 1, GetVertexBuffer()->GetVkBufferPtr(), vertexOffsets );
-		vkCmdBindVertexBuffers( commandBuffer, 1, 1, GetInstanceBuffer()->GetVkBufferPtr(), instanceOffsets );
+		// Bind shape's index and vertex buffers (positions at binding 0 if split, then the attribute stream and the instances)
+		if ( m_geometryAllocation.IsValid() )
+		{
+			// Skipped if the previous pooled model used the same arena
+			m_pGeometryPool->Bind( commandBuffer, m_geometryAllocation, false );
+		}
+		else if ( bComputeSkinned )
+		{
+			// This frame's skinned copies instead of the bind pose
+			vkCmdBindIndexBuffer( commandBuffer, GetIndexBuffer()->GetVkBuffer(), 0, m_vkIndexType );
+			BindSkinnedVertices( commandBuffer, renderInfo, false );
+		}
+		else
+		{
+			vkCmdBindIndexBuffer( commandBuffer, GetIndexBuffer()->GetVkBuffer(), 0, m_vkIndexType );
+			if ( m_pPositionBuffer )
+				vkCmdBindVertexBuffers( commandBuffer, 0, 1, m_pPositionBuffer->GetVkBufferPtr(), vertexOffsets );
+
+			vkCmdBindVertexBuffers( commandBuffer, vertexFormat.GetBindingCount() - 1, 1, GetVertexBuffer()->GetVkBufferPtr(), vertexOffsets );
+		}
+
+		vkCmdBindVertexBuffers( commandBuffer, vertexFormat.GetBindingCount(), 1, GetInstanceBuffer()->GetVkBufferPtr(), instanceOffsets );
 
 		// Bind vertex descriptors
 		if ( !vertexDescriptors.empty() )
@@ -138,33 +560,627 @@ namespace xrlib
 		if ( materialSections.empty() )
 		{
 			// Draw indexed - no material
-			vkCmdDrawIndexed( commandBuffer, indices.size(), GetInstanceCount(), 0, 0, 0 );
+			if ( bSkinned )
+				BindSkin( commandBuffer, renderInfo, 0 );
+
+			vkCmdDrawIndexed( commandBuffer, m_unIndexCount, GetInstanceCount(), m_geometryAllocation.firstIndex, (int32_t) m_geometryAllocation.firstVertex, 0 );
 		}
 		else
 		{
-			// Draw indexed - draw per mesh's material sections
-			for ( auto &section : materialSections )
+			// Draw indexed - draw per mesh's material sections (of each instance's level of detail)
+			DrawLods( commandBuffer, renderInfo, false );
+		}
+
+	}
+
+	void CRenderModel::DrawDepth( const VkCommandBuffer commandBuffer, const CRenderInfo &renderInfo ) 
+	{
+		// Only models with a separate position stream take part in the depth prepass, vertex shader skinned ones would leave their bind pose in it
+		if ( !m_bResident || !m_pPositionBuffer || !renderInfo.HasDepthPrepass() || IsSkinned( renderInfo ) )
+			return;
+
+		const bool bComputeSkinned = DrawsSkinnedCopies( renderInfo );
+		if ( bComputeSkinned && ( !HasSkinOffsets() || !HasSkinnedVertices() ) )
+			return;
+
+		vkCmdSetStencilReference( commandBuffer, VK_STENCIL_FACE_FRONT_AND_BACK, 1 );
+		vkCmdBindPipeline( commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderInfo.vecGraphicsPipelines[ renderInfo.depthPrepassPipelineIndex ] );
+
+		// Positions and instances only
+		if ( m_geometryAllocation.IsValid() )
+		{
+			m_pGeometryPool->Bind( commandBuffer, m_geometryAllocation, true );
+		}
+		else
+		{
+			vkCmdBindIndexBuffer( commandBuffer, GetIndexBuffer()->GetVkBuffer(), 0, m_vkIndexType );
+			if ( bComputeSkinned )
+				BindSkinnedVertices( commandBuffer, renderInfo, true );
+			else
+				vkCmdBindVertexBuffers( commandBuffer, 0, 1, m_pPositionBuffer->GetVkBufferPtr(), vertexOffsets );
+		}
+
+		vkCmdBindVertexBuffers( commandBuffer, 1, 1, GetInstanceBuffer()->GetVkBufferPtr(), instanceOffsets );
+
+		// Eye matrices come from the scene view buffer (lighting set)
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			renderInfo.vecPipelineLayouts[ renderInfo.depthPrepassLayoutIndex ],
+			1, 
+			1, 
+			&renderInfo.sceneLightingDescriptor,
+			0,
+			nullptr );
+
+		if ( materialSections.empty() )
+		{
+			vkCmdDrawIndexed( commandBuffer, m_unIndexCount, GetInstanceCount(), m_geometryAllocation.firstIndex, (int32_t) m_geometryAllocation.firstVertex, 0 );
+			return;
+		}
+
+		DrawLods( commandBuffer, renderInfo, true );
+	}
+
+	void CRenderModel::DrawLods( const VkCommandBuffer commandBuffer, const CRenderInfo &renderInfo, bool bDepthOnly ) 
+	{
+		const uint32_t unInstanceCount = GetInstanceCount();
+		if ( lods.empty() || m_vecInstanceLods.size() != unInstanceCount )
+		{
+			DrawSections( commandBuffer, renderInfo, materialSections, 0, unInstanceCount, bDepthOnly );
+			return;
+		}
+
+		uint32_t unRunStart = 0;
+		for ( uint32_t i = 1; i <= unInstanceCount; i++ )
+		{
+			if ( i < unInstanceCount && m_vecInstanceLods[ i ] == m_vecInstanceLods[ unRunStart ] )
+				continue;
+
+			DrawSections( commandBuffer, renderInfo, GetLodSections( m_vecInstanceLods[ unRunStart ] ), unRunStart, i - unRunStart, bDepthOnly );
+			unRunStart = i;
+		}
+	}
+
+	void CRenderModel::DrawSections( 
+		const VkCommandBuffer commandBuffer, 
+		const CRenderInfo &renderInfo, 
+		const std::vector< SMeshSection > &sections, 
+		uint32_t unFirstInstance, 
+		uint32_t unInstanceCount, 
+		bool bDepthOnly ) 
+	{
+		// Sections bound to a scene graph node draw from that node's range of instance matrices
+		const uint32_t unInstanceBinding = bDepthOnly ? 1 : vertexFormat.GetBindingCount();
+		const bool bNodeInstances = m_pNodeInstanceBuffer && !m_vecSlotNodes.empty() && m_vecNodeInstanceMatrices.size() == m_vecSlotNodes.size() * GetInstanceCount();
+		const bool bSkinned = !bDepthOnly && IsSkinned( renderInfo );
+		int32_t nBoundSlot = -1;
+		int32_t nBoundSkin = -1;
+
+		for ( size_t i = 0; i < sections.size(); i++ )
+		{
+			const SMeshSection &section = sections[ i ];
+			const SMaterial *pMaterial = section.materialIndex < materials.size() ? &materials[ section.materialIndex ] : nullptr;
+
+			const int32_t nSlot = bNodeInstances && section.node >= 0 && section.node < static_cast< int32_t >( m_vecNodeSlots.size() ) ? m_vecNodeSlots[ section.node ] : -1;
+			if ( nSlot != nBoundSlot )
 			{
-				if ( materials[ section.materialIndex ].descriptors.empty() )
-				{
-					vkCmdDrawIndexed( commandBuffer, section.indexCount, GetInstanceCount(), section.firstIndex, 0, 0 );
-					continue;
-				}
+				const VkDeviceSize unOffset = nSlot < 0 ? 0 : sizeof( XrMatrix4x4f ) * GetInstanceCount() * nSlot;
+				vkCmdBindVertexBuffers( commandBuffer, unInstanceBinding, 1, nSlot < 0 ? GetInstanceBuffer()->GetVkBufferPtr() : m_pNodeInstanceBuffer->GetVkBufferPtr(), &unOffset );
+				nBoundSlot = nSlot;
+			}
 
+			if ( bDepthOnly )
+			{
+				// Masked and blended sections would write depth where they are transparent
+				if ( pMaterial && pMaterial->getAlphaMode() != EAlphaMode::Opaque )
+					continue;
+			}
+			else if ( pMaterial && !pMaterial->descriptors.empty() )
+			{
 				vkCmdBindDescriptorSets(
 					commandBuffer,
 					VK_PIPELINE_BIND_POINT_GRAPHICS,
 					renderInfo.vecPipelineLayouts[ pipelineLayoutIndex ],
 					0, // Set 0 in fragment shader
-					materials[ section.materialIndex ].descriptors.size(),
-					materials[ section.materialIndex ].descriptors.data(),
+					pMaterial->descriptors.size(),
+					pMaterial->descriptors.data(),
 					0,
 					nullptr ); // dynamic offsets not supported
+			}
+
+			// Consecutive sections of a skin share its binding
+			if ( bSkinned )
+			{
+				const int32_t nSkin = section.skin >= 0 && section.skin < static_cast< int32_t >( skins.size() ) ? section.skin : 0;
+				if ( nSkin != nBoundSkin )
+				{
+					BindSkin( commandBuffer, renderInfo, nSkin );
+					nBoundSkin = nSkin;
+				}
+			}
+
+			// Lod sections line up with the material sections, so they share base vertices
+			vkCmdDrawIndexed( 
+				commandBuffer, 
+				section.indexCount, 
+				unInstanceCount, 
+				section.firstIndex + m_geometryAllocation.firstIndex, 
+				GetSectionBaseVertex( i ) + (int32_t) m_geometryAllocation.firstVertex, 
+				unFirstInstance );
+		}
+
+		// The next run of sections expects the model's own instance matrices
+		if ( nBoundSlot >= 0 )
+			vkCmdBindVertexBuffers( commandBuffer, unInstanceBinding, 1, GetInstanceBuffer()->GetVkBufferPtr(), instanceOffsets );
+	}
+
+	void CRenderModel::BindSkin( const VkCommandBuffer commandBuffer, const CRenderInfo &renderInfo, int32_t nSkin ) 
+	{
+		// Recorded draws stay valid as the relative offsets repeat, each swapchain image has its own region of the ring
+		const uint32_t unDynamicOffset = static_cast< uint32_t >( renderInfo.pJointMatrices->GetFrameOffset() ) + m_vecSkinOffsets[ nSkin ];
+
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			renderInfo.vecPipelineLayouts[ pipelineLayoutIndex ],
+			2, // set 2 in skinned vertex shaders
+			1,
+			&renderInfo.jointMatricesDescriptor,
+			1,
+			&unDynamicOffset );
+	}
+
+	bool CRenderModel::HasSkinOffsets() const 
+	{
+		if ( m_vecSkinOffsets.size() != skins.size() )
+			return false;
+
+		for ( uint32_t unOffset : m_vecSkinOffsets )
+		{
+			if ( unOffset == std::numeric_limits< uint32_t >::max() )
+				return false;
+		}
+
+		return true;
+	}
+
+	void CRenderModel::UpdateSkins( CRenderInfo &renderInfo ) 
+	{
+		const bool bComputeSkinned = IsComputeSkinned( renderInfo );
+		if ( !m_bResident || ( !IsSkinned( renderInfo ) && !bComputeSkinned ) )
+			return;
+
+		m_vecSkinOffsets.resize( skins.size(), std::numeric_limits< uint32_t >::max() );
+		for ( size_t i = 0; i < skins.size(); i++ )
+		{
+			// Skins without matrices yet are drawn in their bind pose, joints past what a draw can address are dropped
+			const SSkin &skin = skins[ i ];
+			const uint32_t unJointCount = std::clamp< uint32_t >( static_cast< uint32_t >( std::max( skin.matrices.size(), skin.joints.size() ) ), 1, k_unMaxSkinJoints );
+			const uint32_t unMatrixCount = std::min( unJointCount, static_cast< uint32_t >( skin.matrices.size() ) );
+
+			void *pData = nullptr;
+			const VkDeviceSize unOffset = renderInfo.pJointMatrices->Allocate( unJointCount * sizeof( XrMatrix4x4f ), &pData );
+
+			if ( unOffset != VK_WHOLE_SIZE )
+			{
+				XrMatrix4x4f *pMatrices = static_cast< XrMatrix4x4f * >( pData );
+				memcpy( pMatrices, skin.matrices.data(), unMatrixCount * sizeof( XrMatrix4x4f ) );
+
+				for ( uint32_t j = unMatrixCount; j < unJointCount; j++ )
+					XrMatrix4x4f_CreateIdentity( &pMatrices[ j ] );
+			}
+
+			// Offsets only move if skinned models were added, removed or resized - recorded draws need them re-recorded
+			const uint32_t unRelativeOffset = unOffset == VK_WHOLE_SIZE ? std::numeric_limits< uint32_t >::max() : static_cast< uint32_t >( unOffset );
+			if ( m_vecSkinOffsets[ i ] != unRelativeOffset )
+			{
+				m_vecSkinOffsets[ i ] = unRelativeOffset;
+				m_unDrawVersion++;
+			}
+		}
+
+		if ( !bComputeSkinned )
+			return;
+
+		// Morph only models with nothing to apply are drawn from their own vertices, until a weight changes
+		UpdateActiveMorphs( renderInfo );
+
+		const bool bIdle = skins.empty() && m_unActiveMorphCount == 0;
+		if ( m_bMorphsIdle != bIdle )
+		{
+			m_bMorphsIdle = bIdle;
+			m_unDrawVersion++;
+		}
+
+		if ( bIdle )
+			return;
+
+		// Room for this frame's skinned copies, in the model's own vertex format (interleaved vertices hold their positions)
+		const VkDeviceSize unAttributeOffset = renderInfo.pSkinnedVertices->Allocate( (VkDeviceSize) m_unVertexCount * vertexFormat.GetStride() );
+		const VkDeviceSize unPositionOffset = !vertexFormat.splitPositions || unAttributeOffset == VK_WHOLE_SIZE ? 
+			unAttributeOffset : renderInfo.pSkinnedVertices->Allocate( (VkDeviceSize) m_unVertexCount * sizeof( XrVector3f ) );
+
+		const bool bFull = unAttributeOffset == VK_WHOLE_SIZE || unPositionOffset == VK_WHOLE_SIZE;
+		const uint32_t unRelativeAttributeOffset = bFull ? std::numeric_limits< uint32_t >::max() : static_cast< uint32_t >( unAttributeOffset );
+		const uint32_t unRelativePositionOffset = bFull ? std::numeric_limits< uint32_t >::max() : static_cast< uint32_t >( unPositionOffset );
+
+		if ( m_unSkinnedAttributeOffset != unRelativeAttributeOffset || m_unSkinnedPositionOffset != unRelativePositionOffset )
+		{
+			m_unSkinnedAttributeOffset = unRelativeAttributeOffset;
+			m_unSkinnedPositionOffset = unRelativePositionOffset;
+			m_unDrawVersion++;
+		}
+	}
+
+	bool CRenderModel::IsComputeSkinned( const CRenderInfo &renderInfo ) const 
+	{
+		// Vertex shader skinning on top would skin twice
+		return computeSkinning && ( !skins.empty() || !morphTargets.empty() ) && renderInfo.HasComputeSkinning() && vertexFormat.layout == EVertexLayout::Full &&
+			!m_geometryAllocation.IsValid() && !renderInfo.IsSkinnedLayout( pipelineLayoutIndex );
+	}
+
+	bool CRenderModel::DispatchSkinning( const VkCommandBuffer commandBuffer, const CRenderInfo &renderInfo ) 
+	{
+		if ( !m_bResident || !m_pVertexBuffer || !DrawsSkinnedCopies( renderInfo ) || !HasSkinOffsets() || m_vecSkinDispatches.empty() )
+			return false;
+
+		if ( m_unSkinnedAttributeOffset == std::numeric_limits< uint32_t >::max() || !UpdateSkinningDescriptor( renderInfo ) )
+			return false;
+
+		const VkPipelineLayout vkLayout = renderInfo.vecPipelineLayouts[ renderInfo.skinningLayoutIndex ];
+		const uint32_t unVertexFrameOffset = static_cast< uint32_t >( renderInfo.pSkinnedVertices->GetFrameOffset() );
+		const uint32_t unJointFrameOffset = static_cast< uint32_t >( renderInfo.pJointMatrices->GetFrameOffset() );
+
+		SSkinningPushConstants constants;
+		constants.attributeStride = vertexFormat.GetStride() / sizeof( uint32_t );
+		constants.positionStride = vertexFormat.splitPositions ? k_unPositionSize / sizeof( uint32_t ) : constants.attributeStride;
+		constants.attributeShift = vertexFormat.splitPositions ? k_unPositionSize / sizeof( uint32_t ) : 0;
+		constants.morphTargetCount = m_unActiveMorphCount;
+
+		int64_t nBoundSkin = -1;
+		for ( const SSkinDispatch &dispatch : m_vecSkinDispatches )
+		{
+			// Skinned positions, skinned attributes, joint matrices of the run's skin (none for morph only models), active morph targets
+			if ( dispatch.skin != nBoundSkin )
+			{
+				const uint32_t unDynamicOffsets[ 4 ] = { 
+					unVertexFrameOffset + m_unSkinnedPositionOffset, 
+					unVertexFrameOffset + m_unSkinnedAttributeOffset, 
+					unJointFrameOffset + ( skins.empty() ? 0 : m_vecSkinOffsets[ dispatch.skin ] ),
+					unJointFrameOffset + m_unActiveMorphOffset };
+
+				vkCmdBindDescriptorSets( commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, vkLayout, 0, 1, &m_vkSkinningDescriptor, 4, unDynamicOffsets );
+				nBoundSkin = dispatch.skin;
+			}
+
+			constants.firstVertex = dispatch.firstVertex;
+			constants.vertexCount = dispatch.vertexCount;
+			vkCmdPushConstants( commandBuffer, vkLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( SSkinningPushConstants ), &constants );
+			vkCmdDispatch( commandBuffer, ( dispatch.vertexCount + k_unSkinningGroupSize - 1 ) / k_unSkinningGroupSize, 1, 1 );
+		}
+
+		return true;
+	}
+
+	bool CRenderModel::UpdateSkinningDescriptor( const CRenderInfo &renderInfo ) 
+	{
+		if ( m_vkSkinningDescriptor != VK_NULL_HANDLE && !m_bSkinningDescriptorDirty )
+			return true;
+
+		// Sets aren't returned to the pool, a model keeps its set through buffer re-inits
+		if ( m_vkSkinningDescriptor == VK_NULL_HANDLE )
+		{
+			std::vector< VkDescriptorSet > sets;
+			if ( renderInfo.pDescriptors->CreateDescriptorSets( sets, renderInfo.skinningLayoutId, renderInfo.skinningPoolId, 1 ) != VK_SUCCESS )
+			{
+				LogWarning( "", "Out of compute skinning descriptor sets (see CStereoRender::CreateComputePipeline_Skinning), model is drawn in its bind pose" );
+				computeSkinning = false;
+				m_unDrawVersion++;
+				return false;
+			}
+
+			m_vkSkinningDescriptor = sets[ 0 ];
+		}
+
+		// Interleaved vertices are read and written through both the position and the attribute bindings
+		const VkDeviceSize unAttributeBytes = (VkDeviceSize) m_unVertexCount * vertexFormat.GetStride();
+		const VkDeviceSize unPositionBytes = vertexFormat.splitPositions ? (VkDeviceSize) m_unVertexCount * sizeof( XrVector3f ) : unAttributeBytes;
+		const VkBuffer vkSkinnedVertices = renderInfo.pSkinnedVertices->GetBuffer()->GetVkBuffer();
+
+		std::vector< VkDescriptorSet > sets = { m_vkSkinningDescriptor };
+		renderInfo.pDescriptors->UpdateUniformBuffer( sets, 0, m_pPositionBuffer ? m_pPositionBuffer->GetVkBuffer() : m_pVertexBuffer->GetVkBuffer(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER );
+		renderInfo.pDescriptors->UpdateUniformBuffer( sets, 1, m_pVertexBuffer->GetVkBuffer(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER );
+		renderInfo.pDescriptors->UpdateUniformBuffer( sets, 2, vkSkinnedVertices, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 0, unPositionBytes );
+		renderInfo.pDescriptors->UpdateUniformBuffer( sets, 3, vkSkinnedVertices, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 0, unAttributeBytes );
+		renderInfo.pDescriptors->UpdateUniformBuffer( sets, 4, renderInfo.pJointMatrices->GetBuffer()->GetVkBuffer(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 0, renderInfo.pJointMatrices->GetBindRange() );
+
+		// Models without morph deltas never read them, any storage buffer keeps the set valid
+		renderInfo.pDescriptors->UpdateUniformBuffer( sets, 5, m_pMorphDeltaBuffer ? m_pMorphDeltaBuffer->GetVkBuffer() : m_pVertexBuffer->GetVkBuffer(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER );
+		renderInfo.pDescriptors->UpdateUniformBuffer( sets, 6, renderInfo.pJointMatrices->GetBuffer()->GetVkBuffer(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 0, renderInfo.pJointMatrices->GetBindRange() );
+
+		m_bSkinningDescriptorDirty = false;
+		return true;
+	}
+
+	void CRenderModel::BindSkinnedVertices( const VkCommandBuffer commandBuffer, const CRenderInfo &renderInfo, bool bPositionsOnly ) 
+	{
+		// Relative offsets repeat like the joint matrices', so recorded draws stay valid
+		const VkBuffer vkBuffer = renderInfo.pSkinnedVertices->GetBuffer()->GetVkBuffer();
+		const VkDeviceSize unFrameOffset = renderInfo.pSkinnedVertices->GetFrameOffset();
+
+		if ( vertexFormat.splitPositions )
+		{
+			const VkDeviceSize unOffset = unFrameOffset + m_unSkinnedPositionOffset;
+			vkCmdBindVertexBuffers( commandBuffer, 0, 1, &vkBuffer, &unOffset );
+		}
+
+		if ( !bPositionsOnly )
+		{
+			const VkDeviceSize unOffset = unFrameOffset + m_unSkinnedAttributeOffset;
+			vkCmdBindVertexBuffers( commandBuffer, vertexFormat.GetBindingCount() - 1, 1, &vkBuffer, &unOffset );
+		}
+	}
+
+	void CRenderModel::UpdateSkinDispatches() 
+	{
+		if ( !computeSkinning || ( skins.empty() && morphTargets.empty() ) )
+		{
+			m_vecSkinDispatches.clear();
+			return;
+		}
+
+		// Kept as they are once the cpu copy is dropped
+		if ( vertices.empty() )
+			return;
+
+		// Skin of each vertex, from the sections drawing it (lods index the same vertices)
+		std::vector< int32_t > vecVertexSkins( vertices.size(), -1 );
+		bool bConflict = false;
+
+		for ( const SMeshSection &section : materialSections )
+		{
+			const int32_t nSkin = section.skin >= 0 && section.skin < static_cast< int32_t >( skins.size() ) ? section.skin : 0;
+			const size_t unEnd = std::min< size_t >( (size_t) section.firstIndex + section.indexCount, indices.size() );
+
+			for ( size_t i = section.firstIndex; i < unEnd; i++ )
+			{
+				int32_t &nVertexSkin = vecVertexSkins[ indices[ i ] ];
+				bConflict |= nVertexSkin >= 0 && nVertexSkin != nSkin;
+
+				if ( nVertexSkin < 0 )
+					nVertexSkin = nSkin;
+			}
+		}
+
+		if ( bConflict )
+			LogWarning( "", "Vertices shared by sections of different skins are compute skinned with the first one" );
+
+		// Unused vertices join the run before them, a model without sections (or skins) is a single run
+		m_vecSkinDispatches.clear();
+		for ( uint32_t i = 0; i < static_cast< uint32_t >( vertices.size() ); i++ )
+		{
+			const uint32_t unSkin = vecVertexSkins[ i ] >= 0 ? static_cast< uint32_t >( vecVertexSkins[ i ] ) : ( m_vecSkinDispatches.empty() ? 0 : m_vecSkinDispatches.back().skin );
+
+			if ( !m_vecSkinDispatches.empty() && m_vecSkinDispatches.back().skin == unSkin )
+				m_vecSkinDispatches.back().vertexCount++;
+			else
+				m_vecSkinDispatches.push_back( { i, 1, unSkin } );
+		}
+	}
+
+	void CRenderModel::UpdateActiveMorphs( CRenderInfo &renderInfo ) 
+	{
+		m_unActiveMorphCount = 0;
+		m_unActiveMorphOffset = 0;
+		if ( !m_pMorphDeltaBuffer )
+			return;
+
+		// Idle targets cost nothing on the gpu, targets past what a dispatch can address are dropped
+		const uint32_t unTargetCount = static_cast< uint32_t >( std::min( morphTargets.size(), morphWeights.size() ) );
+		uint32_t unActiveCount = 0;
+		for ( uint32_t i = 0; i < unTargetCount; i++ )
+		{
+			if ( morphWeights[ i ] != 0.f && morphTargets[ i ].deltaCount > 0 )
+				unActiveCount++;
+		}
+
+		unActiveCount = std::min( unActiveCount, k_unMaxActiveMorphTargets );
+		if ( unActiveCount == 0 )
+			return;
+
+		// Dropped for this frame if the ring is full, the model keeps its base shape
+		void *pData = nullptr;
+		const VkDeviceSize unOffset = renderInfo.pJointMatrices->Allocate( unActiveCount * sizeof( SActiveMorphTarget ), &pData );
+		if ( unOffset == VK_WHOLE_SIZE )
+			return;
+
+		SActiveMorphTarget *pTargets = static_cast< SActiveMorphTarget * >( pData );
+		uint32_t unWritten = 0;
+		for ( uint32_t i = 0; i < unTargetCount && unWritten < unActiveCount; i++ )
+		{
+			const SMorphTarget &target = morphTargets[ i ];
+			if ( morphWeights[ i ] != 0.f && target.deltaCount > 0 )
+				pTargets[ unWritten++ ] = { target.firstDelta, target.deltaCount, morphWeights[ i ] };
+		}
+
+		m_unActiveMorphCount = unActiveCount;
+		m_unActiveMorphOffset = static_cast< uint32_t >( unOffset );
+	}
+
+	void CRenderModel::ResetMorphWeights() 
+	{
+		morphWeights.resize( morphTargets.size() );
+		for ( size_t i = 0; i < morphTargets.size(); i++ )
+			morphWeights[ i ] = morphTargets[ i ].defaultWeight;
+	}
+
+	bool CRenderModel::SetMorphWeight( const std::string &sName, float fWeight ) 
+	{
+		if ( morphWeights.size() != morphTargets.size() )
+			ResetMorphWeights();
+
+		bool bFound = false;
+		for ( size_t i = 0; i < morphTargets.size(); i++ )
+		{
+			if ( morphTargets[ i ].name == sName )
+			{
+				morphWeights[ i ] = fWeight;
+				bFound = true;
+			}
+		}
+
+		return bFound;
+	}
+
+	void CRenderModel::UpdateSceneGraph() 
+	{
+		sceneGraph.Update();
+
+		if ( m_vecNodeSlots.size() != sceneGraph.GetNodeCount() )
+			UpdateNodeSlots();
+
+		const size_t unInstanceCount = std::min( instances.size(), instanceMatrices.size() );
+		const size_t unMatrixCount = unInstanceCount * m_vecSlotNodes.size();
+		if ( unMatrixCount == 0 )
+		{
+			m_vecNodeInstanceMatrices.clear();
+			return;
+		}
+
+		if ( !m_pNodeInstanceBuffer || m_vecNodeInstanceMatrices.size() != unMatrixCount )
+		{
+			m_vecNodeInstanceMatrices.resize( unMatrixCount );
+
+			delete m_pNodeInstanceBuffer;
+			m_pNodeInstanceBuffer = new CDeviceBuffer( m_pSession );
+			VkResult result = InitBuffer( m_pNodeInstanceBuffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, sizeof( XrMatrix4x4f ) * unMatrixCount, nullptr );
+			assert( result == VK_SUCCESS );
+		}
+
+		// Model matrices are rebuilt every frame, so are their products with the node matrices
+		for ( size_t unSlot = 0; unSlot < m_vecSlotNodes.size(); unSlot++ )
+		{
+			const XrMatrix4x4f &nodeMatrix = sceneGraph.GetWorldMatrix( m_vecSlotNodes[ unSlot ] );
+			XrMatrix4x4f *pOut = m_vecNodeInstanceMatrices.data() + unSlot * unInstanceCount;
+
+			for ( size_t i = 0; i < unInstanceCount; i++ )
+				XrMatrix4x4f_Multiply( &pOut[ i ], &instanceMatrices[ i ], &nodeMatrix );
+		}
+	}
+
+	CDeviceBuffer *CRenderModel::UpdateInstancesBuffer( VkCommandBuffer transferCmdBuffer ) 
+	{
+		if ( !m_pNodeInstanceBuffer || m_vecNodeInstanceMatrices.empty() )
+			return CRenderable::UpdateInstancesBuffer( transferCmdBuffer );
+
+		// One staging buffer for both, the model matrices first
+		const VkDeviceSize unInstanceBytes = sizeof( XrMatrix4x4f ) * instanceMatrices.size();
+		const VkDeviceSize unNodeBytes = sizeof( XrMatrix4x4f ) * m_vecNodeInstanceMatrices.size();
+
+		CDeviceBuffer *pStagingBuffer = new CDeviceBuffer( m_pSession );
+		pStagingBuffer->Init( VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, unInstanceBytes + unNodeBytes );
+		pStagingBuffer->Upload( instanceMatrices.data(), unInstanceBytes, 0 );
+		pStagingBuffer->Upload( m_vecNodeInstanceMatrices.data(), unNodeBytes, unInstanceBytes );
+
+		VkBufferCopy instanceCopyRegion = { 0, 0, unInstanceBytes };
+		vkCmdCopyBuffer( transferCmdBuffer, pStagingBuffer->GetVkBuffer(), m_pInstanceBuffer->GetVkBuffer(), 1, &instanceCopyRegion );
+
+		VkBufferCopy nodeCopyRegion = { unInstanceBytes, 0, unNodeBytes };
+		vkCmdCopyBuffer( transferCmdBuffer, pStagingBuffer->GetVkBuffer(), m_pNodeInstanceBuffer->GetVkBuffer(), 1, &nodeCopyRegion );
+
+		return pStagingBuffer;
+	}
+
+	void CRenderModel::UpdateNodeSlots() 
+	{
+		m_vecNodeSlots.assign( sceneGraph.GetNodeCount(), -1 );
+		m_vecSlotNodes.clear();
+
+		// Lod sections share the node of the material section they simplify
+		for ( const SMeshSection &section : materialSections )
+		{
+			if ( section.node < 0 || section.node >= static_cast< int32_t >( m_vecNodeSlots.size() ) || m_vecNodeSlots[ section.node ] >= 0 )
+				continue;
+
+			m_vecNodeSlots[ section.node ] = static_cast< int32_t >( m_vecSlotNodes.size() );
+			m_vecSlotNodes.push_back( static_cast< uint32_t >( section.node ) );
+		}
+
+		// Sized and filled by the next UpdateSceneGraph()
+		m_vecNodeInstanceMatrices.clear();
+		m_unDrawVersion++;
+	}
+
+	void CRenderModel::UpdateLods( const CRenderInfo &renderInfo ) 
+	{
+		if ( lods.empty() || m_fBoundsRadius <= 0.f || instanceMatrices.size() < GetInstanceCount() )
+			return;
+
+		m_vecInstanceLods.resize( GetInstanceCount(), 0 );
+
+		bool bChanged = false;
+		for ( uint32_t i = 0; i < GetInstanceCount(); i++ )
+		{
+			XrVector3f worldCenter;
+			XrMatrix4x4f_TransformVector3f( &worldCenter, &instanceMatrices[ i ], &m_boundsCenter );
+
+			const XrVector3f &scale = instances[ i ].scale;
+			const float fRadius = m_fBoundsRadius * std::max( { fabsf( scale.x ), fabsf( scale.y ), fabsf( scale.z ) } );
+
+			// Largest projected size (fraction of the view height) in either eye
+			float fScreenSize = 0.f;
+			for ( uint32_t eye = 0; eye < 2; eye++ )
+			{
+				XrVector3f viewCenter;
+				XrMatrix4x4f_TransformVector3f( &viewCenter, &renderInfo.state.eyeViewMatrices[ eye ], &worldCenter );
+
+				const float fDepth = -viewCenter.z;
+				if ( fDepth < -fRadius )
+					continue; // behind the eye
+
+				if ( fDepth <= fRadius )
+				{
+					fScreenSize = FLT_MAX;
+					break;
+				}
 
-				vkCmdDrawIndexed( commandBuffer, section.indexCount, GetInstanceCount(), section.firstIndex, 0, 0 );
+				fScreenSize = std::max( fScreenSize, fRadius * fabsf( renderInfo.state.eyeProjectionMatrices[ eye ].m[ 5 ] ) / fDepth );
 			}
+
+			const uint8_t unLod = static_cast< uint8_t >( SelectLod( fScreenSize, m_vecInstanceLods[ i ] ) );
+			bChanged |= unLod != m_vecInstanceLods[ i ];
+			m_vecInstanceLods[ i ] = unLod;
+		}
+
+		// Cached draw commands have to be re-recorded with the new index ranges
+		if ( bChanged )
+			m_unDrawVersion++;
+	}
+
+	uint32_t CRenderModel::SelectLod( float fScreenSize, uint32_t unCurrentLod ) 
+	{
+		const uint32_t unLodCount = static_cast< uint32_t >( lods.size() );
+		unCurrentLod = std::min( unCurrentLod, unLodCount );
+
+		// lods[ n ] (lod n + 1) is used below its screen size
+		uint32_t unLod = 0;
+		while ( unLod < unLodCount && fScreenSize < lods[ unLod ].screenSize )
+			unLod++;
+
+		// Only move past a threshold once the size is clearly beyond it
+		if ( unLod > unCurrentLod )
+		{
+			while ( unLod > unCurrentLod && fScreenSize >= lods[ unLod - 1 ].screenSize * ( 1.f - lodHysteresis ) )
+				unLod--;
+		}
+		else if ( unLod < unCurrentLod )
+		{
+			while ( unLod < unCurrentLod && fScreenSize <= lods[ unLod ].screenSize * ( 1.f + lodHysteresis ) )
+				unLod++;
 		}
 
+		return unLod;
 	}
 
 	uint32_t CRenderModel::LoadMaterial( CRenderInfo *pRenderInfo, uint32_t layoutId, uint32_t poolId, CTextureManager *pTextureManager ) 
@@ -179,14 +1195,15 @@ namespace xrlib
 			sizeof( SMaterialUBO ) );
 
 		assert( pFragmentDescriptorsBuffer );
+		m_unMaterialPoolId = poolId;
 
 		for ( auto &material : materials )
 		{
 			// Create descriptor sets for material UBO
 			pRenderInfo->pDescriptors->CreateDescriptorSets(
 				material.descriptors,
-				poolId,
 				layoutId,
+				poolId,
 				1 // Number of sets
 			);
 
@@ -289,6 +1306,7 @@ namespace xrlib
 		pFragmentDescriptorsBuffer = pRenderInfo->pDescriptors->CreateBuffer( VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, sizeof( SMaterialUBO ) );
 
 		assert( pFragmentDescriptorsBuffer );
+		m_unMaterialPoolId = poolId;
 
 		uint32_t unMaterialCount = 0;
 		for ( auto &material : materials )
@@ -296,8 +1314,8 @@ namespace xrlib
 			// Create descriptor sets for material UBO
 			pRenderInfo->pDescriptors->CreateDescriptorSets(
 				material.descriptors,
-				poolId,
 				layoutId,
+				poolId,
 				1 // Number of sets
 			);
 
@@ -367,6 +1385,682 @@ namespace xrlib
 	}
 
 
+	bool CRenderModel::FreeMaterialDescriptors( CDescriptorManager *pDescriptors )
+	{
+		// Sets of shared models belong to their source
+		assert( pDescriptors && !IsShared() );
+
+		bool bFreed = true;
+		for ( auto &material : materials )
+		{
+			if ( !material.descriptors.empty() && !pDescriptors->FreeDescriptorSets( m_unMaterialPoolId, material.descriptors ) )
+				bFreed = false;
+		}
+
+		return bFreed;
+	}
+
+	VkDeviceSize CRenderModel::GetResidentBytes()
+	{
+		VkDeviceSize unBytes = 0;
+
+		if ( m_geometryAllocation.IsValid() )
+		{
+			unBytes += m_pGeometryPool->GetAllocationBytes( m_geometryAllocation );
+		}
+		else
+		{
+			if ( m_pPositionBuffer && m_pPositionBuffer->GetAllocation() )
+				unBytes += m_pPositionBuffer->GetAllocation()->size;
+
+			if ( m_pVertexBuffer && m_pVertexBuffer->GetAllocation() )
+				unBytes += m_pVertexBuffer->GetAllocation()->size;
+
+			if ( m_pIndexBuffer && m_pIndexBuffer->GetAllocation() )
+				unBytes += m_pIndexBuffer->GetAllocation()->size;
+
+			if ( m_pMorphDeltaBuffer && m_pMorphDeltaBuffer->GetAllocation() )
+				unBytes += m_pMorphDeltaBuffer->GetAllocation()->size;
+		}
+
+		for ( auto &texture : textures )
+		{
+			if ( texture.allocation )
+				unBytes += texture.allocation->size;
+		}
+
+		return unBytes;
+	}
+
+	void CRenderModel::Evict( CDescriptorManager *pDescriptors, const STexture &placeholder )
+	{
+		if ( !IsEvictable() )
+			return;
+
+		m_bResident = false;
+		m_unDrawVersion++;
+
+		// Callers only evict models that haven't been drawn for longer than the frames in flight, so nothing on the gpu references these
+		VkDevice vkDevice = m_pSession->GetVulkan()->GetVkLogicalDevice();
+
+		// Point material textures to the placeholder before the image views go away
+		for ( auto &material : materials )
+		{
+			if ( !material.descriptors.empty() )
+				UpdateMaterialTextures( pDescriptors, material, &placeholder );
+		}
+
+		// Geometry
+		ReleaseGeometry();
+
+		// Textures - sampler and cpu data are kept for the restore
+		for ( auto &texture : textures )
+		{
+			if ( texture.data.empty() )
+				continue;
+
+			if ( texture.view != VK_NULL_HANDLE )
+			{
+				vkDestroyImageView( vkDevice, texture.view, nullptr );
+				texture.view = VK_NULL_HANDLE;
+			}
+
+			if ( texture.image != VK_NULL_HANDLE )
+			{
+				CUploadManager::Get( m_pSession )->ReleaseImage( texture.image );
+				vkDestroyImage( vkDevice, texture.image, nullptr );
+				texture.image = VK_NULL_HANDLE;
+			}
+
+			if ( texture.allocation )
+			{
+				CDeviceMemoryAllocator::Get( m_pSession )->Free( texture.allocation );
+				texture.allocation = nullptr;
+			}
+		}
+	}
+
+	VkResult CRenderModel::Restore( CDescriptorManager *pDescriptors )
+	{
+		if ( m_bResident || IsRestoring() )
+			return VK_SUCCESS;
+
+		VkDevice vkDevice = m_pSession->GetVulkan()->GetVkLogicalDevice();
+
+		// Geometry
+		VK_CHECK_RETURN( InitGeometry() );
+
+		// Textures
+		for ( auto &texture : textures )
+		{
+			if ( texture.data.empty() || texture.image != VK_NULL_HANDLE )
+				continue;
+
+			VK_CHECK_RETURN( vkutils::CreateImage(
+				texture.image,
+				texture.allocation,
+				vkDevice,
+				m_pSession->GetVulkan()->GetVkPhysicalDevice(),
+				texture.width,
+				texture.height,
+				texture.format,
+				VK_IMAGE_TILING_OPTIMAL,
+				VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT ) );
+
+			VK_CHECK_RETURN( vkutils::CreateImageView( texture.view, vkDevice, texture.image, texture.format, VK_IMAGE_ASPECT_COLOR_BIT ) );
+
+			CUploadManager::Get( m_pSession )->UploadImage( texture.image, texture.data.data(), texture.data.size(), texture.width, texture.height );
+		}
+
+		// Not drawn until the model is resident, so the sets aren't in use
+		for ( auto &material : materials )
+		{
+			if ( !material.descriptors.empty() )
+				UpdateMaterialTextures( pDescriptors, material );
+		}
+
+		// Everything above is in the open batch (or earlier ones), which retire in order
+		m_restoreFuture = CUploadManager::Get( m_pSession )->Submit();
+		return VK_SUCCESS;
+	}
+
+	bool CRenderModel::PollRestore()
+	{
+		if ( !IsRestoring() || m_restoreFuture.wait_for( std::chrono::seconds( 0 ) ) != std::future_status::ready )
+			return false;
+
+		m_restoreFuture = {};
+		m_bResident = true;
+		m_unDrawVersion++;
+		return true;
+	}
+
+	void CRenderModel::UpdateMaterialTextures( CDescriptorManager *pDescriptors, SMaterial &material, const STexture *pPlaceholder )
+	{
+		// Bindings should match the texture bindings in the pbr fragment shader
+		const int textureIndices[ 5 ] = { material.baseColorTexture, material.metallicRoughnessTexture, material.normalTexture, material.emissiveTexture, material.occlusionTexture };
+
+		for ( uint32_t i = 0; i < 5; i++ )
+		{
+			if ( textureIndices[ i ] < 0 )
+				continue;
+
+			const STexture &texture = pPlaceholder ? *pPlaceholder : textures[ textureIndices[ i ] ];
+			pDescriptors->UpdateImageDescriptor( material.descriptors, i + 1, texture.view, texture.sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL );
+		}
+	}
+
+	VkResult CRenderModel::InitVertexBuffer()
+	{
+		if ( m_pVertexBuffer )
+			delete m_pVertexBuffer;
+
+		if ( m_pPositionBuffer )
+		{
+			delete m_pPositionBuffer;
+			m_pPositionBuffer = nullptr;
+		}
+
+		if ( m_pMorphDeltaBuffer )
+		{
+			delete m_pMorphDeltaBuffer;
+			m_pMorphDeltaBuffer = nullptr;
+		}
+
+		m_pVertexBuffer = new CDeviceBuffer( m_pSession );
+		m_unVertexCount = static_cast< uint32_t >( vertices.size() );
+		m_bSkinningDescriptorDirty = true;
+
+		// Sparse morph deltas, only compute skinning applies them
+		if ( computeSkinning && !morphDeltas.empty() )
+		{
+			m_pMorphDeltaBuffer = new CDeviceBuffer( m_pSession );
+			VK_CHECK_RETURN( InitBuffer( m_pMorphDeltaBuffer, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, sizeof( SMorphDelta ) * morphDeltas.size(), morphDeltas.data() ) );
+		}
+
+		// Compute skinning reads the bind pose from storage buffers
+		const VkBufferUsageFlags usageFlags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | ( computeSkinning ? VK_BUFFER_USAGE_STORAGE_BUFFER_BIT : 0 );
+
+		if ( vertexFormat.layout == EVertexLayout::Full && !vertexFormat.splitPositions )
+			return InitBuffer( m_pVertexBuffer, usageFlags, sizeof( SMeshVertex ) * vertices.size(), vertices.data() );
+
+		// Packed copies only live until the data is in staging memory
+		if ( vertexFormat.splitPositions )
+		{
+			std::vector< XrVector3f > vecPositions;
+			vertexFormat.PackPositions( vecPositions, vertices );
+
+			m_pPositionBuffer = new CDeviceBuffer( m_pSession );
+			VK_CHECK_RETURN( InitBuffer( m_pPositionBuffer, usageFlags, sizeof( XrVector3f ) * vecPositions.size(), vecPositions.data() ) );
+		}
+
+		std::vector< uint8_t > vecPacked;
+		vertexFormat.Pack( vecPacked, vertices );
+		return InitBuffer( m_pVertexBuffer, usageFlags, vecPacked.size(), vecPacked.data() );
+	}
+
+	VkResult CRenderModel::InitGeometry()
+	{
+		// Pooled or shared geometry is replaced as a whole
+		if ( m_pSharedSource || m_geometryAllocation.IsValid() )
+			ReleaseGeometry();
+
+		// Compact joints are uint8, skins with more joints than that keep the full layout
+		if ( vertexFormat.layout == EVertexLayout::Compact && ( vertexFormat.optionalAttributes & VERTEX_SKIN_BIT ) )
+		{
+			size_t unMaxJointCount = 0;
+			for ( auto &skin : skins )
+				unMaxJointCount = std::max( unMaxJointCount, skin.joints.size() );
+
+			if ( unMaxJointCount > size_t( std::numeric_limits< uint8_t >::max() ) + 1 )
+			{
+				LogWarning( "", "Skin with %i joints does not fit the compact vertex layout, the model uses the full layout (its pipeline must match vertexFormat)", (int) unMaxJointCount );
+				vertexFormat.layout = EVertexLayout::Full;
+			}
+		}
+
+		// Compute skinned models read their vertices from buffers of their own
+		if ( geometryPool && !computeSkinning && !vertices.empty() && !indices.empty() )
+			return InitPooledGeometry();
+
+		if ( !vertices.empty() )
+			VK_CHECK_RETURN( InitVertexBuffer() );
+
+		if ( !indices.empty() )
+			VK_CHECK_RETURN( InitIndexBuffer() );
+
+		return VK_SUCCESS;
+	}
+
+	VkResult CRenderModel::InitPooledGeometry()
+	{
+		ReleaseGeometry();
+
+		m_unIndexCount = static_cast< uint32_t >( indices.size() );
+		m_unVertexCount = static_cast< uint32_t >( vertices.size() );
+		m_vkIndexType = VK_INDEX_TYPE_UINT32;
+		m_vecSectionBaseVertices.clear();
+
+		// Index values are relative to the allocation's first vertex, which the draws pass as vertex offset
+		std::vector< uint16_t > vecIndices16;
+		std::vector< int32_t > vecBaseVertices;
+		if ( allowIndex16 && PackIndices16( vecIndices16, vecBaseVertices ) )
+		{
+			m_vkIndexType = VK_INDEX_TYPE_UINT16;
+			m_vecSectionBaseVertices = std::move( vecBaseVertices );
+		}
+
+		// Packed copies only live until the data is in staging memory
+		std::vector< uint8_t > vecPacked;
+		std::vector< XrVector3f > vecPositions;
+		const void *pVertexData = vertices.data();
+
+		if ( vertexFormat.layout != EVertexLayout::Full || vertexFormat.splitPositions )
+		{
+			vertexFormat.Pack( vecPacked, vertices );
+			pVertexData = vecPacked.data();
+		}
+
+		if ( vertexFormat.splitPositions )
+			vertexFormat.PackPositions( vecPositions, vertices );
+
+		VK_CHECK_RETURN( geometryPool->Allocate(
+			m_geometryAllocation,
+			vertexFormat.GetStride(),
+			vertexFormat.splitPositions,
+			pVertexData,
+			vecPositions.data(),
+			static_cast< uint32_t >( vertices.size() ),
+			m_vkIndexType,
+			m_vkIndexType == VK_INDEX_TYPE_UINT16 ? static_cast< const void * >( vecIndices16.data() ) : static_cast< const void * >( indices.data() ),
+			m_unIndexCount ) );
+
+		// Arena buffers, owned by the pool
+		m_pGeometryPool = geometryPool;
+		m_pVertexBuffer = m_pGeometryPool->GetVertexBuffer( m_geometryAllocation );
+		m_pPositionBuffer = m_pGeometryPool->GetPositionBuffer( m_geometryAllocation );
+		m_pIndexBuffer = m_pGeometryPool->GetIndexBuffer( m_geometryAllocation );
+
+		m_unDrawVersion++;
+		return VK_SUCCESS;
+	}
+
+	void CRenderModel::ReleaseGeometry()
+	{
+		// Shared geometry belongs to its source, pool ranges are reused once frames in flight are done with them
+		if ( !m_pSharedSource )
+		{
+			if ( m_geometryAllocation.IsValid() )
+			{
+				m_pGeometryPool->Free( m_geometryAllocation );
+			}
+			else
+			{
+				delete m_pPositionBuffer;
+				delete m_pVertexBuffer;
+				delete m_pIndexBuffer;
+			}
+
+			delete m_pMorphDeltaBuffer;
+		}
+
+		m_pSharedSource = nullptr;
+		m_pGeometryPool = nullptr;
+		m_geometryAllocation = {};
+
+		m_pPositionBuffer = nullptr;
+		m_pVertexBuffer = nullptr;
+		m_pIndexBuffer = nullptr;
+		m_pMorphDeltaBuffer = nullptr;
+		m_unVertexCount = 0;
+		m_bSkinningDescriptorDirty = true;
+
+		m_unDrawVersion++;
+	}
+
+	VkResult CRenderModel::InitIndexBuffer()
+	{
+		if ( m_pIndexBuffer )
+			delete m_pIndexBuffer;
+
+		m_pIndexBuffer = new CDeviceBuffer( m_pSession );
+		m_unIndexCount = static_cast< uint32_t >( indices.size() );
+		m_vkIndexType = VK_INDEX_TYPE_UINT32;
+		m_vecSectionBaseVertices.clear();
+
+		std::vector< uint16_t > vecIndices16;
+		std::vector< int32_t > vecBaseVertices;
+
+		if ( !allowIndex16 || !PackIndices16( vecIndices16, vecBaseVertices ) )
+			return InitBuffer( m_pIndexBuffer, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, sizeof( uint32_t ) * indices.size(), indices.data() );
+
+		m_vkIndexType = VK_INDEX_TYPE_UINT16;
+		m_vecSectionBaseVertices = std::move( vecBaseVertices );
+		return InitBuffer( m_pIndexBuffer, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, sizeof( uint16_t ) * vecIndices16.size(), vecIndices16.data() );
+	}
+
+	bool CRenderModel::PackIndices16( std::vector< uint16_t > &outIndices16, std::vector< int32_t > &outBaseVertices )
+	{
+		if ( indices.empty() )
+			return false;
+
+		// 0xFFFF is left out as it is the restart index if primitive restart is ever enabled
+		constexpr uint32_t unMaxIndex16 = std::numeric_limits< uint16_t >::max() - 1;
+
+		outIndices16.clear();
+		outBaseVertices.clear();
+
+		if ( *std::max_element( indices.begin(), indices.end() ) <= unMaxIndex16 )
+		{
+			outIndices16.resize( indices.size() );
+			for ( size_t i = 0; i < indices.size(); i++ )
+				outIndices16[ i ] = static_cast< uint16_t >( indices[ i ] );
+		}
+		else if ( !materialSections.empty() )
+		{
+			// Only sections are drawn, each one offsets its indices by its lowest vertex (vertexOffset of the draw).
+			// Lod sections use the base vertex of the material section they simplify.
+			outIndices16.resize( indices.size(), 0 );
+			std::vector< uint8_t > vecWritten( indices.size(), 0 );
+
+			auto fnPack = [ & ]( const SMeshSection &section, uint32_t unBase )
+			{
+				if ( section.indexCount == 0 )
+					return true;
+
+				if ( section.firstIndex + section.indexCount > indices.size() )
+					return false;
+
+				auto itBegin = indices.begin() + section.firstIndex;
+				auto minMax = std::minmax_element( itBegin, itBegin + section.indexCount );
+				if ( *minMax.first < unBase || *minMax.second - unBase > unMaxIndex16 )
+					return false;
+
+				// Overlapping sections must agree on the values they share
+				bool bConflict = false;
+				for ( uint32_t i = section.firstIndex; i < section.firstIndex + section.indexCount; i++ )
+				{
+					const uint16_t unIndex = static_cast< uint16_t >( indices[ i ] - unBase );
+					bConflict |= vecWritten[ i ] && outIndices16[ i ] != unIndex;
+
+					outIndices16[ i ] = unIndex;
+					vecWritten[ i ] = 1;
+				}
+
+				return !bConflict;
+			};
+
+			bool bFits = true;
+			outBaseVertices.reserve( materialSections.size() );
+			for ( auto &section : materialSections )
+			{
+				const bool bValid = section.indexCount > 0 && section.firstIndex + section.indexCount <= indices.size();
+				const uint32_t unBase = bValid ? *std::min_element( indices.begin() + section.firstIndex, indices.begin() + section.firstIndex + section.indexCount ) : 0;
+
+				outBaseVertices.push_back( static_cast< int32_t >( unBase ) );
+				bFits = bFits && fnPack( section, unBase );
+			}
+
+			for ( auto &lod : lods )
+			{
+				for ( size_t i = 0; i < lod.sections.size() && bFits; i++ )
+					bFits = i < outBaseVertices.size() && fnPack( lod.sections[ i ], static_cast< uint32_t >( outBaseVertices[ i ] ) );
+			}
+
+			if ( !bFits )
+			{
+				outIndices16.clear();
+				outBaseVertices.clear();
+			}
+		}
+
+		return !outIndices16.empty();
+	}
+
+	void CRenderModel::UpdateBounds() 
+	{
+		if ( vertices.empty() )
+			return;
+
+		XrVector3f minPos = vertices[ 0 ].position;
+		XrVector3f maxPos = vertices[ 0 ].position;
+		for ( auto &vertex : vertices )
+		{
+			minPos = { std::min( minPos.x, vertex.position.x ), std::min( minPos.y, vertex.position.y ), std::min( minPos.z, vertex.position.z ) };
+			maxPos = { std::max( maxPos.x, vertex.position.x ), std::max( maxPos.y, vertex.position.y ), std::max( maxPos.z, vertex.position.z ) };
+		}
+
+		m_boundsCenter = { ( minPos.x + maxPos.x ) * 0.5f, ( minPos.y + maxPos.y ) * 0.5f, ( minPos.z + maxPos.z ) * 0.5f };
+
+		float fRadiusSquared = 0.f;
+		for ( auto &vertex : vertices )
+		{
+			const XrVector3f offset { vertex.position.x - m_boundsCenter.x, vertex.position.y - m_boundsCenter.y, vertex.position.z - m_boundsCenter.z };
+			fRadiusSquared = std::max( fRadiusSquared, offset.x * offset.x + offset.y * offset.y + offset.z * offset.z );
+		}
+
+		m_fBoundsRadius = sqrtf( fRadiusSquared );
+	}
+
+	uint32_t CRenderModel::GetUsedVertexAttributes()
+	{
+		uint32_t unAttributes = 0;
+
+		for ( auto &vertex : vertices )
+		{
+			if ( vertex.uv1.x != 0.f || vertex.uv1.y != 0.f )
+				unAttributes |= VERTEX_UV1_BIT;
+
+			if ( vertex.color0.x != 1.f || vertex.color0.y != 1.f || vertex.color0.z != 1.f )
+				unAttributes |= VERTEX_COLOR0_BIT;
+
+			if ( vertex.weights[ 0 ] != 0.f || vertex.weights[ 1 ] != 0.f || vertex.weights[ 2 ] != 0.f || vertex.weights[ 3 ] != 0.f )
+				unAttributes |= VERTEX_SKIN_BIT;
+
+			if ( unAttributes == VERTEX_OPTIONAL_ATTRIBUTES_MASK )
+				break;
+		}
+
+		return unAttributes;
+	}
+
+	void CRenderModel::ShareFrom( const CRenderModel &source )
+	{
+		assert( &source != this );
+
+		// Own geometry (if any) is replaced by the source's
+		ReleaseGeometry();
+		Reset();
+
+		m_pSharedSource = &source;
+		m_pPositionBuffer = source.m_pPositionBuffer;
+		m_pVertexBuffer = source.m_pVertexBuffer;
+		m_pIndexBuffer = source.m_pIndexBuffer;
+		m_pMorphDeltaBuffer = source.m_pMorphDeltaBuffer;
+		m_pGeometryPool = source.m_pGeometryPool;
+		m_geometryAllocation = source.m_geometryAllocation;
+
+		vertexFormat = source.vertexFormat;
+		allowIndex16 = source.allowIndex16;
+		computeSkinning = source.computeSkinning;
+		m_vkIndexType = source.m_vkIndexType;
+		m_unIndexCount = source.m_unIndexCount;
+		m_unVertexCount = source.m_unVertexCount;
+		m_vecSectionBaseVertices = source.m_vecSectionBaseVertices;
+		m_vecSkinDispatches = source.m_vecSkinDispatches;
+
+		m_boundsCenter = source.m_boundsCenter;
+		m_fBoundsRadius = source.m_fBoundsRadius;
+		m_vecInstanceLods.clear();
+
+		// Handles only - views, samplers and descriptor sets are the source's
+		textures = source.textures;
+		materials = source.materials;
+		skins = source.skins;
+		materialSections = source.materialSections;
+		lods = source.lods;
+		lodHysteresis = source.lodHysteresis;
+		morphTargets = source.morphTargets;
+		morphWeights = source.morphWeights;
+
+		// Each sharing model moves its own nodes
+		sceneGraph = source.sceneGraph;
+		animations = source.animations;
+		UpdateNodeSlots();
+
+		m_bResident = true;
+		m_unDrawVersion++;
+
+		// Per model instance data
+		if ( !m_pInstanceBuffer && !instanceMatrices.empty() )
+		{
+			m_pInstanceBuffer = new CDeviceBuffer( m_pSession );
+			VkResult result = InitBuffer( m_pInstanceBuffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, sizeof( XrMatrix4x4f ) * instanceMatrices.size(), instanceMatrices.data() );
+			assert( result == VK_SUCCESS );
+		}
+	}
+
+	void CRenderModel::ShareTexturesFrom( CRenderModel &source )
+	{
+		assert( &source != this );
+
+		if ( !source.m_pTextureOwnership )
+			source.m_pTextureOwnership = std::make_shared< bool >( true );
+
+		m_pTextureOwnership = source.m_pTextureOwnership;
+		m_bBorrowedTextures = true;
+
+		textures.reserve( textures.size() + source.textures.size() );
+		for ( STexture &texture : source.textures )
+		{
+			std::vector< uint8_t > vecData = std::move( texture.data );
+			textures.push_back( texture );
+			texture.data = std::move( vecData );
+		}
+	}
+
+	void CRenderModel::TakeFrom( CRenderModel &source, SReplacedMaterials &outReplaced )
+	{
+		assert( &source != this );
+
+		// Own textures and material sets (e.g. of a textured proxy) are handed back, shared ones stay with the model that owns them
+		outReplaced = {};
+		if ( !IsShared() )
+		{
+			if ( !m_bBorrowedTextures && !HasTextureDependents() )
+				outReplaced.textures = std::move( textures );
+			else if ( !m_bBorrowedTextures && !textures.empty() )
+				LogWarning( "", "Replaced textures are still used by models sharing them and are left alive" );
+
+			for ( SMaterial &material : materials )
+				outReplaced.descriptorSets.insert( outReplaced.descriptorSets.end(), material.descriptors.begin(), material.descriptors.end() );
+
+			outReplaced.descriptorPoolId = m_unMaterialPoolId;
+		}
+
+		outReplaced.pMaterialBuffer = pFragmentDescriptorsBuffer;
+		pFragmentDescriptorsBuffer = nullptr;
+		m_unMaterialPoolId = std::numeric_limits< uint32_t >::max();
+		m_bBorrowedTextures = false;
+
+		ReleaseGeometry();
+
+		m_pSharedSource = source.m_pSharedSource;
+		m_pPositionBuffer = source.m_pPositionBuffer;
+		m_pVertexBuffer = source.m_pVertexBuffer;
+		m_pIndexBuffer = source.m_pIndexBuffer;
+		m_pMorphDeltaBuffer = source.m_pMorphDeltaBuffer;
+		m_pGeometryPool = source.m_pGeometryPool;
+		m_geometryAllocation = source.m_geometryAllocation;
+
+		vertexFormat = source.vertexFormat;
+		allowIndex16 = source.allowIndex16;
+		geometryPool = source.geometryPool;
+		computeSkinning = source.computeSkinning;
+		m_vkIndexType = source.m_vkIndexType;
+		m_unIndexCount = source.m_unIndexCount;
+		m_unVertexCount = source.m_unVertexCount;
+		m_vecSectionBaseVertices = std::move( source.m_vecSectionBaseVertices );
+		m_vecSkinDispatches = std::move( source.m_vecSkinDispatches );
+
+		m_boundsCenter = source.m_boundsCenter;
+		m_fBoundsRadius = source.m_fBoundsRadius;
+		m_vecInstanceLods.clear();
+
+		vertices = std::move( source.vertices );
+		indices = std::move( source.indices );
+		textures = std::move( source.textures );
+		m_pTextureOwnership = std::move( source.m_pTextureOwnership );
+		materials = std::move( source.materials );
+		skins = std::move( source.skins );
+		materialSections = std::move( source.materialSections );
+		lods = std::move( source.lods );
+		sceneGraph = std::move( source.sceneGraph );
+		animations = std::move( source.animations );
+		morphTargets = std::move( source.morphTargets );
+		morphDeltas = std::move( source.morphDeltas );
+		morphWeights = std::move( source.morphWeights );
+		UpdateNodeSlots();
+
+		m_bResident = source.m_bResident;
+		m_unDrawVersion++;
+
+		// Source no longer owns anything
+		source.m_pSharedSource = nullptr;
+		source.m_pPositionBuffer = nullptr;
+		source.m_pVertexBuffer = nullptr;
+		source.m_pIndexBuffer = nullptr;
+		source.m_pMorphDeltaBuffer = nullptr;
+		source.m_pGeometryPool = nullptr;
+		source.m_geometryAllocation = {};
+		source.m_unIndexCount = 0;
+		source.m_unVertexCount = 0;
+		source.Reset();
+		source.textures.clear();
+		source.materials.clear();
+		source.skins.clear();
+		source.materialSections.clear();
+		source.lods.clear();
+		source.sceneGraph.Clear();
+		source.animations.clear();
+		source.morphTargets.clear();
+		source.morphWeights.clear();
+		source.UpdateNodeSlots();
+
+		// Per model instance data
+		if ( !m_pInstanceBuffer && !instanceMatrices.empty() )
+		{
+			m_pInstanceBuffer = new CDeviceBuffer( m_pSession );
+			VkResult result = InitBuffer( m_pInstanceBuffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, sizeof( XrMatrix4x4f ) * instanceMatrices.size(), instanceMatrices.data() );
+			assert( result == VK_SUCCESS );
+		}
+	}
+
+	void CRenderModel::Unshare()
+	{
+		if ( !m_pSharedSource )
+			return;
+
+		ReleaseGeometry();
+
+		m_unIndexCount = 0;
+		m_vecSectionBaseVertices.clear();
+		m_vecSkinDispatches.clear();
+		m_vecInstanceLods.clear();
+
+		textures.clear();
+		materials.clear();
+		skins.clear();
+		materialSections.clear();
+		lods.clear();
+		sceneGraph.Clear();
+		animations.clear();
+		morphTargets.clear();
+		morphWeights.clear();
+		UpdateNodeSlots();
+	}
+
 	void CRenderModel::Reset()
 	{
 		// Clear mesh data
@@ -375,27 +2069,23 @@ namespace xrlib
 
 		indices.clear();
 		indices.shrink_to_fit();
+
+		morphDeltas.clear();
+		morphDeltas.shrink_to_fit();
 	}
 
 	void CRenderModel::DeleteBuffers()
 	{
-		if ( m_pIndexBuffer )
-		{
-			delete m_pIndexBuffer;
-			m_pIndexBuffer = nullptr;
-		}
-
-		if ( m_pVertexBuffer )
-		{
-			delete m_pVertexBuffer;
-			m_pVertexBuffer = nullptr;
-		}
+		ReleaseGeometry();
 
 		if ( m_pInstanceBuffer )
 		{
 			delete m_pInstanceBuffer;
 			m_pInstanceBuffer = nullptr;
 		}
+
+		delete m_pNodeInstanceBuffer;
+		m_pNodeInstanceBuffer = nullptr;
 	}
 
 } // namespace xrlib
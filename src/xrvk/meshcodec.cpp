@@ -0,0 +1,521 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#include <xrvk/meshcodec.hpp>
+
+#include <cmath>
+#include <cstring>
+
+namespace xrlib
+{
+	namespace
+	{
+		constexpr uint8_t k_unVertexHeader = 0xa0;
+		constexpr uint8_t k_unIndexHeader = 0xe0;
+		constexpr uint8_t k_unSequenceHeader = 0xd0;
+
+		constexpr size_t k_unVertexBlockSizeBytes = 8192;
+		constexpr size_t k_unVertexBlockMaxSize = 256;
+		constexpr size_t k_unByteGroupSize = 16;
+		constexpr size_t k_unByteGroupDecodeLimit = 24;
+		constexpr size_t k_unTailMaxSize = 32;
+
+		// Triangles whose codeaux (free / fifo vertex pair) is common are encoded with one byte, indexing this table
+		constexpr uint8_t k_unCodeAuxTable[ 16 ] = { 0x00, 0x76, 0x87, 0x56, 0x67, 0x78, 0xa9, 0x86, 0x65, 0x89, 0x68, 0x98, 0x01, 0x69, 0x00, 0x00 };
+
+		// Vertex codec
+
+		size_t GetVertexBlockSize( size_t unStride )
+		{
+			// A block has to fit the scratch buffer and be a whole number of byte groups
+			size_t unSize = ( k_unVertexBlockSizeBytes / unStride ) & ~( k_unByteGroupSize - 1 );
+			return unSize < k_unVertexBlockMaxSize ? unSize : k_unVertexBlockMaxSize;
+		}
+
+		inline uint8_t Unzigzag8( uint8_t v ) { return static_cast< uint8_t >( -( v & 1 ) ^ ( v >> 1 ) ); }
+
+		// A group of 16 bytes is stored as 0, 2, 4 or 8 bit values - a value with all bits set is followed up by the full byte
+		const uint8_t *DecodeBytesGroup( const uint8_t *pData, uint8_t *pOut, int nBitsLog2 )
+		{
+			switch ( nBitsLog2 )
+			{
+				case 0:
+					memset( pOut, 0, k_unByteGroupSize );
+					return pData;
+
+				case 1:
+				case 2:
+				{
+					const uint32_t unBits = 1u << nBitsLog2;
+					const uint32_t unMask = ( 1u << unBits ) - 1;
+					const uint32_t unPerByte = 8 / unBits;
+
+					const uint8_t *pExtra = pData + k_unByteGroupSize / unPerByte;
+					for ( size_t i = 0; i < k_unByteGroupSize; i += unPerByte )
+					{
+						uint8_t unByte = *pData++;
+						for ( uint32_t j = 0; j < unPerByte; j++ )
+						{
+							const uint8_t unValue = static_cast< uint8_t >( ( unByte >> ( 8 - unBits ) ) & unMask );
+							unByte = static_cast< uint8_t >( unByte << unBits );
+
+							if ( unValue == unMask )
+								pOut[ i + j ] = *pExtra++;
+							else
+								pOut[ i + j ] = unValue;
+						}
+					}
+
+					return pExtra;
+				}
+
+				default:
+					memcpy( pOut, pData, k_unByteGroupSize );
+					return pData + k_unByteGroupSize;
+			}
+		}
+
+		const uint8_t *DecodeBytes( const uint8_t *pData, const uint8_t *pDataEnd, uint8_t *pOut, size_t unSize )
+		{
+			// Two bits per group select its bit width
+			const uint8_t *pHeader = pData;
+			const size_t unHeaderSize = ( unSize / k_unByteGroupSize + 3 ) / 4;
+			if ( static_cast< size_t >( pDataEnd - pData ) < unHeaderSize )
+				return nullptr;
+
+			pData += unHeaderSize;
+
+			for ( size_t i = 0; i < unSize; i += k_unByteGroupSize )
+			{
+				// A group reads at most 24 bytes, the stream always ends with a tail of at least 32
+				if ( static_cast< size_t >( pDataEnd - pData ) < k_unByteGroupDecodeLimit )
+					return nullptr;
+
+				const size_t unGroup = i / k_unByteGroupSize;
+				const int nBitsLog2 = ( pHeader[ unGroup / 4 ] >> ( ( unGroup % 4 ) * 2 ) ) & 3;
+				pData = DecodeBytesGroup( pData, pOut + i, nBitsLog2 );
+			}
+
+			return pData;
+		}
+
+		// Each byte of the vertex is stored as its own stream of zigzag deltas against the previous vertex
+		const uint8_t *DecodeVertexBlock( const uint8_t *pData, const uint8_t *pDataEnd, uint8_t *pOut, size_t unCount, size_t unStride, uint8_t *pLastVertex )
+		{
+			uint8_t deltas[ k_unVertexBlockMaxSize ];
+			const size_t unAlignedCount = ( unCount + k_unByteGroupSize - 1 ) & ~( k_unByteGroupSize - 1 );
+
+			for ( size_t k = 0; k < unStride; k++ )
+			{
+				pData = DecodeBytes( pData, pDataEnd, deltas, unAlignedCount );
+				if ( !pData )
+					return nullptr;
+
+				uint8_t unPrevious = pLastVertex[ k ];
+				uint8_t *pByte = pOut + k;
+				for ( size_t i = 0; i < unCount; i++, pByte += unStride )
+				{
+					unPrevious = static_cast< uint8_t >( Unzigzag8( deltas[ i ] ) + unPrevious );
+					*pByte = unPrevious;
+				}
+			}
+
+			memcpy( pLastVertex, pOut + ( unCount - 1 ) * unStride, unStride );
+			return pData;
+		}
+
+		// Index codecs
+
+		uint32_t DecodeVByte( const uint8_t *&pData )
+		{
+			uint8_t unLead = *pData++;
+			if ( unLead < 128 )
+				return unLead;
+
+			uint32_t unResult = unLead & 127;
+			uint32_t unShift = 7;
+			for ( int i = 0; i < 4; i++ )
+			{
+				uint8_t unGroup = *pData++;
+				unResult |= static_cast< uint32_t >( unGroup & 127 ) << unShift;
+				unShift += 7;
+
+				if ( unGroup < 128 )
+					break;
+			}
+
+			return unResult;
+		}
+
+		inline uint32_t DecodeIndex( const uint8_t *&pData, uint32_t unLast )
+		{
+			const uint32_t v = DecodeVByte( pData );
+			return unLast + ( ( v >> 1 ) ^ ( 0u - ( v & 1 ) ) );
+		}
+
+		inline void WriteIndex( void *pDst, size_t unIndex, size_t unIndexSize, uint32_t unValue )
+		{
+			if ( unIndexSize == 2 )
+				static_cast< uint16_t * >( pDst )[ unIndex ] = static_cast< uint16_t >( unValue );
+			else
+				static_cast< uint32_t * >( pDst )[ unIndex ] = unValue;
+		}
+
+		struct SIndexFifos
+		{
+			uint32_t edges[ 16 ][ 2 ];
+			uint32_t vertices[ 16 ];
+			size_t unEdgeOffset = 0;
+			size_t unVertexOffset = 0;
+
+			SIndexFifos()
+			{
+				memset( edges, 0xff, sizeof( edges ) );
+				memset( vertices, 0xff, sizeof( vertices ) );
+			}
+
+			void PushEdge( uint32_t a, uint32_t b )
+			{
+				edges[ unEdgeOffset ][ 0 ] = a;
+				edges[ unEdgeOffset ][ 1 ] = b;
+				unEdgeOffset = ( unEdgeOffset + 1 ) & 15;
+			}
+
+			// The encoder only pushes vertices it didn't find in the fifo, bPush has to match it exactly
+			void PushVertex( uint32_t v, bool bPush = true )
+			{
+				vertices[ unVertexOffset ] = v;
+				unVertexOffset = ( unVertexOffset + ( bPush ? 1 : 0 ) ) & 15;
+			}
+		};
+
+		// Filters - applied in place after decoding
+
+		template < typename T >
+		void DecodeOctahedral( T *pData, size_t unCount )
+		{
+			const float fMax = static_cast< float >( ( 1 << ( sizeof( T ) * 8 - 1 ) ) - 1 );
+
+			for ( size_t i = 0; i < unCount * 4; i += 4 )
+			{
+				// The third component stores the encoding's 1.0 at the same bit count, z is reconstructed from it
+				float x = static_cast< float >( pData[ i + 0 ] );
+				float y = static_cast< float >( pData[ i + 1 ] );
+				float z = static_cast< float >( pData[ i + 2 ] ) - std::fabs( x ) - std::fabs( y );
+
+				// Unfold the lower hemisphere
+				const float t = z >= 0.f ? 0.f : z;
+				x += x >= 0.f ? t : -t;
+				y += y >= 0.f ? t : -t;
+
+				const float fScale = fMax / std::sqrt( x * x + y * y + z * z );
+
+				pData[ i + 0 ] = static_cast< T >( static_cast< int >( x * fScale + ( x >= 0.f ? 0.5f : -0.5f ) ) );
+				pData[ i + 1 ] = static_cast< T >( static_cast< int >( y * fScale + ( y >= 0.f ? 0.5f : -0.5f ) ) );
+				pData[ i + 2 ] = static_cast< T >( static_cast< int >( z * fScale + ( z >= 0.f ? 0.5f : -0.5f ) ) );
+			}
+		}
+
+		void DecodeQuaternion( int16_t *pData, size_t unCount )
+		{
+			const float fRange = 1.f / std::sqrt( 2.f );
+
+			for ( size_t i = 0; i < unCount * 4; i += 4 )
+			{
+				// The last component holds the index of the dropped (largest) component in its low bits and the scale above them
+				const int nScale = pData[ i + 3 ] | 3;
+				const float fScale = fRange / static_cast< float >( nScale );
+
+				const float x = static_cast< float >( pData[ i + 0 ] ) * fScale;
+				const float y = static_cast< float >( pData[ i + 1 ] ) * fScale;
+				const float z = static_cast< float >( pData[ i + 2 ] ) * fScale;
+
+				const float ww = 1.f - x * x - y * y - z * z;
+				const float w = std::sqrt( ww >= 0.f ? ww : 0.f );
+
+				const int nMax = pData[ i + 3 ] & 3;
+				pData[ i + ( ( nMax + 1 ) & 3 ) ] = static_cast< int16_t >( static_cast< int >( x * 32767.f + ( x >= 0.f ? 0.5f : -0.5f ) ) );
+				pData[ i + ( ( nMax + 2 ) & 3 ) ] = static_cast< int16_t >( static_cast< int >( y * 32767.f + ( y >= 0.f ? 0.5f : -0.5f ) ) );
+				pData[ i + ( ( nMax + 3 ) & 3 ) ] = static_cast< int16_t >( static_cast< int >( z * 32767.f + ( z >= 0.f ? 0.5f : -0.5f ) ) );
+				pData[ i + nMax ] = static_cast< int16_t >( static_cast< int >( w * 32767.f + 0.5f ) );
+			}
+		}
+
+		void DecodeExponential( uint32_t *pData, size_t unCount )
+		{
+			for ( size_t i = 0; i < unCount; i++ )
+			{
+				// 24 bit signed mantissa, 8 bit signed exponent: ldexp( m, e )
+				const int32_t nMantissa = static_cast< int32_t >( pData[ i ] << 8 ) >> 8;
+				const int32_t nExponent = static_cast< int32_t >( pData[ i ] ) >> 24;
+
+				uint32_t unScaleBits = static_cast< uint32_t >( nExponent + 127 ) << 23;
+				float fScale;
+				memcpy( &fScale, &unScaleBits, sizeof( float ) );
+
+				const float fValue = fScale * static_cast< float >( nMantissa );
+				memcpy( &pData[ i ], &fValue, sizeof( float ) );
+			}
+		}
+	} // namespace
+
+	bool DecodeMeshoptVertexBuffer( void *pDst, size_t unCount, size_t unStride, const uint8_t *pSrc, size_t unSrcSize )
+	{
+		if ( unStride == 0 || unStride > 256 || unStride % 4 != 0 )
+			return false;
+
+		const uint8_t *pData = pSrc;
+		const uint8_t *pDataEnd = pSrc + unSrcSize;
+
+		if ( unSrcSize < 1 + unStride )
+			return false;
+
+		const uint8_t unHeader = *pData++;
+		if ( ( unHeader & 0xf0 ) != k_unVertexHeader || ( unHeader & 0x0f ) > 0 )
+			return false;
+
+		// Deltas of the first vertex are against the last bytes of the stream
+		uint8_t lastVertex[ 256 ];
+		memcpy( lastVertex, pDataEnd - unStride, unStride );
+
+		uint8_t *pOut = static_cast< uint8_t * >( pDst );
+		const size_t unBlockSize = GetVertexBlockSize( unStride );
+
+		for ( size_t unOffset = 0; unOffset < unCount; )
+		{
+			const size_t unBlockCount = unOffset + unBlockSize < unCount ? unBlockSize : unCount - unOffset;
+
+			pData = DecodeVertexBlock( pData, pDataEnd, pOut + unOffset * unStride, unBlockCount, unStride, lastVertex );
+			if ( !pData )
+				return false;
+
+			unOffset += unBlockCount;
+		}
+
+		const size_t unTailSize = unStride < k_unTailMaxSize ? k_unTailMaxSize : unStride;
+		return static_cast< size_t >( pDataEnd - pData ) == unTailSize;
+	}
+
+	bool DecodeMeshoptIndexBuffer( void *pDst, size_t unCount, size_t unIndexSize, const uint8_t *pSrc, size_t unSrcSize )
+	{
+		if ( unCount % 3 != 0 || ( unIndexSize != 2 && unIndexSize != 4 ) )
+			return false;
+
+		// Header, a code byte per triangle and the 16 byte codeaux table at the end
+		if ( unSrcSize < 1 + unCount / 3 + 16 )
+			return false;
+
+		if ( ( pSrc[ 0 ] & 0xf0 ) != k_unIndexHeader )
+			return false;
+
+		const int nVersion = pSrc[ 0 ] & 0x0f;
+		if ( nVersion > 1 )
+			return false;
+
+		SIndexFifos fifos;
+		uint32_t unNext = 0;
+		uint32_t unLast = 0;
+
+		// Version 1 uses fifo codes 13 and 14 for last - 1 / last + 1
+		const int nFecMax = nVersion >= 1 ? 13 : 15;
+
+		const uint8_t *pCode = pSrc + 1;
+		const uint8_t *pData = pCode + unCount / 3;
+		const uint8_t *pDataSafeEnd = pSrc + unSrcSize - 16;
+		const uint8_t *pCodeAuxTable = pDataSafeEnd;
+
+		for ( size_t i = 0; i < unCount; i += 3 )
+		{
+			// A triangle reads at most 16 bytes of data, which the codeaux table guarantees past the safe end
+			if ( pData > pDataSafeEnd )
+				return false;
+
+			const uint8_t unCodeTri = *pCode++;
+
+			if ( unCodeTri < 0xf0 )
+			{
+				// Edge from the edge fifo plus a third vertex
+				const int fe = unCodeTri >> 4;
+				const uint32_t a = fifos.edges[ ( fifos.unEdgeOffset - 1 - fe ) & 15 ][ 0 ];
+				const uint32_t b = fifos.edges[ ( fifos.unEdgeOffset - 1 - fe ) & 15 ][ 1 ];
+
+				const int fec = unCodeTri & 15;
+				uint32_t c;
+
+				if ( fec < nFecMax )
+				{
+					// Next vertex or one from the vertex fifo
+					c = fec == 0 ? unNext++ : fifos.vertices[ ( fifos.unVertexOffset - 1 - fec ) & 15 ];
+					fifos.PushVertex( c, fec == 0 );
+				}
+				else
+				{
+					// Free index, delta encoded against the last free index (or +-1 of it)
+					c = unLast = fec != 15 ? unLast + ( fec - ( fec ^ 3 ) ) : DecodeIndex( pData, unLast );
+					fifos.PushVertex( c );
+				}
+
+				WriteIndex( pDst, i + 0, unIndexSize, a );
+				WriteIndex( pDst, i + 1, unIndexSize, b );
+				WriteIndex( pDst, i + 2, unIndexSize, c );
+
+				fifos.PushEdge( c, b );
+				fifos.PushEdge( a, c );
+			}
+			else
+			{
+				uint32_t a, b, c;
+				int feb, fec;
+
+				if ( unCodeTri < 0xfe )
+				{
+					// Common codeaux from the table, first vertex is always the next one
+					const uint8_t unCodeAux = pCodeAuxTable[ unCodeTri & 15 ];
+					feb = unCodeAux >> 4;
+					fec = unCodeAux & 15;
+
+					a = unNext++;
+					b = feb == 0 ? unNext++ : fifos.vertices[ ( fifos.unVertexOffset - feb ) & 15 ];
+					c = fec == 0 ? unNext++ : fifos.vertices[ ( fifos.unVertexOffset - fec ) & 15 ];
+				}
+				else
+				{
+					// Explicit codeaux byte, 0xff marks a free first vertex
+					const uint8_t unCodeAux = *pData++;
+					const int fea = unCodeTri == 0xfe ? 0 : 15;
+					feb = unCodeAux >> 4;
+					fec = unCodeAux & 15;
+
+					// A zero codeaux outside the table restarts the next vertex counter
+					if ( unCodeAux == 0 )
+						unNext = 0;
+
+					a = fea == 0 ? unNext++ : 0;
+					b = feb == 0 ? unNext++ : fifos.vertices[ ( fifos.unVertexOffset - feb ) & 15 ];
+					c = fec == 0 ? unNext++ : fifos.vertices[ ( fifos.unVertexOffset - fec ) & 15 ];
+
+					if ( fea == 15 )
+						unLast = a = DecodeIndex( pData, unLast );
+
+					if ( feb == 15 )
+						unLast = b = DecodeIndex( pData, unLast );
+
+					if ( fec == 15 )
+						unLast = c = DecodeIndex( pData, unLast );
+				}
+
+				WriteIndex( pDst, i + 0, unIndexSize, a );
+				WriteIndex( pDst, i + 1, unIndexSize, b );
+				WriteIndex( pDst, i + 2, unIndexSize, c );
+
+				fifos.PushVertex( a );
+				fifos.PushVertex( b, feb == 0 || feb == 15 );
+				fifos.PushVertex( c, fec == 0 || fec == 15 );
+
+				fifos.PushEdge( b, a );
+				fifos.PushEdge( c, b );
+				fifos.PushEdge( a, c );
+			}
+		}
+
+		// All triangle data has to end exactly at the codeaux table
+		return pData == pDataSafeEnd;
+	}
+
+	bool DecodeMeshoptIndexSequence( void *pDst, size_t unCount, size_t unIndexSize, const uint8_t *pSrc, size_t unSrcSize )
+	{
+		if ( unIndexSize != 2 && unIndexSize != 4 )
+			return false;
+
+		// Header, at least a byte per index and a 4 byte tail
+		if ( unSrcSize < 1 + unCount + 4 )
+			return false;
+
+		if ( ( pSrc[ 0 ] & 0xf0 ) != k_unSequenceHeader || ( pSrc[ 0 ] & 0x0f ) > 1 )
+			return false;
+
+		const uint8_t *pData = pSrc + 1;
+		const uint8_t *pDataSafeEnd = pSrc + unSrcSize - 4;
+
+		// Deltas alternate between two baselines, selected by the low bit
+		uint32_t unLast[ 2 ] = { 0, 0 };
+
+		for ( size_t i = 0; i < unCount; i++ )
+		{
+			// An index reads at most 5 bytes, the tail covers the overrun
+			if ( pData >= pDataSafeEnd )
+				return false;
+
+			uint32_t v = DecodeVByte( pData );
+			const uint32_t unBaseline = v & 1;
+			v >>= 1;
+
+			const uint32_t unIndex = unLast[ unBaseline ] + ( ( v >> 1 ) ^ ( 0u - ( v & 1 ) ) );
+			unLast[ unBaseline ] = unIndex;
+
+			WriteIndex( pDst, i, unIndexSize, unIndex );
+		}
+
+		return pData == pDataSafeEnd;
+	}
+
+	bool DecodeMeshoptFilter( void *pData, size_t unCount, size_t unStride, EMeshoptFilter filter )
+	{
+		switch ( filter )
+		{
+			case EMeshoptFilter::None:
+				return true;
+
+			case EMeshoptFilter::Octahedral:
+				if ( unStride == 4 )
+					DecodeOctahedral( static_cast< int8_t * >( pData ), unCount );
+				else if ( unStride == 8 )
+					DecodeOctahedral( static_cast< int16_t * >( pData ), unCount );
+				else
+					return false;
+				return true;
+
+			case EMeshoptFilter::Quaternion:
+				if ( unStride != 8 )
+					return false;
+				DecodeQuaternion( static_cast< int16_t * >( pData ), unCount );
+				return true;
+
+			case EMeshoptFilter::Exponential:
+				if ( unStride == 0 || unStride % 4 != 0 )
+					return false;
+				DecodeExponential( static_cast< uint32_t * >( pData ), unCount * ( unStride / 4 ) );
+				return true;
+		}
+
+		return false;
+	}
+
+	bool DecodeMeshoptBuffer( void *pDst, size_t unCount, size_t unStride, const uint8_t *pSrc, size_t unSrcSize, EMeshoptMode mode, EMeshoptFilter filter )
+	{
+		switch ( mode )
+		{
+			case EMeshoptMode::Attributes:
+				return DecodeMeshoptVertexBuffer( pDst, unCount, unStride, pSrc, unSrcSize ) && DecodeMeshoptFilter( pDst, unCount, unStride, filter );
+
+			case EMeshoptMode::Triangles:
+				return filter == EMeshoptFilter::None && DecodeMeshoptIndexBuffer( pDst, unCount, unStride, pSrc, unSrcSize );
+
+			case EMeshoptMode::Indices:
+				return filter == EMeshoptFilter::None && DecodeMeshoptIndexSequence( pDst, unCount, unStride, pSrc, unSrcSize );
+		}
+
+		return false;
+	}
+
+} // namespace xrlib
@@ -0,0 +1,930 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#include <xrvk/meshopt.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace xrlib
+{
+	namespace
+	{
+		constexpr uint32_t k_unInvalidIndex = std::numeric_limits< uint32_t >::max();
+
+		// Bitwise hash and equality of vertices (SMeshVertex has no padding), so only exact duplicates are merged
+		struct SVertexHash
+		{
+			const std::vector< SMeshVertex > *pVertices;
+
+			size_t operator()( uint32_t unIndex ) const
+			{
+				const uint8_t *pBytes = reinterpret_cast< const uint8_t * >( &( *pVertices )[ unIndex ] );
+
+				// FNV-1a
+				uint64_t unHash = 14695981039346656037ull;
+				for ( size_t i = 0; i < sizeof( SMeshVertex ); i++ )
+				{
+					unHash ^= pBytes[ i ];
+					unHash *= 1099511628211ull;
+				}
+
+				return static_cast< size_t >( unHash );
+			}
+		};
+
+		struct SVertexEqual
+		{
+			const std::vector< SMeshVertex > *pVertices;
+
+			bool operator()( uint32_t unA, uint32_t unB ) const 
+			{ 
+				return std::memcmp( &( *pVertices )[ unA ], &( *pVertices )[ unB ], sizeof( SMeshVertex ) ) == 0; 
+			}
+		};
+
+		inline XrVector3f Sub( const XrVector3f &a, const XrVector3f &b ) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+		inline XrVector3f Cross( const XrVector3f &a, const XrVector3f &b ) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+		inline float Dot( const XrVector3f &a, const XrVector3f &b ) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+		inline float Length( const XrVector3f &a ) { return sqrtf( Dot( a, a ) ); }
+
+		// Returns the number of vertices of the triangle that missed the cache (timestamp based fifo)
+		inline uint32_t SimulateTriangle( const uint32_t *pTriangle, std::vector< uint32_t > &cacheTime, uint32_t &unTimestamp, uint32_t unCacheSize )
+		{
+			uint32_t unMisses = 0;
+			for ( uint32_t i = 0; i < 3; i++ )
+			{
+				const uint32_t v = pTriangle[ i ];
+				if ( unTimestamp - cacheTime[ v ] > unCacheSize )
+				{
+					cacheTime[ v ] = unTimestamp++;
+					unMisses++;
+				}
+			}
+
+			return unMisses;
+		}
+
+		inline void FlushCache( uint32_t &unTimestamp, uint32_t unCacheSize ) { unTimestamp += unCacheSize + 1; }
+
+		inline bool IsBlended( const std::vector< SMaterial > *pMaterials, uint32_t unMaterialIndex )
+		{
+			return pMaterials && unMaterialIndex < pMaterials->size() && ( *pMaterials )[ unMaterialIndex ].getAlphaMode() == EAlphaMode::Blend;
+		}
+
+		// Reorders a range of the index buffer using compact (local) vertex ids. localIds is scratch space sized to the vertex count,
+		// all invalid on entry and on return.
+		void ReorderRange( 
+			uint32_t *pIndices, 
+			uint32_t unIndexCount, 
+			const std::vector< SMeshVertex > &vertices, 
+			std::vector< uint32_t > &localIds, 
+			uint32_t unCacheSize, 
+			bool bOverdraw, 
+			float fOverdrawThreshold )
+		{
+			std::vector< uint32_t > globalIds;
+			std::vector< uint32_t > localIndices( unIndexCount );
+			for ( uint32_t i = 0; i < unIndexCount; i++ )
+			{
+				const uint32_t v = pIndices[ i ];
+				if ( localIds[ v ] == k_unInvalidIndex )
+				{
+					localIds[ v ] = static_cast< uint32_t >( globalIds.size() );
+					globalIds.push_back( v );
+				}
+
+				localIndices[ i ] = localIds[ v ];
+			}
+
+			ReorderForVertexCache( localIndices.data(), localIndices.size(), static_cast< uint32_t >( globalIds.size() ), unCacheSize );
+
+			if ( bOverdraw )
+			{
+				std::vector< XrVector3f > localPositions( globalIds.size() );
+				for ( size_t i = 0; i < globalIds.size(); i++ )
+					localPositions[ i ] = vertices[ globalIds[ i ] ].position;
+
+				ReorderForOverdraw( localIndices.data(), localIndices.size(), localPositions, unCacheSize, fOverdrawThreshold );
+			}
+
+			for ( uint32_t i = 0; i < unIndexCount; i++ )
+				pIndices[ i ] = globalIds[ localIndices[ i ] ];
+
+			for ( uint32_t v : globalIds )
+				localIds[ v ] = k_unInvalidIndex;
+		}
+
+		// Symmetric 4x4 plane quadric, accumulated with area weights (w) so the error stays a squared distance
+		struct SQuadric
+		{
+			double a2 = 0.0, b2 = 0.0, c2 = 0.0, d2 = 0.0;
+			double ab = 0.0, ac = 0.0, ad = 0.0, bc = 0.0, bd = 0.0, cd = 0.0;
+			double w = 0.0;
+
+			void AddPlane( double a, double b, double c, double d, double weight )
+			{
+				a2 += a * a * weight; b2 += b * b * weight; c2 += c * c * weight; d2 += d * d * weight;
+				ab += a * b * weight; ac += a * c * weight; ad += a * d * weight;
+				bc += b * c * weight; bd += b * d * weight; cd += c * d * weight;
+				w += weight;
+			}
+
+			void Add( const SQuadric &other )
+			{
+				a2 += other.a2; b2 += other.b2; c2 += other.c2; d2 += other.d2;
+				ab += other.ab; ac += other.ac; ad += other.ad;
+				bc += other.bc; bd += other.bd; cd += other.cd;
+				w += other.w;
+			}
+
+			double Evaluate( const XrVector3f &p ) const
+			{
+				const double x = p.x, y = p.y, z = p.z;
+				const double r = a2 * x * x + b2 * y * y + c2 * z * z + d2 + 2.0 * ( ab * x * y + ac * x * z + ad * x + bc * y * z + bd * y + cd * z );
+				return w > 0.0 ? std::max( r / w, 0.0 ) : 0.0;
+			}
+		};
+
+		struct SPositionHash
+		{
+			size_t operator()( const XrVector3f &p ) const
+			{
+				uint32_t unBits[ 3 ];
+				std::memcpy( unBits, &p, sizeof( unBits ) );
+				return ( unBits[ 0 ] * 73856093u ) ^ ( unBits[ 1 ] * 19349663u ) ^ ( unBits[ 2 ] * 83492791u );
+			}
+		};
+
+		struct SPositionEqual
+		{
+			bool operator()( const XrVector3f &a, const XrVector3f &b ) const { return std::memcmp( &a, &b, sizeof( XrVector3f ) ) == 0; }
+		};
+	} // namespace
+
+	void OptimizeMesh(
+		std::vector< SMeshVertex > &vertices,
+		std::vector< uint32_t > &indices,
+		std::vector< SMeshSection > &sections,
+		const std::vector< SMaterial > *pMaterials,
+		const SMeshOptimizeSettings &settings,
+		SMeshOptimizeStats *pOutStats )
+	{
+		SMeshOptimizeStats stats;
+		stats.vertexCountBefore = static_cast< uint32_t >( vertices.size() );
+		stats.sectionCountBefore = static_cast< uint32_t >( sections.size() );
+		stats.acmrBefore = CalculateACMR( indices.data(), indices.size(), stats.vertexCountBefore, settings.vertexCacheSize, &stats.atvrBefore );
+
+		bool bValid = settings.enabled && !indices.empty() && settings.vertexCacheSize > 0;
+
+		// Every stage remaps indices, so they must all be in range
+		if ( bValid && *std::max_element( indices.begin(), indices.end() ) >= vertices.size() )
+		{
+			LogWarning( XRLIB_NAME, "Mesh optimization skipped: indices reference vertices out of range" );
+			bValid = false;
+		}
+
+		// Sections are reordered in place, they can't share index ranges
+		if ( bValid && settings.reorderForVertexCache )
+		{
+			std::vector< SMeshSection > sorted = sections;
+			std::sort( sorted.begin(), sorted.end(), []( const SMeshSection &a, const SMeshSection &b ) { return a.firstIndex < b.firstIndex; } );
+
+			for ( size_t i = 0; i < sorted.size(); i++ )
+			{
+				if ( sorted[ i ].firstIndex + sorted[ i ].indexCount > indices.size() || ( i > 0 && sorted[ i - 1 ].firstIndex + sorted[ i - 1 ].indexCount > sorted[ i ].firstIndex ) )
+				{
+					LogWarning( XRLIB_NAME, "Mesh optimization skipped: mesh sections overlap or exceed the index buffer" );
+					bValid = false;
+					break;
+				}
+			}
+		}
+
+		if ( bValid )
+		{
+			if ( settings.deduplicateVertices )
+				DeduplicateVertices( vertices, indices );
+
+			if ( settings.mergeSections )
+				MergeMeshSections( sections );
+
+			if ( settings.reorderForVertexCache )
+			{
+				// Models without sections are drawn as one
+				std::vector< SMeshSection > ranges = sections;
+				if ( ranges.empty() )
+					ranges.push_back( { 0, static_cast< uint32_t >( indices.size() ), 0 } );
+
+				std::vector< uint32_t > localIds( vertices.size(), k_unInvalidIndex );
+				for ( const auto &section : ranges )
+				{
+					if ( section.indexCount < 6 || section.indexCount % 3 != 0 )
+						continue;
+
+					// Transparent triangles are blended in their authored order
+					if ( IsBlended( pMaterials, section.materialIndex ) )
+						continue;
+
+					ReorderRange( &indices[ section.firstIndex ], section.indexCount, vertices, localIds, settings.vertexCacheSize, settings.reorderForOverdraw, settings.overdrawThreshold );
+				}
+			}
+
+			if ( settings.reorderForVertexFetch )
+				ReorderForVertexFetch( vertices, indices );
+		}
+
+		stats.vertexCountAfter = static_cast< uint32_t >( vertices.size() );
+		stats.sectionCountAfter = static_cast< uint32_t >( sections.size() );
+		stats.acmrAfter = CalculateACMR( indices.data(), indices.size(), stats.vertexCountAfter, settings.vertexCacheSize, &stats.atvrAfter );
+
+		if ( pOutStats )
+			*pOutStats = stats;
+	}
+
+	void GenerateMeshLods(
+		std::vector< SMeshLod > &outLods,
+		std::vector< uint32_t > &indices,
+		const std::vector< SMeshSection > &sections,
+		const std::vector< SMeshVertex > &vertices,
+		const std::vector< SMaterial > *pMaterials,
+		const SMeshLodSettings &settings,
+		uint32_t unCacheSize )
+	{
+		outLods.clear();
+		if ( sections.empty() || vertices.empty() || !settings.enabled )
+			return;
+
+		size_t unPreviousIndexCount = 0;
+		for ( const auto &section : sections )
+			unPreviousIndexCount += section.indexCount;
+
+		std::vector< uint32_t > simplified;
+		std::vector< uint32_t > localIds( vertices.size(), k_unInvalidIndex );
+
+		// Every level is simplified from lod 0, so its error is measured against the original
+		for ( size_t unLevel = 0; unLevel < settings.ratios.size(); unLevel++ )
+		{
+			const size_t unFirstAppended = indices.size();
+			size_t unLodIndexCount = 0;
+
+			SMeshLod lod;
+			lod.screenSize = unLevel < settings.screenSizes.size() ? settings.screenSizes[ unLevel ] : ( outLods.empty() ? 0.f : outLods.back().screenSize * 0.5f );
+
+			for ( const auto &section : sections )
+			{
+				const bool bSimplify = section.indexCount >= 6 && section.indexCount % 3 == 0 && section.firstIndex + section.indexCount <= unFirstAppended;
+				const size_t unTarget = static_cast< size_t >( section.indexCount / 3 * settings.ratios[ unLevel ] ) * 3;
+
+				float fError = 0.f;
+				if ( bSimplify )
+					SimplifyMesh( simplified, &indices[ section.firstIndex ], section.indexCount, vertices, unTarget, settings.maxError, &fError );
+
+				// Sections that can't be simplified reuse their lod 0 range
+				if ( !bSimplify || simplified.size() >= section.indexCount )
+				{
+					lod.sections.push_back( section );
+					unLodIndexCount += section.indexCount;
+					continue;
+				}
+
+				if ( !IsBlended( pMaterials, section.materialIndex ) )
+					ReorderRange( simplified.data(), static_cast< uint32_t >( simplified.size() ), vertices, localIds, unCacheSize, false, 0.f );
+
+				lod.sections.push_back( { static_cast< uint32_t >( indices.size() ), static_cast< uint32_t >( simplified.size() ), section.materialIndex, section.node, section.skin } );
+				lod.error = std::max( lod.error, fError );
+				unLodIndexCount += simplified.size();
+
+				indices.insert( indices.end(), simplified.begin(), simplified.end() );
+			}
+
+			// Stop once levels no longer get meaningfully smaller within the error bound
+			if ( unLodIndexCount > unPreviousIndexCount * ( 1.0 - settings.minReduction ) )
+			{
+				indices.resize( unFirstAppended );
+				break;
+			}
+
+			outLods.push_back( std::move( lod ) );
+			unPreviousIndexCount = unLodIndexCount;
+		}
+	}
+
+	size_t SimplifyMesh(
+		std::vector< uint32_t > &outIndices,
+		const uint32_t *pIndices,
+		size_t unIndexCount,
+		const std::vector< SMeshVertex > &vertices,
+		size_t unTargetIndexCount,
+		float fTargetError,
+		float *pOutError )
+	{
+		if ( pOutError )
+			*pOutError = 0.f;
+
+		outIndices.assign( pIndices, pIndices + ( unIndexCount - unIndexCount % 3 ) );
+		if ( outIndices.size() <= unTargetIndexCount || outIndices.size() < 6 )
+			return outIndices.size();
+
+		// Compact (local) vertex ids
+		std::vector< uint32_t > localIds( vertices.size(), k_unInvalidIndex );
+		std::vector< uint32_t > globalIds;
+		for ( auto &index : outIndices )
+		{
+			if ( localIds[ index ] == k_unInvalidIndex )
+			{
+				localIds[ index ] = static_cast< uint32_t >( globalIds.size() );
+				globalIds.push_back( index );
+			}
+
+			index = localIds[ index ];
+		}
+
+		const uint32_t unVertexCount = static_cast< uint32_t >( globalIds.size() );
+
+		// Positions scaled to the unit cube, so errors are relative to the mesh extent
+		XrVector3f minPos { FLT_MAX, FLT_MAX, FLT_MAX };
+		XrVector3f maxPos { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for ( uint32_t v : globalIds )
+		{
+			const XrVector3f &p = vertices[ v ].position;
+			minPos = { std::min( minPos.x, p.x ), std::min( minPos.y, p.y ), std::min( minPos.z, p.z ) };
+			maxPos = { std::max( maxPos.x, p.x ), std::max( maxPos.y, p.y ), std::max( maxPos.z, p.z ) };
+		}
+
+		const float fExtent = std::max( { maxPos.x - minPos.x, maxPos.y - minPos.y, maxPos.z - minPos.z } );
+		if ( !( fExtent > 0.f ) )
+		{
+			for ( auto &index : outIndices )
+				index = globalIds[ index ];
+
+			return outIndices.size();
+		}
+
+		std::vector< XrVector3f > positions( unVertexCount );
+		for ( uint32_t v = 0; v < unVertexCount; v++ )
+			positions[ v ] = { ( vertices[ globalIds[ v ] ].position.x - minPos.x ) / fExtent, ( vertices[ globalIds[ v ] ].position.y - minPos.y ) / fExtent, ( vertices[ globalIds[ v ] ].position.z - minPos.z ) / fExtent };
+
+		// Vertices at the same position (attribute seams) share a position id
+		std::vector< uint32_t > positionIds( unVertexCount );
+		std::vector< uint32_t > wedgeCounts;
+		{
+			std::unordered_map< XrVector3f, uint32_t, SPositionHash, SPositionEqual > ids;
+			for ( uint32_t v = 0; v < unVertexCount; v++ )
+			{
+				auto it = ids.emplace( vertices[ globalIds[ v ] ].position, static_cast< uint32_t >( wedgeCounts.size() ) );
+				if ( it.second )
+					wedgeCounts.push_back( 0 );
+
+				positionIds[ v ] = it.first->second;
+				wedgeCounts[ positionIds[ v ] ]++;
+			}
+		}
+
+		const size_t unPositionCount = wedgeCounts.size();
+
+		// Seams, borders and non manifold edges stay in place
+		std::vector< uint8_t > locked( unPositionCount, 0 );
+		for ( size_t p = 0; p < unPositionCount; p++ )
+			locked[ p ] = wedgeCounts[ p ] > 1;
+
+		{
+			std::unordered_map< uint64_t, uint32_t > edgeCounts;
+			for ( size_t i = 0; i < outIndices.size(); i += 3 )
+			{
+				for ( uint32_t c = 0; c < 3; c++ )
+				{
+					const uint32_t a = positionIds[ outIndices[ i + c ] ];
+					const uint32_t b = positionIds[ outIndices[ i + ( c + 1 ) % 3 ] ];
+					if ( a != b )
+						edgeCounts[ ( static_cast< uint64_t >( std::min( a, b ) ) << 32 ) | std::max( a, b ) ]++;
+				}
+			}
+
+			for ( const auto &edge : edgeCounts )
+			{
+				if ( edge.second != 2 )
+				{
+					locked[ edge.first >> 32 ] = 1;
+					locked[ edge.first & 0xFFFFFFFFull ] = 1;
+				}
+			}
+		}
+
+		// Area weighted plane quadrics per position
+		std::vector< SQuadric > quadrics( unPositionCount );
+		for ( size_t i = 0; i < outIndices.size(); i += 3 )
+		{
+			const XrVector3f &p0 = positions[ outIndices[ i ] ];
+			const XrVector3f normal = Cross( Sub( positions[ outIndices[ i + 1 ] ], p0 ), Sub( positions[ outIndices[ i + 2 ] ], p0 ) );
+			const float fLength = Length( normal );
+			if ( fLength <= 0.f )
+				continue;
+
+			const XrVector3f n { normal.x / fLength, normal.y / fLength, normal.z / fLength };
+			const float d = -Dot( n, p0 );
+
+			for ( uint32_t c = 0; c < 3; c++ )
+				quadrics[ positionIds[ outIndices[ i + c ] ] ].AddPlane( n.x, n.y, n.z, d, fLength * 0.5f );
+		}
+
+		struct SCollapse
+		{
+			uint32_t unFrom;
+			uint32_t unTo;
+			double fCost;
+		};
+
+		const double fMaxCost = static_cast< double >( fTargetError ) * fTargetError;
+		double fWorstCost = 0.0;
+
+		std::vector< SCollapse > collapses;
+		std::vector< uint32_t > remap( unVertexCount );
+		std::vector< uint8_t > touched( unVertexCount );
+		std::vector< uint32_t > adjacencyOffsets( unVertexCount + 1 );
+		std::vector< uint32_t > adjacency;
+
+		// Each pass collapses the cheapest independent edges, until the target or the error bound is reached
+		while ( outIndices.size() > unTargetIndexCount )
+		{
+			const size_t unTriangleCount = outIndices.size() / 3;
+
+			std::fill( adjacencyOffsets.begin(), adjacencyOffsets.end(), 0 );
+			for ( uint32_t index : outIndices )
+				adjacencyOffsets[ index + 1 ]++;
+
+			for ( uint32_t v = 0; v < unVertexCount; v++ )
+				adjacencyOffsets[ v + 1 ] += adjacencyOffsets[ v ];
+
+			adjacency.resize( outIndices.size() );
+			std::vector< uint32_t > fill( adjacencyOffsets.begin(), adjacencyOffsets.end() - 1 );
+			for ( size_t t = 0; t < unTriangleCount; t++ )
+			{
+				for ( uint32_t c = 0; c < 3; c++ )
+					adjacency[ fill[ outIndices[ t * 3 + c ] ]++ ] = static_cast< uint32_t >( t );
+			}
+
+			collapses.clear();
+			for ( size_t i = 0; i < outIndices.size(); i++ )
+			{
+				const uint32_t u = outIndices[ i ];
+				if ( locked[ positionIds[ u ] ] )
+					continue;
+
+				const size_t unTriangleStart = i - i % 3;
+				for ( uint32_t c = 1; c < 3; c++ )
+				{
+					const uint32_t v = outIndices[ unTriangleStart + ( i - unTriangleStart + c ) % 3 ];
+					if ( positionIds[ u ] == positionIds[ v ] )
+						continue;
+
+					SQuadric quadric = quadrics[ positionIds[ u ] ];
+					quadric.Add( quadrics[ positionIds[ v ] ] );
+					collapses.push_back( { u, v, quadric.Evaluate( positions[ v ] ) } );
+				}
+			}
+
+			if ( collapses.empty() )
+				break;
+
+			std::sort( collapses.begin(), collapses.end(), []( const SCollapse &a, const SCollapse &b ) { return a.fCost < b.fCost; } );
+
+			for ( uint32_t v = 0; v < unVertexCount; v++ )
+				remap[ v ] = v;
+
+			std::fill( touched.begin(), touched.end(), 0 );
+
+			const size_t unTrianglesToRemove = ( outIndices.size() - unTargetIndexCount + 2 ) / 3;
+			size_t unTrianglesRemoved = 0;
+			uint32_t unCollapsed = 0;
+
+			for ( const auto &collapse : collapses )
+			{
+				if ( collapse.fCost > fMaxCost || unTrianglesRemoved >= unTrianglesToRemove )
+					break;
+
+				const uint32_t u = collapse.unFrom;
+				const uint32_t v = collapse.unTo;
+				if ( touched[ u ] || touched[ v ] )
+					continue;
+
+				// Reject collapses that flip (or fold) a remaining triangle
+				bool bFlips = false;
+				size_t unRemoves = 0;
+				for ( uint32_t a = adjacencyOffsets[ u ]; a < adjacencyOffsets[ u + 1 ] && !bFlips; a++ )
+				{
+					const uint32_t *pTriangle = &outIndices[ adjacency[ a ] * 3 ];
+					if ( pTriangle[ 0 ] == v || pTriangle[ 1 ] == v || pTriangle[ 2 ] == v )
+					{
+						unRemoves++;
+						continue;
+					}
+
+					XrVector3f corners[ 3 ] = { positions[ pTriangle[ 0 ] ], positions[ pTriangle[ 1 ] ], positions[ pTriangle[ 2 ] ] };
+					const XrVector3f before = Cross( Sub( corners[ 1 ], corners[ 0 ] ), Sub( corners[ 2 ], corners[ 0 ] ) );
+
+					for ( uint32_t c = 0; c < 3; c++ )
+					{
+						if ( pTriangle[ c ] == u )
+							corners[ c ] = positions[ v ];
+					}
+
+					const XrVector3f after = Cross( Sub( corners[ 1 ], corners[ 0 ] ), Sub( corners[ 2 ], corners[ 0 ] ) );
+					bFlips = Dot( before, after ) <= 0.f;
+				}
+
+				if ( bFlips )
+					continue;
+
+				remap[ u ] = v;
+				quadrics[ positionIds[ v ] ].Add( quadrics[ positionIds[ u ] ] );
+				fWorstCost = std::max( fWorstCost, collapse.fCost );
+
+				// Neighbourhood is frozen for the rest of the pass, so flip checks see current positions
+				for ( uint32_t a = adjacencyOffsets[ u ]; a < adjacencyOffsets[ u + 1 ]; a++ )
+				{
+					for ( uint32_t c = 0; c < 3; c++ )
+						touched[ outIndices[ adjacency[ a ] * 3 + c ] ] = 1;
+				}
+
+				unTrianglesRemoved += unRemoves;
+				unCollapsed++;
+			}
+
+			if ( unCollapsed == 0 )
+				break;
+
+			// Apply and drop degenerate triangles
+			size_t unWrite = 0;
+			for ( size_t i = 0; i < outIndices.size(); i += 3 )
+			{
+				const uint32_t a = remap[ outIndices[ i ] ];
+				const uint32_t b = remap[ outIndices[ i + 1 ] ];
+				const uint32_t c = remap[ outIndices[ i + 2 ] ];
+				if ( a == b || b == c || a == c )
+					continue;
+
+				outIndices[ unWrite++ ] = a;
+				outIndices[ unWrite++ ] = b;
+				outIndices[ unWrite++ ] = c;
+			}
+
+			outIndices.resize( unWrite );
+		}
+
+		for ( auto &index : outIndices )
+			index = globalIds[ index ];
+
+		if ( pOutError )
+			*pOutError = static_cast< float >( sqrt( fWorstCost ) );
+
+		return outIndices.size();
+	}
+
+	uint32_t DeduplicateVertices( std::vector< SMeshVertex > &vertices, std::vector< uint32_t > &indices )
+	{
+		if ( vertices.empty() )
+			return 0;
+
+		std::unordered_map< uint32_t, uint32_t, SVertexHash, SVertexEqual > unique( vertices.size(), SVertexHash { &vertices }, SVertexEqual { &vertices } );
+		std::vector< uint32_t > remap( vertices.size() );
+		std::vector< SMeshVertex > uniqueVertices;
+		uniqueVertices.reserve( vertices.size() );
+
+		for ( uint32_t i = 0; i < static_cast< uint32_t >( vertices.size() ); i++ )
+		{
+			auto it = unique.emplace( i, static_cast< uint32_t >( uniqueVertices.size() ) );
+			if ( it.second )
+				uniqueVertices.push_back( vertices[ i ] );
+
+			remap[ i ] = it.first->second;
+		}
+
+		const uint32_t unRemoved = static_cast< uint32_t >( vertices.size() - uniqueVertices.size() );
+		if ( unRemoved == 0 )
+			return 0;
+
+		for ( auto &index : indices )
+			index = remap[ index ];
+
+		vertices.swap( uniqueVertices );
+		return unRemoved;
+	}
+
+	uint32_t MergeMeshSections( std::vector< SMeshSection > &sections )
+	{
+		if ( sections.size() < 2 )
+			return 0;
+
+		size_t unLast = 0;
+		for ( size_t i = 1; i < sections.size(); i++ )
+		{
+			SMeshSection &last = sections[ unLast ];
+			if ( sections[ i ].materialIndex == last.materialIndex && sections[ i ].node == last.node && sections[ i ].skin == last.skin && last.firstIndex + last.indexCount == sections[ i ].firstIndex )
+			{
+				last.indexCount += sections[ i ].indexCount;
+			}
+			else
+			{
+				sections[ ++unLast ] = sections[ i ];
+			}
+		}
+
+		const uint32_t unRemoved = static_cast< uint32_t >( sections.size() - ( unLast + 1 ) );
+		sections.resize( unLast + 1 );
+		return unRemoved;
+	}
+
+	void ReorderForVertexCache( uint32_t *pIndices, size_t unIndexCount, uint32_t unVertexCount, uint32_t unCacheSize )
+	{
+		const size_t unTriangleCount = unIndexCount / 3;
+		if ( unTriangleCount < 2 || unVertexCount == 0 )
+			return;
+
+		// Vertex to triangle adjacency
+		std::vector< uint32_t > liveCount( unVertexCount, 0 );
+		for ( size_t i = 0; i < unTriangleCount * 3; i++ )
+			liveCount[ pIndices[ i ] ]++;
+
+		std::vector< uint32_t > adjacencyOffsets( unVertexCount + 1, 0 );
+		for ( uint32_t v = 0; v < unVertexCount; v++ )
+			adjacencyOffsets[ v + 1 ] = adjacencyOffsets[ v ] + liveCount[ v ];
+
+		std::vector< uint32_t > adjacency( unTriangleCount * 3 );
+		std::vector< uint32_t > fill( adjacencyOffsets.begin(), adjacencyOffsets.end() - 1 );
+		for ( size_t t = 0; t < unTriangleCount; t++ )
+		{
+			for ( uint32_t c = 0; c < 3; c++ )
+				adjacency[ fill[ pIndices[ t * 3 + c ] ]++ ] = static_cast< uint32_t >( t );
+		}
+
+		std::vector< uint32_t > cacheTime( unVertexCount, 0 );
+		std::vector< uint8_t > emitted( unTriangleCount, 0 );
+		std::vector< uint32_t > deadEnd;
+		std::vector< uint32_t > candidates;
+		std::vector< uint32_t > output;
+		deadEnd.reserve( unTriangleCount * 3 );
+		output.reserve( unTriangleCount * 3 );
+
+		uint32_t unTimestamp = unCacheSize + 1;
+		uint32_t unCursor = 0;
+		uint32_t unFanning = 0;
+
+		while ( unFanning != k_unInvalidIndex )
+		{
+			// Emit all remaining triangles around the fanning vertex
+			candidates.clear();
+			for ( uint32_t a = adjacencyOffsets[ unFanning ]; a < adjacencyOffsets[ unFanning + 1 ]; a++ )
+			{
+				const uint32_t t = adjacency[ a ];
+				if ( emitted[ t ] )
+					continue;
+
+				for ( uint32_t c = 0; c < 3; c++ )
+				{
+					const uint32_t v = pIndices[ t * 3 + c ];
+					output.push_back( v );
+					deadEnd.push_back( v );
+					candidates.push_back( v );
+					liveCount[ v ]--;
+
+					if ( unTimestamp - cacheTime[ v ] > unCacheSize )
+						cacheTime[ v ] = unTimestamp++;
+				}
+
+				emitted[ t ] = 1;
+			}
+
+			// Next fanning vertex - the oldest one still in the cache after its remaining triangles are emitted
+			uint32_t unNext = k_unInvalidIndex;
+			int64_t nBestPriority = -1;
+			for ( uint32_t v : candidates )
+			{
+				if ( liveCount[ v ] == 0 )
+					continue;
+
+				int64_t nPriority = 0;
+				if ( unTimestamp - cacheTime[ v ] + 2 * liveCount[ v ] <= unCacheSize )
+					nPriority = unTimestamp - cacheTime[ v ];
+
+				if ( nPriority > nBestPriority )
+				{
+					nBestPriority = nPriority;
+					unNext = v;
+				}
+			}
+
+			// Dead end - most recently used vertex with live triangles, else the next one in index order
+			if ( unNext == k_unInvalidIndex )
+			{
+				while ( !deadEnd.empty() && unNext == k_unInvalidIndex )
+				{
+					const uint32_t v = deadEnd.back();
+					deadEnd.pop_back();
+
+					if ( liveCount[ v ] > 0 )
+						unNext = v;
+				}
+
+				while ( unNext == k_unInvalidIndex && unCursor < unVertexCount )
+				{
+					if ( liveCount[ unCursor ] > 0 )
+						unNext = unCursor;
+					else
+						unCursor++;
+				}
+			}
+
+			unFanning = unNext;
+		}
+
+		std::memcpy( pIndices, output.data(), output.size() * sizeof( uint32_t ) );
+	}
+
+	void ReorderForOverdraw( uint32_t *pIndices, size_t unIndexCount, const std::vector< XrVector3f > &positions, uint32_t unCacheSize, float fThreshold )
+	{
+		const size_t unTriangleCount = unIndexCount / 3;
+		if ( unTriangleCount < 2 || positions.empty() )
+			return;
+
+		std::vector< uint32_t > cacheTime( positions.size(), 0 );
+		uint32_t unTimestamp = unCacheSize + 1;
+
+		// Hard boundaries - triangles that miss the cache entirely
+		std::vector< uint32_t > hardClusters;
+		for ( size_t t = 0; t < unTriangleCount; t++ )
+		{
+			if ( SimulateTriangle( &pIndices[ t * 3 ], cacheTime, unTimestamp, unCacheSize ) == 3 || t == 0 )
+				hardClusters.push_back( static_cast< uint32_t >( t ) );
+		}
+
+		hardClusters.push_back( static_cast< uint32_t >( unTriangleCount ) );
+
+		// Soft boundaries - split where the running acmr is already close to that of the whole cluster
+		std::vector< uint32_t > clusters;
+		for ( size_t h = 0; h + 1 < hardClusters.size(); h++ )
+		{
+			const uint32_t unStart = hardClusters[ h ];
+			const uint32_t unEnd = hardClusters[ h + 1 ];
+
+			FlushCache( unTimestamp, unCacheSize );
+			uint32_t unClusterMisses = 0;
+			for ( uint32_t t = unStart; t < unEnd; t++ )
+				unClusterMisses += SimulateTriangle( &pIndices[ t * 3 ], cacheTime, unTimestamp, unCacheSize );
+
+			const float fClusterACMR = static_cast< float >( unClusterMisses ) / ( unEnd - unStart );
+
+			FlushCache( unTimestamp, unCacheSize );
+			clusters.push_back( unStart );
+
+			uint32_t unRunStart = unStart;
+			uint32_t unRunMisses = 0;
+			for ( uint32_t t = unStart; t < unEnd; t++ )
+			{
+				unRunMisses += SimulateTriangle( &pIndices[ t * 3 ], cacheTime, unTimestamp, unCacheSize );
+
+				if ( t + 1 < unEnd && static_cast< float >( unRunMisses ) / ( t + 1 - unRunStart ) <= fClusterACMR * fThreshold )
+				{
+					clusters.push_back( t + 1 );
+					unRunStart = t + 1;
+					unRunMisses = 0;
+					FlushCache( unTimestamp, unCacheSize );
+				}
+			}
+		}
+
+		const size_t unClusterCount = clusters.size();
+		clusters.push_back( static_cast< uint32_t >( unTriangleCount ) );
+
+		// Area weighted centroids and normals
+		std::vector< XrVector3f > clusterCentroids( unClusterCount, { 0.f, 0.f, 0.f } );
+		std::vector< XrVector3f > clusterNormals( unClusterCount, { 0.f, 0.f, 0.f } );
+		XrVector3f meshCentroid { 0.f, 0.f, 0.f };
+		float fMeshArea = 0.f;
+
+		for ( size_t c = 0; c < unClusterCount; c++ )
+		{
+			float fClusterArea = 0.f;
+			for ( uint32_t t = clusters[ c ]; t < clusters[ c + 1 ]; t++ )
+			{
+				const XrVector3f &p0 = positions[ pIndices[ t * 3 ] ];
+				const XrVector3f &p1 = positions[ pIndices[ t * 3 + 1 ] ];
+				const XrVector3f &p2 = positions[ pIndices[ t * 3 + 2 ] ];
+
+				const XrVector3f normal = Cross( Sub( p1, p0 ), Sub( p2, p0 ) );
+				const float fArea = Length( normal );
+
+				const XrVector3f center { ( p0.x + p1.x + p2.x ) / 3.f, ( p0.y + p1.y + p2.y ) / 3.f, ( p0.z + p1.z + p2.z ) / 3.f };
+				clusterCentroids[ c ] = { clusterCentroids[ c ].x + center.x * fArea, clusterCentroids[ c ].y + center.y * fArea, clusterCentroids[ c ].z + center.z * fArea };
+				clusterNormals[ c ] = { clusterNormals[ c ].x + normal.x, clusterNormals[ c ].y + normal.y, clusterNormals[ c ].z + normal.z };
+				fClusterArea += fArea;
+			}
+
+			meshCentroid = { meshCentroid.x + clusterCentroids[ c ].x, meshCentroid.y + clusterCentroids[ c ].y, meshCentroid.z + clusterCentroids[ c ].z };
+			fMeshArea += fClusterArea;
+
+			if ( fClusterArea > 0.f )
+				clusterCentroids[ c ] = { clusterCentroids[ c ].x / fClusterArea, clusterCentroids[ c ].y / fClusterArea, clusterCentroids[ c ].z / fClusterArea };
+		}
+
+		if ( fMeshArea > 0.f )
+			meshCentroid = { meshCentroid.x / fMeshArea, meshCentroid.y / fMeshArea, meshCentroid.z / fMeshArea };
+
+		// Clusters facing away from the center are the likeliest occluders
+		std::vector< float > sortKeys( unClusterCount, 0.f );
+		for ( size_t c = 0; c < unClusterCount; c++ )
+		{
+			const float fLength = Length( clusterNormals[ c ] );
+			if ( fLength > 0.f )
+				sortKeys[ c ] = Dot( Sub( clusterCentroids[ c ], meshCentroid ), clusterNormals[ c ] ) / fLength;
+		}
+
+		std::vector< uint32_t > order( unClusterCount );
+		for ( uint32_t c = 0; c < static_cast< uint32_t >( unClusterCount ); c++ )
+			order[ c ] = c;
+
+		std::stable_sort( order.begin(), order.end(), [ & ]( uint32_t a, uint32_t b ) { return sortKeys[ a ] > sortKeys[ b ]; } );
+
+		std::vector< uint32_t > output;
+		output.reserve( unTriangleCount * 3 );
+		for ( uint32_t c : order )
+			output.insert( output.end(), pIndices + clusters[ c ] * 3, pIndices + clusters[ c + 1 ] * 3 );
+
+		std::memcpy( pIndices, output.data(), output.size() * sizeof( uint32_t ) );
+	}
+
+	void ReorderForVertexFetch( std::vector< SMeshVertex > &vertices, std::vector< uint32_t > &indices )
+	{
+		std::vector< uint32_t > remap( vertices.size(), k_unInvalidIndex );
+		std::vector< SMeshVertex > reordered;
+		reordered.reserve( vertices.size() );
+
+		for ( auto &index : indices )
+		{
+			if ( remap[ index ] == k_unInvalidIndex )
+			{
+				remap[ index ] = static_cast< uint32_t >( reordered.size() );
+				reordered.push_back( vertices[ index ] );
+			}
+
+			index = remap[ index ];
+		}
+
+		vertices.swap( reordered );
+	}
+
+	float CalculateACMR( const uint32_t *pIndices, size_t unIndexCount, uint32_t unVertexCount, uint32_t unCacheSize, float *pOutATVR )
+	{
+		const size_t unTriangleCount = unIndexCount / 3;
+		if ( pOutATVR )
+			*pOutATVR = 0.f;
+
+		if ( unTriangleCount == 0 || unVertexCount == 0 )
+			return 0.f;
+
+		std::vector< uint32_t > cacheTime( unVertexCount, 0 );
+		std::vector< uint8_t > referenced( unVertexCount, 0 );
+		uint32_t unTimestamp = unCacheSize + 1;
+		uint32_t unMisses = 0;
+		uint32_t unReferenced = 0;
+
+		for ( size_t i = 0; i < unTriangleCount * 3; i++ )
+		{
+			const uint32_t v = pIndices[ i ];
+			if ( v >= unVertexCount )
+				continue;
+
+			if ( unTimestamp - cacheTime[ v ] > unCacheSize )
+			{
+				cacheTime[ v ] = unTimestamp++;
+				unMisses++;
+			}
+
+			if ( !referenced[ v ] )
+			{
+				referenced[ v ] = 1;
+				unReferenced++;
+			}
+		}
+
+		if ( pOutATVR && unReferenced > 0 )
+			*pOutATVR = static_cast< float >( unMisses ) / unReferenced;
+
+		return static_cast< float >( unMisses ) / unTriangleCount;
+	}
+
+} // namespace xrlib
@@ -0,0 +1,647 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#include <xrvk/modelcache.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <type_traits>
+
+namespace xrlib
+{
+	static_assert( std::is_trivially_copyable_v< SMeshVertex > && std::is_trivially_copyable_v< SMeshSection >, "Mesh data is written as is" );
+	static_assert( std::is_trivially_copyable_v< SModelCacheMaterial > && std::is_trivially_copyable_v< SModelCacheTexture > && std::is_trivially_copyable_v< SModelCacheNode >, "Cache records are written as is" );
+	static_assert( std::is_trivially_copyable_v< SModelCacheMorphTarget > && std::is_trivially_copyable_v< SMorphDelta >, "Morph records are written as is" );
+	static_assert( std::is_trivially_copyable_v< SAnimationTrack > && std::is_trivially_copyable_v< SAnimationSampler > && std::is_trivially_copyable_v< SAnimationChannel >, "Animation records are written as is" );
+
+	// Byte stream of the skins and animations chunks
+	struct SCacheWriter
+	{
+		std::vector< uint8_t > data;
+
+		void Write( const void *pData, size_t unSize )
+		{
+			const uint8_t *pBytes = static_cast< const uint8_t * >( pData );
+			data.insert( data.end(), pBytes, pBytes + unSize );
+		}
+
+		template < typename T > void Write( const T &value ) { Write( &value, sizeof( T ) ); }
+
+		template < typename T > void WriteArray( const std::vector< T > &values )
+		{
+			Write( static_cast< uint32_t >( values.size() ) );
+			if ( !values.empty() )
+				Write( values.data(), sizeof( T ) * values.size() );
+		}
+	};
+
+	struct SCacheReader
+	{
+		const uint8_t *pData = nullptr;
+		size_t size = 0;
+		size_t offset = 0;
+		bool failed = false;
+
+		bool Read( void *pOut, size_t unSize )
+		{
+			if ( failed || unSize > size - offset )
+			{
+				failed = true;
+				return false;
+			}
+
+			memcpy( pOut, pData + offset, unSize );
+			offset += unSize;
+			return true;
+		}
+
+		template < typename T > bool Read( T &outValue ) { return Read( &outValue, sizeof( T ) ); }
+
+		template < typename T > bool ReadArray( std::vector< T > &outValues )
+		{
+			uint32_t unCount = 0;
+			if ( !Read( unCount ) || unCount > ( size - offset ) / sizeof( T ) )
+			{
+				failed = true;
+				return false;
+			}
+
+			outValues.resize( unCount );
+			return unCount == 0 || Read( outValues.data(), sizeof( T ) * unCount );
+		}
+	};
+
+	uint64_t HashBytes( const void *pData, size_t unSize, uint64_t unHash )
+	{
+		const uint8_t *pBytes = static_cast< const uint8_t * >( pData );
+		for ( size_t i = 0; i < unSize; i++ )
+		{
+			unHash ^= pBytes[ i ];
+			unHash *= 1099511628211ull;
+		}
+
+		return unHash;
+	}
+
+	uint64_t HashFile( const std::string &sFilename )
+	{
+		std::ifstream file( sFilename, std::ios::binary );
+		if ( !file )
+			return 0;
+
+		uint64_t unHash = k_unFnvOffsetBasis;
+		std::vector< char > vecChunk( 64 * 1024 );
+		while ( file )
+		{
+			file.read( vecChunk.data(), vecChunk.size() );
+			unHash = HashBytes( vecChunk.data(), static_cast< size_t >( file.gcount() ), unHash );
+		}
+
+		return unHash;
+	}
+
+	CModelCacheFile::~CModelCacheFile() 
+	{ 
+		Close(); 
+	}
+
+	bool CModelCacheFile::Write( const std::string &sCacheFile, const CRenderModel &model, uint64_t unSourceHash )
+	{
+		std::vector< std::pair< SModelCacheChunk, std::vector< uint8_t > > > vecChunks;
+		auto addChunk = [ &vecChunks ]( EModelCacheChunk type, uint32_t unCount, const void *pData, size_t unSize )
+		{
+			SModelCacheChunk chunk;
+			chunk.type = type;
+			chunk.count = unCount;
+			chunk.size = unSize;
+
+			const uint8_t *pBytes = static_cast< const uint8_t * >( pData );
+			vecChunks.push_back( { chunk, std::vector< uint8_t >( pBytes, pBytes + unSize ) } );
+		};
+
+		addChunk( EModelCacheChunk::Vertices, static_cast< uint32_t >( model.vertices.size() ), model.vertices.data(), sizeof( SMeshVertex ) * model.vertices.size() );
+		addChunk( EModelCacheChunk::Indices, static_cast< uint32_t >( model.indices.size() ), model.indices.data(), sizeof( uint32_t ) * model.indices.size() );
+		addChunk( EModelCacheChunk::Sections, static_cast< uint32_t >( model.materialSections.size() ), model.materialSections.data(), sizeof( SMeshSection ) * model.materialSections.size() );
+
+		// Lods
+		std::vector< SModelCacheLod > vecLods;
+		std::vector< SMeshSection > vecLodSections;
+		for ( const SMeshLod &lod : model.lods )
+		{
+			SModelCacheLod record;
+			record.screenSize = lod.screenSize;
+			record.error = lod.error;
+			record.firstSection = static_cast< uint32_t >( vecLodSections.size() );
+			record.sectionCount = static_cast< uint32_t >( lod.sections.size() );
+			vecLods.push_back( record );
+			vecLodSections.insert( vecLodSections.end(), lod.sections.begin(), lod.sections.end() );
+		}
+
+		addChunk( EModelCacheChunk::Lods, static_cast< uint32_t >( vecLods.size() ), vecLods.data(), sizeof( SModelCacheLod ) * vecLods.size() );
+		addChunk( EModelCacheChunk::LodSections, static_cast< uint32_t >( vecLodSections.size() ), vecLodSections.data(), sizeof( SMeshSection ) * vecLodSections.size() );
+
+		// Materials, descriptors are created per run
+		std::vector< SModelCacheMaterial > vecMaterials( model.materials.size() );
+		for ( size_t i = 0; i < model.materials.size(); i++ )
+		{
+			const SMaterial &material = model.materials[ i ];
+			SModelCacheMaterial &record = vecMaterials[ i ];
+			record.parameters = material;
+			record.baseColorTexture = material.baseColorTexture;
+			record.metallicRoughnessTexture = material.metallicRoughnessTexture;
+			record.normalTexture = material.normalTexture;
+			record.occlusionTexture = material.occlusionTexture;
+			record.emissiveTexture = material.emissiveTexture;
+			record.doubleSided = material.doubleSided ? 1 : 0;
+		}
+
+		addChunk( EModelCacheChunk::Materials, static_cast< uint32_t >( vecMaterials.size() ), vecMaterials.data(), sizeof( SModelCacheMaterial ) * vecMaterials.size() );
+
+		// Textures, with their pixels and strings in chunks of their own
+		std::vector< SModelCacheTexture > vecTextures( model.textures.size() );
+		std::vector< uint8_t > vecTextureData;
+		std::string sStrings;
+		for ( size_t i = 0; i < model.textures.size(); i++ )
+		{
+			const STexture &texture = model.textures[ i ];
+			SModelCacheTexture &record = vecTextures[ i ];
+
+			vecTextureData.resize( ( vecTextureData.size() + k_unModelCacheAlignment - 1 ) / k_unModelCacheAlignment * k_unModelCacheAlignment );
+			record.dataOffset = vecTextureData.size();
+			record.dataSize = texture.data.size();
+			vecTextureData.insert( vecTextureData.end(), texture.data.begin(), texture.data.end() );
+
+			record.nameOffset = static_cast< uint32_t >( sStrings.size() );
+			record.nameLength = static_cast< uint32_t >( texture.name.size() );
+			sStrings += texture.name;
+			record.uriOffset = static_cast< uint32_t >( sStrings.size() );
+			record.uriLength = static_cast< uint32_t >( texture.uri.size() );
+			sStrings += texture.uri;
+
+			record.type = texture.type;
+			record.width = texture.width;
+			record.height = texture.height;
+			record.channels = texture.channels;
+			record.bitsPerChannel = texture.bitsPerChannel;
+			record.format = texture.format;
+			record.samplerConfig = texture.samplerConfig;
+		}
+
+		addChunk( EModelCacheChunk::Textures, static_cast< uint32_t >( vecTextures.size() ), vecTextures.data(), sizeof( SModelCacheTexture ) * vecTextures.size() );
+		addChunk( EModelCacheChunk::TextureData, static_cast< uint32_t >( vecTextureData.size() ), vecTextureData.data(), vecTextureData.size() );
+
+		// Skins - name, skeleton, joints, joint nodes, inverse bind matrices, hierarchy (by parent joint, ascending)
+		SCacheWriter skins;
+		for ( const SSkin &skin : model.skins )
+		{
+			skins.Write( static_cast< uint32_t >( sStrings.size() ) );
+			skins.Write( static_cast< uint32_t >( skin.name.size() ) );
+			sStrings += skin.name;
+
+			skins.Write( skin.skeleton );
+			skins.WriteArray( skin.joints );
+			skins.WriteArray( skin.jointNodes );
+			skins.WriteArray( skin.inverseBindMatrices );
+
+			std::vector< uint32_t > vecParents;
+			for ( const auto &it : skin.hierarchy )
+				vecParents.push_back( it.first );
+			std::sort( vecParents.begin(), vecParents.end() );
+
+			skins.WriteArray( vecParents );
+			for ( uint32_t unParent : vecParents )
+				skins.WriteArray( skin.hierarchy.at( unParent ) );
+		}
+
+		addChunk( EModelCacheChunk::Skins, static_cast< uint32_t >( model.skins.size() ), skins.data.data(), skins.data.size() );
+
+		// Scene graph
+		std::vector< SModelCacheNode > vecNodes( model.sceneGraph.GetNodeCount() );
+		for ( uint32_t i = 0; i < model.sceneGraph.GetNodeCount(); i++ )
+		{
+			SModelCacheNode &record = vecNodes[ i ];
+			record.parent = model.sceneGraph.GetParent( i );
+			record.translation = model.sceneGraph.GetTranslation( i );
+			record.rotation = model.sceneGraph.GetRotation( i );
+			record.scale = model.sceneGraph.GetScale( i );
+			record.nameOffset = static_cast< uint32_t >( sStrings.size() );
+			record.nameLength = static_cast< uint32_t >( model.sceneGraph.GetName( i ).size() );
+			sStrings += model.sceneGraph.GetName( i );
+		}
+
+		addChunk( EModelCacheChunk::Nodes, static_cast< uint32_t >( vecNodes.size() ), vecNodes.data(), sizeof( SModelCacheNode ) * vecNodes.size() );
+
+		// Morph targets
+		std::vector< SModelCacheMorphTarget > vecMorphTargets( model.morphTargets.size() );
+		for ( size_t i = 0; i < model.morphTargets.size(); i++ )
+		{
+			const SMorphTarget &target = model.morphTargets[ i ];
+			SModelCacheMorphTarget &record = vecMorphTargets[ i ];
+			record.nameOffset = static_cast< uint32_t >( sStrings.size() );
+			record.nameLength = static_cast< uint32_t >( target.name.size() );
+			record.node = target.node;
+			record.index = target.index;
+			record.firstDelta = target.firstDelta;
+			record.deltaCount = target.deltaCount;
+			record.defaultWeight = target.defaultWeight;
+			sStrings += target.name;
+		}
+
+		addChunk( EModelCacheChunk::MorphTargets, static_cast< uint32_t >( vecMorphTargets.size() ), vecMorphTargets.data(), sizeof( SModelCacheMorphTarget ) * vecMorphTargets.size() );
+		addChunk( EModelCacheChunk::MorphDeltas, static_cast< uint32_t >( model.morphDeltas.size() ), model.morphDeltas.data(), sizeof( SMorphDelta ) * model.morphDeltas.size() );
+
+		// Animations - name, duration, times, values, tracks, samplers, channels
+		SCacheWriter animations;
+		for ( const std::shared_ptr< const SAnimationClip > &pClip : model.animations )
+		{
+			const SAnimationClip emptyClip;
+			const SAnimationClip &clip = pClip ? *pClip : emptyClip;
+
+			animations.Write( static_cast< uint32_t >( sStrings.size() ) );
+			animations.Write( static_cast< uint32_t >( clip.name.size() ) );
+			sStrings += clip.name;
+
+			animations.Write( clip.duration );
+			animations.WriteArray( clip.times );
+			animations.WriteArray( clip.values );
+			animations.WriteArray( clip.tracks );
+			animations.WriteArray( clip.samplers );
+			animations.WriteArray( clip.channels );
+		}
+
+		addChunk( EModelCacheChunk::Animations, static_cast< uint32_t >( model.animations.size() ), animations.data.data(), animations.data.size() );
+		addChunk( EModelCacheChunk::Strings, static_cast< uint32_t >( sStrings.size() ), sStrings.data(), sStrings.size() );
+
+		// Layout
+		SModelCacheHeader header;
+		header.sourceHash = unSourceHash;
+		header.chunkCount = static_cast< uint32_t >( vecChunks.size() );
+
+		uint64_t unOffset = sizeof( SModelCacheHeader ) + sizeof( SModelCacheChunk ) * vecChunks.size();
+		for ( auto &chunk : vecChunks )
+		{
+			unOffset = ( unOffset + k_unModelCacheAlignment - 1 ) / k_unModelCacheAlignment * k_unModelCacheAlignment;
+			chunk.first.offset = unOffset;
+			unOffset += chunk.first.size;
+		}
+
+		// Written to a temporary first so a failed write never leaves a truncated cache behind
+		const std::string sTempFile = sCacheFile + ".tmp";
+		{
+			std::ofstream file( sTempFile, std::ios::binary | std::ios::trunc );
+			if ( !file )
+			{
+				LogError( XRLIB_NAME, "Unable to create model cache %s", sCacheFile.c_str() );
+				return false;
+			}
+
+			file.write( reinterpret_cast< const char * >( &header ), sizeof( header ) );
+			for ( auto &chunk : vecChunks )
+				file.write( reinterpret_cast< const char * >( &chunk.first ), sizeof( SModelCacheChunk ) );
+
+			const char padding[ k_unModelCacheAlignment ] = {};
+			for ( auto &chunk : vecChunks )
+			{
+				file.write( padding, static_cast< std::streamsize >( chunk.first.offset - static_cast< uint64_t >( file.tellp() ) ) );
+				file.write( reinterpret_cast< const char * >( chunk.second.data() ), static_cast< std::streamsize >( chunk.second.size() ) );
+			}
+
+			if ( !file )
+			{
+				LogError( XRLIB_NAME, "Unable to write model cache %s", sCacheFile.c_str() );
+				file.close();
+				std::remove( sTempFile.c_str() );
+				return false;
+			}
+		}
+
+		std::remove( sCacheFile.c_str() );
+		if ( std::rename( sTempFile.c_str(), sCacheFile.c_str() ) != 0 )
+		{
+			LogError( XRLIB_NAME, "Unable to replace model cache %s", sCacheFile.c_str() );
+			std::remove( sTempFile.c_str() );
+			return false;
+		}
+
+		LogInfo( XRLIB_NAME, "Model cache written: %s (%.2f MB, %i vertices, %i textures)", sCacheFile.c_str(), unOffset / 1048576.0, (int) model.vertices.size(), (int) model.textures.size() );
+		return true;
+	}
+
+	bool CModelCacheFile::Open( const std::string &sCacheFile, uint64_t unSourceHash )
+	{
+		Close();
+
+		if ( !m_file.Open( sCacheFile ) )
+			return false;
+
+		m_pData = m_file.GetData();
+		m_unSize = m_file.GetSize();
+
+		const SModelCacheHeader *pHeader = reinterpret_cast< const SModelCacheHeader * >( m_pData );
+		bool bValid = m_unSize >= sizeof( SModelCacheHeader ) 
+			&& pHeader->magic == k_unModelCacheMagic 
+			&& pHeader->version == k_unModelCacheVersion 
+			&& pHeader->vertexSize == sizeof( SMeshVertex )
+			&& pHeader->chunkCount <= ( m_unSize - sizeof( SModelCacheHeader ) ) / sizeof( SModelCacheChunk );
+
+		if ( !bValid )
+		{
+			LogWarning( XRLIB_NAME, "Model cache %s is invalid or of another version", sCacheFile.c_str() );
+			Close();
+			return false;
+		}
+
+		if ( pHeader->sourceHash != unSourceHash )
+		{
+			LogInfo( XRLIB_NAME, "Model cache %s is out of date", sCacheFile.c_str() );
+			Close();
+			return false;
+		}
+
+		m_pChunks = reinterpret_cast< const SModelCacheChunk * >( m_pData + sizeof( SModelCacheHeader ) );
+		m_unChunkCount = pHeader->chunkCount;
+
+		for ( uint32_t i = 0; i < m_unChunkCount; i++ )
+		{
+			if ( m_pChunks[ i ].offset > m_unSize || m_pChunks[ i ].size > m_unSize - m_pChunks[ i ].offset )
+			{
+				LogWarning( XRLIB_NAME, "Model cache %s is truncated", sCacheFile.c_str() );
+				Close();
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void CModelCacheFile::Close()
+	{
+		m_file.Close();
+
+		m_pData = nullptr;
+		m_unSize = 0;
+		m_pChunks = nullptr;
+		m_unChunkCount = 0;
+	}
+
+	const SModelCacheChunk *CModelCacheFile::FindChunk( EModelCacheChunk type, size_t unElementSize )
+	{
+		for ( uint32_t i = 0; i < m_unChunkCount; i++ )
+		{
+			if ( m_pChunks[ i ].type != type )
+				continue;
+
+			if ( unElementSize > 0 && m_pChunks[ i ].size != static_cast< uint64_t >( m_pChunks[ i ].count ) * unElementSize )
+				return nullptr;
+
+			return &m_pChunks[ i ];
+		}
+
+		return nullptr;
+	}
+
+	std::string CModelCacheFile::ReadString( uint32_t unOffset, uint32_t unLength )
+	{
+		const SModelCacheChunk *pStrings = FindChunk( EModelCacheChunk::Strings );
+		if ( !pStrings || static_cast< uint64_t >( unOffset ) + unLength > pStrings->size )
+			return {};
+
+		return std::string( reinterpret_cast< const char * >( GetChunkData( pStrings ) ) + unOffset, unLength );
+	}
+
+	bool CModelCacheFile::Read( CRenderModel *outRenderModel )
+	{
+		assert( outRenderModel );
+		if ( !IsOpen() )
+			return false;
+
+		// Mesh data
+		if ( !ReadArray( outRenderModel->vertices, EModelCacheChunk::Vertices ) || 
+			 !ReadArray( outRenderModel->indices, EModelCacheChunk::Indices ) || 
+			 !ReadArray( outRenderModel->materialSections, EModelCacheChunk::Sections ) )
+			return false;
+
+		// Lods
+		std::vector< SModelCacheLod > vecLods;
+		std::vector< SMeshSection > vecLodSections;
+		if ( !ReadArray( vecLods, EModelCacheChunk::Lods ) || !ReadArray( vecLodSections, EModelCacheChunk::LodSections ) )
+			return false;
+
+		outRenderModel->lods.resize( vecLods.size() );
+		for ( size_t i = 0; i < vecLods.size(); i++ )
+		{
+			const SModelCacheLod &record = vecLods[ i ];
+			if ( static_cast< size_t >( record.firstSection ) + record.sectionCount > vecLodSections.size() )
+				return false;
+
+			SMeshLod &lod = outRenderModel->lods[ i ];
+			lod.screenSize = record.screenSize;
+			lod.error = record.error;
+			lod.sections.assign( vecLodSections.begin() + record.firstSection, vecLodSections.begin() + record.firstSection + record.sectionCount );
+		}
+
+		// Materials
+		std::vector< SModelCacheMaterial > vecMaterials;
+		if ( !ReadArray( vecMaterials, EModelCacheChunk::Materials ) )
+			return false;
+
+		outRenderModel->materials.resize( vecMaterials.size() );
+		for ( size_t i = 0; i < vecMaterials.size(); i++ )
+		{
+			const SModelCacheMaterial &record = vecMaterials[ i ];
+			SMaterial &material = outRenderModel->materials[ i ];
+			static_cast< SMaterialUBO & >( material ) = record.parameters;
+			material.baseColorTexture = record.baseColorTexture;
+			material.metallicRoughnessTexture = record.metallicRoughnessTexture;
+			material.normalTexture = record.normalTexture;
+			material.occlusionTexture = record.occlusionTexture;
+			material.emissiveTexture = record.emissiveTexture;
+			material.doubleSided = record.doubleSided != 0;
+		}
+
+		// Textures
+		std::vector< SModelCacheTexture > vecTextures;
+		if ( !ReadArray( vecTextures, EModelCacheChunk::Textures ) )
+			return false;
+
+		outRenderModel->textures.resize( vecTextures.size() );
+		for ( size_t i = 0; i < vecTextures.size(); i++ )
+		{
+			const SModelCacheTexture &record = vecTextures[ i ];
+			STexture &texture = outRenderModel->textures[ i ];
+			texture.name = ReadString( record.nameOffset, record.nameLength );
+			texture.uri = ReadString( record.uriOffset, record.uriLength );
+			texture.type = record.type;
+			texture.width = record.width;
+			texture.height = record.height;
+			texture.channels = record.channels;
+			texture.bitsPerChannel = record.bitsPerChannel;
+			texture.format = record.format;
+			texture.samplerConfig = record.samplerConfig;
+		}
+
+		// Skins
+		const SModelCacheChunk *pSkins = FindChunk( EModelCacheChunk::Skins, 0 );
+		if ( !pSkins )
+			return false;
+
+		SCacheReader reader;
+		reader.pData = GetChunkData( pSkins );
+		reader.size = pSkins->size;
+
+		outRenderModel->skins.resize( pSkins->count );
+		for ( SSkin &skin : outRenderModel->skins )
+		{
+			uint32_t unNameOffset = 0, unNameLength = 0;
+			reader.Read( unNameOffset );
+			reader.Read( unNameLength );
+			skin.name = ReadString( unNameOffset, unNameLength );
+
+			reader.Read( skin.skeleton );
+			reader.ReadArray( skin.joints );
+			reader.ReadArray( skin.jointNodes );
+			reader.ReadArray( skin.inverseBindMatrices );
+
+			std::vector< uint32_t > vecParents;
+			reader.ReadArray( vecParents );
+
+			skin.hierarchy.clear();
+			for ( uint32_t unParent : vecParents )
+				reader.ReadArray( skin.hierarchy[ unParent ] );
+
+			if ( reader.failed )
+				return false;
+
+			skin.BuildHierarchy();
+		}
+
+		// Scene graph
+		std::vector< SModelCacheNode > vecNodes;
+		if ( !ReadArray( vecNodes, EModelCacheChunk::Nodes ) )
+			return false;
+
+		outRenderModel->sceneGraph.Clear();
+		outRenderModel->sceneGraph.Reserve( vecNodes.size() );
+		for ( const SModelCacheNode &record : vecNodes )
+			outRenderModel->sceneGraph.AddNode( record.parent < static_cast< int32_t >( outRenderModel->sceneGraph.GetNodeCount() ) ? record.parent : -1, record.translation, record.rotation, record.scale, ReadString( record.nameOffset, record.nameLength ) );
+
+		// Morph targets, checked so the skinning pass never reads past the deltas
+		std::vector< SModelCacheMorphTarget > vecMorphTargets;
+		if ( !ReadArray( vecMorphTargets, EModelCacheChunk::MorphTargets ) || !ReadArray( outRenderModel->morphDeltas, EModelCacheChunk::MorphDeltas ) )
+			return false;
+
+		outRenderModel->morphTargets.resize( vecMorphTargets.size() );
+		for ( size_t i = 0; i < vecMorphTargets.size(); i++ )
+		{
+			const SModelCacheMorphTarget &record = vecMorphTargets[ i ];
+			if ( static_cast< uint64_t >( record.firstDelta ) + record.deltaCount > outRenderModel->morphDeltas.size() || record.node >= static_cast< int32_t >( vecNodes.size() ) )
+				return false;
+
+			SMorphTarget &target = outRenderModel->morphTargets[ i ];
+			target.name = ReadString( record.nameOffset, record.nameLength );
+			target.node = record.node;
+			target.index = record.index;
+			target.firstDelta = record.firstDelta;
+			target.deltaCount = record.deltaCount;
+			target.defaultWeight = record.defaultWeight;
+		}
+
+		for ( const SMorphDelta &delta : outRenderModel->morphDeltas )
+		{
+			if ( delta.vertex >= outRenderModel->vertices.size() )
+				return false;
+		}
+
+		outRenderModel->ResetMorphWeights();
+		if ( !outRenderModel->morphTargets.empty() )
+			outRenderModel->computeSkinning = true;
+
+		// Animations, checked so playback never reads past the keys
+		const SModelCacheChunk *pAnimations = FindChunk( EModelCacheChunk::Animations, 0 );
+		if ( !pAnimations )
+			return false;
+
+		reader = SCacheReader();
+		reader.pData = GetChunkData( pAnimations );
+		reader.size = pAnimations->size;
+
+		outRenderModel->animations.clear();
+		outRenderModel->animations.reserve( pAnimations->count );
+		for ( uint32_t i = 0; i < pAnimations->count; i++ )
+		{
+			std::shared_ptr< SAnimationClip > pClip = std::make_shared< SAnimationClip >();
+
+			uint32_t unNameOffset = 0, unNameLength = 0;
+			reader.Read( unNameOffset );
+			reader.Read( unNameLength );
+			pClip->name = ReadString( unNameOffset, unNameLength );
+
+			reader.Read( pClip->duration );
+			reader.ReadArray( pClip->times );
+			reader.ReadArray( pClip->values );
+			reader.ReadArray( pClip->tracks );
+			reader.ReadArray( pClip->samplers );
+			reader.ReadArray( pClip->channels );
+
+			if ( reader.failed )
+				return false;
+
+			for ( const SAnimationTrack &track : pClip->tracks )
+			{
+				if ( static_cast< uint64_t >( track.firstKey ) + track.keyCount > pClip->times.size() )
+					return false;
+			}
+
+			for ( const SAnimationSampler &sampler : pClip->samplers )
+			{
+				const bool bComponentsValid = sampler.path == EAnimationPath::Weights ? sampler.components > 0 : sampler.components == ( sampler.path == EAnimationPath::Rotation ? 4 : 3 );
+				if ( sampler.track >= pClip->tracks.size() || !bComponentsValid )
+					return false;
+
+				const uint64_t unValueCount = static_cast< uint64_t >( pClip->tracks[ sampler.track ].keyCount ) * sampler.components * ( sampler.interpolation == EAnimationInterpolation::CubicSpline ? 3 : 1 );
+				if ( sampler.firstValue + unValueCount > pClip->values.size() )
+					return false;
+			}
+
+			for ( const SAnimationChannel &channel : pClip->channels )
+			{
+				if ( channel.sampler >= pClip->samplers.size() || pClip->samplers[ channel.sampler ].path != channel.path )
+					return false;
+			}
+
+			outRenderModel->animations.push_back( std::move( pClip ) );
+		}
+
+		return true;
+	}
+
+	const uint8_t *CModelCacheFile::GetTextureData( uint32_t unTexture, size_t &outSize )
+	{
+		outSize = 0;
+
+		const SModelCacheChunk *pTextures = FindChunk( EModelCacheChunk::Textures, sizeof( SModelCacheTexture ) );
+		const SModelCacheChunk *pData = FindChunk( EModelCacheChunk::TextureData );
+		if ( !pTextures || !pData || unTexture >= pTextures->count )
+			return nullptr;
+
+		SModelCacheTexture record;
+		memcpy( &record, GetChunkData( pTextures ) + sizeof( SModelCacheTexture ) * unTexture, sizeof( SModelCacheTexture ) );
+		if ( record.dataSize == 0 || record.dataOffset > pData->size || record.dataSize > pData->size - record.dataOffset )
+			return nullptr;
+
+		outSize = static_cast< size_t >( record.dataSize );
+		return GetChunkData( pData ) + record.dataOffset;
+	}
+
+} // namespace xrlib
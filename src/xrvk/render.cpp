@@ -573,6 +573,15 @@ namespace xrlib
 			result = vkAllocateCommandBuffers( GetLogicalDevice(), &commandBufferAlloc, &m_vecMultiviewRenderTargets.back().vkTransferCommandBuffer );
 			assert( result == VK_SUCCESS );
 
+			// Secondary command buffers for the main subpass (cached and per frame draws)
+			commandBufferAlloc.commandPool = m_vkRenderCommandPool;
+			commandBufferAlloc.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			result = vkAllocateCommandBuffers( GetLogicalDevice(), &commandBufferAlloc, &m_vecMultiviewRenderTargets.back().vkCachedDrawCommandBuffer );
+			assert( result == VK_SUCCESS );
+
+			result = vkAllocateCommandBuffers( GetLogicalDevice(), &commandBufferAlloc, &m_vecMultiviewRenderTargets.back().vkDynamicDrawCommandBuffer );
+			assert( result == VK_SUCCESS );
+
 			// Fences
 			VkFenceCreateInfo fenceCI { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
 			result = vkCreateFence( GetLogicalDevice(), &fenceCI, nullptr, &m_vecMultiviewRenderTargets.back().vkRenderCommandFence );
@@ -1454,12 +1463,13 @@ namespace xrlib
 		VkRenderPass vkRenderPass, 
 		std::string sVertexShaderFilename, 
 		std::string sFragmentShaderFilename,
-		bool bCreateAsMainPBRPipeline )
+		bool bCreateAsMainPBRPipeline,
+		const SVertexFormat &vertexFormat )
 	{
 		assert( pRenderInfo && unPbrDescriptorPoolCount > 0 );
 
 		SShaderSet *pShaderSet = new SShaderSet( sVertexShaderFilename, sFragmentShaderFilename );
-		SetupPBRVertexAttributes( *pShaderSet );
+		SetupPBRVertexAttributes( *pShaderSet, vertexFormat );
 
 		#ifdef XR_USE_PLATFORM_ANDROID
 			pShaderSet->Init( assetManager, GetLogicalDevice() );
@@ -1508,12 +1518,13 @@ namespace xrlib
 		const std::string &sFragmentShaderFilename,
 		SPipelineStateInfo &pipelineState,
 		bool bCreateAsMainPBRPipeline,
-		uint32_t unDescriptorPoolCount )
+		uint32_t unDescriptorPoolCount,
+		const SVertexFormat &vertexFormat )
 	{
 		assert( pRenderInfo && !sVertexShaderFilename.empty() && !sFragmentShaderFilename.empty() );
 
 		SShaderSet *pShaderSet = new SShaderSet( sVertexShaderFilename, sFragmentShaderFilename );
-		SetupPBRVertexAttributes( *pShaderSet );
+		SetupPBRVertexAttributes( *pShaderSet, vertexFormat );
 
 		#ifdef XR_USE_PLATFORM_ANDROID
 			pShaderSet->Init( assetManager, GetLogicalDevice() );
@@ -1556,6 +1567,177 @@ namespace xrlib
 			m_bUseVisMask ? 2 : 0 );
 	}
 
+	VkResult CStereoRender::CreateGraphicsPipeline_SkinnedPBR(
+		#ifdef XR_USE_PLATFORM_ANDROID
+			AAssetManager *assetManager,
+		#endif
+		SPipelines &outPipelines,
+		uint32_t &outPipelineIndex,
+		CRenderInfo *pRenderInfo,
+		VkRenderPass vkRenderPass,
+		const std::string &sVertexShaderFilename,
+		const std::string &sFragmentShaderFilename,
+		const SVertexFormat &vertexFormat,
+		uint32_t unMaxFrameJoints )
+	{
+		assert( pRenderInfo && !sVertexShaderFilename.empty() && !sFragmentShaderFilename.empty() );
+		assert( pRenderInfo->vecPipelineLayouts[ outPipelines.pbrLayout ] != VK_NULL_HANDLE );
+		assert( vertexFormat.layout == EVertexLayout::Full );
+
+		// Joint matrix ring (one region per swapchain image) and its descriptor set, shared by all skinned pipelines
+		VK_CHECK_RESULT( pRenderInfo->SetupSkinning( std::max< uint32_t >( static_cast< uint32_t >( GetMultiviewRenderTargets().size() ), 1 ), unMaxFrameJoints ) );
+
+		SShaderSet *pShaderSet = new SShaderSet( sVertexShaderFilename, sFragmentShaderFilename );
+		SetupPBRVertexAttributes( *pShaderSet, vertexFormat );
+
+		#ifdef XR_USE_PLATFORM_ANDROID
+			pShaderSet->Init( assetManager, GetLogicalDevice() );
+		#else
+			pShaderSet->Init( GetLogicalDevice() );
+		#endif
+
+		// Sets 0 and 1 match the pbr layout, so material and lighting sets bind the same way
+		if ( pRenderInfo->skinnedLayoutIndex == std::numeric_limits< uint16_t >::max() )
+			pRenderInfo->skinnedLayoutIndex = pRenderInfo->AddNewLayout();
+
+		outPipelines.skinnedPbrLayout = pRenderInfo->skinnedLayoutIndex;
+
+		outPipelineIndex = pRenderInfo->AddNewPipeline();
+		outPipelines.skinnedPbr = outPipelineIndex;
+
+		std::vector< VkDescriptorSetLayout > layouts = { 
+			pRenderInfo->pDescriptors->GetDescriptorSetLayout( outPipelines.pbrFragmentDescriptorLayout ), 
+			pRenderInfo->pDescriptors->GetDescriptorSetLayout( pRenderInfo->lightingLayoutId ),
+			pRenderInfo->pDescriptors->GetDescriptorSetLayout( pRenderInfo->skinLayoutId ) };
+
+		SPipelineCreationParams params { 
+			.renderPass = vkRenderPass, 
+			.useVisMask = m_bUseVisMask, 
+			.depthFormat = m_vkDepthFormat, 
+			.subpassIndex = static_cast< uint32_t >( m_bUseVisMask ? 2 : 0 ) 
+		};
+
+		VkResult result = CreateBasePipeline( 
+			pRenderInfo->vecPipelineLayouts[ pRenderInfo->skinnedLayoutIndex ], 
+			pRenderInfo->vecGraphicsPipelines[ outPipelineIndex ], 
+			pShaderSet, 
+			params, 
+			layouts );
+
+		delete pShaderSet;
+		return result;
+	}
+
+	VkResult CStereoRender::CreateGraphicsPipeline_DepthPrepass(
+		#ifdef XR_USE_PLATFORM_ANDROID
+			AAssetManager *assetManager,
+		#endif
+		SPipelines &outPipelines,
+		CRenderInfo *pRenderInfo,
+		VkRenderPass vkRenderPass,
+		const std::string &sVertexShaderFilename,
+		const std::string &sFragmentShaderFilename )
+	{
+		assert( pRenderInfo && !sVertexShaderFilename.empty() && !sFragmentShaderFilename.empty() );
+		assert( pRenderInfo->vecPipelineLayouts[ outPipelines.pbrLayout ] != VK_NULL_HANDLE );
+
+		SShaderSet *pShaderSet = new SShaderSet( sVertexShaderFilename, sFragmentShaderFilename );
+
+		// Position only stream and instances
+		pShaderSet->vertexBindings = { { 0, sizeof( XrVector3f ), VK_VERTEX_INPUT_RATE_VERTEX }, { 1, sizeof( XrMatrix4x4f ), VK_VERTEX_INPUT_RATE_INSTANCE } };
+		pShaderSet->vertexAttributes = { { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 } };
+		FillVertexAttributes< XrMatrix4x4f >( pShaderSet->vertexAttributes, 1, 8 );
+
+		#ifdef XR_USE_PLATFORM_ANDROID
+			pShaderSet->Init( assetManager, GetLogicalDevice() );
+		#else
+			pShaderSet->Init( GetLogicalDevice() );
+		#endif
+
+		SPipelineStateInfo state = CreateDefaultPipelineState( pShaderSet->vertexBindings, pShaderSet->vertexAttributes, GetTextureWidth(), GetTextureHeight() );
+		ConfigureDepthStencil( state.depthStencil, m_bUseVisMask, m_vkDepthFormat );
+
+		// Depth only
+		for ( auto &attachment : state.colorBlendAttachments )
+			attachment.colorWriteMask = 0;
+
+		outPipelines.depthPrepass = pRenderInfo->AddNewPipeline();
+		pRenderInfo->depthPrepassLayoutIndex = outPipelines.pbrLayout;
+
+		VkResult result = CreateGraphicsPipeline(
+			pRenderInfo->vecPipelineLayouts[ outPipelines.pbrLayout ],
+			pRenderInfo->vecGraphicsPipelines[ outPipelines.depthPrepass ],
+			vkRenderPass,
+			pShaderSet->stages,
+			&state.vertexInput,
+			&state.assembly,
+			nullptr,
+			&state.viewport,
+			&state.rasterization,
+			&state.multisample,
+			&state.depthStencil,
+			&state.colorBlend,
+			&state.dynamicState,
+			VK_NULL_HANDLE,
+			m_bUseVisMask ? 2 : 0 );
+
+		if ( result == VK_SUCCESS )
+			pRenderInfo->depthPrepassPipelineIndex = outPipelines.depthPrepass;
+
+		delete pShaderSet;
+		return result;
+	}
+
+	VkResult CStereoRender::CreateComputePipeline_Skinning(
+		#ifdef XR_USE_PLATFORM_ANDROID
+			AAssetManager *assetManager,
+		#endif
+		SPipelines &outPipelines,
+		CRenderInfo *pRenderInfo,
+		const std::string &sShaderFilename,
+		uint32_t unMaxFrameVertices,
+		uint32_t unMaxModels )
+	{
+		assert( pRenderInfo && !sShaderFilename.empty() && unMaxFrameVertices > 0 );
+		assert( !pRenderInfo->HasComputeSkinning() );
+
+		// Skinned vertex ring (one region per swapchain image, full vertex layout) and the per model descriptor set layout
+		VK_CHECK_RESULT( pRenderInfo->SetupComputeSkinning( 
+			std::max< uint32_t >( static_cast< uint32_t >( GetMultiviewRenderTargets().size() ), 1 ), 
+			(VkDeviceSize) unMaxFrameVertices * sizeof( SMeshVertex ), 
+			unMaxModels ) );
+
+		SShader shader( sShaderFilename );
+
+		#ifdef XR_USE_PLATFORM_ANDROID
+			VkPipelineShaderStageCreateInfo stageCI = shader.Init( assetManager, GetLogicalDevice(), VK_SHADER_STAGE_COMPUTE_BIT );
+		#else
+			VkPipelineShaderStageCreateInfo stageCI = shader.Init( GetLogicalDevice(), VK_SHADER_STAGE_COMPUTE_BIT );
+		#endif
+
+		std::vector< VkPushConstantRange > pcRanges = { { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( SSkinningPushConstants ) } };
+		std::vector< VkDescriptorSetLayout > layouts = { pRenderInfo->pDescriptors->GetDescriptorSetLayout( pRenderInfo->skinningLayoutId ) };
+		VkPipelineLayoutCreateInfo layoutCI = GeneratePipelineLayoutCI( pcRanges, layouts );
+
+		outPipelines.skinningLayout = pRenderInfo->AddNewLayout();
+		VK_CHECK_RESULT( vkCreatePipelineLayout( GetLogicalDevice(), &layoutCI, nullptr, &pRenderInfo->vecPipelineLayouts[ outPipelines.skinningLayout ] ) );
+
+		VkComputePipelineCreateInfo pipelineCI { VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+		pipelineCI.stage = stageCI;
+		pipelineCI.layout = pRenderInfo->vecPipelineLayouts[ outPipelines.skinningLayout ];
+
+		outPipelines.skinning = pRenderInfo->AddNewPipeline();
+		VkResult result = vkCreateComputePipelines( GetLogicalDevice(), VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &pRenderInfo->vecGraphicsPipelines[ outPipelines.skinning ] );
+
+		if ( result == VK_SUCCESS )
+		{
+			pRenderInfo->skinningLayoutIndex = outPipelines.skinningLayout;
+			pRenderInfo->skinningPipelineIndex = outPipelines.skinning;
+		}
+
+		return result;
+	}
+
 	VkResult CStereoRender::CreateGraphicsPipeline(
 		VkPipelineLayout &outLayout, 
 		VkPipeline &outPipeline, 
@@ -1645,7 +1827,7 @@ namespace xrlib
 		{
 			outDepthStencilCI.depthTestEnable = VK_TRUE;
 			outDepthStencilCI.depthWriteEnable = VK_TRUE;
-			outDepthStencilCI.depthCompareOp = VK_COMPARE_OP_LESS;
+			outDepthStencilCI.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL; // equal passes for surfaces laid down by the depth prepass
 			outDepthStencilCI.stencilTestEnable = bUseVisMask ? VK_TRUE : VK_FALSE;
 			outDepthStencilCI.depthBoundsTestEnable = VK_FALSE;
 
@@ -1682,16 +1864,19 @@ namespace xrlib
 
 		VK_CHECK_RESULT( pRenderInfo->pDescriptors->CreateDescriptorSetLayout( outPipelines.pbrFragmentDescriptorLayout, pbrBindings ) );
 
-		VK_CHECK_RESULT( pRenderInfo->pDescriptors->CreateDescriptorPool( outPipelines.pbrFragmentDescriptorPool, outPipelines.pbrFragmentDescriptorLayout, poolCount ) );
+		// Material sets are freed when their model's materials are replaced (see CGltf::UpdateAsyncLoads)
+		VK_CHECK_RESULT( pRenderInfo->pDescriptors->CreateDescriptorPool( outPipelines.pbrFragmentDescriptorPool, outPipelines.pbrFragmentDescriptorLayout, poolCount, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT ) );
 
 		// Setup lighting descriptors
-		VkDescriptorPoolSize lightingPoolSize { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 };
+		VkDescriptorPoolSize lightingPoolSize { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2 };
 
 		VkDescriptorPoolCreateInfo lightingPoolInfo { .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO, .maxSets = 1, .poolSizeCount = 1, .pPoolSizes = &lightingPoolSize };
 
 		VK_CHECK_RESULT( pRenderInfo->pDescriptors->CreateDescriptorPool( pRenderInfo->lightingPoolId, lightingPoolInfo ) );
 
-		std::vector< SDescriptorBinding > lightingBindings = { { 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT } };
+		std::vector< SDescriptorBinding > lightingBindings = { 
+			{ 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT },		// Scene lighting
+			{ 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT } };		// Scene view (eye matrices)
 
 		VK_CHECK_RESULT( pRenderInfo->pDescriptors->CreateDescriptorSetLayout( pRenderInfo->lightingLayoutId, lightingBindings ) );
 
@@ -1716,23 +1901,22 @@ namespace xrlib
 			{ 5, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 12 * sizeFloat } };
 	}
 
-	void CStereoRender::SetupPBRVertexAttributes( SShaderSet &shaderSet ) 
+	void CStereoRender::SetupPBRVertexAttributes( SShaderSet &shaderSet, const SVertexFormat &vertexFormat ) 
 	{
-		shaderSet.vertexBindings = { { 0, sizeof( SMeshVertex ), VK_VERTEX_INPUT_RATE_VERTEX }, { 1, sizeof( XrMatrix4x4f ), VK_VERTEX_INPUT_RATE_INSTANCE } };
+		// Positions (if split), mesh vertex attributes, then instances
+		const uint32_t unInstanceBinding = vertexFormat.GetBindingCount();
 
-		shaderSet.vertexAttributes = {
-			{ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof( SMeshVertex, position ) },
-			{ 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof( SMeshVertex, normal ) },
-			{ 2, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof( SMeshVertex, tangent ) },
-			{ 3, 0, VK_FORMAT_R32G32_SFLOAT, offsetof( SMeshVertex, uv0 ) },
-			{ 4, 0, VK_FORMAT_R32G32_SFLOAT, offsetof( SMeshVertex, uv1 ) },
-			{ 5, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof( SMeshVertex, color0 ) },
-			{ 6, 0, VK_FORMAT_R32G32B32A32_SINT, offsetof( SMeshVertex, joints ) },
-			{ 7, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof( SMeshVertex, weights ) },
-			{ 8, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 0 },
-			{ 9, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 16 },
-			{ 10, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 32 },
-			{ 11, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 48 } };
+		shaderSet.vertexBindings.clear();
+		if ( vertexFormat.splitPositions )
+			shaderSet.vertexBindings.push_back( { 0, sizeof( XrVector3f ), VK_VERTEX_INPUT_RATE_VERTEX } );
+
+		shaderSet.vertexBindings.push_back( { unInstanceBinding - 1, vertexFormat.GetStride(), VK_VERTEX_INPUT_RATE_VERTEX } );
+		shaderSet.vertexBindings.push_back( { unInstanceBinding, sizeof( XrMatrix4x4f ), VK_VERTEX_INPUT_RATE_INSTANCE } );
+
+		// Mesh vertex (locations 0-7, compact formats may leave some out), then instance model matrix columns
+		shaderSet.vertexAttributes.clear();
+		FillVertexAttributes( shaderSet.vertexAttributes, 0, 0, vertexFormat );
+		FillVertexAttributes< XrMatrix4x4f >( shaderSet.vertexAttributes, unInstanceBinding, 8 );
 	}
 
 	VkResult CStereoRender::CreateBasePipeline( 
@@ -1743,9 +1927,10 @@ namespace xrlib
 		std::vector< VkDescriptorSetLayout > &layouts ) 
 	{ 
 		
+		// No push constants, the pbr shaders read the eye matrices from the scene view uniform
 		if ( outLayout == VK_NULL_HANDLE && !layouts.empty() )
 		{
-			std::vector< VkPushConstantRange > pcRanges = { GetEyeMatricesPushConstant() };
+			std::vector< VkPushConstantRange > pcRanges;
 			VkPipelineLayoutCreateInfo layoutCI = GeneratePipelineLayoutCI( pcRanges, layouts );
 			VK_CHECK_RESULT( vkCreatePipelineLayout( GetLogicalDevice(), &layoutCI, nullptr, &outLayout ) );
 		}
@@ -1869,8 +2054,77 @@ namespace xrlib
 				XrMatrix4x4f_Multiply( &state.eyeVPs[ k_Left ], &state.eyeProjectionMatrices[ k_Left ], &state.eyeViewMatrices[ k_Left ] );
 				XrMatrix4x4f_Multiply( &state.eyeVPs[ k_Right ], &state.eyeProjectionMatrices[ k_Right ], &state.eyeViewMatrices[ k_Right ] );
 
+				// Update scene view buffer (eye matrices for shaders that don't use push constants)
+				if ( pRenderInfo->pSceneView )
+					memcpy( pRenderInfo->pSceneView->eyeVPs, state.eyeVPs.data(), sizeof( SSceneView ) );
+
+				// Main subpass is recorded into secondary command buffers if any renderable has cacheable draws
+				const bool bUseSecondaryDraws = useCachedDrawCommands && HasCachedDraws( pRenderInfo );
+				const VkSubpassContents mainSubpassContents = bUseSecondaryDraws ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+
+				// Begin recording, then submit queued uploads and acquire the finished ones before the render pass starts
+				BeginDraw( state.unCurrentSwapchainImage_Color, state.clearValues, true, VK_NULL_HANDLE );
+				CUploadManager::Get( m_pSession )->Update( GetMultiviewRenderTargets().at( state.unCurrentSwapchainImage_Color ).vkRenderCommandBuffer );
+
+				if ( pRenderInfo->pResidencyManager )
+					pRenderInfo->pResidencyManager->Update();
+
+				// Copy model matrices to gpu buffer (ahead of the render pass, so per frame compute work can use them)
+				state.ClearStagingBuffers();
+				{
+					// Begin buffer recording to gpu
+					BeginBufferUpdates( state.unCurrentSwapchainImage_Color );
+
+					// Geometry pool ranges freed enough frames ago can be reused
+					if ( pRenderInfo->pGeometryPool )
+						pRenderInfo->pGeometryPool->Update();
+
+					// Joint matrices and skinned vertices go to this swapchain image's region, the gpu is done with its last frame
+					if ( pRenderInfo->pJointMatrices )
+						pRenderInfo->pJointMatrices->BeginFrame( state.unCurrentSwapchainImage_Color );
+
+					if ( pRenderInfo->pSkinnedVertices )
+						pRenderInfo->pSkinnedVertices->BeginFrame( state.unCurrentSwapchainImage_Color );
+
+					// Update asset buffers
+					XrTime renderTime = state.frameState.predictedDisplayTime + state.frameState.predictedDisplayPeriod;
+
+					for ( auto &renderable : pRenderInfo->vecRenderables )
+					{
+						if ( !renderable->isVisible )
+							continue;
+
+						// Mark as drawn, restores it if it was evicted
+						if ( pRenderInfo->pResidencyManager )
+							pRenderInfo->pResidencyManager->Touch( renderable );
+
+						// Update matrices (for each instance)
+						for ( uint32_t i = 0; i < renderable->instances.size(); i++ )
+							renderable->UpdateModelMatrix( i, m_pSession->GetAppSpace(), renderTime );
+
+						// Node hierarchies go on top of the model matrices
+						renderable->UpdateSceneGraph();
+
+						// Joint matrices of skinned renderables (e.g. posed by CAnimator or hand tracking) to the ring
+						renderable->UpdateSkins( *pRenderInfo );
+
+						// Pick levels of detail from the updated matrices
+						renderable->UpdateLods( *pRenderInfo );
+
+						// Add to render
+						state.vecStagingBuffers.push_back( renderable->UpdateInstancesBuffer( GetMultiviewRenderTargets().at( state.unCurrentSwapchainImage_Color ).vkTransferCommandBuffer ) );
+					}
+
+					// Submit to gpu
+					SubmitBufferUpdates( state.unCurrentSwapchainImage_Color );
+				}
+
+				// Skin vertices once for every pass that draws them
+				if ( pRenderInfo->HasComputeSkinning() )
+					DispatchSkinning( GetMultiviewRenderTargets().at( state.unCurrentSwapchainImage_Color ).vkRenderCommandBuffer, pRenderInfo );
+
 				// Begin draw commands for rendering
-				BeginDraw( state.unCurrentSwapchainImage_Color, state.clearValues, true, renderPass );
+				BeginDraw( state.unCurrentSwapchainImage_Color, state.clearValues, false, renderPass, m_bUseVisMask ? VK_SUBPASS_CONTENTS_INLINE : mainSubpassContents );
 
 				// Draw vismask (if activated)
 				if ( m_bUseVisMask && stencils.size() == 2 )
@@ -1913,40 +2167,44 @@ namespace xrlib
 					}
 
 					// Transition to the next subpass for main rendering
-					vkCmdNextSubpass( GetMultiviewRenderTargets().at( state.unCurrentSwapchainImage_Color ).vkRenderCommandBuffer, VK_SUBPASS_CONTENTS_INLINE );
+					vkCmdNextSubpass( GetMultiviewRenderTargets().at( state.unCurrentSwapchainImage_Color ).vkRenderCommandBuffer, mainSubpassContents );
 				}
 
-				// Copy model matrices to gpu buffer
-				state.ClearStagingBuffers();
+				//  Main rendering subpass: Draw render assets
+				if ( bUseSecondaryDraws )
 				{
-					// Begin buffer recording to gpu
-					BeginBufferUpdates( state.unCurrentSwapchainImage_Color );
+					SMultiviewRenderTarget &renderTarget = GetMultiviewRenderTargets().at( state.unCurrentSwapchainImage_Color );
 
-					// Update asset buffers
-					XrTime renderTime = state.frameState.predictedDisplayTime + state.frameState.predictedDisplayPeriod;
+					// Only re-record cached draws if the scene changed since these were last recorded for this swapchain image
+					if ( !IsDrawCacheValid( state.unCurrentSwapchainImage_Color, renderPass, pRenderInfo ) )
+						RecordCachedDraws( state.unCurrentSwapchainImage_Color, renderPass, pRenderInfo );
 
-					for ( auto &renderable : pRenderInfo->vecRenderables )
-					{
-						if ( !renderable->isVisible )
-							continue;
+					RecordDynamicDraws( state.unCurrentSwapchainImage_Color, renderPass, pRenderInfo );
 
-						// Update matrices (for each instance)
-						for ( uint32_t i = 0; i < renderable->instances.size(); i++ )
-							renderable->UpdateModelMatrix( i, m_pSession->GetAppSpace(), renderTime );
+					VkCommandBuffer secondaryDraws[] = { renderTarget.vkCachedDrawCommandBuffer, renderTarget.vkDynamicDrawCommandBuffer };
+					vkCmdExecuteCommands( renderTarget.vkRenderCommandBuffer, 2, secondaryDraws );
+				}
+				else
+				{
+					VkCommandBuffer vkRenderCommandBuffer = GetMultiviewRenderTargets().at( state.unCurrentSwapchainImage_Color ).vkRenderCommandBuffer;
+					if ( pRenderInfo->pGeometryPool )
+						pRenderInfo->pGeometryPool->ResetBindings( vkRenderCommandBuffer );
 
-						// Add to render
-						state.vecStagingBuffers.push_back( renderable->UpdateInstancesBuffer( GetMultiviewRenderTargets().at( state.unCurrentSwapchainImage_Color ).vkTransferCommandBuffer ) );
+					// Depth prepass first, so the main draws only shade visible fragments
+					if ( useDepthPrepass && pRenderInfo->HasDepthPrepass() )
+					{
+						for ( auto &renderable : pRenderInfo->vecRenderables )
+						{
+							if ( renderable->isVisible )
+								DrawRenderable( vkRenderCommandBuffer, renderable, pRenderInfo, true );
+						}
 					}
 
-					// Submit to gpu
-					SubmitBufferUpdates( state.unCurrentSwapchainImage_Color );
-				}
-
-				//  Main rendering subpass: Draw render assets
-				for ( auto &renderable : pRenderInfo->vecRenderables )
-				{
-					if ( renderable->isVisible )
-						renderable->Draw( GetMultiviewRenderTargets().at( state.unCurrentSwapchainImage_Color ).vkRenderCommandBuffer, *pRenderInfo );
+					for ( auto &renderable : pRenderInfo->vecRenderables )
+					{
+						if ( renderable->isVisible )
+							DrawRenderable( vkRenderCommandBuffer, renderable, pRenderInfo, false );
+					}
 				}
 				
 				// Submit draw calls to gpu - this will also clear the staging buffers (if any)
@@ -2053,11 +2311,19 @@ namespace xrlib
 
 		vecStagingBuffers.clear();
 
+		// Wait on upload batches submitted this frame, their acquires are recorded in this command buffer
+		std::vector< VkSemaphore > vecWaitSemaphores;
+		std::vector< VkPipelineStageFlags > vecWaitStages;
+		CUploadManager::Get( m_pSession )->GetWaitSemaphores( vecWaitSemaphores, vecWaitStages );
+
 		// Execute render commands (requires exclusive access to vkQueue)
 		// safest after wait swapchain image
 		VkSubmitInfo submitInfo { VK_STRUCTURE_TYPE_SUBMIT_INFO };
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &m_vecMultiviewRenderTargets[ unSwpachainImageIndex ].vkRenderCommandBuffer;
+		submitInfo.waitSemaphoreCount = (uint32_t) vecWaitSemaphores.size();
+		submitInfo.pWaitSemaphores = vecWaitSemaphores.empty() ? nullptr : vecWaitSemaphores.data();
+		submitInfo.pWaitDstStageMask = vecWaitStages.empty() ? nullptr : vecWaitStages.data();
 		vkQueueSubmit( GetAppSession()->GetVulkan()->GetVkQueue_Graphics(), 1, &submitInfo, m_vecMultiviewRenderTargets[ unSwpachainImageIndex ].vkRenderCommandFence );
 
 		// Wait for rendering to finish
@@ -2067,6 +2333,171 @@ namespace xrlib
 		vkResetCommandBuffer( m_vecMultiviewRenderTargets[ unSwpachainImageIndex ].vkRenderCommandBuffer, renderBufferResetFlags );
 	}
 
+	bool CStereoRender::HasCachedDraws( CRenderInfo *pRenderInfo ) 
+	{
+		for ( auto &renderable : pRenderInfo->vecRenderables )
+		{
+			if ( renderable->isVisible && renderable->cacheDrawCommands )
+				return true;
+		}
+
+		return false;
+	}
+
+	bool CStereoRender::IsDrawCacheValid( const uint32_t unSwpachainImageIndex, const VkRenderPass renderPass, CRenderInfo *pRenderInfo ) 
+	{
+		SMultiviewRenderTarget &renderTarget = m_vecMultiviewRenderTargets[ unSwpachainImageIndex ];
+
+		if ( renderTarget.unCachedSceneVersion != pRenderInfo->sceneVersion || renderTarget.vkCachedRenderPass != renderPass )
+			return false;
+
+		if ( renderTarget.bCachedDepthPrepass != ( useDepthPrepass && pRenderInfo->HasDepthPrepass() ) )
+			return false;
+
+		// Catch visibility toggles and buffer re-inits of the recorded renderables
+		size_t unCachedIndex = 0;
+		for ( auto &renderable : pRenderInfo->vecRenderables )
+		{
+			if ( !renderable->isVisible || !renderable->cacheDrawCommands )
+				continue;
+
+			if ( unCachedIndex >= renderTarget.vecCachedDraws.size() )
+				return false;
+
+			auto &cachedDraw = renderTarget.vecCachedDraws[ unCachedIndex++ ];
+			if ( cachedDraw.first != renderable || cachedDraw.second != renderable->GetDrawVersion() )
+				return false;
+		}
+
+		return unCachedIndex == renderTarget.vecCachedDraws.size();
+	}
+
+	void CStereoRender::RecordCachedDraws( const uint32_t unSwpachainImageIndex, const VkRenderPass renderPass, CRenderInfo *pRenderInfo ) 
+	{
+		SMultiviewRenderTarget &renderTarget = m_vecMultiviewRenderTargets[ unSwpachainImageIndex ];
+
+		VkCommandBufferInheritanceInfo inheritanceInfo { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+		inheritanceInfo.renderPass = renderPass;
+		inheritanceInfo.subpass = m_bUseVisMask ? 2 : 0;
+		inheritanceInfo.framebuffer = renderTarget.vkFrameBuffer;
+
+		VkCommandBufferBeginInfo beginInfo { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		renderTarget.vecCachedDraws.clear();
+		renderTarget.bCachedDepthPrepass = useDepthPrepass && pRenderInfo->HasDepthPrepass();
+		vkBeginCommandBuffer( renderTarget.vkCachedDrawCommandBuffer, &beginInfo );
+
+		if ( pRenderInfo->pGeometryPool )
+			pRenderInfo->pGeometryPool->ResetBindings( renderTarget.vkCachedDrawCommandBuffer );
+
+		if ( renderTarget.bCachedDepthPrepass )
+		{
+			for ( auto &renderable : pRenderInfo->vecRenderables )
+			{
+				if ( renderable->isVisible && renderable->cacheDrawCommands )
+					DrawRenderable( renderTarget.vkCachedDrawCommandBuffer, renderable, pRenderInfo, true );
+			}
+		}
+
+		for ( auto &renderable : pRenderInfo->vecRenderables )
+		{
+			if ( !renderable->isVisible || !renderable->cacheDrawCommands )
+				continue;
+
+			DrawRenderable( renderTarget.vkCachedDrawCommandBuffer, renderable, pRenderInfo, false );
+			renderTarget.vecCachedDraws.push_back( { renderable, renderable->GetDrawVersion() } );
+		}
+
+		vkEndCommandBuffer( renderTarget.vkCachedDrawCommandBuffer );
+
+		renderTarget.vkCachedRenderPass = renderPass;
+		renderTarget.unCachedSceneVersion = pRenderInfo->sceneVersion;
+
+		if ( CheckLogLevelVerbose( GetMinLogLevel() ) )
+			LogVerbose( "", "Re-recorded cached draws for swapchain image %i (%i renderables, scene version %llu)", unSwpachainImageIndex, (uint32_t) renderTarget.vecCachedDraws.size(), (unsigned long long) pRenderInfo->sceneVersion );
+	}
+
+	void CStereoRender::RecordDynamicDraws( const uint32_t unSwpachainImageIndex, const VkRenderPass renderPass, CRenderInfo *pRenderInfo ) 
+	{
+		SMultiviewRenderTarget &renderTarget = m_vecMultiviewRenderTargets[ unSwpachainImageIndex ];
+
+		VkCommandBufferInheritanceInfo inheritanceInfo { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+		inheritanceInfo.renderPass = renderPass;
+		inheritanceInfo.subpass = m_bUseVisMask ? 2 : 0;
+		inheritanceInfo.framebuffer = renderTarget.vkFrameBuffer;
+
+		VkCommandBufferBeginInfo beginInfo { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		// Renderables that push per frame data (e.g. eye matrices as push constants) are recorded every frame
+		vkBeginCommandBuffer( renderTarget.vkDynamicDrawCommandBuffer, &beginInfo );
+
+		if ( pRenderInfo->pGeometryPool )
+			pRenderInfo->pGeometryPool->ResetBindings( renderTarget.vkDynamicDrawCommandBuffer );
+
+		if ( useDepthPrepass && pRenderInfo->HasDepthPrepass() )
+		{
+			for ( auto &renderable : pRenderInfo->vecRenderables )
+			{
+				if ( renderable->isVisible && !renderable->cacheDrawCommands )
+					DrawRenderable( renderTarget.vkDynamicDrawCommandBuffer, renderable, pRenderInfo, true );
+			}
+		}
+
+		for ( auto &renderable : pRenderInfo->vecRenderables )
+		{
+			if ( renderable->isVisible && !renderable->cacheDrawCommands )
+				DrawRenderable( renderTarget.vkDynamicDrawCommandBuffer, renderable, pRenderInfo, false );
+		}
+
+		vkEndCommandBuffer( renderTarget.vkDynamicDrawCommandBuffer );
+	}
+
+	void CStereoRender::DrawRenderable( const VkCommandBuffer commandBuffer, CRenderable *pRenderable, CRenderInfo *pRenderInfo, bool bDepthOnly ) 
+	{
+		if ( bDepthOnly )
+			pRenderable->DrawDepth( commandBuffer, *pRenderInfo );
+		else
+			pRenderable->Draw( commandBuffer, *pRenderInfo );
+
+		if ( pRenderInfo->pGeometryPool && !pRenderable->UsesGeometryPool() )
+			pRenderInfo->pGeometryPool->ResetBindings( commandBuffer );
+	}
+
+	void CStereoRender::DispatchSkinning( const VkCommandBuffer commandBuffer, CRenderInfo *pRenderInfo ) 
+	{
+		vkCmdBindPipeline( commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pRenderInfo->vecGraphicsPipelines[ pRenderInfo->skinningPipelineIndex ] );
+
+		bool bDispatched = false;
+		for ( auto &renderable : pRenderInfo->vecRenderables )
+		{
+			if ( renderable->isVisible )
+				bDispatched |= renderable->DispatchSkinning( commandBuffer, *pRenderInfo );
+		}
+
+		if ( !bDispatched )
+			return;
+
+		// One barrier for all skinned models, the ring is only read as vertex buffers after this
+		VkMemoryBarrier barrier { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+
+		vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr );
+	}
+
+	void CStereoRender::InvalidateDrawCache() 
+	{
+		for ( auto &renderTarget : m_vecMultiviewRenderTargets )
+		{
+			renderTarget.unCachedSceneVersion = std::numeric_limits< uint64_t >::max();
+			renderTarget.vecCachedDraws.clear();
+		}
+	}
+
 	void CStereoRender::BeginBufferUpdates( const uint32_t unSwpachainImageIndex ) 
 	{ 
 		VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
@@ -12,6 +12,7 @@
 
 
 #include <xrvk/renderables.hpp>
+#include <xrvk/ringbuffer.hpp>
 
 namespace xrlib
 {
@@ -32,7 +33,7 @@ namespace xrlib
 			descriptorLayoutIndex( descriptorLayoutIdx ),
 			isVisible( bIsVisible )
 	{
-		assert( pSession );
+		// A null session is only valid for cpu side models (e.g. offline imports), which never create buffers
 
 		// Fill descriptors (if any)
 		if ( descriptorLayoutIdx < std::numeric_limits< uint32_t >::max() )
@@ -68,7 +69,8 @@ namespace xrlib
 			delete m_pInstanceBuffer;
 
 		m_pInstanceBuffer = new CDeviceBuffer( m_pSession );
-		assert( InitBuffer( m_pInstanceBuffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof( XrMatrix4x4f ) * instanceMatrices.size(), nullptr ) == VK_SUCCESS );
+		VkResult result = InitBuffer( m_pInstanceBuffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, sizeof( XrMatrix4x4f ) * instanceMatrices.size(), nullptr );
+		assert( result == VK_SUCCESS );
 
 		return GetInstanceCount();
 	}
@@ -76,13 +78,15 @@ namespace xrlib
 	VkResult CRenderable::InitBuffer( CDeviceBuffer *pBuffer, VkBufferUsageFlags usageFlags, VkDeviceSize unSize, void *pData, VkMemoryPropertyFlags memPropFlags, VkAllocationCallbacks *pCallbacks )
 	{
 		assert( pBuffer );
-		return pBuffer->Init( usageFlags, memPropFlags, unSize, pData, pCallbacks );
+		m_unDrawVersion++;
+		return pBuffer->Init( usageFlags, memPropFlags, unSize, pData, true, pCallbacks );
 	}
 
 	VkResult CRenderable::InitInstancesBuffer( CDeviceBuffer *pBuffer, VkBufferUsageFlags usageFlags, VkDeviceSize unSize, void *pData, VkMemoryPropertyFlags memPropFlags, VkAllocationCallbacks *pCallbacks )
 	{
 		assert( pBuffer );
-		return pBuffer->Init( usageFlags, memPropFlags, unSize, pData, pCallbacks );
+		m_unDrawVersion++;
+		return pBuffer->Init( usageFlags, memPropFlags, unSize, pData, true, pCallbacks );
 	}
 
 	CDeviceBuffer *CRenderable::UpdateInstancesBuffer( VkCommandBuffer transferCmdBuffer )
@@ -154,6 +158,7 @@ namespace xrlib
 	{ 
 		assert( pSession );
 
+		m_pSession = pSession;
 		m_device = pSession->GetVulkan()->GetVkLogicalDevice();
 		pDescriptors = new CDescriptorManager( pSession );
 	}
@@ -163,6 +168,15 @@ namespace xrlib
 		if ( pSceneLightingBuffer )
 			delete pSceneLightingBuffer;
 
+		if ( pSceneViewBuffer )
+			delete pSceneViewBuffer;
+
+		if ( pJointMatrices )
+			delete pJointMatrices;
+
+		if ( pSkinnedVertices )
+			delete pSkinnedVertices;
+
 		if ( pDescriptors )
 			delete pDescriptors;
 
@@ -194,12 +208,14 @@ namespace xrlib
 	uint16_t CRenderInfo::AddNewPipeline( VkPipeline pipeline ) 
 	{ 
 		vecGraphicsPipelines.push_back( pipeline );
+		BumpSceneVersion();
 		return static_cast<uint16_t> ( vecGraphicsPipelines.size() - 1 ); 
 	}
 
 	uint32_t CRenderInfo::AddNewRenderable( CRenderable *renderable ) 
 	{ 
 		vecRenderables.push_back( renderable );
+		BumpSceneVersion();
 		return vecRenderables.size() - 1;
 	}
 
@@ -257,6 +273,124 @@ namespace xrlib
 			VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
 			0,
 			sizeof( SSceneLighting ) );
+
+		// Create buffer for per frame eye matrices, kept mapped and written each frame
+		pSceneViewBuffer = pDescriptors->CreateBuffer( 
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
+			sizeof( SSceneView ) );
+
+		assert( pSceneViewBuffer );
+
+		if ( pSceneViewBuffer->MapMemory() == VK_SUCCESS )
+		{
+			pSceneView = static_cast< SSceneView * >( pSceneViewBuffer->GetMappedData() );
+			XrMatrix4x4f_CreateIdentity( &pSceneView->eyeVPs[ 0 ] );
+			XrMatrix4x4f_CreateIdentity( &pSceneView->eyeVPs[ 1 ] );
+		}
+
+		pDescriptors->UpdateUniformBuffer(
+			descriptors,
+			1, // binding = 1 in vertex shader (set 1)
+			pSceneViewBuffer->GetVkBuffer(),
+			VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+			0,
+			sizeof( SSceneView ) );
+	}
+
+	VkResult CRenderInfo::SetupSkinning( uint32_t unFrameCount, uint32_t unMaxFrameJoints ) 
+	{
+		assert( pDescriptors && unFrameCount > 0 );
+
+		if ( pJointMatrices )
+			return VK_SUCCESS;
+
+		// One region per frame in flight, so joint matrices of frames still on the gpu aren't overwritten
+		CFrameRingBuffer *pRing = new CFrameRingBuffer( m_pSession );
+		VkResult result = pRing->Init( 
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
+			(VkDeviceSize) unMaxFrameJoints * sizeof( XrMatrix4x4f ), 
+			unFrameCount, 
+			(VkDeviceSize) k_unMaxSkinJoints * sizeof( XrMatrix4x4f ) );
+
+		if ( result != VK_SUCCESS )
+		{
+			delete pRing;
+			return result;
+		}
+
+		// Single dynamic storage buffer (set 2 in skinned vertex shaders), each skin's offset is passed when binding it
+		std::vector< SDescriptorBinding > skinBindings = { { 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_VERTEX_BIT } };
+
+		std::vector< VkDescriptorSet > skinSets;
+		if ( ( result = pDescriptors->CreateDescriptorSetLayout( skinLayoutId, skinBindings ) ) != VK_SUCCESS ||
+			 ( result = pDescriptors->CreateDescriptorPool( skinPoolId, skinLayoutId, 1 ) ) != VK_SUCCESS ||
+			 ( result = pDescriptors->CreateDescriptorSets( skinSets, skinLayoutId, skinPoolId, 1 ) ) != VK_SUCCESS )
+		{
+			delete pRing;
+			return result;
+		}
+
+		jointMatricesDescriptor = skinSets[ 0 ];
+		pDescriptors->UpdateUniformBuffer(
+			skinSets,
+			0,
+			pRing->GetBuffer()->GetVkBuffer(),
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+			0,
+			pRing->GetBindRange() );
+
+		pJointMatrices = pRing;
+		return VK_SUCCESS;
+	}
+
+	VkResult CRenderInfo::SetupComputeSkinning( uint32_t unFrameCount, VkDeviceSize unFrameBytes, uint32_t unMaxModels ) 
+	{
+		assert( pDescriptors && unFrameCount > 0 && unMaxModels > 0 );
+
+		if ( pSkinnedVertices )
+			return VK_SUCCESS;
+
+		// Joint matrices are shared with vertex shader skinning
+		VkResult result = SetupSkinning( unFrameCount );
+		if ( result != VK_SUCCESS )
+			return result;
+
+		// Written by the compute prepass and read as vertex buffers in the same frame, so the ring never needs to be host visible
+		CFrameRingBuffer *pRing = new CFrameRingBuffer( m_pSession );
+		result = pRing->Init( 
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 
+			unFrameBytes, 
+			unFrameCount, 
+			0, 
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+		if ( result != VK_SUCCESS )
+		{
+			delete pRing;
+			return result;
+		}
+
+		// Source positions and attributes, skinned positions and attributes (the model's ranges in the ring), joint matrices, morph deltas
+		// and the active morph targets (in the joint matrix ring). Each compute skinned model gets a set of its own as the sources are its buffers
+		std::vector< SDescriptorBinding > skinningBindings = { 
+			{ 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT },
+			{ 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT },
+			{ 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_COMPUTE_BIT },
+			{ 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_COMPUTE_BIT },
+			{ 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_COMPUTE_BIT },
+			{ 5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT },
+			{ 6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_COMPUTE_BIT } };
+
+		if ( ( result = pDescriptors->CreateDescriptorSetLayout( skinningLayoutId, skinningBindings ) ) != VK_SUCCESS ||
+			 ( result = pDescriptors->CreateDescriptorPool( skinningPoolId, skinningLayoutId, unMaxModels ) ) != VK_SUCCESS )
+		{
+			delete pRing;
+			return result;
+		}
+
+		pSkinnedVertices = pRing;
+		return VK_SUCCESS;
 	}
 
 } // namespace xrlib
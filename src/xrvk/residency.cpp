@@ -0,0 +1,152 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#include <xrvk/residency.hpp>
+
+namespace xrlib
+{
+	CResidencyManager::CResidencyManager( CSession *pSession, CRenderInfo *pRenderInfo, CTextureManager *pTextureManager, SResidencyConfig residencyConfig )
+		: config( residencyConfig )
+		, m_pSession( pSession )
+		, m_pRenderInfo( pRenderInfo )
+		, m_pTextureManager( pTextureManager )
+	{
+		assert( pSession && pRenderInfo && pTextureManager );
+
+		m_pAllocator = CDeviceMemoryAllocator::Get( m_pSession );
+
+		// Evicted material textures point here (1x1 white, same as the material defaults)
+		m_pTextureManager->CreateDefaultTexture( m_placeholderTexture );
+	}
+
+	CResidencyManager::~CResidencyManager() 
+	{
+		m_models.clear();
+		m_vecRestoring.clear();
+
+		m_pTextureManager->DestroyTexture( m_placeholderTexture );
+	}
+
+	void CResidencyManager::Register( CRenderModel *pModel ) 
+	{ 
+		assert( pModel );
+		m_models[ pModel ] = { pModel, m_unFrame };
+	}
+
+	void CResidencyManager::Unregister( CRenderModel *pModel ) 
+	{
+		m_models.erase( pModel );
+		m_vecRestoring.erase( std::remove( m_vecRestoring.begin(), m_vecRestoring.end(), pModel ), m_vecRestoring.end() );
+	}
+
+	void CResidencyManager::Touch( CRenderable *pRenderable ) 
+	{
+		auto it = m_models.find( pRenderable );
+		if ( it == m_models.end() )
+			return;
+
+		SResidencyEntry &entry = it->second;
+		entry.lastDrawnFrame = m_unFrame;
+
+		// Needed again - bring it back, it is drawn once the uploads have been acquired
+		if ( !entry.pModel->IsResident() && !entry.pModel->IsRestoring() )
+		{
+			if ( entry.pModel->Restore( m_pRenderInfo->pDescriptors ) == VK_SUCCESS )
+				m_vecRestoring.push_back( entry.pModel );
+			else
+				LogError( "", "Unable to restore evicted render model (%.2f MB)", entry.pModel->GetResidentBytes() / 1048576.0 );
+		}
+	}
+
+	void CResidencyManager::Update() 
+	{
+		m_unFrame++;
+
+		// Finish restores whose uploads are done
+		for ( auto it = m_vecRestoring.begin(); it != m_vecRestoring.end(); )
+		{
+			if ( ( *it )->PollRestore() )
+				it = m_vecRestoring.erase( it );
+			else
+				++it;
+		}
+
+		if ( m_pAllocator->GetDeviceLocalBudgetUsage() > config.evictThreshold )
+			EvictLeastRecentlyDrawn();
+	}
+
+	uint32_t CResidencyManager::GetEvictedCount() 
+	{ 
+		uint32_t unCount = 0;
+		for ( auto &[ pRenderable, entry ] : m_models )
+		{
+			if ( !entry.pModel->IsResident() )
+				unCount++;
+		}
+
+		return unCount;
+	}
+
+	void CResidencyManager::EvictLeastRecentlyDrawn() 
+	{
+		// Bytes to free to get the most pressured device local heap back down to the target
+		std::vector< SMemoryHeapBudget > vecBudgets;
+		m_pAllocator->GetHeapBudgets( vecBudgets );
+
+		VkDeviceSize unBytesToFree = 0;
+		for ( auto &heapBudget : vecBudgets )
+		{
+			if ( ( heapBudget.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT ) == 0 )
+				continue;
+
+			VkDeviceSize unTarget = (VkDeviceSize) ( heapBudget.budget * config.evictTarget );
+			if ( heapBudget.usage > unTarget )
+				unBytesToFree = std::max( unBytesToFree, heapBudget.usage - unTarget );
+		}
+
+		if ( unBytesToFree == 0 )
+			return;
+
+		// Least recently drawn first, skipping anything that may still be referenced by frames in flight
+		std::vector< SResidencyEntry * > vecCandidates;
+		for ( auto &[ pRenderable, entry ] : m_models )
+		{
+			if ( entry.pModel->IsEvictable() && m_unFrame - entry.lastDrawnFrame >= config.minIdleFrames )
+				vecCandidates.push_back( &entry );
+		}
+
+		std::sort( vecCandidates.begin(), vecCandidates.end(), []( const SResidencyEntry *a, const SResidencyEntry *b ) { return a->lastDrawnFrame < b->lastDrawnFrame; } );
+
+		VkDeviceSize unFreedBytes = 0;
+		uint32_t unEvictions = 0;
+		for ( SResidencyEntry *pEntry : vecCandidates )
+		{
+			if ( unFreedBytes >= unBytesToFree || unEvictions >= config.maxEvictionsPerFrame )
+				break;
+
+			unFreedBytes += pEntry->pModel->GetResidentBytes();
+			pEntry->pModel->Evict( m_pRenderInfo->pDescriptors, m_placeholderTexture );
+			unEvictions++;
+		}
+
+		if ( unEvictions == 0 )
+			return;
+
+		// Give emptied blocks back to the driver so the budget actually drops
+		m_pAllocator->Trim();
+
+		if ( CheckLogLevelVerbose( GetMinLogLevel() ) )
+			LogVerbose( "", "Residency: evicted %i render models (%.2f MB) to relieve device memory pressure (%.2f MB over target)", unEvictions, unFreedBytes / 1048576.0, unBytesToFree / 1048576.0 );
+	}
+
+} // namespace xrlib
@@ -0,0 +1,91 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#include <xrvk/ringbuffer.hpp>
+
+#include <algorithm>
+
+namespace xrlib
+{
+	CFrameRingBuffer::CFrameRingBuffer( CSession *pSession )
+		: m_pSession( pSession )
+	{
+		assert( pSession );
+	}
+
+	CFrameRingBuffer::~CFrameRingBuffer()
+	{
+		delete m_pBuffer;
+	}
+
+	VkResult CFrameRingBuffer::Init( VkBufferUsageFlags usageFlags, VkDeviceSize unFrameSize, uint32_t unFrameCount, VkDeviceSize unBindRange, VkMemoryPropertyFlags memPropFlags )
+	{
+		assert( unFrameSize > 0 && unFrameCount > 0 && m_pBuffer == nullptr );
+
+		// Dynamic offsets must be multiples of the offset alignment of the descriptor types the buffer may be bound as
+		VkPhysicalDeviceProperties deviceProps;
+		vkGetPhysicalDeviceProperties( m_pSession->GetVulkan()->GetVkPhysicalDevice(), &deviceProps );
+		m_unAlignment = std::max< VkDeviceSize >( { deviceProps.limits.minStorageBufferOffsetAlignment, deviceProps.limits.minUniformBufferOffsetAlignment, 1 } );
+
+		m_unFrameSize = ( unFrameSize + m_unAlignment - 1 ) / m_unAlignment * m_unAlignment;
+		m_unBindRange = unBindRange;
+		m_unFrameCount = unFrameCount;
+
+		// The last allocation of the last region still has a full bind range behind it
+		m_pBuffer = new CDeviceBuffer( m_pSession );
+		VkResult result = m_pBuffer->Init( usageFlags, memPropFlags, m_unFrameSize * unFrameCount + unBindRange );
+
+		if ( result == VK_SUCCESS && ( memPropFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT ) )
+			result = m_pBuffer->MapMemory();
+
+		if ( result != VK_SUCCESS )
+		{
+			delete m_pBuffer;
+			m_pBuffer = nullptr;
+			return result;
+		}
+
+		m_pMapped = static_cast< uint8_t * >( m_pBuffer->GetMappedData() );
+		LogInfo( "", "Frame ring buffer created: %i frames of %i bytes", unFrameCount, (int) m_unFrameSize );
+		return VK_SUCCESS;
+	}
+
+	void CFrameRingBuffer::BeginFrame( uint32_t unFrame )
+	{
+		m_unFrameOffset = ( unFrame % m_unFrameCount ) * m_unFrameSize;
+		m_unCursor = 0;
+	}
+
+	VkDeviceSize CFrameRingBuffer::Allocate( VkDeviceSize unSize, void **ppOutData )
+	{
+		assert( m_pBuffer );
+
+		if ( m_unCursor + unSize > m_unFrameSize )
+		{
+			if ( !m_bOverflowLogged )
+				LogWarning( "", "Frame ring buffer full (%i bytes per frame), per frame data is dropped", (int) m_unFrameSize );
+
+			m_bOverflowLogged = true;
+			return VK_WHOLE_SIZE;
+		}
+
+		const VkDeviceSize unOffset = m_unCursor;
+		m_unCursor = std::min( ( unOffset + unSize + m_unAlignment - 1 ) / m_unAlignment * m_unAlignment, m_unFrameSize );
+
+		if ( ppOutData && m_pMapped )
+			*ppOutData = m_pMapped + m_unFrameOffset + unOffset;
+
+		return unOffset;
+	}
+
+} // namespace xrlib
@@ -0,0 +1,245 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#include <xrvk/scenegraph.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+	#define XRVK_SCENEGRAPH_SSE
+	#include <xmmintrin.h>
+#elif defined( __ARM_NEON ) && ( defined( __aarch64__ ) || defined( _M_ARM64 ) )
+	#define XRVK_SCENEGRAPH_NEON
+	#include <arm_neon.h>
+#endif
+
+namespace xrlib
+{
+	namespace
+	{
+		// Same result as XrMatrix4x4f_CreateTranslationRotationScale, without its two full matrix multiplies
+		inline void ComposeMatrix( XrMatrix4x4f *pOut, const XrVector3f &translation, const XrQuaternionf &rotation, const XrVector3f &scale )
+		{
+			const float x2 = rotation.x + rotation.x;
+			const float y2 = rotation.y + rotation.y;
+			const float z2 = rotation.z + rotation.z;
+
+			const float xx2 = rotation.x * x2;
+			const float yy2 = rotation.y * y2;
+			const float zz2 = rotation.z * z2;
+			const float yz2 = rotation.y * z2;
+			const float wx2 = rotation.w * x2;
+			const float xy2 = rotation.x * y2;
+			const float wz2 = rotation.w * z2;
+			const float xz2 = rotation.x * z2;
+			const float wy2 = rotation.w * y2;
+
+			float *m = pOut->m;
+			m[ 0 ] = ( 1.f - yy2 - zz2 ) * scale.x;
+			m[ 1 ] = ( xy2 + wz2 ) * scale.x;
+			m[ 2 ] = ( xz2 - wy2 ) * scale.x;
+			m[ 3 ] = 0.f;
+
+			m[ 4 ] = ( xy2 - wz2 ) * scale.y;
+			m[ 5 ] = ( 1.f - xx2 - zz2 ) * scale.y;
+			m[ 6 ] = ( yz2 + wx2 ) * scale.y;
+			m[ 7 ] = 0.f;
+
+			m[ 8 ] = ( xz2 + wy2 ) * scale.z;
+			m[ 9 ] = ( yz2 - wx2 ) * scale.z;
+			m[ 10 ] = ( 1.f - xx2 - yy2 ) * scale.z;
+			m[ 11 ] = 0.f;
+
+			m[ 12 ] = translation.x;
+			m[ 13 ] = translation.y;
+			m[ 14 ] = translation.z;
+			m[ 15 ] = 1.f;
+		}
+
+		// Column major, same result as XrMatrix4x4f_Multiply. pOut must not alias pB.
+		inline void MultiplyMatrix( XrMatrix4x4f *pOut, const XrMatrix4x4f *pA, const XrMatrix4x4f *pB )
+		{
+		#if defined( XRVK_SCENEGRAPH_SSE )
+			const __m128 a0 = _mm_loadu_ps( &pA->m[ 0 ] );
+			const __m128 a1 = _mm_loadu_ps( &pA->m[ 4 ] );
+			const __m128 a2 = _mm_loadu_ps( &pA->m[ 8 ] );
+			const __m128 a3 = _mm_loadu_ps( &pA->m[ 12 ] );
+
+			for ( int i = 0; i < 4; i++ )
+			{
+				const float *pColumn = &pB->m[ i * 4 ];
+				__m128 c = _mm_mul_ps( a0, _mm_set1_ps( pColumn[ 0 ] ) );
+				c = _mm_add_ps( c, _mm_mul_ps( a1, _mm_set1_ps( pColumn[ 1 ] ) ) );
+				c = _mm_add_ps( c, _mm_mul_ps( a2, _mm_set1_ps( pColumn[ 2 ] ) ) );
+				c = _mm_add_ps( c, _mm_mul_ps( a3, _mm_set1_ps( pColumn[ 3 ] ) ) );
+				_mm_storeu_ps( &pOut->m[ i * 4 ], c );
+			}
+		#elif defined( XRVK_SCENEGRAPH_NEON )
+			const float32x4_t a0 = vld1q_f32( &pA->m[ 0 ] );
+			const float32x4_t a1 = vld1q_f32( &pA->m[ 4 ] );
+			const float32x4_t a2 = vld1q_f32( &pA->m[ 8 ] );
+			const float32x4_t a3 = vld1q_f32( &pA->m[ 12 ] );
+
+			for ( int i = 0; i < 4; i++ )
+			{
+				const float32x4_t b = vld1q_f32( &pB->m[ i * 4 ] );
+				float32x4_t c = vmulq_laneq_f32( a0, b, 0 );
+				c = vfmaq_laneq_f32( c, a1, b, 1 );
+				c = vfmaq_laneq_f32( c, a2, b, 2 );
+				c = vfmaq_laneq_f32( c, a3, b, 3 );
+				vst1q_f32( &pOut->m[ i * 4 ], c );
+			}
+		#else
+			XrMatrix4x4f_Multiply( pOut, pA, pB );
+		#endif
+		}
+	} // namespace
+
+	uint32_t CSceneGraph::AddNode( int32_t nParent, const XrVector3f &translation, const XrQuaternionf &rotation, const XrVector3f &scale, const std::string &sName )
+	{
+		const uint32_t unNode = GetNodeCount();
+
+		// Parents come first, which is what lets Update() run front to back
+		assert( nParent < static_cast< int32_t >( unNode ) );
+		if ( nParent >= static_cast< int32_t >( unNode ) )
+			nParent = -1;
+
+		m_vecParents.push_back( nParent < 0 ? -1 : nParent );
+		m_vecTranslations.push_back( translation );
+		m_vecRotations.push_back( rotation );
+		m_vecScales.push_back( scale );
+		m_vecWorldMatrices.emplace_back();
+		m_vecFlags.push_back( 0 );
+		m_vecNames.push_back( sName );
+
+		MarkDirty( unNode );
+		return unNode;
+	}
+
+	void CSceneGraph::Clear()
+	{
+		m_vecParents.clear();
+		m_vecTranslations.clear();
+		m_vecRotations.clear();
+		m_vecScales.clear();
+		m_vecWorldMatrices.clear();
+		m_vecFlags.clear();
+		m_vecNames.clear();
+
+		m_unDirtyCount = 0;
+		m_bChangedFlags = false;
+	}
+
+	void CSceneGraph::Reserve( size_t unNodeCount )
+	{
+		m_vecParents.reserve( unNodeCount );
+		m_vecTranslations.reserve( unNodeCount );
+		m_vecRotations.reserve( unNodeCount );
+		m_vecScales.reserve( unNodeCount );
+		m_vecWorldMatrices.reserve( unNodeCount );
+		m_vecFlags.reserve( unNodeCount );
+		m_vecNames.reserve( unNodeCount );
+	}
+
+	void CSceneGraph::SetTranslation( uint32_t unNode, const XrVector3f &translation )
+	{
+		m_vecTranslations[ unNode ] = translation;
+		MarkDirty( unNode );
+	}
+
+	void CSceneGraph::SetRotation( uint32_t unNode, const XrQuaternionf &rotation )
+	{
+		m_vecRotations[ unNode ] = rotation;
+		MarkDirty( unNode );
+	}
+
+	void CSceneGraph::SetScale( uint32_t unNode, const XrVector3f &scale )
+	{
+		m_vecScales[ unNode ] = scale;
+		MarkDirty( unNode );
+	}
+
+	void CSceneGraph::SetLocalTransform( uint32_t unNode, const XrVector3f &translation, const XrQuaternionf &rotation, const XrVector3f &scale )
+	{
+		m_vecTranslations[ unNode ] = translation;
+		m_vecRotations[ unNode ] = rotation;
+		m_vecScales[ unNode ] = scale;
+		MarkDirty( unNode );
+	}
+
+	void CSceneGraph::MarkDirty( uint32_t unNode )
+	{
+		if ( m_vecFlags[ unNode ] & k_unDirty )
+			return;
+
+		m_vecFlags[ unNode ] |= k_unDirty;
+		m_unDirtyCount++;
+	}
+
+	uint32_t CSceneGraph::Update()
+	{
+		if ( m_unDirtyCount == 0 )
+		{
+			// Nothing moved, only last update's changes need to be forgotten
+			if ( m_bChangedFlags )
+			{
+				std::fill( m_vecFlags.begin(), m_vecFlags.end(), 0 );
+				m_bChangedFlags = false;
+			}
+
+			return 0;
+		}
+
+		const size_t unNodeCount = m_vecParents.size();
+		const int32_t *pParents = m_vecParents.data();
+		uint8_t *pFlags = m_vecFlags.data();
+		XrMatrix4x4f *pWorld = m_vecWorldMatrices.data();
+
+		// Parents are always updated before their children, so a changed parent is already flagged when its children are reached
+		uint32_t unUpdated = 0;
+		for ( size_t i = 0; i < unNodeCount; i++ )
+		{
+			const int32_t nParent = pParents[ i ];
+			const bool bChanged = ( pFlags[ i ] & k_unDirty ) || ( nParent >= 0 && ( pFlags[ nParent ] & k_unChanged ) );
+
+			pFlags[ i ] = bChanged ? k_unChanged : 0;
+			if ( !bChanged )
+				continue;
+
+			if ( nParent < 0 )
+			{
+				ComposeMatrix( &pWorld[ i ], m_vecTranslations[ i ], m_vecRotations[ i ], m_vecScales[ i ] );
+			}
+			else
+			{
+				XrMatrix4x4f localMatrix;
+				ComposeMatrix( &localMatrix, m_vecTranslations[ i ], m_vecRotations[ i ], m_vecScales[ i ] );
+				MultiplyMatrix( &pWorld[ i ], &pWorld[ nParent ], &localMatrix );
+			}
+
+			unUpdated++;
+		}
+
+		m_unDirtyCount = 0;
+		m_bChangedFlags = unUpdated > 0;
+		return unUpdated;
+	}
+
+	int32_t CSceneGraph::FindNode( const std::string &sName ) const
+	{
+		auto it = std::find( m_vecNames.begin(), m_vecNames.end(), sName );
+		return it == m_vecNames.end() ? -1 : static_cast< int32_t >( it - m_vecNames.begin() );
+	}
+
+} // namespace xrlib
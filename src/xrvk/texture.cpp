@@ -55,14 +55,10 @@ namespace xrlib
 		// Calculate data size
 		VkDeviceSize imageSize = width * height * BYTES_PER_PIXEL; 
 
-		// Create staging buffer using CDeviceBuffer
-		CDeviceBuffer stagingBuffer( m_pSession );
-		VK_CHECK_RESULT( stagingBuffer.Init( VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, imageSize, data, true ) );
-
 		// Create image
 		VK_CHECK_RESULT( vkutils::CreateImage( 
 			outTexture.image, 
-			outTexture.memory, 
+			outTexture.allocation, 
 			GetDevice(), 
 			GetPhysicalDevice(),
 			width, 
@@ -72,32 +68,8 @@ namespace xrlib
 			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT ) );
 
-		// Copy data to image
-		vkutils::TransitionImageLayout( 
-			GetDevice(), 
-			m_pool, 
-			GetGraphicsQueue(),
-			outTexture.image, 
-			format, 
-			VK_IMAGE_LAYOUT_UNDEFINED, 
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL );
-
-		vkutils::CopyBufferToImage( 
-			GetDevice(), 
-			m_pool, 
-			GetGraphicsQueue(),
-			stagingBuffer.GetVkBuffer(), 
-			outTexture.image, 
-			width, 
-			height );
-
-		vkutils::TransitionImageLayout( 
-			GetDevice(), 
-			m_pool,
-			GetGraphicsQueue(),
-			outTexture.image, 
-			format,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL );
+		// Queue copy to image, the upload manager transitions it for shader reads
+		CUploadManager::Get( m_pSession )->UploadImage( outTexture.image, data, imageSize, width, height );
 
 		// Create image view
 		VK_CHECK_RESULT( vkutils::CreateImageView( outTexture.view, GetDevice(), outTexture.image, format, VK_IMAGE_ASPECT_COLOR_BIT ) );
@@ -146,9 +118,12 @@ namespace xrlib
 		if ( texture.view != VK_NULL_HANDLE )
 			vkDestroyImageView( GetDevice(), texture.view, nullptr );
 		if ( texture.image != VK_NULL_HANDLE )
+		{
+			CUploadManager::Get( m_pSession )->ReleaseImage( texture.image );
 			vkDestroyImage( GetDevice(), texture.image, nullptr );
-		if ( texture.memory != VK_NULL_HANDLE )
-			vkFreeMemory( GetDevice(), texture.memory, nullptr );
+		}
+		if ( texture.allocation )
+			CDeviceMemoryAllocator::Get( m_pSession )->Free( texture.allocation );
 		if ( texture.sampler != VK_NULL_HANDLE && texture.sampler != m_defaultSampler )
 			vkDestroySampler( GetDevice(), texture.sampler, nullptr );
 
@@ -0,0 +1,571 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+#include <xrvk/upload.hpp>
+
+namespace xrlib
+{
+	std::mutex CUploadManager::s_registryMutex;
+	std::unordered_map< VkDevice, CUploadManager * > CUploadManager::s_registry;
+
+	CUploadManager *CUploadManager::Get( CSession *pSession )
+	{
+		assert( pSession );
+		VkDevice vkDevice = pSession->GetVulkan()->GetVkLogicalDevice();
+
+		std::scoped_lock lock( s_registryMutex );
+		auto it = s_registry.find( vkDevice );
+		if ( it != s_registry.end() )
+			return it->second;
+
+		CUploadManager *pUploadManager = new CUploadManager( pSession );
+		s_registry[ vkDevice ] = pUploadManager;
+		return pUploadManager;
+	}
+
+	void CUploadManager::Destroy( VkDevice vkDevice )
+	{
+		std::scoped_lock lock( s_registryMutex );
+		auto it = s_registry.find( vkDevice );
+		if ( it == s_registry.end() )
+			return;
+
+		delete it->second;
+		s_registry.erase( it );
+	}
+
+	CUploadManager::CUploadManager( CSession *pSession )
+	{
+		assert( pSession );
+
+		CVulkan *pVulkan = pSession->GetVulkan();
+		m_vkDevice = pVulkan->GetVkLogicalDevice();
+		m_pAllocator = CDeviceMemoryAllocator::Get( m_vkDevice, pVulkan->GetVkPhysicalDevice() );
+
+		m_vkTransferQueue = pVulkan->GetVkQueue_Transfer();
+		m_unTransferFamily = pVulkan->GetVkQueueIndex_TransferFamily();
+		m_unGraphicsFamily = pVulkan->GetVkQueueIndex_GraphicsFamily();
+
+		VkCommandPoolCreateInfo commandPoolCI { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+		commandPoolCI.queueFamilyIndex = m_unTransferFamily;
+		commandPoolCI.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		VK_CHECK_RESULT( vkCreateCommandPool( m_vkDevice, &commandPoolCI, nullptr, &m_vkCommandPool ) );
+
+		LogInfo( "", "Upload manager created on queue family %i (graphics family %i), ownership transfers %s",
+			m_unTransferFamily, m_unGraphicsFamily, IsOwnershipTransferRequired() ? "enabled" : "not required" );
+	}
+
+	CUploadManager::~CUploadManager()
+	{
+		WaitIdle();
+
+		std::scoped_lock lock( m_mutex );
+
+		// Nothing will acquire these anymore
+		for ( SUploadBatch *pBatch : m_inFlightBatches )
+			RetireBatch( pBatch );
+
+		// Never submitted, just release staging memory
+		CloseOpenBatch();
+		for ( SUploadBatch *pBatch : m_closedBatches )
+			RetireBatch( pBatch );
+
+		m_inFlightBatches.clear();
+		m_closedBatches.clear();
+		m_vecWaitSemaphores.clear();
+
+		if ( m_vkCommandPool != VK_NULL_HANDLE )
+			vkDestroyCommandPool( m_vkDevice, m_vkCommandPool, nullptr );
+	}
+
+	std::shared_future< void > CUploadManager::UploadBuffer( VkBuffer vkDstBuffer, const void *pData, VkDeviceSize unSize, VkDeviceSize unDstOffset )
+	{
+		assert( vkDstBuffer != VK_NULL_HANDLE );
+		assert( pData && unSize > 0 );
+
+		SUpload upload;
+		upload.dstBuffer = vkDstBuffer;
+		upload.dstOffset = unDstOffset;
+		VK_CHECK_RESULT( CreateStaging( upload, pData, unSize ) );
+
+		return AddUpload( upload );
+	}
+
+	std::shared_future< void > CUploadManager::UploadImage(
+		VkImage vkDstImage,
+		const void *pData,
+		VkDeviceSize unSize,
+		uint32_t unWidth,
+		uint32_t unHeight,
+		VkImageLayout finalLayout )
+	{
+		assert( vkDstImage != VK_NULL_HANDLE );
+		assert( pData && unSize > 0 );
+
+		SUpload upload;
+		upload.dstImage = vkDstImage;
+		upload.width = unWidth;
+		upload.height = unHeight;
+		upload.finalLayout = finalLayout;
+		VK_CHECK_RESULT( CreateStaging( upload, pData, unSize ) );
+
+		return AddUpload( upload );
+	}
+
+	std::shared_future< void > CUploadManager::Submit()
+	{
+		std::scoped_lock lock( m_mutex );
+
+		if ( !m_pOpenBatch )
+		{
+			if ( !m_closedBatches.empty() )
+				return m_closedBatches.back()->future;
+
+			if ( !m_inFlightBatches.empty() )
+				return m_inFlightBatches.back()->future;
+
+			// Nothing outstanding
+			std::promise< void > ready;
+			ready.set_value();
+			return ready.get_future().share();
+		}
+
+		std::shared_future< void > future = m_pOpenBatch->future;
+		CloseOpenBatch();
+		return future;
+	}
+
+	void CUploadManager::Update( VkCommandBuffer graphicsCommandBuffer )
+	{
+		std::scoped_lock lock( m_mutex );
+
+		// Anything enqueued since the last frame goes out now. Acquires have to be recorded on the
+		// graphics queue in the frame that waits on the batch, so hold batches back without a command buffer
+		CloseOpenBatch();
+
+		while ( !m_closedBatches.empty() && graphicsCommandBuffer != VK_NULL_HANDLE )
+		{
+			SUploadBatch *pBatch = m_closedBatches.front();
+			if ( SubmitBatch( pBatch ) != VK_SUCCESS )
+			{
+				LogError( "", "Unable to submit upload batch, retrying next frame" );
+				break;
+			}
+
+			if ( IsOwnershipTransferRequired() )
+				RecordAcquires( pBatch, graphicsCommandBuffer );
+
+			m_vecWaitSemaphores.push_back( pBatch->semaphore );
+
+			m_closedBatches.pop_front();
+			m_inFlightBatches.push_back( pBatch );
+		}
+
+		// Retire finished batches in submission order - the graphics submit that waited on them
+		// has completed by now as frames are submitted and waited on before the next Update()
+		while ( !m_inFlightBatches.empty() )
+		{
+			SUploadBatch *pBatch = m_inFlightBatches.front();
+			if ( vkGetFenceStatus( m_vkDevice, pBatch->fence ) != VK_SUCCESS )
+				break;
+
+			if ( std::find( m_vecWaitSemaphores.begin(), m_vecWaitSemaphores.end(), pBatch->semaphore ) != m_vecWaitSemaphores.end() )
+				break;
+
+			m_inFlightBatches.pop_front();
+			RetireBatch( pBatch );
+		}
+	}
+
+	void CUploadManager::GetWaitSemaphores( std::vector< VkSemaphore > &outSemaphores, std::vector< VkPipelineStageFlags > &outWaitStages )
+	{
+		std::scoped_lock lock( m_mutex );
+
+		for ( VkSemaphore semaphore : m_vecWaitSemaphores )
+		{
+			outSemaphores.push_back( semaphore );
+			outWaitStages.push_back( k_vkUploadWaitStages );
+		}
+
+		m_vecWaitSemaphores.clear();
+	}
+
+	void CUploadManager::ReleaseBuffer( VkBuffer vkBuffer )
+	{
+		std::scoped_lock lock( m_mutex );
+
+		auto fnDropPending = [ & ]( SUploadBatch *pBatch )
+		{
+			for ( auto it = pBatch->uploads.begin(); it != pBatch->uploads.end(); )
+			{
+				if ( it->dstBuffer == vkBuffer )
+				{
+					pBatch->stagingBytes -= it->size;
+					FreeStaging( *it );
+					it = pBatch->uploads.erase( it );
+				}
+				else
+				{
+					++it;
+				}
+			}
+		};
+
+		if ( m_pOpenBatch )
+			fnDropPending( m_pOpenBatch );
+
+		for ( SUploadBatch *pBatch : m_closedBatches )
+			fnDropPending( pBatch );
+
+		// Already on the gpu - wait for the copy and skip the acquire
+		for ( SUploadBatch *pBatch : m_inFlightBatches )
+		{
+			for ( SUpload &upload : pBatch->uploads )
+			{
+				if ( upload.dstBuffer != vkBuffer )
+					continue;
+
+				vkWaitForFences( m_vkDevice, 1, &pBatch->fence, VK_TRUE, UINT64_MAX );
+				upload.dstBuffer = VK_NULL_HANDLE;
+			}
+		}
+	}
+
+	void CUploadManager::ReleaseImage( VkImage vkImage )
+	{
+		std::scoped_lock lock( m_mutex );
+
+		auto fnDropPending = [ & ]( SUploadBatch *pBatch )
+		{
+			for ( auto it = pBatch->uploads.begin(); it != pBatch->uploads.end(); )
+			{
+				if ( it->dstImage == vkImage )
+				{
+					pBatch->stagingBytes -= it->size;
+					FreeStaging( *it );
+					it = pBatch->uploads.erase( it );
+				}
+				else
+				{
+					++it;
+				}
+			}
+		};
+
+		if ( m_pOpenBatch )
+			fnDropPending( m_pOpenBatch );
+
+		for ( SUploadBatch *pBatch : m_closedBatches )
+			fnDropPending( pBatch );
+
+		for ( SUploadBatch *pBatch : m_inFlightBatches )
+		{
+			for ( SUpload &upload : pBatch->uploads )
+			{
+				if ( upload.dstImage != vkImage )
+					continue;
+
+				vkWaitForFences( m_vkDevice, 1, &pBatch->fence, VK_TRUE, UINT64_MAX );
+				upload.dstImage = VK_NULL_HANDLE;
+			}
+		}
+	}
+
+	void CUploadManager::WaitIdle()
+	{
+		std::scoped_lock lock( m_mutex );
+
+		std::vector< VkFence > vecFences;
+		for ( SUploadBatch *pBatch : m_inFlightBatches )
+			vecFences.push_back( pBatch->fence );
+
+		if ( !vecFences.empty() )
+			vkWaitForFences( m_vkDevice, (uint32_t) vecFences.size(), vecFences.data(), VK_TRUE, UINT64_MAX );
+	}
+
+	size_t CUploadManager::GetPendingBatchCount()
+	{
+		std::scoped_lock lock( m_mutex );
+		return m_closedBatches.size() + m_inFlightBatches.size() + ( m_pOpenBatch ? 1 : 0 );
+	}
+
+	SUploadBatch *CUploadManager::GetOpenBatch()
+	{
+		if ( !m_pOpenBatch )
+			m_pOpenBatch = new SUploadBatch;
+
+		return m_pOpenBatch;
+	}
+
+	void CUploadManager::CloseOpenBatch()
+	{
+		if ( !m_pOpenBatch )
+			return;
+
+		m_closedBatches.push_back( m_pOpenBatch );
+		m_pOpenBatch = nullptr;
+	}
+
+	VkResult CUploadManager::CreateStaging( SUpload &upload, const void *pData, VkDeviceSize unSize )
+	{
+		VkBufferCreateInfo bufferCI { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+		bufferCI.size = unSize;
+		bufferCI.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		VK_CHECK_RETURN( vkCreateBuffer( m_vkDevice, &bufferCI, nullptr, &upload.stagingBuffer ) );
+
+		VkResult result = m_pAllocator->AllocateAndBindBuffer( upload.pStagingAllocation, upload.stagingBuffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+		if ( result != VK_SUCCESS )
+		{
+			vkDestroyBuffer( m_vkDevice, upload.stagingBuffer, nullptr );
+			upload.stagingBuffer = VK_NULL_HANDLE;
+			return result;
+		}
+
+		void *pMapped = nullptr;
+		result = m_pAllocator->Map( upload.pStagingAllocation, &pMapped );
+		if ( result != VK_SUCCESS )
+		{
+			FreeStaging( upload );
+			return result;
+		}
+
+		memcpy( pMapped, pData, unSize );
+		m_pAllocator->Unmap( upload.pStagingAllocation );
+
+		upload.size = unSize;
+		return VK_SUCCESS;
+	}
+
+	void CUploadManager::FreeStaging( SUpload &upload )
+	{
+		if ( upload.stagingBuffer != VK_NULL_HANDLE )
+			vkDestroyBuffer( m_vkDevice, upload.stagingBuffer, nullptr );
+
+		if ( upload.pStagingAllocation )
+			m_pAllocator->Free( upload.pStagingAllocation );
+
+		upload.stagingBuffer = VK_NULL_HANDLE;
+		upload.pStagingAllocation = nullptr;
+	}
+
+	std::shared_future< void > CUploadManager::AddUpload( SUpload &upload )
+	{
+		std::scoped_lock lock( m_mutex );
+
+		SUploadBatch *pBatch = GetOpenBatch();
+		pBatch->uploads.push_back( upload );
+		pBatch->stagingBytes += upload.size;
+
+		std::shared_future< void > future = pBatch->future;
+		if ( pBatch->stagingBytes >= k_unMaxUploadBatchSize )
+			CloseOpenBatch();
+
+		return future;
+	}
+
+	VkResult CUploadManager::SubmitBatch( SUploadBatch *pBatch )
+	{
+		VkCommandBufferAllocateInfo commandBufferAI { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+		commandBufferAI.commandPool = m_vkCommandPool;
+		commandBufferAI.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		commandBufferAI.commandBufferCount = 1;
+		VK_CHECK_RETURN( vkAllocateCommandBuffers( m_vkDevice, &commandBufferAI, &pBatch->commandBuffer ) );
+
+		VkFenceCreateInfo fenceCI { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+		VK_CHECK_RETURN( vkCreateFence( m_vkDevice, &fenceCI, nullptr, &pBatch->fence ) );
+
+		VkSemaphoreCreateInfo semaphoreCI { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+		VK_CHECK_RETURN( vkCreateSemaphore( m_vkDevice, &semaphoreCI, nullptr, &pBatch->semaphore ) );
+
+		RecordBatch( pBatch );
+
+		VkSubmitInfo submitInfo { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &pBatch->commandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &pBatch->semaphore;
+		VK_CHECK_RETURN( vkQueueSubmit( m_vkTransferQueue, 1, &submitInfo, pBatch->fence ) );
+
+		if ( CheckLogLevelVerbose( GetMinLogLevel() ) )
+			LogVerbose( "", "Upload batch submitted with %i upload(s), %llu bytes", (uint32_t) pBatch->uploads.size(), (unsigned long long) pBatch->stagingBytes );
+
+		return VK_SUCCESS;
+	}
+
+	void CUploadManager::RecordBatch( SUploadBatch *pBatch )
+	{
+		VkCommandBufferBeginInfo beginInfo { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer( pBatch->commandBuffer, &beginInfo );
+
+		const bool bRelease = IsOwnershipTransferRequired();
+
+		std::vector< VkBufferMemoryBarrier > vecBufferBarriers;
+		std::vector< VkImageMemoryBarrier > vecImageBarriers;
+
+		// All images to transfer dst first
+		for ( SUpload &upload : pBatch->uploads )
+		{
+			if ( upload.dstImage == VK_NULL_HANDLE )
+				continue;
+
+			VkImageMemoryBarrier barrier { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = upload.dstImage;
+			barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			vecImageBarriers.push_back( barrier );
+		}
+
+		if ( !vecImageBarriers.empty() )
+			vkCmdPipelineBarrier( pBatch->commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, (uint32_t) vecImageBarriers.size(), vecImageBarriers.data() );
+
+		vecImageBarriers.clear();
+
+		// Copies, followed by either the release half of the ownership transfer or a plain barrier for the graphics queue
+		for ( SUpload &upload : pBatch->uploads )
+		{
+			if ( upload.dstBuffer != VK_NULL_HANDLE )
+			{
+				VkBufferCopy region {};
+				region.dstOffset = upload.dstOffset;
+				region.size = upload.size;
+				vkCmdCopyBuffer( pBatch->commandBuffer, upload.stagingBuffer, upload.dstBuffer, 1, &region );
+
+				VkBufferMemoryBarrier barrier { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = bRelease ? 0 : VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.srcQueueFamilyIndex = bRelease ? m_unTransferFamily : VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = bRelease ? m_unGraphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+				barrier.buffer = upload.dstBuffer;
+				barrier.offset = upload.dstOffset;
+				barrier.size = upload.size;
+				vecBufferBarriers.push_back( barrier );
+			}
+			else if ( upload.dstImage != VK_NULL_HANDLE )
+			{
+				VkBufferImageCopy region {};
+				region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+				region.imageExtent = { upload.width, upload.height, 1 };
+				vkCmdCopyBufferToImage( pBatch->commandBuffer, upload.stagingBuffer, upload.dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region );
+
+				VkImageMemoryBarrier barrier { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = bRelease ? 0 : VK_ACCESS_SHADER_READ_BIT;
+				barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				barrier.newLayout = upload.finalLayout;
+				barrier.srcQueueFamilyIndex = bRelease ? m_unTransferFamily : VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = bRelease ? m_unGraphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+				barrier.image = upload.dstImage;
+				barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+				vecImageBarriers.push_back( barrier );
+			}
+		}
+
+		// Transfer only queues can't name graphics stages, the acquire on the graphics queue handles those.
+		// Transfer is in the destination scope as well since per frame instance copies may write the same buffers
+		VkPipelineStageFlags dstStages = bRelease ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT :
+			VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+		if ( !vecBufferBarriers.empty() || !vecImageBarriers.empty() )
+			vkCmdPipelineBarrier(
+				pBatch->commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				dstStages,
+				0,
+				0,
+				nullptr,
+				(uint32_t) vecBufferBarriers.size(),
+				vecBufferBarriers.data(),
+				(uint32_t) vecImageBarriers.size(),
+				vecImageBarriers.data() );
+
+		vkEndCommandBuffer( pBatch->commandBuffer );
+	}
+
+	void CUploadManager::RecordAcquires( SUploadBatch *pBatch, VkCommandBuffer graphicsCommandBuffer )
+	{
+		std::vector< VkBufferMemoryBarrier > vecBufferBarriers;
+		std::vector< VkImageMemoryBarrier > vecImageBarriers;
+
+		// Must match the release barriers recorded on the transfer queue
+		for ( SUpload &upload : pBatch->uploads )
+		{
+			if ( upload.dstBuffer != VK_NULL_HANDLE )
+			{
+				VkBufferMemoryBarrier barrier { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+				barrier.srcQueueFamilyIndex = m_unTransferFamily;
+				barrier.dstQueueFamilyIndex = m_unGraphicsFamily;
+				barrier.buffer = upload.dstBuffer;
+				barrier.offset = upload.dstOffset;
+				barrier.size = upload.size;
+				vecBufferBarriers.push_back( barrier );
+			}
+			else if ( upload.dstImage != VK_NULL_HANDLE )
+			{
+				VkImageMemoryBarrier barrier { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+				barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				barrier.newLayout = upload.finalLayout;
+				barrier.srcQueueFamilyIndex = m_unTransferFamily;
+				barrier.dstQueueFamilyIndex = m_unGraphicsFamily;
+				barrier.image = upload.dstImage;
+				barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+				vecImageBarriers.push_back( barrier );
+			}
+		}
+
+		if ( vecBufferBarriers.empty() && vecImageBarriers.empty() )
+			return;
+
+		// Source stages overlap the semaphore wait, so the acquire and its layout transition run after the transfer queue's signal
+		vkCmdPipelineBarrier(
+			graphicsCommandBuffer,
+			k_vkUploadWaitStages,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0,
+			0,
+			nullptr,
+			(uint32_t) vecBufferBarriers.size(),
+			vecBufferBarriers.data(),
+			(uint32_t) vecImageBarriers.size(),
+			vecImageBarriers.data() );
+	}
+
+	void CUploadManager::RetireBatch( SUploadBatch *pBatch )
+	{
+		for ( SUpload &upload : pBatch->uploads )
+			FreeStaging( upload );
+
+		if ( pBatch->commandBuffer != VK_NULL_HANDLE )
+			vkFreeCommandBuffers( m_vkDevice, m_vkCommandPool, 1, &pBatch->commandBuffer );
+
+		if ( pBatch->fence != VK_NULL_HANDLE )
+			vkDestroyFence( m_vkDevice, pBatch->fence, nullptr );
+
+		if ( pBatch->semaphore != VK_NULL_HANDLE )
+			vkDestroySemaphore( m_vkDevice, pBatch->semaphore, nullptr );
+
+		pBatch->promise.set_value();
+		delete pBatch;
+	}
+
+} // namespace xrlib
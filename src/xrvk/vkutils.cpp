@@ -83,7 +83,7 @@ namespace vkutils
 
 	VkResult CreateImage( 
 		VkImage &outImage,
-		VkDeviceMemory &outImageMemory,
+		xrlib::SMemoryAllocation *&outImageAllocation,
 		VkDevice device, 
 		VkPhysicalDevice physicalDevice, 
 		uint32_t width, 
@@ -110,18 +110,7 @@ namespace vkutils
 
 		VK_CHECK_RESULT( vkCreateImage( device, &imageInfo, nullptr, &outImage ) );
 
-		VkMemoryRequirements memRequirements;
-		vkGetImageMemoryRequirements( device, outImage, &memRequirements );
-
-		VkMemoryAllocateInfo allocInfo {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType( physicalDevice, memRequirements.memoryTypeBits, properties );
-
-		VK_CHECK_RESULT( vkAllocateMemory( device, &allocInfo, nullptr, &outImageMemory ) );
-		VK_CHECK_RESULT( vkBindImageMemory( device, outImage, outImageMemory, 0 ) );
-
-		return VK_SUCCESS;
+		return xrlib::CDeviceMemoryAllocator::Get( device, physicalDevice )->AllocateAndBindImage( outImageAllocation, outImage, properties, tiling );
 	}
 
 	VkResult CreateImageView( VkImageView &outImageView, VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags )
@@ -167,7 +156,8 @@ namespace vkutils
 	{
 		// Create staging buffer
 		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
+		xrlib::SMemoryAllocation *pStagingAllocation = nullptr;
+		xrlib::CDeviceMemoryAllocator *pAllocator = xrlib::CDeviceMemoryAllocator::Get( device, physicalDevice );
 
 		VkBufferCreateInfo bufferInfo {};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -177,22 +167,13 @@ namespace vkutils
 
 		VK_CHECK_RESULT( vkCreateBuffer( device, &bufferInfo, nullptr, &stagingBuffer ) );
 
-		VkMemoryRequirements memRequirements;
-		vkGetBufferMemoryRequirements( device, stagingBuffer, &memRequirements );
-
-		VkMemoryAllocateInfo allocInfo {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType( physicalDevice, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
-
-		VK_CHECK_RESULT( vkAllocateMemory( device, &allocInfo, nullptr, &stagingBufferMemory ) );
-		VK_CHECK_RESULT( vkBindBufferMemory( device, stagingBuffer, stagingBufferMemory, 0 ) );
+		VK_CHECK_RESULT( pAllocator->AllocateAndBindBuffer( pStagingAllocation, stagingBuffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT ) );
 
 		// Copy data to staging buffer
 		void *data;
-		vkMapMemory( device, stagingBufferMemory, 0, imageData.size(), 0, &data );
+		VK_CHECK_RESULT( pAllocator->Map( pStagingAllocation, &data ) );
 		memcpy( data, imageData.data(), imageData.size() );
-		vkUnmapMemory( device, stagingBufferMemory );
+		pAllocator->Unmap( pStagingAllocation );
 
 		// Transition image to transfer destination layout
 		TransitionImageLayout( device, commandPool, graphicsQueue, image, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL );
@@ -205,7 +186,7 @@ namespace vkutils
 
 		// Cleanup staging buffer
 		vkDestroyBuffer( device, stagingBuffer, nullptr );
-		vkFreeMemory( device, stagingBufferMemory, nullptr );
+		pAllocator->Free( pStagingAllocation );
 	}
 
 	void TransitionImageLayout( 
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2024,2025 Copyright Rune Berg
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+// xrlib_bench_skin - times SSkin::UpdateMatrices on a 26 joint hand and a 100 joint character skeleton, per update and for a crowd
+// of skins, e.g. to compare the joint hierarchy evaluation across changes and devices.
+
+#include <xrvk/mesh.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace xrlib;
+
+static void PrintUsage()
+{
+	printf( "Usage: xrlib_bench_skin [options]\n" );
+	printf( "  --iterations <n>    timed runs per case, the best and mean are reported (default: 1000)\n" );
+	printf( "  --skins <n>         skins updated per run (default: 300)\n" );
+}
+
+// Root joint with chains of joints hanging off it, listed parents first like a glTF export: 1 + 5 x 5 is a hand, 1 + 9 x 11 a character
+static SSkin MakeSkeleton( uint32_t unChains, uint32_t unChainLength )
+{
+	SSkin skin;
+	skin.name = std::to_string( 1 + unChains * unChainLength ) + " joints";
+
+	const uint32_t unJointCount = 1 + unChains * unChainLength;
+	for ( uint32_t i = 0; i < unJointCount; i++ )
+		skin.joints.push_back( i );
+
+	for ( uint32_t unChain = 0; unChain < unChains; unChain++ )
+	{
+		uint32_t unParent = 0;
+		for ( uint32_t i = 0; i < unChainLength; i++ )
+		{
+			const uint32_t unJoint = 1 + unChain * unChainLength + i;
+			skin.hierarchy[ unParent ].push_back( unJoint );
+			unParent = unJoint;
+		}
+	}
+
+	skin.inverseBindMatrices.resize( unJointCount );
+	for ( XrMatrix4x4f &inverseBind : skin.inverseBindMatrices )
+		XrMatrix4x4f_CreateIdentity( &inverseBind );
+
+	skin.BuildHierarchy();
+	return skin;
+}
+
+// Best and mean milliseconds of fnRun over the iterations
+template < typename FnRun >
+static void Measure( const char *pLabel, uint32_t unIterations, uint32_t unSkins, uint32_t unJoints, FnRun &&fnRun )
+{
+	double dBest = 1e30;
+	double dTotal = 0.0;
+
+	for ( uint32_t i = 0; i < unIterations; i++ )
+	{
+		const auto start = std::chrono::steady_clock::now();
+		fnRun();
+		const double dMs = std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - start ).count();
+
+		dBest = std::min( dBest, dMs );
+		dTotal += dMs;
+	}
+
+	printf( "%-22s %3u joints x %u skins: best %.3f ms (%.2f us per skin), mean %.3f ms\n",
+		pLabel, unJoints, unSkins, dBest, dBest * 1000.0 / unSkins, dTotal / unIterations );
+}
+
+static void RunSkeleton( uint32_t unChains, uint32_t unChainLength, uint32_t unIterations, uint32_t unSkins )
+{
+	std::vector< SSkin > skins( unSkins, MakeSkeleton( unChains, unChainLength ) );
+	const uint32_t unJoints = static_cast< uint32_t >( skins[ 0 ].joints.size() );
+
+	// Bent joints with a little offset each, different per skin so no two updates are alike
+	std::vector< std::vector< XrQuaternionf > > orientations( unSkins );
+	std::vector< std::vector< XrVector3f > > positions( unSkins );
+	std::vector< std::vector< XrPosef > > poses( unSkins );
+	std::vector< std::vector< XrMatrix4x4f > > localMatrices( unSkins );
+
+	for ( uint32_t unSkin = 0; unSkin < unSkins; unSkin++ )
+	{
+		for ( uint32_t i = 0; i < unJoints; i++ )
+		{
+			const float fHalfAngle = 0.05f + 0.001f * static_cast< float >( ( unSkin + i ) % 100 );
+			const XrQuaternionf orientation = { std::sin( fHalfAngle ), 0.f, 0.f, std::cos( fHalfAngle ) };
+			const XrVector3f position = { 0.f, 0.02f, 0.001f * static_cast< float >( i % 7 ) };
+			const XrVector3f scale = { 1.f, 1.f, 1.f };
+
+			XrMatrix4x4f local;
+			XrMatrix4x4f_CreateTranslationRotationScale( &local, &position, &orientation, &scale );
+
+			orientations[ unSkin ].push_back( orientation );
+			positions[ unSkin ].push_back( position );
+			poses[ unSkin ].push_back( { orientation, position } );
+			localMatrices[ unSkin ].push_back( local );
+		}
+	}
+
+	// First update allocates, keep it out of the timings
+	for ( uint32_t unSkin = 0; unSkin < unSkins; unSkin++ )
+		skins[ unSkin ].UpdateMatrices( orientations[ unSkin ], positions[ unSkin ] );
+
+	Measure( "orientations/positions", unIterations, unSkins, unJoints, [ & ]() {
+		for ( uint32_t unSkin = 0; unSkin < unSkins; unSkin++ )
+			skins[ unSkin ].UpdateMatrices( orientations[ unSkin ], positions[ unSkin ] );
+	} );
+
+	Measure( "poses", unIterations, unSkins, unJoints, [ & ]() {
+		for ( uint32_t unSkin = 0; unSkin < unSkins; unSkin++ )
+			skins[ unSkin ].UpdateMatrices( poses[ unSkin ] );
+	} );
+
+	Measure( "local matrices", unIterations, unSkins, unJoints, [ & ]() {
+		for ( uint32_t unSkin = 0; unSkin < unSkins; unSkin++ )
+			skins[ unSkin ].UpdateMatrices( localMatrices[ unSkin ].data() );
+	} );
+
+	// Keeps the updates from being optimized out
+	float fChecksum = 0.f;
+	for ( const SSkin &skin : skins )
+		fChecksum += skin.matrices.back().m[ 13 ];
+
+	printf( "%-22s %3u joints x %u skins: %g\n", "checksum", unJoints, unSkins, fChecksum );
+}
+
+int main( int argc, char *argv[] )
+{
+	uint32_t unIterations = 1000;
+	uint32_t unSkins = 300;
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( strcmp( argv[ i ], "--iterations" ) == 0 && i + 1 < argc )
+			unIterations = static_cast< uint32_t >( std::max( 1, atoi( argv[ ++i ] ) ) );
+		else if ( strcmp( argv[ i ], "--skins" ) == 0 && i + 1 < argc )
+			unSkins = static_cast< uint32_t >( std::max( 1, atoi( argv[ ++i ] ) ) );
+		else if ( strcmp( argv[ i ], "--help" ) == 0 || strcmp( argv[ i ], "-h" ) == 0 )
+		{
+			PrintUsage();
+			return 0;
+		}
+		else
+		{
+			printf( "Unknown option: %s\n\n", argv[ i ] );
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	RunSkeleton( 5, 5, unIterations, unSkins );
+	RunSkeleton( 9, 11, unIterations, unSkins );
+
+	return 0;
+}
@@ -0,0 +1,111 @@
+/* 
+ * Copyright 2024,2025 Copyright Rune Berg 
+ * https://github.com/1runeberg | http://runeberg.io | https://runeberg.social | https://www.youtube.com/@1RuneBerg
+ * Licensed under Apache 2.0: https://www.apache.org/licenses/LICENSE-2.0
+ * SPDX-License-Identifier: Apache-2.0
+ * 
+ * This work is the next iteration of OpenXRProvider (v1, v2)
+ * OpenXRProvider (v1): Released 2021 -  https://github.com/1runeberg/OpenXRProvider
+ * OpenXRProvider (v2): Released 2022 - https://github.com/1runeberg/OpenXRProvider_v2/
+ * v1 & v2 licensed under MIT: https://opensource.org/license/mit
+*/
+
+
+// xrlib_import - writes the model cache of a gltf/glb file offline (see CModelCacheFile), e.g. as a build step for shipped assets.
+// The cache is only used at runtime if CGltf's import settings there match the ones used here.
+
+#include <xrlib/thread_pool.hpp>
+#include <xrvk/gltf.hpp>
+#include <xrvk/modelcache.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+using namespace xrlib;
+
+static void PrintUsage()
+{
+	printf( "Usage: xrlib_import <model.gltf|model.glb> [output.xrmc] [options]\n" );
+	printf( "  Output defaults to the input path with the .xrmc extension.\n\n" );
+	printf( "Options (must match the CGltf settings of the application loading the cache):\n" );
+	printf( "  --no-optimize    skip mesh optimization\n" );
+	printf( "  --no-lods        skip level of detail generation\n" );
+}
+
+int main( int argc, char *argv[] )
+{
+	std::string sInput, sOutput;
+	bool bOptimize = true;
+	bool bLods = true;
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( strcmp( argv[ i ], "--no-optimize" ) == 0 )
+			bOptimize = false;
+		else if ( strcmp( argv[ i ], "--no-lods" ) == 0 )
+			bLods = false;
+		else if ( strcmp( argv[ i ], "--help" ) == 0 || strcmp( argv[ i ], "-h" ) == 0 )
+		{
+			PrintUsage();
+			return 0;
+		}
+		else if ( argv[ i ][ 0 ] == '-' )
+		{
+			printf( "Unknown option: %s\n\n", argv[ i ] );
+			PrintUsage();
+			return 1;
+		}
+		else if ( sInput.empty() )
+			sInput = argv[ i ];
+		else if ( sOutput.empty() )
+			sOutput = argv[ i ];
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if ( sInput.empty() )
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if ( sOutput.empty() )
+		sOutput = fs::path( sInput ).replace_extension( ".xrmc" ).string();
+
+	// No session - textures keep their decoded pixels and no gpu resources are created
+	CThreadPool threadPool;
+	CGltf gltf( nullptr );
+	gltf.imageDecodePool = &threadPool;
+	gltf.meshOptimization.enabled = bOptimize;
+	gltf.lodGeneration.enabled = bLods;
+
+	const uint64_t unImportHash = gltf.GetImportHash( sInput );
+	if ( unImportHash == 0 )
+	{
+		printf( "Unable to read %s\n", sInput.c_str() );
+		return 1;
+	}
+
+	CRenderModel model( nullptr, nullptr, false );
+	if ( !gltf.LoadAndParse( &model, VK_NULL_HANDLE, sInput ) )
+	{
+		printf( "Unable to import %s\n", sInput.c_str() );
+		return 1;
+	}
+
+	if ( !CModelCacheFile::Write( sOutput, model, unImportHash ) )
+		return 1;
+
+	printf( "%s -> %s: %zu vertices, %zu indices, %zu sections, %zu lods, %zu materials, %zu textures, %zu skins, %zu animations\n",
+		sInput.c_str(), sOutput.c_str(),
+		model.vertices.size(), model.indices.size(), model.materialSections.size(), model.lods.size(), 
+		model.materials.size(), model.textures.size(), model.skins.size(), model.animations.size() );
+
+	return 0;
+}